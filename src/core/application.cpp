@@ -67,6 +67,7 @@
 #include <util/util.h>
 #include <util/structuresops.h>
 #include <util/sys/paths.h>
+#include <util/sys/tracing.h>
 #include <util/qml/tooltipitem.h>
 #include <util/threads/concurrentexception.h>
 
@@ -113,6 +114,9 @@ namespace LC
 			VarMap_ = Parse (parser, &desc);
 		}
 
+		if (VarMap_.count ("trace-startup"))
+			Util::Tracing::Enable ();
+
 		if (VarMap_.count ("help"))
 		{
 			std::cout << "LeechCraft " << LEECHCRAFT_VERSION << " (https://leechcraft.org)" << std::endl;
@@ -209,8 +213,15 @@ namespace LC
 
 		CheckStartupPass ();
 
-		Core::Instance ();
-		InitSettings ();
+		{
+			Util::Tracing::TraceSpan span { "Core initialization", "startup" };
+			Core::Instance ();
+		}
+
+		{
+			Util::Tracing::TraceSpan span { "settings initialization", "startup" };
+			InitSettings ();
+		}
 
 		InitPluginsIconset ();
 
@@ -266,6 +277,8 @@ namespace LC
 				("autorestart", "automatically restart LC if it's closed (not guaranteed to work everywhere, especially on Windows and Mac OS X)")
 				("minimized", "start LC minimized to tray")
 				("no-splash-screen", "do not show the splash screen")
+				("trace-startup", bpo::value<std::string> (), "record the startup trace and write it in Chrome trace event format to the given file (useful for profiling)")
+				("record-network", bpo::value<std::string> (), "record the network requests made by the plugins and write them in HAR format to the given file on exit (useful for profiling)")
 				("restart", "restart the LC");
 		bpo::positional_options_description pdesc;
 		pdesc.add ("entity", -1);
@@ -520,13 +533,29 @@ namespace LC
 
 	void Application::finishInit ()
 	{
-		auto rwm = Core::Instance ().GetRootWindowsManager ();
-		rwm->Initialize ();
-		Core::Instance ().DelayedInit ();
+		{
+			Util::Tracing::TraceSpan span { "Application::finishInit", "startup" };
+
+			auto rwm = Core::Instance ().GetRootWindowsManager ();
+			rwm->Initialize ();
+			Core::Instance ().DelayedInit ();
+
+			const auto win = rwm->GetMainWindow (0);
+			win->showFirstTime ();
+			Splash_->finish (win);
+		}
 
-		const auto win = rwm->GetMainWindow (0);
-		win->showFirstTime ();
-		Splash_->finish (win);
+		if (VarMap_.count ("trace-startup"))
+		{
+			/* Give plugins doing delayed initialization (like restoring
+			 * the tabs from the previous session) a chance to do their
+			 * work before dumping the trace.
+			 */
+			const auto& path = QString::fromStdString (VarMap_ ["trace-startup"].as<std::string> ());
+			QTimer::singleShot (10000,
+					this,
+					[path] { Util::Tracing::Dump (path); });
+		}
 	}
 
 #ifdef Q_OS_MAC
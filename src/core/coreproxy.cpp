@@ -30,6 +30,7 @@
 #include "coreproxy.h"
 #include <algorithm>
 #include <interfaces/ifinder.h>
+#include <util/sys/tracing.h>
 #include "core.h"
 #include "mainwindow.h"
 #include "xmlsettingsmanager.h"
@@ -90,6 +91,8 @@ namespace LC
 
 	QStringList CoreProxy::GetSearchCategories () const
 	{
+		Util::Tracing::TraceSpan span { "CoreProxy::GetSearchCategories", "core" };
+
 		const QList<IFinder*>& finders = Core::Instance ().GetPluginManager ()->
 			GetAllCastableTo<IFinder*> ();
 
@@ -119,6 +122,7 @@ namespace LC
 
 	void CoreProxy::RegisterSkinnable (QAction *act)
 	{
+		Util::Tracing::TraceSpan span { "CoreProxy::RegisterSkinnable", "core" };
 		IconThemeEngine::Instance ().UpdateIconset ({ act });
 	}
 
@@ -0,0 +1,149 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "initscheduler.h"
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
+#include <interfaces/core/iloadprogressreporter.h>
+
+namespace LC
+{
+	InitScheduleResult RunInitScheduled (const QObjectList& ordered,
+			const QHash<QObject*, QObjectList>& deps,
+			const QSet<QObject*>& threadSafe,
+			ILoadProcess *proc,
+			const InitAction_f& action)
+	{
+		const auto& orderedSet = QSet<QObject*>::fromList (ordered);
+
+		QHash<QObject*, int> pendingDeps;
+		QHash<QObject*, QObjectList> dependents;
+		QObjectList ready;
+		for (const auto obj : ordered)
+		{
+			int count = 0;
+			for (const auto dep : deps.value (obj))
+				if (dep != obj && orderedSet.contains (dep))
+				{
+					++count;
+					dependents [dep] << obj;
+				}
+
+			if (count)
+				pendingDeps [obj] = count;
+			else
+				ready << obj;
+		}
+
+		InitScheduleResult result;
+
+		auto markDone = [&] (QObject *obj, bool success)
+		{
+			if (proc)
+				++*proc;
+
+			if (!success)
+			{
+				if (!result.Failed_)
+					result.Failed_ = obj;
+				return;
+			}
+
+			result.Done_ << obj;
+			for (const auto dependent : dependents.value (obj))
+				if (!--pendingDeps [dependent])
+					ready << dependent;
+		};
+
+		// The watchers deliver their signals in this thread, so the
+		// finished list is only accessed from here.
+		QEventLoop loop;
+		QList<QPair<QObject*, bool>> finished;
+		int running = 0;
+
+		while (true)
+		{
+			if (!result.Failed_)
+				for (auto it = ready.begin (); it != ready.end (); )
+				{
+					if (!threadSafe.contains (*it))
+					{
+						++it;
+						continue;
+					}
+
+					++running;
+
+					const auto obj = *it;
+					const auto watcher = new QFutureWatcher<bool> { &loop };
+					QObject::connect (watcher,
+							&QFutureWatcher<bool>::finished,
+							&loop,
+							[&, watcher, obj]
+							{
+								finished.push_back ({ obj, watcher->result () });
+								watcher->deleteLater ();
+								loop.quit ();
+							});
+					watcher->setFuture (QtConcurrent::run ([&action, obj] { return action (obj, true); }));
+
+					it = ready.erase (it);
+				}
+
+			if (!finished.isEmpty ())
+			{
+				for (const auto& pair : finished)
+				{
+					--running;
+					markDone (pair.first, pair.second);
+				}
+				finished.clear ();
+				continue;
+			}
+
+			if (!result.Failed_ && !ready.isEmpty ())
+			{
+				const auto obj = ready.takeFirst ();
+				markDone (obj, action (obj, false));
+				continue;
+			}
+
+			if (!running)
+				break;
+
+			// The finished list is only filled by the watchers during the
+			// event processing, so nothing is missed between the check
+			// above and entering the loop.
+			loop.exec (QEventLoop::ExcludeUserInputEvents);
+		}
+
+		return result;
+	}
+}
@@ -0,0 +1,74 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <QHash>
+#include <QObjectList>
+#include <QSet>
+
+class ILoadProcess;
+
+namespace LC
+{
+	struct InitScheduleResult
+	{
+		QObjectList Done_;
+		QObject *Failed_ = nullptr;
+	};
+
+	/** The action to run for an object. The second parameter is true if
+	 * the action is run in a worker thread.
+	 */
+	using InitAction_f = std::function<bool (QObject*, bool)>;
+
+	/** Runs the action for each object in the ordered list so that every
+	 * object is processed only after all of its dependencies. The objects
+	 * from the threadSafe set are processed in the global thread pool, and
+	 * the rest is processed in the calling thread, so independent
+	 * thread-safe plugins are processed concurrently both with each other
+	 * and with the GUI thread ones.
+	 *
+	 * The calling thread runs its event loop while waiting for the worker
+	 * threads, so the objects processed there may use queued or blocking
+	 * queued calls into the calling thread.
+	 *
+	 * Once the action fails for an object, no new objects are scheduled,
+	 * and the function returns as soon as the already running ones are
+	 * finished.
+	 *
+	 * The proc is advanced for each processed object, if it is not null.
+	 */
+	InitScheduleResult RunInitScheduled (const QObjectList& ordered,
+			const QHash<QObject*, QObjectList>& deps,
+			const QSet<QObject*>& threadSafe,
+			ILoadProcess *proc,
+			const InitAction_f& action);
+}
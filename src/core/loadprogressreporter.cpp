@@ -28,6 +28,8 @@
  **********************************************************************/
 
 #include "loadprogressreporter.h"
+#include <algorithm>
+#include <QMutex>
 #include <QtDebug>
 #include "application.h"
 #include "loadprocess.h"
@@ -47,4 +49,87 @@ namespace LC
 
 		return process;
 	}
+
+	namespace
+	{
+		struct PluginTiming
+		{
+			QString Plugin_;
+			LoadProgressReporter::Stage Stage_;
+			qint64 Nsecs_;
+			bool InWorker_;
+		};
+
+		struct PluginTimings
+		{
+			QMutex Mutex_;
+			QList<PluginTiming> Timings_;
+		};
+
+		PluginTimings& GetPluginTimings ()
+		{
+			static PluginTimings timings;
+			return timings;
+		}
+
+		QString GetStageName (LoadProgressReporter::Stage stage)
+		{
+			switch (stage)
+			{
+			case LoadProgressReporter::Stage::Load:
+				return "load";
+			case LoadProgressReporter::Stage::FirstInit:
+				return "Init ()";
+			case LoadProgressReporter::Stage::SecondInit:
+				return "SecondInit ()";
+			}
+
+			return {};
+		}
+	}
+
+	void LoadProgressReporter::ReportPluginTiming (const QString& plugin, Stage stage, qint64 nsecs, bool inWorker)
+	{
+		auto& timings = GetPluginTimings ();
+		QMutexLocker locker { &timings.Mutex_ };
+		timings.Timings_.push_back ({ plugin, stage, nsecs, inWorker });
+	}
+
+	void LoadProgressReporter::DumpPluginTimings ()
+	{
+		auto& timings = GetPluginTimings ();
+		QMutexLocker locker { &timings.Mutex_ };
+
+		auto sorted = timings.Timings_;
+		std::stable_sort (sorted.begin (), sorted.end (),
+				[] (const PluginTiming& t1, const PluginTiming& t2) { return t1.Nsecs_ > t2.Nsecs_; });
+
+		for (const auto stage : { Stage::Load, Stage::FirstInit, Stage::SecondInit })
+		{
+			qint64 total = 0;
+			int count = 0;
+			for (const auto& timing : sorted)
+				if (timing.Stage_ == stage)
+				{
+					total += timing.Nsecs_;
+					++count;
+				}
+
+			qDebug () << "plugins"
+					<< GetStageName (stage)
+					<< "timings: total"
+					<< total / 1000000
+					<< "ms for"
+					<< count
+					<< "plugins";
+
+			for (const auto& timing : sorted)
+				if (timing.Stage_ == stage)
+					qDebug () << "\t"
+							<< timing.Plugin_
+							<< timing.Nsecs_ / 1000000
+							<< "ms"
+							<< (timing.InWorker_ ? "(worker thread)" : "");
+		}
+	}
 }
@@ -37,6 +37,25 @@ namespace LC
 							   , public ILoadProgressReporter
 	{
 	public:
+		enum class Stage
+		{
+			Load,
+			FirstInit,
+			SecondInit
+		};
+
 		ILoadProcess_ptr InitiateProcess (const QString&, int, int) override;
+
+		/** Records the time it took to process the given plugin at the
+		 * given stage. This function is thread-safe.
+		 */
+		static void ReportPluginTiming (const QString& plugin, Stage stage, qint64 nsecs, bool inWorker);
+
+		/** Dumps the timings recorded so far, slowest plugins first.
+		 *
+		 * PluginManager only calls this when the startup is traced, that
+		 * is, when LeechCraft is started with the --trace-startup option.
+		 */
+		static void DumpPluginTimings ();
 	};
 }
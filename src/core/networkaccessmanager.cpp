@@ -33,14 +33,17 @@
 #include <QNetworkRequest>
 #include <QDir>
 #include <QFile>
+#include <QSaveFile>
 #include <QNetworkReply>
 #include <QTimer>
 #include <util/network/customcookiejar.h>
 #include <util/network/networkdiskcache.h>
 #include <util/xpc/defaulthookproxy.h>
 #include "core.h"
+#include "application.h"
 #include "xmlsettingsmanager.h"
 #include "mainwindow.h"
+#include "networkinstrumentation.h"
 #include "sslerrorshandler.h"
 
 Q_DECLARE_METATYPE (QNetworkReply*);
@@ -48,6 +51,22 @@ Q_DECLARE_METATYPE (QNetworkReply*);
 using namespace LC;
 using namespace LC::Util;
 
+namespace
+{
+	QString GetCookiesFilePath ()
+	{
+		return QDir::homePath () + "/.leechcraft/core/cookies.txt";
+	}
+
+	QString GetCookiesJournalPath ()
+	{
+		return QDir::homePath () + "/.leechcraft/core/cookies.journal";
+	}
+
+	// The journal is merged into cookies.txt as soon as it grows this big.
+	const qint64 MaxCookiesJournalSize = 1024 * 1024;
+}
+
 NetworkAccessManager::NetworkAccessManager (QObject *parent)
 : QNetworkAccessManager (parent)
 , CookieSaveTimer_ (new QTimer (this))
@@ -97,8 +116,9 @@ NetworkAccessManager::NetworkAccessManager (QObject *parent)
 			<< "so continuing without cache";
 	}
 
-	QFile file (QDir::homePath () +
-			"/.leechcraft/core/cookies.txt");
+	CookieJar_->EnableJournal ();
+
+	QFile file (GetCookiesFilePath ());
 	if (file.open (QIODevice::ReadOnly))
 		CookieJar_->Load (file.readAll ());
 	else
@@ -107,11 +127,25 @@ NetworkAccessManager::NetworkAccessManager (QObject *parent)
 			<< file.fileName ()
 			<< file.errorString ();
 
+	QFile journal (GetCookiesJournalPath ());
+	if (journal.open (QIODevice::ReadOnly))
+	{
+		CookiesJournalSize_ = journal.size ();
+		CookieJar_->LoadJournal (journal.readAll ());
+	}
+
 	connect (CookieSaveTimer_,
 			SIGNAL (timeout ()),
 			this,
 			SLOT (saveCookies ()));
 	CookieSaveTimer_->start (10000);
+
+	const auto& map = qobject_cast<Application*> (qApp)->GetVarMap ();
+	if (map.count ("record-network"))
+	{
+		const auto& path = QString::fromStdString (map ["record-network"].as<std::string> ());
+		Instrumentation_ = new NetworkInstrumentation (path, this);
+	}
 }
 
 NetworkAccessManager::~NetworkAccessManager ()
@@ -131,6 +165,8 @@ QNetworkReply* NetworkAccessManager::createRequest (QNetworkAccessManager::Opera
 	if (proxy->IsCancelled ())
 	{
 		const auto reply = proxy->GetReturnValue ().value<QNetworkReply*> ();
+		if (Instrumentation_)
+			Instrumentation_->Track (op, r, out, reply);
 		emit requestCreated (op, r, reply);
 		return reply;
 	}
@@ -144,6 +180,8 @@ QNetworkReply* NetworkAccessManager::createRequest (QNetworkAccessManager::Opera
 	}
 
 	QNetworkReply *result = QNetworkAccessManager::createRequest (op, r, out);
+	if (Instrumentation_)
+		Instrumentation_->Track (op, r, out, result);
 	emit requestCreated (op, r, result);
 	return result;
 }
@@ -154,7 +192,40 @@ void LC::NetworkAccessManager::handleSslErrors (QNetworkReply *replyObj,
 	new SslErrorsHandler { replyObj, errors };
 }
 
-void LC::NetworkAccessManager::saveCookies () const
+bool LC::NetworkAccessManager::WriteCookiesSnapshot (const QByteArray& data) const
+{
+	QSaveFile file (GetCookiesFilePath ());
+	if (!file.open (QIODevice::WriteOnly) ||
+			file.write (data) != data.size () ||
+			!file.commit ())
+	{
+		emit error (tr ("Could not save cookies, error opening cookie file."));
+		qWarning () << Q_FUNC_INFO
+			<< file.errorString ();
+		return false;
+	}
+
+	QFile::remove (GetCookiesJournalPath ());
+	return true;
+}
+
+bool LC::NetworkAccessManager::AppendCookiesJournal (const QByteArray& records) const
+{
+	QFile file (GetCookiesJournalPath ());
+	if (!file.open (QIODevice::WriteOnly | QIODevice::Append) ||
+			file.write (records) != records.size ())
+	{
+		qWarning () << Q_FUNC_INFO
+			<< "unable to append to"
+			<< file.fileName ()
+			<< file.errorString ();
+		return false;
+	}
+
+	return true;
+}
+
+void LC::NetworkAccessManager::saveCookies ()
 {
 	QDir dir = QDir::home ();
 	dir.cd (".leechcraft");
@@ -165,19 +236,34 @@ void LC::NetworkAccessManager::saveCookies () const
 		return;
 	}
 
-	QFile file (QDir::homePath () +
-			"/.leechcraft/core/cookies.txt");
-	if (!file.open (QIODevice::WriteOnly | QIODevice::Truncate))
+	const auto& journal = CookieJar_->TakeJournal ();
+
+	const bool saveEnabled = !XmlSettingsManager::Instance ()->
+			property ("DeleteCookiesOnExit").toBool ();
+	if (!saveEnabled)
 	{
-		emit error (tr ("Could not save cookies, error opening cookie file."));
-		qWarning () << Q_FUNC_INFO
-			<< file.errorString ();
+		WriteCookiesSnapshot ({});
+		CookiesJournalSize_ = 0;
 		return;
 	}
 
-	const bool saveEnabled = !XmlSettingsManager::Instance ()->
-			property ("DeleteCookiesOnExit").toBool ();
-	file.write (saveEnabled ? CookieJar_->Save () : QByteArray ());
+	if (journal && !CookiesSnapshotPending_)
+	{
+		if (journal->isEmpty ())
+			return;
+
+		if (CookiesJournalSize_ + journal->size () < MaxCookiesJournalSize &&
+				AppendCookiesJournal (*journal))
+		{
+			CookiesJournalSize_ += journal->size ();
+			return;
+		}
+	}
+
+	// The journal records taken above are lost if the snapshot fails, so retry it next time.
+	CookiesSnapshotPending_ = !WriteCookiesSnapshot (CookieJar_->Save ());
+	if (!CookiesSnapshotPending_)
+		CookiesJournalSize_ = 0;
 }
 
 void LC::NetworkAccessManager::handleFilterTrackingCookies ()
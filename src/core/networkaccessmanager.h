@@ -38,6 +38,7 @@ class QTimer;
 namespace LC
 {
 	class SslErrorsDialog;
+	class NetworkInstrumentation;
 
 	namespace Util
 	{
@@ -51,16 +52,23 @@ namespace LC
 		QTimer * const CookieSaveTimer_;
 
 		Util::CustomCookieJar *CookieJar_;
+		qint64 CookiesJournalSize_ = 0;
+		bool CookiesSnapshotPending_ = false;
+
+		NetworkInstrumentation *Instrumentation_ = nullptr;
 	public:
 		NetworkAccessManager (QObject* = 0);
 		virtual ~NetworkAccessManager ();
 	protected:
 		QNetworkReply* createRequest (Operation,
 				const QNetworkRequest&, QIODevice*);
+	private:
+		bool WriteCookiesSnapshot (const QByteArray&) const;
+		bool AppendCookiesJournal (const QByteArray&) const;
 	private slots:
 		void handleSslErrors (QNetworkReply*, const QList<QSslError>&);
 
-		void saveCookies () const;
+		void saveCookies ();
 		void handleFilterTrackingCookies ();
 		void setCookiesEnabled ();
 		void setMatchDomainExactly ();
@@ -0,0 +1,367 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "networkinstrumentation.h"
+#include <algorithm>
+#include <memory>
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkReply>
+#include <QSaveFile>
+#include <QUrlQuery>
+#include <QtDebug>
+
+#if defined (_GNU_SOURCE) || defined (Q_OS_OSX)
+#include <execinfo.h>
+#include <dlfcn.h>
+#endif
+
+namespace LC
+{
+	namespace
+	{
+		// Older entries are dropped from the HAR dump, but are still counted in the stats.
+		const int MaxEntries = 10000;
+
+		const QString UnknownPlugin = "unknown";
+
+		QString DetectPlugin ()
+		{
+#if defined (_GNU_SOURCE) || defined (Q_OS_OSX)
+			const int maxSize = 64;
+			void *callstack [maxSize];
+			const auto size = backtrace (callstack, maxSize);
+
+			static QHash<const void*, QString> base2name;
+
+			for (int i = 0; i < size; ++i)
+			{
+				Dl_info info;
+				if (!dladdr (callstack [i], &info) || !info.dli_fname)
+					continue;
+
+				auto pos = base2name.find (info.dli_fbase);
+				if (pos == base2name.end ())
+				{
+					auto name = QFileInfo { QString::fromLocal8Bit (info.dli_fname) }.completeBaseName ();
+					if (name.startsWith ("lib"))
+						name = name.mid (3);
+
+					const QString prefix { "leechcraft_" };
+					pos = base2name.insert (info.dli_fbase,
+							name.startsWith (prefix) ? name.mid (prefix.size ()) : QString {});
+				}
+
+				if (!pos->isEmpty ())
+					return *pos;
+			}
+#endif
+
+			return UnknownPlugin;
+		}
+
+		qint64 GetBodySize (QIODevice *out)
+		{
+			return out && !out->isSequential () ? out->size () : -1;
+		}
+	}
+
+	NetworkInstrumentation::NetworkInstrumentation (const QString& harPath, QObject *parent)
+	: QObject { parent }
+	, HarPath_ { harPath }
+	{
+	}
+
+	NetworkInstrumentation::~NetworkInstrumentation ()
+	{
+		LogStats ();
+		DumpHar (HarPath_);
+	}
+
+	void NetworkInstrumentation::Track (QNetworkAccessManager::Operation op,
+			const QNetworkRequest& req, QIODevice *out, QNetworkReply *reply)
+	{
+		if (!reply)
+			return;
+
+		const auto pending = std::make_shared<PendingEntry> ();
+		pending->Timer_.start ();
+
+		auto& entry = pending->Entry_;
+		entry.Plugin_ = DetectPlugin ();
+		entry.Op_ = op;
+		entry.CustomVerb_ = req.attribute (QNetworkRequest::CustomVerbAttribute).toByteArray ();
+		entry.Request_ = req;
+		entry.BytesSent_ = GetBodySize (out);
+		entry.Started_ = QDateTime::currentDateTimeUtc ();
+
+		connect (reply,
+				&QNetworkReply::metaDataChanged,
+				this,
+				[pending]
+				{
+					auto& entry = pending->Entry_;
+					if (entry.Wait_ < 0)
+						entry.Wait_ = pending->Timer_.elapsed ();
+				});
+		connect (reply,
+				&QNetworkReply::downloadProgress,
+				this,
+				[pending] (qint64 received) { pending->Entry_.BytesReceived_ = received; });
+		connect (reply,
+				&QNetworkReply::finished,
+				this,
+				[this, pending, reply] { HandleFinished (*pending, reply); });
+	}
+
+	const QHash<QString, NetworkInstrumentation::PluginStats>& NetworkInstrumentation::GetStats () const
+	{
+		return Stats_;
+	}
+
+	void NetworkInstrumentation::HandleFinished (PendingEntry& pending, QNetworkReply *reply)
+	{
+		auto& entry = pending.Entry_;
+
+		entry.Total_ = pending.Timer_.elapsed ();
+		if (entry.Wait_ < 0)
+			entry.Wait_ = entry.Total_;
+		entry.Receive_ = entry.Total_ - entry.Wait_;
+
+		entry.Status_ = reply->attribute (QNetworkRequest::HttpStatusCodeAttribute).toInt ();
+		entry.StatusText_ = reply->attribute (QNetworkRequest::HttpReasonPhraseAttribute).toByteArray ();
+		entry.ResponseHeaders_ = reply->rawHeaderPairs ();
+		entry.FromCache_ = reply->attribute (QNetworkRequest::SourceIsFromCacheAttribute).toBool ();
+		if (reply->error () != QNetworkReply::NoError)
+			entry.Error_ = reply->errorString ();
+
+		auto& stats = Stats_ [entry.Plugin_];
+		++stats.Requests_;
+		if (!entry.Error_.isEmpty ())
+			++stats.Failed_;
+		if (entry.Op_ == QNetworkAccessManager::GetOperation)
+			++(entry.FromCache_ ? stats.CacheHits_ : stats.CacheMisses_);
+		stats.BytesSent_ += std::max<qint64> (entry.BytesSent_, 0);
+		stats.BytesReceived_ += entry.BytesReceived_;
+		stats.TotalTime_ += entry.Total_;
+
+		Entries_.enqueue (entry);
+		if (Entries_.size () > MaxEntries)
+			Entries_.dequeue ();
+	}
+
+	void NetworkInstrumentation::LogStats () const
+	{
+		auto plugins = Stats_.keys ();
+		std::sort (plugins.begin (), plugins.end (),
+				[this] (const QString& left, const QString& right)
+				{
+					return Stats_ [left].BytesReceived_ > Stats_ [right].BytesReceived_;
+				});
+
+		qDebug () << Q_FUNC_INFO
+				<< "network usage by plugin:";
+		for (const auto& plugin : plugins)
+		{
+			const auto& stats = Stats_ [plugin];
+			qDebug () << plugin
+					<< stats.Requests_ << "requests,"
+					<< stats.Failed_ << "failed,"
+					<< stats.CacheHits_ << "cache hits,"
+					<< stats.CacheMisses_ << "cache misses,"
+					<< stats.BytesSent_ << "bytes sent,"
+					<< stats.BytesReceived_ << "bytes received,"
+					<< stats.TotalTime_ << "ms total";
+		}
+	}
+
+	namespace
+	{
+		QString GetMethod (const NetworkInstrumentation::Entry& entry)
+		{
+			switch (entry.Op_)
+			{
+			case QNetworkAccessManager::HeadOperation:
+				return "HEAD";
+			case QNetworkAccessManager::GetOperation:
+				return "GET";
+			case QNetworkAccessManager::PutOperation:
+				return "PUT";
+			case QNetworkAccessManager::PostOperation:
+				return "POST";
+			case QNetworkAccessManager::DeleteOperation:
+				return "DELETE";
+			case QNetworkAccessManager::CustomOperation:
+			case QNetworkAccessManager::UnknownOperation:
+				break;
+			}
+
+			return QString::fromLatin1 (entry.CustomVerb_);
+		}
+
+		QJsonArray ToHarHeaders (const QList<QPair<QByteArray, QByteArray>>& headers)
+		{
+			QJsonArray result;
+			for (const auto& pair : headers)
+				result.append (QJsonObject
+						{
+							{ "name", QString::fromLatin1 (pair.first) },
+							{ "value", QString::fromLatin1 (pair.second) }
+						});
+			return result;
+		}
+
+		QJsonArray GetRequestHeaders (const QNetworkRequest& req)
+		{
+			QList<QPair<QByteArray, QByteArray>> headers;
+			for (const auto& name : req.rawHeaderList ())
+				headers.append ({ name, req.rawHeader (name) });
+			return ToHarHeaders (headers);
+		}
+
+		QJsonArray GetQueryString (const QUrl& url)
+		{
+			QJsonArray result;
+			for (const auto& item : QUrlQuery { url }.queryItems (QUrl::FullyDecoded))
+				result.append (QJsonObject { { "name", item.first }, { "value", item.second } });
+			return result;
+		}
+
+		QJsonObject ToHarEntry (const NetworkInstrumentation::Entry& entry)
+		{
+			QString mimeType;
+			QString redirect;
+			for (const auto& pair : entry.ResponseHeaders_)
+			{
+				const auto& name = pair.first.toLower ();
+				if (name == "content-type")
+					mimeType = QString::fromLatin1 (pair.second);
+				else if (name == "location")
+					redirect = QString::fromLatin1 (pair.second);
+			}
+
+			const QJsonObject request
+			{
+				{ "method", GetMethod (entry) },
+				{ "url", entry.Request_.url ().toString () },
+				{ "httpVersion", "HTTP/1.1" },
+				{ "cookies", QJsonArray {} },
+				{ "headers", GetRequestHeaders (entry.Request_) },
+				{ "queryString", GetQueryString (entry.Request_.url ()) },
+				{ "headersSize", -1 },
+				{ "bodySize", entry.BytesSent_ }
+			};
+
+			const QJsonObject response
+			{
+				{ "status", entry.Status_ },
+				{ "statusText", QString::fromLatin1 (entry.StatusText_) },
+				{ "httpVersion", "HTTP/1.1" },
+				{ "cookies", QJsonArray {} },
+				{ "headers", ToHarHeaders (entry.ResponseHeaders_) },
+				{ "content", QJsonObject { { "size", entry.BytesReceived_ }, { "mimeType", mimeType } } },
+				{ "redirectURL", redirect },
+				{ "headersSize", -1 },
+				{ "bodySize", entry.FromCache_ ? 0 : entry.BytesReceived_ }
+			};
+
+			const QJsonObject timings
+			{
+				{ "blocked", -1 },
+				{ "dns", -1 },
+				{ "connect", -1 },
+				{ "ssl", -1 },
+				{ "send", 0 },
+				{ "wait", entry.Wait_ },
+				{ "receive", entry.Receive_ }
+			};
+
+			QJsonObject result
+			{
+				{ "startedDateTime", entry.Started_.toString (Qt::ISODateWithMs) },
+				{ "time", entry.Total_ },
+				{ "request", request },
+				{ "response", response },
+				{ "cache", QJsonObject {} },
+				{ "timings", timings },
+				{ "_plugin", entry.Plugin_ },
+				{ "_fromCache", entry.FromCache_ }
+			};
+			if (!entry.Error_.isEmpty ())
+				result ["_error"] = entry.Error_;
+			return result;
+		}
+	}
+
+	bool NetworkInstrumentation::DumpHar (const QString& path) const
+	{
+		QJsonArray entries;
+		for (const auto& entry : Entries_)
+			entries.append (ToHarEntry (entry));
+
+		const QJsonObject log
+		{
+			{ "version", "1.2" },
+			{
+				"creator",
+				QJsonObject
+				{
+					{ "name", QCoreApplication::applicationName () },
+					{ "version", QCoreApplication::applicationVersion () }
+				}
+			},
+			{ "entries", entries }
+		};
+
+		QSaveFile file { path };
+		if (!file.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< path
+					<< file.errorString ();
+			return false;
+		}
+
+		file.write (QJsonDocument { QJsonObject { { "log", log } } }.toJson (QJsonDocument::Compact));
+		if (!file.commit ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to write"
+					<< path
+					<< file.errorString ();
+			return false;
+		}
+
+		return true;
+	}
+}
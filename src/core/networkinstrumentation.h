@@ -0,0 +1,125 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QQueue>
+
+class QNetworkReply;
+
+namespace LC
+{
+	/** Records the requests made via the core NetworkAccessManager, the
+	 * timings of their phases and whether they've been served from the
+	 * cache, attributing each request to the plugin that has issued it.
+	 *
+	 * The plugin is determined by looking for the first plugin library
+	 * in the call stack of the createRequest() call. Requests issued
+	 * from places like the event loop or a web engine, as well as the
+	 * requests on the platforms without backtrace support, are
+	 * attributed to the "unknown" pseudo-plugin.
+	 *
+	 * Qt doesn't report DNS lookup, connection and SSL handshake times,
+	 * so they are exported as not available.
+	 */
+	class NetworkInstrumentation : public QObject
+	{
+	public:
+		struct PluginStats
+		{
+			int Requests_ = 0;
+			int Failed_ = 0;
+			int CacheHits_ = 0;
+			int CacheMisses_ = 0;
+			qint64 BytesSent_ = 0;
+			qint64 BytesReceived_ = 0;
+			qint64 TotalTime_ = 0;
+		};
+
+		struct Entry
+		{
+			QString Plugin_;
+
+			QNetworkAccessManager::Operation Op_;
+			QByteArray CustomVerb_;
+			QNetworkRequest Request_;
+			qint64 BytesSent_ = -1;
+
+			QDateTime Started_;
+
+			qint64 Wait_ = -1;
+			qint64 Receive_ = -1;
+			qint64 Total_ = -1;
+
+			int Status_ = 0;
+			QByteArray StatusText_;
+			QList<QPair<QByteArray, QByteArray>> ResponseHeaders_;
+			qint64 BytesReceived_ = 0;
+			bool FromCache_ = false;
+			QString Error_;
+		};
+	private:
+		const QString HarPath_;
+
+		QHash<QString, PluginStats> Stats_;
+		QQueue<Entry> Entries_;
+	public:
+		/** The HAR dump is written to the harPath on destruction.
+		 */
+		NetworkInstrumentation (const QString& harPath, QObject* = nullptr);
+		~NetworkInstrumentation () override;
+
+		/** Starts tracking the given reply. Should be called right after
+		 * the reply is created.
+		 */
+		void Track (QNetworkAccessManager::Operation, const QNetworkRequest&, QIODevice*, QNetworkReply*);
+
+		const QHash<QString, PluginStats>& GetStats () const;
+
+		/** Writes the recorded requests in the HAR format to the given
+		 * file. Only the finished requests are written.
+		 */
+		bool DumpHar (const QString& path) const;
+	private:
+		struct PendingEntry
+		{
+			Entry Entry_;
+			QElapsedTimer Timer_;
+		};
+
+		void HandleFinished (PendingEntry&, QNetworkReply*);
+		void LogStats () const;
+	};
+}
@@ -44,11 +44,14 @@
 #include <QtDebug>
 #include <QElapsedTimer>
 #include <QtConcurrentMap>
+#include <QThread>
 #include <QMessageBox>
 #include <QMainWindow>
 #include <util/exceptions.h>
 #include <util/sll/prelude.h>
 #include <util/sll/scopeguards.h>
+#include <util/sys/tracing.h>
+#include <xmlsettingsdialog/settingsthreadmanager.h>
 #include <interfaces/iinfo.h>
 #include <interfaces/iplugin2.h>
 #include <interfaces/ipluginready.h>
@@ -61,11 +64,13 @@
 #include "xmlsettingsmanager.h"
 #include "coreproxy.h"
 #include "plugintreebuilder.h"
+#include "pluginmetadatacache.h"
 #include "config.h"
 #include "coreinstanceobject.h"
 #include "shortcutmanager.h"
 #include "application.h"
 #include "loadprogressreporter.h"
+#include "initscheduler.h"
 #include "settingstab.h"
 #include "loaders/sopluginloader.h"
 #include "loadprocessbase.h"
@@ -392,50 +397,89 @@ namespace LC
 		}
 	};
 
-	QObject* PluginManager::TryFirstInit (QObjectList ordered, PluginLoadProcess *proc)
+	QObject* PluginManager::TryFirstInit (QObjectList ordered,
+			QSet<QObject*>& initialized, PluginLoadProcess *proc)
 	{
+		// CoreProxy is a QObject, so better create them all in the GUI thread.
+		QHash<QObject*, ICoreProxy_ptr> proxies;
+		for (const auto obj : ordered)
+			proxies [obj] = std::make_shared<CoreProxy> ();
+
+		const auto& result = RunInitScheduled (ordered,
+				PluginTreeBuilder_->GetDependencies (),
+				GetThreadSafeInits (ordered),
+				proc,
+				[&proxies] (QObject *obj, bool inWorker)
+				{
+					const auto ii = qobject_cast<IInfo*> (obj);
+
+					Util::Tracing::TraceSpan span { "IInfo::Init", "plugins", ii->GetName () };
+					QElapsedTimer timer;
+					timer.start ();
+
+					try
+					{
+						qDebug () << "Initializing"
+								<< ii->GetName ()
+								<< (inWorker ? "in a worker thread" : "");
+						ii->Init (proxies.value (obj));
+					}
+					catch (const std::exception& e)
+					{
+						qWarning () << Q_FUNC_INFO
+								<< "while initializing"
+								<< obj
+								<< "got"
+								<< e.what ();
+						return false;
+					}
+					catch (...)
+					{
+						qWarning () << Q_FUNC_INFO
+								<< "while initializing"
+								<< obj
+								<< "caught unknown exception";
+						return false;
+					}
+
+					LoadProgressReporter::ReportPluginTiming (ii->GetName (),
+							LoadProgressReporter::Stage::FirstInit, timer.nsecsElapsed (), inWorker);
+					return true;
+				});
+
 		QSettings settings (QCoreApplication::organizationName (),
 				QCoreApplication::applicationName () + "-pg");
 		const auto guard = Util::BeginGroup (settings, "Plugins");
 
-		for (const auto obj : ordered)
+		for (const auto obj : result.Done_)
 		{
-			++*proc;
+			initialized << obj;
 
-			const auto ii = qobject_cast<IInfo*> (obj);
-			try
-			{
-				qDebug () << "Initializing" << ii->GetName ();
-				ii->Init (std::make_shared<CoreProxy> ());
-
-				const auto& path = GetPluginLibraryPath (obj);
-				if (path.isEmpty ())
-					continue;
+			const auto& path = GetPluginLibraryPath (obj);
+			if (path.isEmpty ())
+				continue;
 
-				settings.beginGroup (path);
-				settings.setValue ("Info", ii->GetInfo ());
-				settings.endGroup ();
-			}
-			catch (const std::exception& e)
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "while initializing"
-						<< obj
-						<< "got"
-						<< e.what ();
-				return obj;
-			}
-			catch (...)
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "while initializing"
-						<< obj
-						<< "caught unknown exception";
-				return obj;
-			}
+			settings.beginGroup (path);
+			settings.setValue ("Info", qobject_cast<IInfo*> (obj)->GetInfo ());
+			settings.endGroup ();
 		}
 
-		return 0;
+		return result.Failed_;
+	}
+
+	QSet<QObject*> PluginManager::GetThreadSafeInits (const QObjectList& objects) const
+	{
+		if (DBusMode_ || qgetenv ("LC_SERIAL_PLUGIN_INIT") == "1")
+			return {};
+
+		QSet<QObject*> result;
+		for (const auto obj : objects)
+		{
+			const auto& loader = Obj2Loader_.value (obj);
+			if (loader && loader->GetManifest () ["ThreadSafeInit"].toBool ())
+				result << obj;
+		}
+		return result;
 	}
 
 	void PluginManager::TryUnload (QObjectList plugins)
@@ -459,6 +503,8 @@ namespace LC
 
 	void PluginManager::Init (bool safeMode)
 	{
+		Util::Tracing::TraceSpan initSpan { "PluginManager::Init", "plugins" };
+
 		DefaultPluginIcon_ = QIcon ("lcicons:/resources/images/defaultpluginicon.svg");
 		CheckPlugins ();
 		FillInstances ();
@@ -511,25 +557,40 @@ namespace LC
 
 		sndInitProc->SetCount (ordered.size ());
 
-		for (const auto obj : ordered)
-		{
-			++*sndInitProc;
-			const auto ii = qobject_cast<IInfo*> (obj);
-			try
-			{
-				qDebug () << "second init" << ii->GetName ();
-				ii->SecondInit ();
-			}
-			catch (const std::exception& e)
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "while initializing"
-						<< obj
-						<< "got"
-						<< e.what ();
-				continue;
-			}
-		}
+		RunInitScheduled (ordered,
+				PluginTreeBuilder_->GetDependencies (),
+				GetThreadSafeInits (ordered),
+				sndInitProc.get (),
+				[] (QObject *obj, bool inWorker)
+				{
+					const auto ii = qobject_cast<IInfo*> (obj);
+
+					Util::Tracing::TraceSpan span { "IInfo::SecondInit", "plugins", ii->GetName () };
+					QElapsedTimer timer;
+					timer.start ();
+
+					try
+					{
+						qDebug () << "second init"
+								<< ii->GetName ()
+								<< (inWorker ? "in a worker thread" : "");
+						ii->SecondInit ();
+					}
+					catch (const std::exception& e)
+					{
+						qWarning () << Q_FUNC_INFO
+								<< "while initializing"
+								<< obj
+								<< "got"
+								<< e.what ();
+					}
+
+					LoadProgressReporter::ReportPluginTiming (ii->GetName (),
+							LoadProgressReporter::Stage::SecondInit, timer.nsecsElapsed (), inWorker);
+
+					// A failed second init doesn't prevent others from initializing.
+					return true;
+				});
 
 		SetInitStage (InitStage::PostSecond);
 
@@ -539,6 +600,11 @@ namespace LC
 		SetInitStage (InitStage::Complete);
 
 		TryUnload (failed);
+
+		// The dump is several lines per plugin, so it's only useful when
+		// profiling the startup.
+		if (Util::Tracing::IsEnabled ())
+			LoadProgressReporter::DumpPluginTimings ();
 	}
 
 	void PluginManager::Release ()
@@ -566,6 +632,9 @@ namespace LC
 				qDebug () << "Releasing" << ii->GetName ();
 				ii->Release ();
 
+				// The plugin's settings managers die with the library.
+				SettingsThreadManager::Instance ().Flush ();
+
 				const auto& loader = Obj2Loader_.value (obj);
 				if (!loader)
 					continue;
@@ -993,12 +1062,17 @@ namespace LC
 
 	void PluginManager::CheckPlugins ()
 	{
+		Util::Tracing::TraceSpan span { "PluginManager::CheckPlugins", "plugins" };
+
 		QSettings settings (QCoreApplication::organizationName (),
 				QCoreApplication::applicationName () + "-pg");
 		settings.beginGroup ("Plugins");
 
 		QHash<QByteArray, QString> id2source;
 
+		PluginMetadataCache metadataCache;
+		DropUnfulfillable (metadataCache);
+
 		QList<std::function<void (Loaders::IPluginLoader_ptr)>> checks
 		{
 			Checks::IsFile,
@@ -1010,12 +1084,12 @@ namespace LC
 
 		auto thrCheck = [shouldDump, checks] (Loaders::IPluginLoader_ptr loader) -> std::optional<Checks::Fail>
 		{
+			Util::Tracing::TraceSpan loadSpan { "load library", "plugins", loader->GetFileName () };
+
 			QElapsedTimer timer;
+			timer.start ();
 			if (shouldDump)
-			{
-				timer.start ();
 				qDebug () << loader->GetFileName () << ": beginning checks";
-			}
 
 			for (const auto& check : checks)
 				try
@@ -1034,6 +1108,11 @@ namespace LC
 						<< "ms";
 			}
 
+			LoadProgressReporter::ReportPluginTiming (QFileInfo { loader->GetFileName () }.fileName (),
+					LoadProgressReporter::Stage::Load,
+					timer.nsecsElapsed (),
+					QThread::currentThread () != qApp->thread ());
+
 			return {};
 		};
 
@@ -1065,6 +1144,7 @@ namespace LC
 		for (int i = fails.size () - 1; i >= 0; --i)
 			if (fails [i])
 			{
+				metadataCache.Remove (PluginContainers_.at (i)->GetFileName ());
 				PluginContainers_.removeAt (i);
 				PluginLoadErrors_ << fails [i]->Error_;
 			}
@@ -1076,6 +1156,8 @@ namespace LC
 		{
 			auto loader = PluginContainers_.at (i);
 
+			Util::Tracing::TraceSpan instSpan { "instantiate plugin", "plugins", loader->GetFileName () };
+
 			bool success = true;
 			for (auto check : checks)
 				try
@@ -1091,10 +1173,13 @@ namespace LC
 
 			if (!success)
 			{
+				metadataCache.Remove (loader->GetFileName ());
 				PluginContainers_.removeAt (i--);
 				continue;
 			}
 
+			metadataCache.Update (loader->GetFileName (), loader->Instance ());
+
 			IInfo *info = qobject_cast<IInfo*> (loader->Instance ());
 			try
 			{
@@ -1142,6 +1227,34 @@ namespace LC
 		}
 
 		settings.endGroup ();
+
+		metadataCache.Save ();
+	}
+
+	void PluginManager::DropUnfulfillable (const PluginMetadataCache& cache)
+	{
+		if (qgetenv ("LC_NO_PLUGIN_METADATA_CACHE") == "1")
+			return;
+
+		QStringList paths;
+		for (const auto& loader : PluginContainers_)
+			paths << loader->GetFileName ();
+
+		const auto coreInstance = Core::Instance ().GetCoreInstanceObject ();
+		const auto& unfulfillable = cache.GetUnfulfillable (paths, coreInstance->GetExpectedPluginClasses ());
+		if (unfulfillable.isEmpty ())
+			return;
+
+		qDebug () << Q_FUNC_INFO
+				<< "not loading"
+				<< unfulfillable.size ()
+				<< "plugins with unfulfilled dependencies";
+
+		const auto& unfulfillableSet = QSet<QString>::fromList (unfulfillable);
+		const auto newEnd = std::remove_if (PluginContainers_.begin (), PluginContainers_.end (),
+				[&unfulfillableSet] (const Loaders::IPluginLoader_ptr& loader)
+					{ return unfulfillableSet.contains (loader->GetFileName ()); });
+		PluginContainers_.erase (newEnd, PluginContainers_.end ());
 	}
 
 	void PluginManager::FillInstances ()
@@ -1160,21 +1273,15 @@ namespace LC
 	QObjectList PluginManager::FirstInitAll (PluginLoadProcess *proc)
 	{
 		QObjectList ordered = PluginTreeBuilder_->GetResult ();
-		QObjectList initialized;
+		QSet<QObject*> initialized;
 		QObjectList failedList;
 
 		QObject *failed = 0;
-		while ((failed = TryFirstInit (ordered, proc)))
+		while ((failed = TryFirstInit (ordered, initialized, proc)))
 		{
 			CacheValid_ = false;
 
 			failedList << failed;
-			for (const auto obj : ordered)
-			{
-				if (failed == obj)
-					break;
-				initialized << obj;
-			}
 
 			PluginTreeBuilder_->RemoveObject (failed);
 
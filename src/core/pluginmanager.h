@@ -44,6 +44,7 @@ namespace LC
 {
 	class MainWindow;
 	class PluginTreeBuilder;
+	class PluginMetadataCache;
 
 	class PluginManager : public QAbstractItemModel
 						, public IPluginsManager
@@ -150,6 +151,12 @@ namespace LC
 		 */
 		void CheckPlugins ();
 
+		/** Removes from the list of plugins to be loaded those that are
+		 * known from the metadata cache to have unfulfilled dependencies,
+		 * so that their libraries aren't loaded at all.
+		 */
+		void DropUnfulfillable (const PluginMetadataCache&);
+
 		/** Fills the Plugins_ list with all instances, both from "real"
 		 * plugins and from adaptors.
 		 */
@@ -162,10 +169,18 @@ namespace LC
 
 		/** Tries to perform IInfo::Init() on plugins and returns the
 		 * first plugin that has failed to initialize. This function
-		 * stops initializing plugins upon first failure. If all plugins
+		 * stops scheduling new plugins upon first failure. If all plugins
 		 * were initialized successfully, this function returns NULL.
+		 *
+		 * The successfully initialized plugins are added to the passed
+		 * set.
+		 */
+		QObject* TryFirstInit (QObjectList, QSet<QObject*>&, PluginLoadProcess*);
+
+		/** Returns the plugins among the given ones whose initialization
+		 * may be performed outside of the GUI thread.
 		 */
-		QObject* TryFirstInit (QObjectList, PluginLoadProcess*);
+		QSet<QObject*> GetThreadSafeInits (const QObjectList&) const;
 
 		/** Plainly tries to find a corresponding QPluginLoader and
 		 * unload the corresponding library.
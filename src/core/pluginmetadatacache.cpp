@@ -0,0 +1,239 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "pluginmetadatacache.h"
+#include <algorithm>
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QSettings>
+#include <QtDebug>
+#include <interfaces/iinfo.h>
+#include <interfaces/iplugin2.h>
+#include <interfaces/ipluginready.h>
+#include <interfaces/ipluginadaptor.h>
+
+namespace LC
+{
+	namespace
+	{
+		QStringList ToStringList (const QSet<QByteArray>& set)
+		{
+			QStringList result;
+			for (const auto& item : set)
+				result << QString::fromUtf8 (item);
+			return result;
+		}
+
+		QSet<QByteArray> FromStringList (const QStringList& list)
+		{
+			QSet<QByteArray> result;
+			for (const auto& item : list)
+				result << item.toUtf8 ();
+			return result;
+		}
+	}
+
+	PluginMetadataCache::PluginMetadataCache ()
+	{
+		QSettings settings (QCoreApplication::organizationName (),
+				QCoreApplication::applicationName () + "-pgcache");
+		const auto size = settings.beginReadArray ("Plugins");
+		for (int i = 0; i < size; ++i)
+		{
+			settings.setArrayIndex (i);
+
+			Metadata md;
+			md.ID_ = settings.value ("ID").toByteArray ();
+			md.Name_ = settings.value ("Name").toString ();
+			md.Needs_ = settings.value ("Needs").toStringList ();
+			md.Uses_ = settings.value ("Uses").toStringList ();
+			md.Provides_ = settings.value ("Provides").toStringList ();
+			md.PluginClasses_ = FromStringList (settings.value ("PluginClasses").toStringList ());
+			md.ExpectedPluginClasses_ = FromStringList (settings.value ("ExpectedPluginClasses").toStringList ());
+			md.IsAdaptor_ = settings.value ("IsAdaptor").toBool ();
+
+			Entries_ [settings.value ("Path").toString ()] = Entry
+			{
+				settings.value ("MTime").toDateTime (),
+				settings.value ("Size").toLongLong (),
+				md
+			};
+		}
+		settings.endArray ();
+	}
+
+	PluginMetadataCache::~PluginMetadataCache ()
+	{
+		Save ();
+	}
+
+	std::optional<PluginMetadataCache::Metadata> PluginMetadataCache::Get (const QString& path) const
+	{
+		const auto pos = Entries_.find (path);
+		if (pos == Entries_.end ())
+			return {};
+
+		const QFileInfo fi { path };
+		if (fi.lastModified () != pos->MTime_ ||
+				fi.size () != pos->Size_)
+			return {};
+
+		return pos->Metadata_;
+	}
+
+	void PluginMetadataCache::Update (const QString& path, QObject *instance)
+	{
+		const auto ii = qobject_cast<IInfo*> (instance);
+		if (!ii)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< instance
+					<< "from"
+					<< path
+					<< "doesn't implement IInfo";
+			Remove (path);
+			return;
+		}
+
+		Metadata md;
+		md.ID_ = ii->GetUniqueID ();
+		md.Name_ = ii->GetName ();
+		md.Needs_ = ii->Needs ();
+		md.Uses_ = ii->Uses ();
+		md.Provides_ = ii->Provides ();
+		if (const auto ip2 = qobject_cast<IPlugin2*> (instance))
+			md.PluginClasses_ = ip2->GetPluginClasses ();
+		if (const auto ipr = qobject_cast<IPluginReady*> (instance))
+			md.ExpectedPluginClasses_ = ipr->GetExpectedPluginClasses ();
+		md.IsAdaptor_ = qobject_cast<IPluginAdaptor*> (instance);
+
+		const QFileInfo fi { path };
+		Entries_ [path] = Entry { fi.lastModified (), fi.size (), md };
+		IsDirty_ = true;
+	}
+
+	void PluginMetadataCache::Remove (const QString& path)
+	{
+		if (Entries_.remove (path))
+			IsDirty_ = true;
+	}
+
+	void PluginMetadataCache::Save ()
+	{
+		if (!IsDirty_)
+			return;
+
+		QSettings settings (QCoreApplication::organizationName (),
+				QCoreApplication::applicationName () + "-pgcache");
+		settings.remove ("Plugins");
+		settings.beginWriteArray ("Plugins", Entries_.size ());
+		int i = 0;
+		for (auto it = Entries_.begin (); it != Entries_.end (); ++it)
+		{
+			settings.setArrayIndex (i++);
+
+			const auto& md = it->Metadata_;
+			settings.setValue ("Path", it.key ());
+			settings.setValue ("MTime", it->MTime_);
+			settings.setValue ("Size", it->Size_);
+			settings.setValue ("ID", md.ID_);
+			settings.setValue ("Name", md.Name_);
+			settings.setValue ("Needs", md.Needs_);
+			settings.setValue ("Uses", md.Uses_);
+			settings.setValue ("Provides", md.Provides_);
+			settings.setValue ("PluginClasses", ToStringList (md.PluginClasses_));
+			settings.setValue ("ExpectedPluginClasses", ToStringList (md.ExpectedPluginClasses_));
+			settings.setValue ("IsAdaptor", md.IsAdaptor_);
+		}
+		settings.endArray ();
+
+		IsDirty_ = false;
+	}
+
+	QStringList PluginMetadataCache::GetUnfulfillable (const QStringList& paths,
+			const QSet<QByteArray>& extraExpected) const
+	{
+		QHash<QString, Metadata> alive;
+		for (const auto& path : paths)
+		{
+			const auto& md = Get (path);
+			if (!md || md->IsAdaptor_)
+				return {};
+
+			alive [path] = *md;
+		}
+
+		QStringList result;
+
+		/* This mirrors what PluginTreeBuilder does for the instances:
+		 * a plugin is fulfilled if all its needed features are provided
+		 * and all its plugin classes are expected by other fulfilled
+		 * plugins. Dropping a plugin may make others unfulfilled, so
+		 * iterate until nothing changes.
+		 */
+		bool changed = true;
+		while (changed)
+		{
+			changed = false;
+
+			QSet<QString> features;
+			auto expected = extraExpected;
+			for (const auto& md : alive)
+			{
+				features += QSet<QString>::fromList (md.Provides_);
+				expected += md.ExpectedPluginClasses_;
+			}
+
+			for (auto it = alive.begin (); it != alive.end (); )
+			{
+				const auto& md = *it;
+				const auto isFulfilled = std::all_of (md.Needs_.begin (), md.Needs_.end (),
+							[&features] (const QString& feature) { return features.contains (feature); }) &&
+						std::all_of (md.PluginClasses_.begin (), md.PluginClasses_.end (),
+							[&expected] (const QByteArray& pclass) { return expected.contains (pclass); });
+				if (isFulfilled)
+				{
+					++it;
+					continue;
+				}
+
+				qDebug () << Q_FUNC_INFO
+						<< md.Name_
+						<< "from"
+						<< it.key ()
+						<< "won't have its dependencies fulfilled, skipping it";
+				result << it.key ();
+				it = alive.erase (it);
+				changed = true;
+			}
+		}
+
+		return result;
+	}
+}
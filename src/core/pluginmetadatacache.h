@@ -0,0 +1,116 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <optional>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QDateTime>
+
+class QObject;
+
+namespace LC
+{
+	/** Caches the information about the plugins that otherwise requires
+	 * loading the plugin library and instantiating the plugin, so that
+	 * the libraries of the plugins that would fail to initialize anyway
+	 * because of unfulfilled dependencies aren't even loaded.
+	 *
+	 * The entries are keyed by the library path and are invalidated if
+	 * the modification time or the size of the library changes.
+	 */
+	class PluginMetadataCache
+	{
+	public:
+		struct Metadata
+		{
+			QByteArray ID_;
+			QString Name_;
+
+			QStringList Needs_;
+			QStringList Uses_;
+			QStringList Provides_;
+
+			QSet<QByteArray> PluginClasses_;
+			QSet<QByteArray> ExpectedPluginClasses_;
+
+			bool IsAdaptor_ = false;
+		};
+	private:
+		struct Entry
+		{
+			QDateTime MTime_;
+			qint64 Size_;
+			Metadata Metadata_;
+		};
+		QHash<QString, Entry> Entries_;
+		bool IsDirty_ = false;
+	public:
+		PluginMetadataCache ();
+		~PluginMetadataCache ();
+
+		PluginMetadataCache (const PluginMetadataCache&) = delete;
+		PluginMetadataCache& operator= (const PluginMetadataCache&) = delete;
+
+		/** Returns the cached metadata for the library at the given
+		 * path, if the library hasn't changed since it's been cached.
+		 */
+		std::optional<Metadata> Get (const QString& path) const;
+
+		/** Updates the metadata for the library at the given path from
+		 * the plugin instance loaded from it.
+		 */
+		void Update (const QString& path, QObject *instance);
+
+		/** Removes the entry for the given path, if any.
+		 */
+		void Remove (const QString& path);
+
+		/** Writes the changed entries, if any, to the persistent
+		 * storage. This is also done automatically on destruction.
+		 */
+		void Save ();
+
+		/** Returns the paths among the given ones whose plugins are
+		 * known not to have their dependencies fulfilled by the plugins
+		 * from the rest of the paths.
+		 *
+		 * The plugin classes from the additionally passed set are
+		 * considered to always be expected by some plugin.
+		 *
+		 * The check is conservative: if there is a path that has no
+		 * valid cache entry or whose plugin is an IPluginAdaptor, it
+		 * might provide anything, and an empty list is returned.
+		 */
+		QStringList GetUnfulfillable (const QStringList& paths,
+				const QSet<QByteArray>& extraExpected) const;
+	};
+}
@@ -182,6 +182,7 @@ namespace LC
 		Graph_.clear ();
 		Object2Vertex_.clear ();
 		Result_.clear ();
+		Dependencies_.clear ();
 
 		CreateGraph ();
 		const auto& edge2vert = MakeEdges ();
@@ -212,6 +213,14 @@ namespace LC
 		boost::topological_sort (fulfilledSubgraph, std::back_inserter (vertices));
 		for (const auto& vertex : vertices)
 			Result_ << fulfilledSubgraph [vertex].Object_;
+
+		for (const auto& pair : edge2vert)
+		{
+			const auto& dependent = Graph_ [pair.first];
+			const auto& dependency = Graph_ [pair.second];
+			if (dependent.IsFulfilled_ && dependency.IsFulfilled_)
+				Dependencies_ [dependent.Object_] << dependency.Object_;
+		}
 	}
 
 	QObjectList PluginTreeBuilder::GetResult () const
@@ -219,6 +228,11 @@ namespace LC
 		return Result_;
 	}
 
+	QHash<QObject*, QObjectList> PluginTreeBuilder::GetDependencies () const
+	{
+		return Dependencies_;
+	}
+
 	void PluginTreeBuilder::CreateGraph ()
 	{
 		for (const auto object : Instances_)
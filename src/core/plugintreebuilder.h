@@ -80,6 +80,7 @@ namespace LC
 
 		QHash<QObject*, Vertex_t> Object2Vertex_;
 		QObjectList Result_;
+		QHash<QObject*, QObjectList> Dependencies_;
 	public:
 		PluginTreeBuilder ();
 
@@ -87,6 +88,11 @@ namespace LC
 		void RemoveObject (QObject*);
 		void Calculate ();
 		QObjectList GetResult () const;
+
+		/** Returns the direct dependencies of each object in the result
+		 * of the last Calculate() call.
+		 */
+		QHash<QObject*, QObjectList> GetDependencies () const;
 	private:
 		void CreateGraph ();
 		QMap<Edge_t, QPair<Vertex_t, Vertex_t>> MakeEdges ();
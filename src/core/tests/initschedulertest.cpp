@@ -0,0 +1,183 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "initschedulertest.h"
+#include <memory>
+#include <vector>
+#include <QtTest>
+#include <QMutex>
+#include <QThread>
+#include <initscheduler.h>
+
+QTEST_GUILESS_MAIN (LC::InitSchedulerTest)
+
+namespace LC
+{
+	namespace
+	{
+		struct Graph
+		{
+			std::vector<std::unique_ptr<QObject>> Objects_;
+			QObjectList Ordered_;
+			QHash<QObject*, QObjectList> Deps_;
+
+			/* The objects are named by their indexes, and their
+			 * dependencies are given as lists of indexes. The dependencies
+			 * always precede the dependent objects, like in the list
+			 * computed by the plugin tree builder.
+			 */
+			Graph (const QList<QList<int>>& deps)
+			{
+				for (int i = 0; i < deps.size (); ++i)
+				{
+					Objects_.push_back (std::make_unique<QObject> ());
+
+					const auto obj = Objects_.back ().get ();
+					obj->setObjectName (QString::number (i));
+					Ordered_ << obj;
+
+					for (const auto dep : deps.at (i))
+						Deps_ [obj] << Ordered_.at (dep);
+				}
+			}
+
+			QObject* operator[] (int i) const
+			{
+				return Ordered_.at (i);
+			}
+		};
+
+		const QList<QList<int>> Diamond
+		{
+			{},
+			{ 0 },
+			{ 0 },
+			{ 1, 2 },
+			{},
+			{ 4, 3 }
+		};
+	}
+
+	void InitSchedulerTest::testDependencyOrder ()
+	{
+		const Graph graph { Diamond };
+
+		QMutex mutex;
+		QObjectList order;
+
+		const auto& result = RunInitScheduled (graph.Ordered_,
+				graph.Deps_,
+				{ graph [1], graph [2], graph [4] },
+				nullptr,
+				[&] (QObject *obj, bool)
+				{
+					QMutexLocker locker { &mutex };
+					for (const auto dep : graph.Deps_.value (obj))
+						if (!order.contains (dep))
+							return false;
+					order << obj;
+					return true;
+				});
+
+		QCOMPARE (result.Failed_, static_cast<QObject*> (nullptr));
+		QCOMPARE (result.Done_.size (), graph.Ordered_.size ());
+		QCOMPARE (order.size (), graph.Ordered_.size ());
+	}
+
+	void InitSchedulerTest::testThreads ()
+	{
+		const Graph graph { Diamond };
+		const QSet<QObject*> threadSafe { graph [1], graph [2], graph [4] };
+
+		QMutex mutex;
+		QHash<QObject*, bool> inGuiThread;
+		QHash<QObject*, bool> reportedWorker;
+
+		RunInitScheduled (graph.Ordered_,
+				graph.Deps_,
+				threadSafe,
+				nullptr,
+				[&] (QObject *obj, bool inWorker)
+				{
+					QMutexLocker locker { &mutex };
+					inGuiThread [obj] = QThread::currentThread () == qApp->thread ();
+					reportedWorker [obj] = inWorker;
+					return true;
+				});
+
+		for (const auto obj : graph.Ordered_)
+		{
+			QCOMPARE (inGuiThread.value (obj), !threadSafe.contains (obj));
+			QCOMPARE (reportedWorker.value (obj), threadSafe.contains (obj));
+		}
+	}
+
+	void InitSchedulerTest::testWorkerCallsGuiThread ()
+	{
+		const Graph graph { { {}, {}, { 0 } } };
+
+		QObject guiObject;
+		bool calledInGuiThread = false;
+
+		const auto& result = RunInitScheduled (graph.Ordered_,
+				graph.Deps_,
+				{ graph [0] },
+				nullptr,
+				[&] (QObject *obj, bool inWorker)
+				{
+					if (!inWorker)
+						return true;
+
+					// Would deadlock if the GUI thread was blocked waiting
+					// for the workers.
+					QMetaObject::invokeMethod (&guiObject,
+							[&] { calledInGuiThread = QThread::currentThread () == qApp->thread (); },
+							Qt::BlockingQueuedConnection);
+					return obj == graph [0];
+				});
+
+		QVERIFY (calledInGuiThread);
+		QCOMPARE (result.Done_.size (), 3);
+	}
+
+	void InitSchedulerTest::testFailure ()
+	{
+		const Graph graph { Diamond };
+
+		const auto& result = RunInitScheduled (graph.Ordered_,
+				graph.Deps_,
+				{ graph [1], graph [2] },
+				nullptr,
+				[&] (QObject *obj, bool) { return obj != graph [1]; });
+
+		QCOMPARE (result.Failed_, graph [1]);
+		QVERIFY (!result.Done_.contains (graph [3]));
+		QVERIFY (!result.Done_.contains (graph [5]));
+	}
+}
@@ -0,0 +1,178 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "networkinstrumentationtest.h"
+#include <QtTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <networkinstrumentation.h>
+
+QTEST_GUILESS_MAIN (LC::NetworkInstrumentationTest)
+
+namespace LC
+{
+	namespace
+	{
+		const QByteArray Body = "hello, world";
+
+		/* Answers every request with the same small plain text
+		 * response and closes the connection.
+		 */
+		class Server : public QTcpServer
+		{
+		public:
+			Server ()
+			{
+				connect (this,
+						&QTcpServer::newConnection,
+						this,
+						[this]
+						{
+							while (const auto socket = nextPendingConnection ())
+								connect (socket,
+										&QTcpSocket::readyRead,
+										socket,
+										[socket] { HandleRead (socket); });
+						});
+			}
+		private:
+			static void HandleRead (QTcpSocket *socket)
+			{
+				const auto request = socket->property ("Buffer").toByteArray () + socket->readAll ();
+				socket->setProperty ("Buffer", request);
+				if (!request.contains ("\r\n\r\n"))
+					return;
+
+				socket->write ("HTTP/1.1 200 OK\r\n"
+						"Content-Type: text/plain\r\n"
+						"Content-Length: " + QByteArray::number (Body.size ()) + "\r\n"
+						"Connection: close\r\n"
+						"\r\n" + Body);
+				socket->disconnectFromHost ();
+			}
+		};
+
+		QJsonArray DumpEntries (const NetworkInstrumentation& instr, const QString& path)
+		{
+			if (!instr.DumpHar (path))
+				return {};
+
+			QFile file { path };
+			if (!file.open (QIODevice::ReadOnly))
+				return {};
+
+			return QJsonDocument::fromJson (file.readAll ()).object ()
+					["log"].toObject () ["entries"].toArray ();
+		}
+
+		bool RunTracked (NetworkInstrumentation& instr, const QUrl& url)
+		{
+			QNetworkAccessManager nam;
+			const QNetworkRequest req { url };
+			const auto reply = nam.get (req);
+			instr.Track (QNetworkAccessManager::GetOperation, req, nullptr, reply);
+
+			QSignalSpy spy { reply, &QNetworkReply::finished };
+			return spy.wait ();
+		}
+	}
+
+	void NetworkInstrumentationTest::testHarEntry ()
+	{
+		Server server;
+		QVERIFY (server.listen (QHostAddress::LocalHost));
+
+		QUrl url { "http://127.0.0.1/path?key=value" };
+		url.setPort (server.serverPort ());
+
+		QTemporaryDir dir;
+		NetworkInstrumentation instr { dir.filePath ("session.har") };
+		QVERIFY (RunTracked (instr, url));
+
+		const auto& entries = DumpEntries (instr, dir.filePath ("dump.har"));
+		QCOMPARE (entries.size (), 1);
+
+		const auto& entry = entries.at (0).toObject ();
+		QCOMPARE (entry ["_plugin"].toString (), QString { "unknown" });
+		QVERIFY (!entry.contains ("_error"));
+
+		const auto& request = entry ["request"].toObject ();
+		QCOMPARE (request ["method"].toString (), QString { "GET" });
+		QCOMPARE (request ["url"].toString (), url.toString ());
+		QCOMPARE (request ["queryString"].toArray ().size (), 1);
+
+		const auto& response = entry ["response"].toObject ();
+		QCOMPARE (response ["status"].toInt (), 200);
+		QCOMPARE (response ["statusText"].toString (), QString { "OK" });
+
+		const auto& content = response ["content"].toObject ();
+		QCOMPARE (content ["size"].toInt (), Body.size ());
+		QCOMPARE (content ["mimeType"].toString (), QString { "text/plain" });
+
+		const auto& timings = entry ["timings"].toObject ();
+		QVERIFY (timings ["wait"].toInt () >= 0);
+		QCOMPARE (timings ["wait"].toInt () + timings ["receive"].toInt (), entry ["time"].toInt ());
+
+		const auto& stats = instr.GetStats ();
+		QCOMPARE (stats.size (), 1);
+		QCOMPARE (stats ["unknown"].Requests_, 1);
+		QCOMPARE (stats ["unknown"].Failed_, 0);
+		QCOMPARE (stats ["unknown"].BytesReceived_, static_cast<qint64> (Body.size ()));
+	}
+
+	void NetworkInstrumentationTest::testFailedRequest ()
+	{
+		QUrl url { "http://127.0.0.1/" };
+		{
+			// Grab a free port and release it, so that the connection gets refused.
+			QTcpServer server;
+			QVERIFY (server.listen (QHostAddress::LocalHost));
+			url.setPort (server.serverPort ());
+		}
+
+		QTemporaryDir dir;
+		NetworkInstrumentation instr { dir.filePath ("session.har") };
+		QVERIFY (RunTracked (instr, url));
+
+		const auto& entries = DumpEntries (instr, dir.filePath ("dump.har"));
+		QCOMPARE (entries.size (), 1);
+
+		const auto& entry = entries.at (0).toObject ();
+		QVERIFY (!entry ["_error"].toString ().isEmpty ());
+		QCOMPARE (entry ["response"].toObject () ["status"].toInt (), 0);
+
+		QCOMPARE (instr.GetStats () ["unknown"].Failed_, 1);
+	}
+}
@@ -64,6 +64,21 @@ typedef std::shared_ptr<ICoreProxy> ICoreProxy_ptr;
  * plugin depends on others - move it to SecondInit(), leaving in Init()
  * only basic initialization/allocation stuff like allocation memory for
  * the objects.
+ *
+ * Plugins whose Init() and SecondInit() may safely be called from a
+ * thread other than the GUI one may declare that by setting the
+ * "ThreadSafeInit" key to true in their JSON manifest (passed via
+ * Q_PLUGIN_METADATA). Such plugins are initialized in a thread pool,
+ * concurrently with other plugins that neither depend on them nor are
+ * depended upon. These plugins must not create widgets and must not
+ * create QObjects with parents living in other threads. The GUI thread
+ * keeps processing events while waiting for them, so they may use queued
+ * or blocking queued calls to run something in the GUI thread. Keep in
+ * mind that QObjects created in Init() or SecondInit() of such plugins
+ * live in the worker thread unless moved to the GUI thread explicitly.
+ *
+ * Setting the LC_SERIAL_PLUGIN_INIT environment variable to 1 disables
+ * this and initializes all plugins in the GUI thread.
  */
 class Q_DECL_EXPORT IInfo
 {
@@ -45,6 +45,7 @@
 #include <QMimeData>
 #include <QToolBar>
 #include <QUrlQuery>
+#include <QTimer>
 #include <util/compat/fontwidth.h>
 #include <util/compat/screengeometry.h>
 #include <util/xpc/defaulthookproxy.h>
@@ -110,6 +111,16 @@ namespace LC
 {
 namespace Azoth
 {
+	namespace
+	{
+		/** The number of messages kept in the chat view DOM, and the
+		 * number of messages the view is expanded by on scroll-back.
+		 */
+		const int DOMWindowSize = 300;
+
+		const int FrameTickMs = 16;
+	}
+
 	QObject *ChatTab::S_ParentMultiTabs_ = 0;
 	TabClassInfo ChatTab::S_ChatTabClass_;
 	TabClassInfo ChatTab::S_MUCTabClass_;
@@ -154,6 +165,7 @@ namespace Azoth
 	, BgColor_ (QApplication::palette ().color (QPalette::Base))
 	, NumUnreadMsgs_ (Core::Instance ().GetUnreadCount (GetEntry<ICLEntry> ()))
 	, CDF_ (new ContactDropFilter (entryId, this))
+	, DOMWindow_ (DOMWindowSize)
 	{
 		Ui_.setupUi (this);
 		fontsWidget->RegisterSettable (this);
@@ -163,7 +175,11 @@ namespace Azoth
 		Ui_.View_->installEventFilter (Util::MakeLambdaEventFilter ([this, fontsWidget] (QWheelEvent *e)
 				{
 					if (!(e->modifiers () & Qt::ControlModifier))
+					{
+						if (e->delta () > 0)
+							ExpandViewWindow ();
 						return false;
+					}
 
 					int degrees = e->delta () / 8;
 					int steps = static_cast<qreal> (degrees) / 15;
@@ -302,6 +318,8 @@ namespace Azoth
 
 	void ChatTab::PrepareTheme ()
 	{
+		PendingMessages_.clear ();
+
 		const auto entry = GetEntry<QObject> ();
 		auto data = Core::Instance ().GetSelectedChatTemplate (entry,
 				Ui_.View_->page ()->mainFrame ());
@@ -742,28 +760,27 @@ namespace Azoth
 
 	void ChatTab::on_View__loadFinished (bool)
 	{
-		for (const auto msg : HistoryMessages_)
-			AppendMessage (msg);
+		// The pending messages are already in the entry's messages list.
+		PendingMessages_.clear ();
 
-		ICLEntry *e = GetEntry<ICLEntry> ();
-		if (!e)
+		if (!GetEntry<ICLEntry> ())
 		{
 			qWarning () << Q_FUNC_INFO
 					<< "null entry";
 			return;
 		}
 
-		auto messages = e->GetAllMessages ();
+		const auto& messages = GetViewMessages ();
 
-		const auto& dummyMsgs = DummyMsgManager::Instance ().GetIMessages (e->GetQObject ());
-		if (!dummyMsgs.isEmpty ())
-		{
-			messages += dummyMsgs;
-			std::sort (messages.begin (), messages.end (), Util::ComparingBy (&IMessage::GetDateTime));
-		}
+		// Only the last DOMWindow_ messages are put into the DOM, the
+		// older ones are prepended lazily as the user scrolls back.
+		HiddenMessagesCount_ = std::max (messages.size () - DOMWindow_, 0);
+		DOMEntries_.clear ();
 
-		for (const auto msg : messages)
-			AppendMessage (msg);
+		IChatStyleResourceSource::MessagesBatch_t batch;
+		for (const auto msg : messages.mid (HiddenMessagesCount_))
+			AddToDOMBatch (msg, batch);
+		AppendBatch (batch);
 
 		QFile scrollerJS (":/plugins/azoth/resources/scripts/scrollers.js");
 		if (!scrollerJS.open (QIODevice::ReadOnly))
@@ -776,10 +793,39 @@ namespace Azoth
 			Ui_.View_->page ()->mainFrame ()->evaluateJavaScript ("InstallEventListeners(); ScrollToBottom();");
 		}
 
+		if (RestoreScrollHeight_)
+		{
+			// Keep the messages that were at the top of the view before
+			// expanding it at the same position.
+			const auto frame = Ui_.View_->page ()->mainFrame ();
+			frame->evaluateJavaScript ("window.ShouldScroll = false;");
+			frame->setScrollPosition ({ 0, frame->contentsSize ().height () - RestoreScrollHeight_ });
+			RestoreScrollHeight_ = 0;
+		}
+
 		emit hookThemeReloaded (Util::DefaultHookProxy_ptr (new Util::DefaultHookProxy),
 				this, Ui_.View_, GetEntry<QObject> ());
 	}
 
+	void ChatTab::flushPendingMessages ()
+	{
+		IsFlushScheduled_ = false;
+
+		const auto pending = PendingMessages_;
+		PendingMessages_.clear ();
+
+		IChatStyleResourceSource::MessagesBatch_t batch;
+		for (const auto& msgObj : pending)
+			if (const auto msg = qobject_cast<IMessage*> (msgObj))
+				AddToDOMBatch (msg, batch);
+		AppendBatch (batch);
+
+		// Drop the old messages from the DOM once there are too many of
+		// them, unless the user is reading the history.
+		if (DOMEntries_.size () > DOMWindow_ + DOMWindowSize && IsViewAtBottom ())
+			ShrinkViewWindow ();
+	}
+
 #ifdef ENABLE_MEDIACALLS
 	void ChatTab::handleCallRequested ()
 	{
@@ -852,11 +898,19 @@ namespace Azoth
 		CoreMessages_.clear ();
 		DummyMsgManager::Instance ().ClearMessages (GetCLEntry ());
 		LastDateTime_ = QDateTime ();
+		DOMWindow_ = DOMWindowSize;
 		PrepareTheme ();
 	}
 
 	void ChatTab::handleHistoryBack ()
 	{
+		if (HiddenMessagesCount_)
+		{
+			Ui_.View_->page ()->mainFrame ()->setScrollPosition ({ 0, 0 });
+			ExpandViewWindow ();
+			return;
+		}
+
 		ScrollbackPos_ += 50;
 		qDeleteAll (HistoryMessages_);
 		HistoryMessages_.clear ();
@@ -1070,7 +1124,7 @@ namespace Azoth
 				Ui_.VariantBox_->setCurrentIndex (idx);
 		}
 
-		AppendMessage (msg);
+		EnqueueMessage (msg);
 	}
 
 	void ChatTab::handleVariantsChanged (QStringList variants)
@@ -1830,7 +1884,48 @@ namespace Azoth
 		}
 	}
 
-	void ChatTab::AppendMessage (IMessage *msg)
+	QList<IMessage*> ChatTab::GetViewMessages () const
+	{
+		const auto e = GetEntry<ICLEntry> ();
+		if (!e)
+			return HistoryMessages_;
+
+		auto messages = e->GetAllMessages ();
+
+		const auto& dummyMsgs = DummyMsgManager::Instance ().GetIMessages (e->GetQObject ());
+		if (!dummyMsgs.isEmpty ())
+		{
+			messages += dummyMsgs;
+			std::sort (messages.begin (), messages.end (), Util::ComparingBy (&IMessage::GetDateTime));
+		}
+
+		return HistoryMessages_ + messages;
+	}
+
+	void ChatTab::AddDateSeparator (const QDateTime& msgDateTime, QObject *parent,
+			IChatStyleResourceSource::MessagesBatch_t& batch)
+	{
+		auto datetime = msgDateTime;
+		const auto& thisDate = datetime.date ();
+		const auto& str = QLocale ().toString (thisDate, QLocale::LongFormat);
+
+		datetime.setTime ({0, 0});
+
+		auto coreMessage = new CoreMessage (str, datetime,
+				IMessage::Type::ServiceMessage, IMessage::Direction::In, parent, this);
+		ChatMsgAppendInfo coreInfo
+		{
+			false,
+			Core::Instance ().GetChatTabsManager ()->IsActiveChat (GetEntry<ICLEntry> ()),
+			ToggleRichText_->isChecked (),
+			Account_
+		};
+		batch.append ({ coreMessage, coreInfo });
+		CoreMessages_ << coreMessage;
+	}
+
+	void ChatTab::AddToBatch (IMessage *msg, IChatStyleResourceSource::MessagesBatch_t& batch,
+			QDateTime& lastDateTime, bool scrollback)
 	{
 		auto other = qobject_cast<ICLEntry*> (msg->OtherPart ());
 
@@ -1880,41 +1975,24 @@ namespace Azoth
 				(msg->GetMessageType () != IMessage::Type::MUCMessage &&
 					msg->GetMessageType () != IMessage::Type::ServiceMessage))
 		{
-			const auto& dt = msg->GetDateTime ().toString ("HH:mm:ss.zzz");
-			MUCEventLog_->append (QString ("<font color=\"#56ED56\">[%1] %2</font>")
-						.arg (dt)
-						.arg (msg->GetEscapedBody ()));
+			if (!scrollback)
+			{
+				const auto& dt = msg->GetDateTime ().toString ("HH:mm:ss.zzz");
+				MUCEventLog_->append (QString ("<font color=\"#56ED56\">[%1] %2</font>")
+							.arg (dt)
+							.arg (msg->GetEscapedBody ()));
+			}
 			if (msg->GetMessageSubType () != IMessage::SubType::RoomSubjectChange)
 				return;
 		}
 
-		QWebFrame *frame = Ui_.View_->page ()->mainFrame ();
-
 		const bool isActiveChat = Core::Instance ()
 				.GetChatTabsManager ()->IsActiveChat (GetEntry<ICLEntry> ());
 
-		if (!LastDateTime_.isNull () && !IsSameDay (LastDateTime_, msg) && parent)
-		{
-			auto datetime = msg->GetDateTime ();
-			const auto& thisDate = datetime.date ();
-			const auto& str = QLocale ().toString (thisDate, QLocale::LongFormat);
-
-			datetime.setTime ({0, 0});
-
-			auto coreMessage = new CoreMessage (str, datetime,
-					IMessage::Type::ServiceMessage, IMessage::Direction::In, parent->GetQObject (), this);
-			ChatMsgAppendInfo coreInfo
-			{
-				false,
-				isActiveChat,
-				ToggleRichText_->isChecked (),
-				Account_
-			};
-			Core::Instance ().AppendMessageByTemplate (frame, coreMessage, coreInfo);
-			CoreMessages_ << coreMessage;
-		}
+		if (!lastDateTime.isNull () && !IsSameDay (lastDateTime, msg) && parent)
+			AddDateSeparator (msg->GetDateTime (), parent->GetQObject (), batch);
 
-		LastDateTime_ = msg->GetDateTime ();
+		lastDateTime = msg->GetDateTime ();
 
 		ChatMsgAppendInfo info
 		{
@@ -1924,14 +2002,145 @@ namespace Azoth
 			Account_
 		};
 
-		const auto& links = FormatterProxyObject {}.FindLinks (msg->GetBody ());
-		if (!links.isEmpty ())
-			LastLink_ = links.last ();
+		if (!scrollback)
+		{
+			const auto& links = FormatterProxyObject {}.FindLinks (msg->GetBody ());
+			if (!links.isEmpty ())
+				LastLink_ = links.last ();
+		}
 
-		if (!Core::Instance ().AppendMessageByTemplate (frame,
-				msg->GetQObject (), info))
+		batch.append ({ msg->GetQObject (), info });
+	}
+
+	void ChatTab::AppendBatch (const IChatStyleResourceSource::MessagesBatch_t& batch)
+	{
+		if (!Core::Instance ().AppendMessagesByTemplate (Ui_.View_->page ()->mainFrame (),
+				GetEntry<QObject> (), batch))
 			qWarning () << Q_FUNC_INFO
-					<< "unhandled append message :(";
+					<< "unhandled append messages :(";
+	}
+
+	void ChatTab::AddToDOMBatch (IMessage *msg, IChatStyleResourceSource::MessagesBatch_t& batch)
+	{
+		const auto prevSize = batch.size ();
+		AddToBatch (msg, batch, LastDateTime_, false);
+		DOMEntries_.append (batch.size () - prevSize);
+	}
+
+	void ChatTab::EnqueueMessage (IMessage *msg)
+	{
+		PendingMessages_ << msg->GetQObject ();
+
+		if (IsFlushScheduled_)
+			return;
+
+		IsFlushScheduled_ = true;
+		QTimer::singleShot (FrameTickMs,
+				this,
+				SLOT (flushPendingMessages ()));
+	}
+
+	bool ChatTab::ExpandViewWindow ()
+	{
+		if (!HiddenMessagesCount_ || RestoreScrollHeight_)
+			return false;
+
+		const auto frame = Ui_.View_->page ()->mainFrame ();
+		if (frame->scrollPosition ().y () > 0)
+			return false;
+
+		const auto& messages = GetViewMessages ();
+		const auto hidden = std::min (HiddenMessagesCount_, messages.size ());
+		const auto count = std::min (hidden, DOMWindowSize);
+		const auto& slice = messages.mid (hidden - count, count);
+
+		IChatStyleResourceSource::MessagesBatch_t batch;
+		QList<int> entries;
+		QDateTime lastDateTime;
+		for (const auto msg : slice)
+		{
+			const auto prevSize = batch.size ();
+			AddToBatch (msg, batch, lastDateTime, true);
+			entries << batch.size () - prevSize;
+		}
+
+		// The first message already in the view might need a date
+		// separator now that it has a predecessor, unless it still has
+		// the one it has been appended with.
+		bool headSeparator = false;
+		if (hidden < messages.size () && !lastDateTime.isNull () &&
+				(DOMEntries_.isEmpty () || DOMEntries_.first () < 2))
+		{
+			const auto next = messages.at (hidden);
+			if (!IsSameDay (lastDateTime, next))
+				if (const auto parent = next->ParentCLEntry ())
+				{
+					AddDateSeparator (next->GetDateTime (), parent, batch);
+					headSeparator = true;
+				}
+		}
+
+		const auto heightScript = "document.documentElement.scrollHeight";
+		const auto oldHeight = frame->evaluateJavaScript (heightScript).toInt ();
+
+		DOMWindow_ += DOMWindowSize;
+		if (!Core::Instance ().PrependMessagesByTemplate (frame, GetEntry<QObject> (), batch))
+		{
+			// The style doesn't support inserting messages before the
+			// existing ones, so reload the view with the larger window.
+			RestoreScrollHeight_ = std::max (frame->contentsSize ().height (), 1);
+			LastDateTime_ = QDateTime ();
+			PrepareTheme ();
+			return true;
+		}
+
+		HiddenMessagesCount_ = hidden - count;
+		if (headSeparator && !DOMEntries_.isEmpty ())
+			++DOMEntries_.first ();
+		DOMEntries_ = entries + DOMEntries_;
+
+		// Keep the messages that were at the top of the view before
+		// expanding it at the same position.
+		const auto newHeight = frame->evaluateJavaScript (heightScript).toInt ();
+		frame->evaluateJavaScript ("window.ShouldScroll = false;");
+		frame->setScrollPosition ({ 0, newHeight - oldHeight });
+		return true;
+	}
+
+	void ChatTab::ShrinkViewWindow ()
+	{
+		DOMWindow_ = DOMWindowSize;
+
+		const auto toRemove = DOMEntries_.size () - DOMWindowSize;
+		int entries = 0;
+		for (int i = 0; i < toRemove; ++i)
+			entries += DOMEntries_.at (i);
+
+		auto removed = Core::Instance ().RemoveFirstMessagesByTemplate (Ui_.View_->page ()->mainFrame (),
+				GetEntry<QObject> (), entries);
+		if (removed < 0)
+		{
+			// The style can't remove messages, so reload the view with
+			// the last messages.
+			LastDateTime_ = QDateTime ();
+			PrepareTheme ();
+			return;
+		}
+
+		// A message is hidden once all its entries are gone, the
+		// partially removed one stays the first message in the view.
+		while (!DOMEntries_.isEmpty () && DOMEntries_.first () <= removed)
+		{
+			removed -= DOMEntries_.takeFirst ();
+			++HiddenMessagesCount_;
+		}
+		if (!DOMEntries_.isEmpty ())
+			DOMEntries_.first () -= removed;
+	}
+
+	bool ChatTab::IsViewAtBottom () const
+	{
+		return Ui_.View_->page ()->mainFrame ()->evaluateJavaScript ("window.ShouldScroll").toBool ();
 	}
 
 	QString ChatTab::ReformatTitle ()
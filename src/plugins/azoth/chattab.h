@@ -40,6 +40,7 @@
 #include <interfaces/ihaverecoverabletabs.h>
 #include <interfaces/iwkfontssettable.h>
 #include "interfaces/azoth/azothcommon.h"
+#include "interfaces/azoth/ichatstyleresourcesource.h"
 #include "ui_chattab.h"
 
 class QTextBrowser;
@@ -108,6 +109,18 @@ namespace Azoth
 		QDateTime LastDateTime_;
 		QList<CoreMessage*> CoreMessages_;
 
+		QList<QPointer<QObject>> PendingMessages_;
+		bool IsFlushScheduled_ = false;
+
+		int DOMWindow_;
+		/** The number of style source messages (including the date
+		 * separators) each of the view messages in the DOM has produced,
+		 * in the display order.
+		 */
+		QList<int> DOMEntries_;
+		int HiddenMessagesCount_ = 0;
+		int RestoreScrollHeight_ = 0;
+
 		QIcon TabIcon_;
 		bool IsMUC_ = false;
 		int PreviousTextHeight_ = 0;
@@ -204,6 +217,7 @@ namespace Azoth
 		void on_SubjectButton__toggled (bool);
 		void on_SubjChange__released ();
 		void on_View__loadFinished (bool);
+		void flushPendingMessages ();
 		void handleHistoryBack ();
 		void handleRichEditorToggled ();
 		void handleRichTextToggled ();
@@ -256,9 +270,41 @@ namespace Azoth
 
 		void UpdateTextHeight ();
 
-		/** Appends the message to the message view area.
+		/** Returns the messages to be shown in the view, including the
+		 * ones hidden from the DOM, ordered by their date.
+		 */
+		QList<IMessage*> GetViewMessages () const;
+
+		/** Adds the message to the batch of messages to be inserted
+		 * into the message view area, preceding it with a date separator
+		 * if the message is from a different day than lastDateTime.
+		 *
+		 * If scrollback is true, the message is being restored to the
+		 * view as the user scrolls back, so side effects like updating
+		 * the MUC event log are skipped.
+		 */
+		void AddToBatch (IMessage*, IChatStyleResourceSource::MessagesBatch_t&,
+				QDateTime& lastDateTime, bool scrollback);
+		void AddDateSeparator (const QDateTime&, QObject*,
+				IChatStyleResourceSource::MessagesBatch_t&);
+		void AppendBatch (const IChatStyleResourceSource::MessagesBatch_t&);
+		void AddToDOMBatch (IMessage*, IChatStyleResourceSource::MessagesBatch_t&);
+
+		/** Queues the message to be appended to the message view area
+		 * along with other messages arriving during the same frame tick.
+		 */
+		void EnqueueMessage (IMessage*);
+
+		/** Puts more of the messages that were dropped from the view
+		 * back, if the view is scrolled to the top.
+		 */
+		bool ExpandViewWindow ();
+
+		/** Drops the oldest messages from the view, leaving the last
+		 * DOMWindowSize ones.
 		 */
-		void AppendMessage (IMessage*);
+		void ShrinkViewWindow ();
+		bool IsViewAtBottom () const;
 
 		/** Updates the tab icon and other usages of state icon from the
 		 * TabIcon_.
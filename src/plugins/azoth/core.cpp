@@ -40,6 +40,7 @@
 #include <QStringListModel>
 #include <QMessageBox>
 #include <QClipboard>
+#include <QTimer>
 #include <QtDebug>
 #include <util/util.h>
 #include <util/compat/imagebytes.h>
@@ -73,6 +74,7 @@
 #include "interfaces/azoth/iextselfinfoaccount.h"
 #include "interfaces/azoth/ihistoryplugin.h"
 #include "interfaces/azoth/icanhavesslerrors.h"
+#include "interfaces/azoth/iprovidebodytransformers.h"
 
 #ifdef ENABLE_CRYPT
 #include "cryptomanager.h"
@@ -104,6 +106,7 @@
 #include "avatarsmanager.h"
 #include "historysyncer.h"
 #include "sslerrorshandler.h"
+#include "rosterstate.h"
 
 Q_DECLARE_METATYPE (QPointer<QObject>);
 
@@ -246,6 +249,18 @@ namespace LC::Azoth
 				this, "updateStatusIconset");
 		XmlSettingsManager::Instance ().RegisterObject ("GroupContacts",
 				this, "handleGroupContactsChanged");
+		XmlSettingsManager::Instance ().RegisterObject ({
+					"SmileIcons",
+					"RequireSpaceBeforeSmiles",
+					"HighlightNicksInBody",
+					"HighlightNicksInBodyAlphaReduction",
+					"ShortenURLLength",
+					"ShowRichImagesAsLinks",
+					"LimitMaxImageSize",
+					"MaxImageWidth",
+					"MaxImageHeight"
+				},
+				this, "clearFormattedBodies");
 	}
 
 	Core& Core::Instance ()
@@ -385,6 +400,16 @@ namespace LC::Azoth
 
 		if (const auto ihp = qobject_cast<IHistoryPlugin*> (plugin))
 			HistorySyncer_->AddStorage (ihp);
+
+		if (const auto ipbt = qobject_cast<IProvideBodyTransformers*> (plugin))
+		{
+			BodyTransformersProviders_ << ipbt;
+			connect (plugin,
+					SIGNAL (bodyTransformersChanged ()),
+					this,
+					SLOT (rebuildBodyTransformers ()));
+			rebuildBodyTransformers ();
+		}
 	}
 
 	void Core::RegisterHookable (QObject *object)
@@ -782,6 +807,53 @@ namespace LC::Azoth
 		return src->AppendMessage (frame, message, info);
 	}
 
+	bool Core::AppendMessagesByTemplate (QWebFrame *frame, QObject *entry,
+			const IChatStyleResourceSource::MessagesBatch_t& messages)
+	{
+		if (messages.isEmpty ())
+			return true;
+
+		IChatStyleResourceSource *src = GetCurrentChatStyle (entry);
+		if (!src)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "empty result for"
+					<< entry;
+			return false;
+		}
+
+		return src->AppendMessages (frame, messages);
+	}
+
+	bool Core::PrependMessagesByTemplate (QWebFrame *frame, QObject *entry,
+			const IChatStyleResourceSource::MessagesBatch_t& messages)
+	{
+		IChatStyleResourceSource *src = GetCurrentChatStyle (entry);
+		if (!src)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "empty result for"
+					<< entry;
+			return false;
+		}
+
+		return src->PrependMessages (frame, messages);
+	}
+
+	int Core::RemoveFirstMessagesByTemplate (QWebFrame *frame, QObject *entry, int count)
+	{
+		IChatStyleResourceSource *src = GetCurrentChatStyle (entry);
+		if (!src)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "empty result for"
+					<< entry;
+			return -1;
+		}
+
+		return src->RemoveFirstMessages (frame, count);
+	}
+
 	void Core::FrameFocused (QObject *entry, QWebFrame *frame)
 	{
 		IChatStyleResourceSource *src = GetCurrentChatStyle (entry);
@@ -841,41 +913,33 @@ namespace LC::Azoth
 
 	namespace
 	{
-		bool IsInsideTag (const QString& body, int pos)
+		QStringList GetParticipantsNicks (IMessage *msg)
 		{
-			const auto prevOpen = body.lastIndexOf ('<', pos - 1);
-			const auto nextClose = body.indexOf ('>', pos + 1);
-
-			if (prevOpen == -1 || nextClose == -1)
-				return false;
-
-			const auto prevClose = body.lastIndexOf ('>', pos - 1);
-			const auto nextOpen = body.indexOf ('<', pos + 1);
+			const auto entry = qobject_cast<IMUCEntry*> (msg->ParentCLEntry ());
+			if (!entry)
+				return {};
 
-			return prevClose < prevOpen || nextClose < nextOpen;
+			return Util::Map (entry->GetParticipants (),
+					[] (QObject *obj) { return qobject_cast<ICLEntry*> (obj)->GetEntryName (); });
 		}
 
-		void HighlightNicks (QString& body, IMessage *msg, const QList<QColor>& colors)
+		void HighlightNicks (BodySpans_t& body, const QStringList& nicks, const QList<QColor>& colors)
 		{
-			const auto entry = qobject_cast<IMUCEntry*> (msg->ParentCLEntry ());
-			if (!entry)
+			if (nicks.isEmpty ())
 				return;
 
 			const auto intensity = XmlSettingsManager::Instance ()
 					.property ("HighlightNicksInBodyAlphaReduction").toInt ();
 
-			const auto& nicks = Util::Map (entry->GetParticipants (),
-					[] (QObject *obj) { return qobject_cast<ICLEntry*> (obj)->GetEntryName (); });
-			for (const auto& nick : nicks)
+			QHash<QString, QString> nick2color;
+			auto getColor = [&] (const QString& nick)
 			{
-				if (!body.contains (nick))
-					continue;
+				const auto pos = nick2color.find (nick);
+				if (pos != nick2color.end ())
+					return *pos;
 
 				auto nickColor = GetNickColor (nick, colors);
-				if (nickColor.isNull ())
-					continue;
-
-				if (intensity != 100)
+				if (!nickColor.isNull () && intensity != 100)
 				{
 					QColor color { nickColor };
 					nickColor = QString ("rgba(%1, %2, %3, %4)")
@@ -884,30 +948,54 @@ namespace LC::Azoth
 							.arg (color.blue ())
 							.arg (intensity / 100.);
 				}
+				nick2color [nick] = nickColor;
+				return nickColor;
+			};
 
-				auto isGoodChar = [] (const QChar& c) { return c.isSpace () || c.isPunct (); };
+			auto isGoodChar = [] (const QChar& c) { return c.isSpace () || c.isPunct (); };
 
-				int pos = 0;
-				while ((pos = body.indexOf (nick, pos)) >= 0)
-				{
-					const auto posG = Util::MakeScopeGuard ([&pos, &nick] { pos += nick.size (); });
+			TransformTextSpans (body,
+					[&] (const QString& text)
+					{
+						QString result;
+						for (const auto& nick : nicks)
+						{
+							const auto& source = result.isNull () ? text : result;
+							if (nick.isEmpty () || !source.contains (nick))
+								continue;
 
-					if (IsInsideTag (body, pos))
-						continue;
+							const auto& nickColor = getColor (nick);
+							if (nickColor.isNull ())
+								continue;
 
-					const auto nickEnd = pos + nick.size ();
-					if ((pos > 0 && !isGoodChar (body.at (pos - 1))) ||
-						(nickEnd + 1 < body.size () && !isGoodChar (body.at (nickEnd))))
-						continue;
+							auto str = source;
+							int pos = 0;
+							while ((pos = str.indexOf (nick, pos)) >= 0)
+							{
+								const auto posG = Util::MakeScopeGuard ([&pos, &nick] { pos += nick.size (); });
 
-					const auto& startStr = "<span style='color: " + nickColor + "'>";
-					const QString endStr { "</span>" };
-					body.insert (nickEnd, endStr);
-					body.insert (pos, startStr);
+								// The previous nicks have already inserted their spans.
+								if (str.lastIndexOf ('<', pos) > str.lastIndexOf ('>', pos))
+									continue;
 
-					pos += startStr.size () + endStr.size ();
-				}
-			}
+								const auto nickEnd = pos + nick.size ();
+								if ((pos > 0 && !isGoodChar (str.at (pos - 1))) ||
+									(nickEnd + 1 < str.size () && !isGoodChar (str.at (nickEnd))))
+									continue;
+
+								const auto& startStr = "<span style='color: " + nickColor + "'>";
+								const QString endStr { "</span>" };
+								str.insert (nickEnd, endStr);
+								str.insert (pos, startStr);
+
+								pos += startStr.size () + endStr.size ();
+							}
+
+							if (str != source)
+								result = str;
+						}
+						return result;
+					});
 		}
 
 		bool LimitImagesSize (const QDomNodeList& imgs)
@@ -1021,10 +1109,75 @@ namespace LC::Azoth
 		}
 	}
 
+	BodySpans_t Core::TokenizeFormattedBody (const QString& body, bool isRich)
+	{
+		// The stages below depend only on the body text and the
+		// ShortenURLLength setting, so their results are cached by the body
+		// itself and shared by all the messages with the same text.
+		const auto& cacheKey = (isRich ? "r/" : "p/") + body;
+		if (const auto cached = TokenizedBodies_.object (cacheKey))
+			return *cached;
+
+		auto spans = TokenizeBody (body);
+
+		if (!isRich)
+		{
+			auto& formatter = PluginProxyObject_->GetFormatterProxy ();
+			TransformTextSpans (spans,
+					[&formatter] (const QString& text)
+					{
+						auto result = text;
+						formatter.FormatLinks (result);
+						result.replace ('\n', "<br />");
+						result.replace ("  ", "&nbsp; ");
+						return result == text ? QString {} : result;
+					});
+		}
+
+		TokenizedBodies_.insert (cacheKey, new BodySpans_t { spans }, body.size ());
+		return spans;
+	}
+
+	namespace
+	{
+		QString GetFormattingContext (const QList<QColor>& colors, const QStringList& nicks)
+		{
+			QString context;
+			for (const auto& color : colors)
+				context += color.name ();
+			return context + '/' + QString::number (qHash (nicks));
+		}
+	}
+
+	bool Core::HasBodyFormattingHooks () const
+	{
+		return isSignalConnected (QMetaMethod::fromSignal (&Core::hookFormatBodyBegin)) ||
+				isSignalConnected (QMetaMethod::fromSignal (&Core::hookFormatBodyEnd)) ||
+				isSignalConnected (QMetaMethod::fromSignal (&Core::hookGonnaHandleSmiles));
+	}
+
 	QString Core::FormatBody (QString body, IMessage *msg, const QList<QColor>& colors)
 	{
 		QObject *msgObj = msg->GetQObject ();
 
+		const bool highlightNicks = msg->GetMessageType () == IMessage::Type::MUCMessage &&
+				XmlSettingsManager::Instance ().property ("HighlightNicksInBody").toBool ();
+		const auto& nicks = highlightNicks ? GetParticipantsNicks (msg) : QStringList {};
+
+		// The chat view formats all the messages again when it's reloaded.
+		// The body transformers are expected to be pure, and the other
+		// inputs are checked by the cache, but the string hooks may do
+		// anything, so the bodies are only cached if there are none.
+		const auto canCache = !HasBodyFormattingHooks ();
+		const auto sourceBody = body;
+		const auto& cacheContext = canCache ? GetFormattingContext (colors, nicks) : QString {};
+		if (canCache)
+		{
+			const auto& cached = FormattedBodies_.Get (msgObj, sourceBody, cacheContext);
+			if (!cached.isNull ())
+				return cached;
+		}
+
 		IRichTextMessage *rtMsg = qobject_cast<IRichTextMessage*> (msgObj);
 		const bool isRich = rtMsg && rtMsg->GetRichBody () == body;
 
@@ -1036,18 +1189,16 @@ namespace LC::Azoth
 
 		proxy->FillValue ("body", body);
 
-		if (!isRich)
-		{
-			PluginProxyObject_->GetFormatterProxy ().FormatLinks (body);
-			body.replace ('\n', "<br />");
-			body.replace ("  ", "&nbsp; ");
-		}
+		auto spans = TokenizeFormattedBody (body, isRich);
+
+		ApplyBodyTransformers (spans, BodyTransformers_, msg);
 
-		body = HandleSmiles (body);
+		HandleSmiles (spans);
 
-		if (msg->GetMessageType () == IMessage::Type::MUCMessage &&
-				XmlSettingsManager::Instance ().property ("HighlightNicksInBody").toBool ())
-			HighlightNicks (body, msg, colors);
+		if (highlightNicks)
+			HighlightNicks (spans, nicks, colors);
+
+		body = JoinSpans (spans);
 
 		if (isRich)
 			PostprocRichBody (body);
@@ -1057,82 +1208,59 @@ namespace LC::Azoth
 		emit hookFormatBodyEnd (proxy, msgObj);
 		proxy->FillValue ("body", body);
 
-		return proxy->IsCancelled () ?
-				proxy->GetReturnValue ().toString () :
-				body;
+		if (proxy->IsCancelled ())
+			return proxy->GetReturnValue ().toString ();
+
+		if (canCache)
+			FormattedBodies_.Insert (msgObj, sourceBody, cacheContext, body);
+		return body;
 	}
 
-	QString Core::HandleSmiles (QString body)
+	void Core::HandleSmiles (BodySpans_t& spans)
 	{
 		const QString& pack = XmlSettingsManager::Instance ()
 				.property ("SmileIcons").toString ();
 
+		// The hook needs the body as a whole, but this is cheap compared
+		// to the emoticon matching itself.
 		Util::DefaultHookProxy_ptr proxy (new Util::DefaultHookProxy);
-		emit hookGonnaHandleSmiles (proxy, body, pack);
+		emit hookGonnaHandleSmiles (proxy, JoinSpans (spans), pack);
 		if (proxy->IsCancelled ())
 		{
 			const QString& cand = proxy->GetReturnValue ().toString ();
-			return cand.isEmpty () ? body : cand;
+			if (!cand.isEmpty ())
+				spans = TokenizeBody (cand);
+			return;
 		}
 
 		if (pack.isEmpty ())
-			return body;
-
-		IEmoticonResourceSource *src = SmilesOptionsModel_->GetSourceForOption (pack);
-		if (!src)
-			return body;
+			return;
 
 		const bool requireSpace = XmlSettingsManager::Instance ()
 				.property ("RequireSpaceBeforeSmiles").toBool ();
 
-		const QString& img = QString ("<img src=\"%2\" title=\"%1\" />");
-		QMap<int, QString> pos2smile;
-		for (const auto& str : src->GetEmoticonStrings (pack))
-		{
-			const auto& escaped = str.toHtmlEscaped ();
-			int pos = 0;
-			while ((pos = body.indexOf (escaped, pos)) != -1)
-			{
-				const bool isOk = !pos ||
-						!requireSpace ||
-						(requireSpace && pos && body [pos - 1].isSpace ());
-				if (isOk)
-					pos2smile [pos] = str;
-
-				pos += escaped.size ();
-			}
-		}
-
-		if (pos2smile.isEmpty ())
-			return body;
-
-		for (auto i = pos2smile.begin (); i != pos2smile.end (); ++i)
+		if (!SmilesMatcherInfo_.Matcher_ ||
+				SmilesMatcherInfo_.Pack_ != pack ||
+				SmilesMatcherInfo_.RequireSpace_ != requireSpace)
 		{
-			const auto& escapedSmile = i.value ().toHtmlEscaped ();
-			for (int j = 1; j < escapedSmile.size (); ++j)
-				pos2smile.remove (i.key () + j);
-		}
-
-		QList<QPair<int, QString>> reversed;
-		reversed.reserve (pos2smile.size ());
-		for (auto i = pos2smile.begin (); i != pos2smile.end (); ++i)
-			reversed.push_front ({ i.key (), i.value () });
-
-		for (const auto& pair : reversed)
-		{
-			const auto& str = pair.second;
-			const auto& escaped = str.toHtmlEscaped ();
-
-			const auto& rawData = src->GetImage (pack, str).toBase64 ();
-
-			const auto& smileStr = img
-					.arg (str)
-					.arg (QString ("data:image/png;base64," + rawData));
+			IEmoticonResourceSource *src = SmilesOptionsModel_->GetSourceForOption (pack);
+			if (!src)
+				return;
 
-			body.replace (pair.first, escaped.size (), smileStr);
+			const auto getter = [src, pack] (const QString& str)
+			{
+				return "data:image/png;base64," + src->GetImage (pack, str).toBase64 ();
+			};
+			SmilesMatcherInfo_ =
+			{
+				pack,
+				requireSpace,
+				std::make_shared<SmilesMatcher> (src->GetEmoticonStrings (pack), requireSpace, getter)
+			};
 		}
 
-		return body;
+		TransformTextSpans (spans,
+				[matcher = SmilesMatcherInfo_.Matcher_] (const QString& text) { return (*matcher) (text); });
 	}
 
 	namespace
@@ -1298,18 +1426,38 @@ namespace LC::Azoth
 		emit hookEntryStatusChanged (Util::DefaultHookProxy_ptr (new Util::DefaultHookProxy),
 				entry->GetQObject (), variant);
 
-		const State state = entry->GetStatus ().State_;
-		const auto& icon = ResourcesManager::Instance ().GetIconPathForState (state);
+		PendingStatusEntries_ << entry;
+		if (IsStatusFlushScheduled_)
+			return;
 
-		for (auto item : Entry2Items_.value (entry))
+		IsStatusFlushScheduled_ = true;
+		QTimer::singleShot (0,
+				this,
+				SLOT (flushPendingStatuses ()));
+	}
+
+	void Core::flushPendingStatuses ()
+	{
+		IsStatusFlushScheduled_ = false;
+
+		const auto entries = PendingStatusEntries_;
+		PendingStatusEntries_.clear ();
+
+		for (const auto entry : entries)
 		{
-			ItemIconManager_->SetIcon (item, icon.get ());
-			RecalculateOnlineForCat (item->parent ());
-		}
+			const State state = entry->GetStatus ().State_;
+			const auto& icon = ResourcesManager::Instance ().GetIconPathForState (state);
 
-		const QString& id = entry->GetEntryID ();
-		if (!XferJobManager_->GetPendingIncomingJobsFor (id).isEmpty ())
-			CheckFileIcon (id);
+			for (auto item : Entry2Items_.value (entry))
+			{
+				UpdateItemState (item, state);
+				ItemIconManager_->SetIcon (item, icon.get ());
+			}
+
+			const QString& id = entry->GetEntryID ();
+			if (!XferJobManager_->GetPendingIncomingJobsFor (id).isEmpty ())
+				CheckFileIcon (id);
+		}
 	}
 
 	void Core::CheckFileIcon (const QString& id)
@@ -1410,19 +1558,6 @@ namespace LC::Azoth
 		category->setData (sum, CLRUnreadMsgCount);
 	}
 
-	void Core::RecalculateOnlineForCat (QStandardItem *catItem)
-	{
-		int result = 0;
-		for (int i = 0; i < catItem->rowCount (); ++i)
-		{
-			auto entryObj = catItem->child (i)->
-					data (CLREntryObject).value<QObject*> ();
-			result += qobject_cast<ICLEntry*> (entryObj)->GetStatus ().State_ != SOffline;
-		}
-
-		catItem->setData (result, CLRNumOnline);
-	}
-
 	void Core::HandlePowerNotification (Entity e)
 	{
 		qDebug () << Q_FUNC_INFO << e.Entity_;
@@ -1455,6 +1590,7 @@ namespace LC::Azoth
 
 		ItemIconManager_->Cancel (item);
 
+		UpdateItemState (item, SOffline);
 		category->removeRow (item->row ());
 
 		if (!category->rowCount ())
@@ -1493,6 +1629,7 @@ namespace LC::Azoth
 				Qt::ItemIsDropEnabled);
 
 		catItem->appendRow (clItem);
+		UpdateItemState (clItem, clEntry->GetStatus ().State_);
 
 		Entry2Items_ [clEntry] << clItem;
 	}
@@ -1838,7 +1975,10 @@ namespace LC::Azoth
 
 		for (auto entry : Entry2Items_.keys ())
 			if (entry->GetParentAccount () == accFace)
+			{
 				Entry2Items_.remove (entry);
+				PendingStatusEntries_.remove (entry);
+			}
 
 		NotificationsManager_->RemoveAccount (account);
 
@@ -1927,6 +2067,7 @@ namespace LC::Azoth
 				RemoveCLItem (item);
 
 			Entry2Items_.remove (entry);
+			PendingStatusEntries_.remove (entry);
 
 			ActionsManager_->HandleEntryRemoved (entry);
 
@@ -2286,6 +2427,21 @@ namespace LC::Azoth
 		}
 	}
 
+	void Core::clearFormattedBodies ()
+	{
+		TokenizedBodies_.clear ();
+		FormattedBodies_.Clear ();
+	}
+
+	void Core::rebuildBodyTransformers ()
+	{
+		BodyTransformers_.clear ();
+		for (const auto provider : BodyTransformersProviders_)
+			BodyTransformers_ += provider->GetBodyTransformers ();
+
+		FormattedBodies_.Clear ();
+	}
+
 	void Core::updateItem ()
 	{
 		ICLEntry *entry = qobject_cast<ICLEntry*> (sender ());
@@ -47,6 +47,7 @@
 #include "interfaces/azoth/isupportriex.h"
 #include "sourcetrackingmodel.h"
 #include "animatediconmanager.h"
+#include "formatpipeline.h"
 
 class QStandardItemModel;
 class QStandardItem;
@@ -111,6 +112,9 @@ namespace LC::Azoth
 		typedef QHash<ICLEntry*, QList<QStandardItem*>> Entry2Items_t;
 		Entry2Items_t Entry2Items_;
 
+		QSet<ICLEntry*> PendingStatusEntries_;
+		bool IsStatusFlushScheduled_ = false;
+
 		ActionsManager *ActionsManager_;
 
 		typedef QHash<QString, QObject*> ID2Entry_t;
@@ -124,6 +128,20 @@ namespace LC::Azoth
 		QMap<State, int> StateCounter_;
 
 		std::shared_ptr<SourceTrackingModel<IEmoticonResourceSource>> SmilesOptionsModel_;
+
+		struct SmilesMatcherInfo
+		{
+			QString Pack_;
+			bool RequireSpace_;
+			std::shared_ptr<SmilesMatcher> Matcher_;
+		};
+		SmilesMatcherInfo SmilesMatcherInfo_ {};
+
+		QCache<QString, BodySpans_t> TokenizedBodies_ { 4 * 1024 * 1024 };
+		FormattedBodiesCache FormattedBodies_ { 4 * 1024 * 1024 };
+
+		QList<IProvideBodyTransformers*> BodyTransformersProviders_;
+		BodyTransformers_t BodyTransformers_;
 		std::shared_ptr<SourceTrackingModel<IChatStyleResourceSource>> ChatStylesOptionsModel_;
 
 		std::shared_ptr<PluginManager> PluginManager_;
@@ -151,7 +169,12 @@ namespace LC::Azoth
 			CLRRole,
 			CLRAffiliation,
 			CLRNumOnline,
-			CLRIsMUCCategory
+			CLRIsMUCCategory,
+
+			/** The State of the contact, kept up to date so that sorting
+			 * and filtering don't need to query the entry itself.
+			 */
+			CLREntryState
 		};
 
 		enum CLEntryType
@@ -261,13 +284,18 @@ namespace LC::Azoth
 		QUrl GetSelectedChatTemplateURL (QObject*) const;
 
 		bool AppendMessageByTemplate (QWebFrame*, QObject*, const ChatMsgAppendInfo&);
+		bool AppendMessagesByTemplate (QWebFrame*, QObject*,
+				const IChatStyleResourceSource::MessagesBatch_t&);
+		int RemoveFirstMessagesByTemplate (QWebFrame*, QObject*, int);
+		bool PrependMessagesByTemplate (QWebFrame*, QObject*,
+				const IChatStyleResourceSource::MessagesBatch_t&);
 
 		void FrameFocused (QObject*, QWebFrame*);
 
 		QString FormatDate (QDateTime, IMessage*);
 		QString FormatNickname (QString, IMessage*, const QString& color);
 		QString FormatBody (QString body, IMessage *msg, const QList<QColor>& coloring);
-		QString HandleSmiles (QString body);
+		void HandleSmiles (BodySpans_t& body);
 
 		/** This function increases the number of unread messages by
 		 * the given amount, which may be negative.
@@ -294,6 +322,16 @@ namespace LC::Azoth
 		void AddSmileResourceSource (IEmoticonResourceSource*);
 		void AddChatStyleResourceSource (IChatStyleResourceSource*);
 
+		/** Splits the body into spans and formats links, newlines and
+		 * spaces in the text ones unless the body is rich.
+		 */
+		BodySpans_t TokenizeFormattedBody (const QString& body, bool isRich);
+
+		/** Returns whether any plugin handles the string-based body
+		 * formatting hooks, whose results can't be cached.
+		 */
+		bool HasBodyFormattingHooks () const;
+
 		/** Adds the given contact list entry to the given account and
 		 * performs common initialization tasks.
 		 */
@@ -319,6 +357,10 @@ namespace LC::Azoth
 				QMap<const IAccount*, QStandardItem*>& accountItemCache);
 
 		/** Handles the event of status changes in a contact list entry.
+		 *
+		 * The contact list model is updated on the next event loop
+		 * iteration along with all the other entries whose status has
+		 * changed meanwhile.
 		 */
 		void HandleStatusChanged (const EntryStatus& status,
 				ICLEntry *entry, const QString& variant);
@@ -333,8 +375,6 @@ namespace LC::Azoth
 		 */
 		void RecalculateUnreadForParents (QStandardItem*);
 
-		void RecalculateOnlineForCat (QStandardItem*);
-
 		void HandlePowerNotification (Entity);
 
 		/** Removes one item representing the given CL entry.
@@ -449,6 +489,21 @@ namespace LC::Azoth
 		 */
 		void handleGroupContactsChanged ();
 
+		/** Applies the status changes accumulated during the current
+		 * event loop iteration to the contact list model.
+		 */
+		void flushPendingStatuses ();
+
+		/** Is registered in the XmlSettingsManager as handler for
+		 * changes of the properties affecting body formatting.
+		 */
+		void clearFormattedBodies ();
+
+		/** Collects the body transformers of all the plugins again
+		 * and drops the bodies formatted with the previous ones.
+		 */
+		void rebuildBodyTransformers ();
+
 		/** This slot is used to update the model item which is
 		 * corresponding to the sender() which is expected to be a
 		 * ICLEntry.
@@ -0,0 +1,271 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "formatpipeline.h"
+#include <algorithm>
+
+namespace LC
+{
+namespace Azoth
+{
+	namespace
+	{
+		bool IsLinkStart (const QStringRef& tag)
+		{
+			return tag.size () > 2 &&
+					tag.at (1).toLower () == 'a' &&
+					(tag.at (2).isSpace () || tag.at (2) == '>');
+		}
+
+		bool IsLinkEnd (const QStringRef& tag)
+		{
+			return tag.startsWith ("</a", Qt::CaseInsensitive) &&
+					(tag.size () == 3 || !tag.at (3).isLetterOrNumber ());
+		}
+
+		int FindTagEnd (const QString& body, int pos)
+		{
+			QChar quote;
+			for (const auto size = body.size (); pos < size; ++pos)
+			{
+				const auto c = body.at (pos);
+				if (!quote.isNull ())
+				{
+					if (c == quote)
+						quote = QChar {};
+				}
+				else if (c == '"' || c == '\'')
+					quote = c;
+				else if (c == '>')
+					return pos;
+			}
+			return -1;
+		}
+
+		void Tokenize (const QString& body, bool inLink, BodySpans_t& result)
+		{
+			int pos = 0;
+			const auto size = body.size ();
+			while (pos < size)
+			{
+				const auto tagStart = body.indexOf ('<', pos);
+				const auto tagEnd = tagStart >= 0 ? FindTagEnd (body, tagStart) : -1;
+				if (tagEnd < 0)
+				{
+					result.append ({ BodySpan::Type::Text, body.mid (pos), inLink });
+					return;
+				}
+
+				if (tagStart > pos)
+					result.append ({ BodySpan::Type::Text, body.mid (pos, tagStart - pos), inLink });
+
+				const auto& tag = body.midRef (tagStart, tagEnd - tagStart + 1);
+				if (IsLinkStart (tag))
+					inLink = true;
+				else if (IsLinkEnd (tag))
+					inLink = false;
+				result.append ({ BodySpan::Type::Markup, tag.toString (), inLink });
+
+				pos = tagEnd + 1;
+			}
+		}
+	}
+
+	BodySpans_t TokenizeBody (const QString& body)
+	{
+		BodySpans_t result;
+		Tokenize (body, false, result);
+		return result;
+	}
+
+	QString JoinSpans (const BodySpans_t& spans)
+	{
+		int size = 0;
+		for (const auto& span : spans)
+			size += span.Str_.size ();
+
+		QString result;
+		result.reserve (size);
+		for (const auto& span : spans)
+			result += span.Str_;
+		return result;
+	}
+
+	void TransformTextSpans (BodySpans_t& spans, const SpanTransformer_f& transformer)
+	{
+		BodySpans_t result;
+		result.reserve (spans.size ());
+
+		for (auto& span : spans)
+		{
+			if (span.Type_ != BodySpan::Type::Text || span.InLink_)
+			{
+				result << std::move (span);
+				continue;
+			}
+
+			const auto& transformed = transformer (span.Str_);
+			if (transformed.isNull ())
+				result << std::move (span);
+			else
+				Tokenize (transformed, false, result);
+		}
+
+		spans = std::move (result);
+	}
+
+	void ApplyBodyTransformers (BodySpans_t& spans, const BodyTransformers_t& transformers, IMessage *msg)
+	{
+		for (const auto& transformer : transformers)
+		{
+			const auto& trigger = transformer.Trigger_;
+			const auto hasTrigger = trigger.isEmpty () ||
+					std::any_of (spans.begin (), spans.end (),
+							[&trigger] (const BodySpan& span)
+							{
+								return span.Type_ == BodySpan::Type::Text &&
+										!span.InLink_ &&
+										span.Str_.contains (trigger);
+							});
+			if (!hasTrigger)
+				continue;
+
+			TransformTextSpans (spans,
+					[&] (const QString& text)
+					{
+						if (!trigger.isEmpty () && !text.contains (trigger))
+							return QString {};
+						return transformer.Transform_ (text, msg);
+					});
+		}
+	}
+
+	SmilesMatcher::SmilesMatcher (const QStringList& strings,
+			bool requireSpace, const ImageSrcGetter_f& getter)
+	: RequireSpace_ { requireSpace }
+	, SrcGetter_ { getter }
+	{
+		for (const auto& str : strings)
+		{
+			const auto& escaped = str.toHtmlEscaped ();
+			if (!escaped.isEmpty ())
+				FirstChar2Smiles_ [escaped.at (0)].append ({ escaped, str });
+		}
+
+		for (auto& smiles : FirstChar2Smiles_)
+			std::stable_sort (smiles.begin (), smiles.end (),
+					[] (const Smile& s1, const Smile& s2) { return s1.Escaped_.size () > s2.Escaped_.size (); });
+	}
+
+	QString SmilesMatcher::operator() (const QString& text) const
+	{
+		if (FirstChar2Smiles_.isEmpty ())
+			return {};
+
+		QString result;
+		int copiedUpTo = 0;
+
+		for (int pos = 0, size = text.size (); pos < size; )
+		{
+			const auto smilesPos = FirstChar2Smiles_.find (text.at (pos));
+			if (smilesPos == FirstChar2Smiles_.end () ||
+					(RequireSpace_ && pos && !text.at (pos - 1).isSpace ()))
+			{
+				++pos;
+				continue;
+			}
+
+			const auto smile = std::find_if (smilesPos->begin (), smilesPos->end (),
+					[&text, pos] (const Smile& smile)
+					{
+						return text.midRef (pos, smile.Escaped_.size ()) == smile.Escaped_;
+					});
+			if (smile == smilesPos->end ())
+			{
+				++pos;
+				continue;
+			}
+
+			result += text.midRef (copiedUpTo, pos - copiedUpTo);
+			result += GetHtml (smile->Str_);
+
+			pos += smile->Escaped_.size ();
+			copiedUpTo = pos;
+		}
+
+		if (!copiedUpTo)
+			return {};
+
+		result += text.midRef (copiedUpTo);
+		return result;
+	}
+
+	const QString& SmilesMatcher::GetHtml (const QString& str) const
+	{
+		auto pos = Str2Html_.find (str);
+		if (pos == Str2Html_.end ())
+			pos = Str2Html_.insert (str,
+					QString ("<img src=\"%2\" title=\"%1\" />")
+						.arg (str.toHtmlEscaped ())
+						.arg (SrcGetter_ (str)));
+		return *pos;
+	}
+
+	FormattedBodiesCache::FormattedBodiesCache (int maxCost)
+	: Entries_ { maxCost }
+	{
+	}
+
+	QString FormattedBodiesCache::Get (QObject *msg, const QString& body, const QString& context) const
+	{
+		// A destroyed message resets the QPointer, so a new message
+		// allocated at the same address never matches its entry.
+		const auto entry = Entries_.object (msg);
+		if (!entry ||
+				entry->Msg_ != msg ||
+				entry->Body_ != body ||
+				entry->Context_ != context)
+			return {};
+
+		return entry->Result_;
+	}
+
+	void FormattedBodiesCache::Insert (QObject *msg, const QString& body,
+			const QString& context, const QString& result)
+	{
+		const auto cost = body.size () + context.size () + result.size ();
+		Entries_.insert (msg, new Entry { msg, body, context, result }, cost);
+	}
+
+	void FormattedBodiesCache::Clear ()
+	{
+		Entries_.clear ();
+	}
+}
+}
@@ -0,0 +1,155 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <QList>
+#include <QHash>
+#include <QCache>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+#include "interfaces/azoth/iprovidebodytransformers.h"
+
+namespace LC
+{
+namespace Azoth
+{
+	/** A span of an HTML message body, either a piece of text or a tag.
+	 */
+	struct BodySpan
+	{
+		enum class Type
+		{
+			Text,
+			Markup
+		};
+
+		Type Type_;
+		QString Str_;
+
+		/** Whether the span is inside an \\<a\\> element.
+		 */
+		bool InLink_;
+	};
+
+	using BodySpans_t = QList<BodySpan>;
+
+	/** Splits the HTML \em body into text and markup spans.
+	 *
+	 * The body is only scanned once, so the formatting stages can work on
+	 * the text spans without rescanning the tags inserted by the previous
+	 * stages.
+	 */
+	BodySpans_t TokenizeBody (const QString& body);
+
+	QString JoinSpans (const BodySpans_t&);
+
+	/** Transforms a text span into an HTML string, or returns a null
+	 * string if the span should be left intact.
+	 */
+	using SpanTransformer_f = std::function<QString (const QString&)>;
+
+	/** Applies the \em transformer to each text span outside of links,
+	 * replacing the span with the tokenized result.
+	 */
+	void TransformTextSpans (BodySpans_t&, const SpanTransformer_f& transformer);
+
+	/** Applies the plugin \em transformers in order to the text spans
+	 * outside of links that contain the trigger of the transformer.
+	 */
+	void ApplyBodyTransformers (BodySpans_t&, const BodyTransformers_t& transformers, IMessage *msg);
+
+	/** Caches the completely formatted bodies of the messages, so that
+	 * reloading the chat view doesn't format all of them again.
+	 *
+	 * An entry is only returned for the same message object while it is
+	 * alive, and for the same source body and context. The context holds
+	 * everything else the formatting depends on, like nick colors or MUC
+	 * participants.
+	 */
+	class FormattedBodiesCache
+	{
+		struct Entry
+		{
+			QPointer<QObject> Msg_;
+			QString Body_;
+			QString Context_;
+			QString Result_;
+		};
+		QCache<QObject*, Entry> Entries_;
+	public:
+		explicit FormattedBodiesCache (int maxCost);
+
+		/** Returns the cached formatted body, or a null string if there
+		 * is no matching entry.
+		 */
+		QString Get (QObject *msg, const QString& body, const QString& context) const;
+
+		void Insert (QObject *msg, const QString& body, const QString& context, const QString& result);
+
+		void Clear ();
+	};
+
+	/** Replaces emoticon strings in the text spans with images.
+	 *
+	 * All the emoticon strings of a pack are indexed by their first
+	 * character, so each text span is scanned only once regardless of the
+	 * number of emoticons in the pack. The longest emoticon string wins if
+	 * several of them match at the same position.
+	 */
+	class SmilesMatcher
+	{
+	public:
+		/** Returns the \em src attribute of the image for the given
+		 * emoticon string.
+		 */
+		using ImageSrcGetter_f = std::function<QString (const QString&)>;
+	private:
+		struct Smile
+		{
+			QString Escaped_;
+			QString Str_;
+		};
+		QHash<QChar, QList<Smile>> FirstChar2Smiles_;
+
+		const bool RequireSpace_;
+		const ImageSrcGetter_f SrcGetter_;
+
+		mutable QHash<QString, QString> Str2Html_;
+	public:
+		SmilesMatcher (const QStringList& strings, bool requireSpace, const ImageSrcGetter_f&);
+
+		QString operator() (const QString& text) const;
+	private:
+		const QString& GetHtml (const QString&) const;
+	};
+}
+}
@@ -110,6 +110,15 @@ namespace Azoth
 			return;
 		}
 
+		if (InProgress_.contains (acc))
+		{
+			qDebug () << Q_FUNC_INFO
+					<< "sync is already in progress for"
+					<< acc->GetAccountID ();
+			return;
+		}
+		InProgress_ << acc;
+
 		using RetType_t = Util::UnwrapFutureType_t<decltype (Storages_ [0]->RequestMaxTimestamp (acc))>;
 
 		auto allStorages = std::make_shared<QFutureSynchronizer<RetType_t>> ();
@@ -129,6 +138,7 @@ namespace Azoth
 								<< "got storage errors:"
 								<< partition.first
 								<< "; aborting sync";
+						FinishAccountSync (acc);
 						return;
 					}
 
@@ -147,7 +157,11 @@ namespace Azoth
 		Util::Sequence (this, ihsh->FetchServerHistory (from)) >>
 				Util::Visitor
 				{
-					[] (const QString& err) { qWarning () << Q_FUNC_INFO << err; },
+					[this, acc] (const QString& err)
+					{
+						qWarning () << Q_FUNC_INFO << err;
+						FinishAccountSync (acc);
+					},
 					[this, acc] (const auto& map) { AppendItems (acc, map); }
 				};
 	}
@@ -155,6 +169,9 @@ namespace Azoth
 	void HistorySyncer::AppendItems (IAccount *acc,
 			const IHaveServerHistory::MessagesSyncMap_t& map)
 	{
+		using RetType_t = IHistoryPlugin::AddRawMessagesResult_t;
+
+		auto allStorages = std::make_shared<QFutureSynchronizer<RetType_t>> ();
 		for (const auto& pair : Util::Stlize (map))
 		{
 			const auto& entry = qobject_cast<ICLEntry*> (Core::Instance ().GetEntry (pair.first));
@@ -163,9 +180,35 @@ namespace Azoth
 					pair.second.VisibleName_;
 
 			for (const auto storage : Storages_)
-				storage->AddRawMessages (acc->GetAccountID (),
-						pair.first, name, pair.second.Messages_);
+				allStorages->addFuture (storage->AddRawMessages (acc->GetAccountID (),
+						pair.first, name, pair.second.Messages_));
 		}
+
+		Util::Sequence (this, QtConcurrent::run ([allStorages] { allStorages->waitForFinished (); })) >>
+				[=]
+				{
+					FinishAccountSync (acc);
+
+					const auto& results = Util::Map (allStorages->futures (),
+							[] (auto future) { return future.result (); });
+
+					const auto& errors = Util::PartitionEithers (results).first;
+					if (!errors.isEmpty ())
+					{
+						qWarning () << Q_FUNC_INFO
+								<< "got storage errors:"
+								<< errors
+								<< "; the messages will be refetched during the next sync";
+						return;
+					}
+
+					qobject_cast<IHaveServerHistory*> (acc->GetQObject ())->HandleServerHistoryStored ();
+				};
+	}
+
+	void HistorySyncer::FinishAccountSync (IAccount *acc)
+	{
+		InProgress_.remove (acc);
 	}
 }
 }
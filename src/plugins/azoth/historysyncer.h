@@ -52,6 +52,7 @@ namespace Azoth
 		QList<IHistoryPlugin*> Storages_;
 
 		QSet<IAccount*> CurrentlyOnline_;
+		QSet<IAccount*> InProgress_;
 	public:
 		HistorySyncer (QObject* = nullptr);
 
@@ -62,6 +63,7 @@ namespace Azoth
 		void RequestAccountFrom (IAccount*, const QDateTime&);
 
 		void AppendItems (IAccount*, const IHaveServerHistory::MessagesSyncMap_t&);
+		void FinishAccountSync (IAccount*);
 	};
 }
 }
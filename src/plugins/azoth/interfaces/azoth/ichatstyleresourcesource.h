@@ -29,6 +29,8 @@
 
 #ifndef PLUGINS_AZOTH_INTERFACES_ICHATSTYLERESOURCESOURCE_H
 #define PLUGINS_AZOTH_INTERFACES_ICHATSTYLERESOURCESOURCE_H
+#include <QList>
+#include <QPair>
 #include "iresourceplugin.h"
 
 class QUrl;
@@ -136,6 +138,84 @@ namespace Azoth
 		virtual bool AppendMessage (QWebFrame *frame, QObject *message,
 				const ChatMsgAppendInfo& info) = 0;
 
+		/** @brief A list of messages along with their append info.
+		 */
+		using MessagesBatch_t = QList<QPair<QObject*, ChatMsgAppendInfo>>;
+
+		/** @brief Appends several messages to the chat view at once.
+		 *
+		 * This function is called when several messages should be
+		 * appended to the chat view at once, like when the view is
+		 * loaded or when several messages arrive at nearly the same
+		 * time.
+		 *
+		 * Style sources that are able to insert all the messages with a
+		 * single DOM operation should reimplement this function. The
+		 * default implementation calls AppendMessage() for each message.
+		 *
+		 * @param[in] frame The chat view frame.
+		 * @param[in] messages The messages to append, in the display
+		 * order.
+		 * @return true on success, false otherwise.
+		 *
+		 * @sa AppendMessage()
+		 */
+		virtual bool AppendMessages (QWebFrame *frame, const MessagesBatch_t& messages)
+		{
+			bool result = true;
+			for (const auto& pair : messages)
+				result = AppendMessage (frame, pair.first, pair.second) && result;
+			return result;
+		}
+
+		/** @brief Inserts older messages before the ones in the chat view.
+		 *
+		 * This function is called when the user scrolls back to the
+		 * messages that have been dropped from the chat view.
+		 *
+		 * The default implementation returns false, meaning that
+		 * prepending isn't supported by the style source, in which case
+		 * the chat view is reloaded with the new messages instead.
+		 *
+		 * @param[in] frame The chat view frame.
+		 * @param[in] messages The messages to prepend, in the display
+		 * order.
+		 * @return Whether the messages have been prepended.
+		 */
+		virtual bool PrependMessages (QWebFrame *frame, const MessagesBatch_t& messages)
+		{
+			Q_UNUSED (frame)
+			Q_UNUSED (messages)
+			return false;
+		}
+
+		/** @brief Removes the oldest messages from the chat view.
+		 *
+		 * This function is called when the chat view holds too many
+		 * messages, to drop the oldest ones from the document without
+		 * reloading it. The count is in the messages previously passed
+		 * to AppendMessage(), AppendMessages() or PrependMessages().
+		 *
+		 * Style sources that group several messages into a single
+		 * element may remove fewer messages than requested, but never
+		 * more.
+		 *
+		 * The default implementation returns -1, meaning that removing
+		 * messages isn't supported by the style source, in which case
+		 * the chat view is reloaded with the recent messages instead.
+		 *
+		 * @param[in] frame The chat view frame.
+		 * @param[in] count The number of the oldest messages to remove.
+		 * @return The number of messages actually removed, or -1 if
+		 * removing is not supported.
+		 */
+		virtual int RemoveFirstMessages (QWebFrame *frame, int count)
+		{
+			Q_UNUSED (frame)
+			Q_UNUSED (count)
+			return -1;
+		}
+
 		/** @brief Notifies about a frame obtaining user input focus.
 		 *
 		 * This function is called whenever a given frame receives user
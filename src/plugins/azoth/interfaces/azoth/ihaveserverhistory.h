@@ -137,6 +137,24 @@ namespace Azoth
 		using DatedFetchResult_t = Util::Either<QString, MessagesSyncMap_t>;
 
 		virtual QFuture<DatedFetchResult_t> FetchServerHistory (const QDateTime& since) = 0;
+
+		/** @brief Notifies that the fetched messages have been stored.
+		 *
+		 * This function is called once all history storages have
+		 * successfully stored the messages returned by the last call to
+		 * FetchServerHistory(const QDateTime&). Only one such call is
+		 * active for an account at a time.
+		 *
+		 * An account keeping its own sync state (like the ID of the last
+		 * fetched message) should only advance it at this point, so that
+		 * the messages aren't skipped by the next sync if storing them
+		 * fails.
+		 *
+		 * The default implementation does nothing.
+		 */
+		virtual void HandleServerHistoryStored ()
+		{
+		}
 	protected:
 		/** @brief Emitted when messages are fetched.
 		 *
@@ -32,6 +32,7 @@
 #include <QList>
 #include <QVariantMap>
 #include <util/sll/eitherfwd.h>
+#include <util/sll/void.h>
 #include "imessage.h"
 
 template<typename>
@@ -79,6 +80,14 @@ namespace Azoth
 		 * displayed to the user.
 		 */
 		IMessage::EscapePolicy EscPolicy_;
+
+		/** @brief The server-assigned ID of the message, if any.
+		 *
+		 * This is, for example, the archive ID of a message fetched from
+		 * the server-side archive. History storages use it to skip the
+		 * messages they already have.
+		 */
+		QString StanzaID_;
 	};
 
 	/** @brief Interface for plugins storing chat history.
@@ -123,17 +132,25 @@ namespace Azoth
 
 		virtual QFuture<MaxTimestampResult_t> RequestMaxTimestamp (IAccount *acc) = 0;
 
+		using AddRawMessagesResult_t = Util::Either<QString, Util::Void>;
+
 		/** @brief Adds a set of messages to the history.
+		 *
+		 * The messages that are already in the history are skipped. The
+		 * messages having the same non-empty HistoryItem::StanzaID_ are
+		 * considered the same.
 		 *
 		 * @param[in] accountId The unique ID of the corresponding account.
 		 * @param[in] entryId The unique ID of the corresponding entry.
 		 * @param[in] visibleName The human-readable name of the entry.
 		 * @param[in] items A list of HistoryItem structures describing the
 		 * messages.
+		 * @return The future that becomes ready once the messages are
+		 * stored, or with an error description if storing them failed.
 		 *
 		 * @sa HistoryItem
 		 */
-		virtual void AddRawMessages (const QString& accountId,
+		virtual QFuture<AddRawMessagesResult_t> AddRawMessages (const QString& accountId,
 				const QString& entryId,
 				const QString& visibleName,
 				const QList<HistoryItem>& items) = 0;
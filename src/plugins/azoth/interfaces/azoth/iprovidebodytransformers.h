@@ -0,0 +1,115 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <QList>
+#include <QString>
+#include <QtPlugin>
+
+namespace LC
+{
+namespace Azoth
+{
+	class IMessage;
+
+	/** @brief A transformer of the text pieces of message bodies.
+	 *
+	 * Azoth splits the HTML body of a message into text and markup spans
+	 * once, and the transformers then run over the text spans outside of
+	 * links. The markup inserted by a transformer is never passed to the
+	 * later ones, so transformers don't need to skip tags by themselves.
+	 *
+	 * @sa IProvideBodyTransformers
+	 */
+	struct BodyTransformer
+	{
+		/** @brief The string a text span should contain.
+		 *
+		 * Only the spans containing this string are passed to the
+		 * Transform_ function. An empty string means all spans are
+		 * passed.
+		 */
+		QString Trigger_;
+
+		/** @brief Transforms the HTML-escaped text of a span.
+		 *
+		 * The function gets the text of the span and the message being
+		 * formatted. It returns the HTML the span should be replaced
+		 * with, or a null string if the span should be left intact.
+		 *
+		 * Formatted bodies are cached, so the result should depend only
+		 * on the text, the message and the settings of the plugin.
+		 */
+		std::function<QString (const QString& text, IMessage *msg)> Transform_;
+	};
+
+	using BodyTransformers_t = QList<BodyTransformer>;
+
+	/** @brief Interface for plugins formatting message bodies.
+	 *
+	 * This interface should be implemented by the plugins that modify
+	 * the text of the messages shown in the chat window, like emoticon
+	 * or formula renderers. Unlike the hookFormatBodyBegin() and
+	 * hookFormatBodyEnd() hooks, the transformers don't need to rescan
+	 * the whole HTML body, and the bodies they format can be cached.
+	 *
+	 * The transformers of different plugins run in the order the
+	 * plugins are loaded, before the emoticons are inserted.
+	 */
+	class IProvideBodyTransformers
+	{
+	public:
+		virtual ~IProvideBodyTransformers () {}
+
+		/** @brief Returns the body transformers of this plugin.
+		 *
+		 * This function is called once the plugin is loaded and each
+		 * time bodyTransformersChanged() is emitted.
+		 *
+		 * @return The list of transformers to apply in order.
+		 */
+		virtual BodyTransformers_t GetBodyTransformers () = 0;
+	protected:
+		/** @brief Notifies that the transformers have changed.
+		 *
+		 * This signal should be emitted whenever the transformers or
+		 * the settings affecting their output change, so that the
+		 * cached bodies are formatted again.
+		 *
+		 * @note This function is expected to be a signal.
+		 */
+		virtual void bodyTransformersChanged () = 0;
+	};
+}
+}
+
+Q_DECLARE_INTERFACE (LC::Azoth::IProvideBodyTransformers,
+		"org.LeechCraft.Azoth.IProvideBodyTransformers/1.0")
@@ -34,6 +34,7 @@
 #include "ircmessage.h"
 #include "ircserverhandler.h"
 #include "channelsmanager.h"
+#include "rostername.h"
 
 namespace LC
 {
@@ -194,22 +195,62 @@ namespace Acetamide
 	void ChannelHandler::SetChannelUser (const QString& nick,
 			const QString& user, const QString& host)
 	{
-		QString nickName = nick;
-		bool hasRole = false;
-		QChar roleSign;
+		const auto& result = UpdateChannelUser (nick, user, host, GetPrefixList ());
+		if (result.IsNew_)
+			CM_->GetAccount ()->handleGotRosterItems ({ result.Entry_.get () });
 
-		if (CM_->GetISupport ().contains ("PREFIX"))
+		MakeJoinMessage (result.Nick_);
+	}
+
+	void ChannelHandler::AddRosterNames (const QStringList& nicks)
+	{
+		PendingRosterNames_ += nicks;
+	}
+
+	void ChannelHandler::FlushRosterNames ()
+	{
+		const auto nicks = std::move (PendingRosterNames_);
+		PendingRosterNames_.clear ();
+
+		const auto& prefixList = GetPrefixList ();
+
+		QList<QObject*> newEntries;
+		int joinedCount = 0;
+		for (const auto& nick : nicks)
 		{
-			const QStringList& prefixList = CM_->GetISupport () ["PREFIX"].split (')');
-			int id = prefixList.value (1).indexOf (nick [0]);
-			if (id != -1)
-			{
-				hasRole = true;
-				nickName = nickName.mid (1);
-				roleSign = prefixList.at (0) [id + 1];
-			}
+			if (nick.isEmpty ())
+				continue;
+
+			const auto& result = UpdateChannelUser (nick, {}, {}, prefixList);
+			if (result.IsNew_)
+				newEntries << result.Entry_.get ();
+			++joinedCount;
 		}
 
+		if (!newEntries.isEmpty ())
+			CM_->GetAccount ()->handleGotRosterItems (newEntries);
+
+		// The participants themselves are already shown in the roster,
+		// and listing thousands of them in the chat is of no use.
+		if (joinedCount)
+			HandleServiceMessage (tr ("%n participant(s) in the channel.", 0, joinedCount),
+					IMessage::Type::StatusMessage,
+					IMessage::SubType::Other);
+	}
+
+	QStringList ChannelHandler::GetPrefixList () const
+	{
+		const auto& isupport = CM_->GetISupport ();
+		return isupport.contains ("PREFIX") ?
+				isupport ["PREFIX"].split (')') :
+				QStringList {};
+	}
+
+	ChannelHandler::UserUpdateResult ChannelHandler::UpdateChannelUser (const QString& nick,
+			const QString& user, const QString& host, const QStringList& prefixList)
+	{
+		const auto& [nickName, role] = ParseRosterName (nick, prefixList);
+
 		CM_->ClosePrivateChat (nickName);
 
 		const auto existed = Nick2Entry_.contains (nickName);
@@ -218,38 +259,10 @@ namespace Acetamide
 		entry->SetUserName (user);
 		entry->SetHostName (host);
 
-		ChannelRole role;
-		if (hasRole)
-			switch (roleSign.toLatin1 ())
-			{
-				case 'v':
-					role = ChannelRole::Voiced;
-					break;
-				case 'h':
-					role = ChannelRole::HalfOperator;
-					break;
-				case 'o':
-					role = ChannelRole::Operator;
-					break;
-				case 'a':
-					role = ChannelRole::Admin;
-					break;
-				case 'q':
-					role = ChannelRole::Owner;
-					break;
-				default:
-					role = ChannelRole::Participant;
- 			}
-		else
-			role = ChannelRole::Participant;
-
 		entry->SetRole (role);
 		entry->SetStatus (EntryStatus (SOnline, QString ()));
 
-		if (!existed)
-			CM_->GetAccount ()->handleGotRosterItems ({ entry.get () });
-
-		MakeJoinMessage (nickName);
+		return { nickName, entry, !existed };
 	}
 
 	void ChannelHandler::MakeJoinMessage (const QString& nick)
@@ -62,6 +62,7 @@ namespace Acetamide
 		bool IsRosterReceived_;
 
 		QHash<QString, ChannelParticipantEntry_ptr> Nick2Entry_;
+		QStringList PendingRosterNames_;
 
 		ChannelModes ChannelMode_;
 		QString Url_;
@@ -99,6 +100,17 @@ namespace Acetamide
 		void SetChannelUser (const QString& nick,
 				const QString& user = QString (), const QString& host = QString ());
 
+		/** Buffers the NAMES reply \em nicks until FlushRosterNames()
+		 * is called at the end of the NAMES list.
+		 */
+		void AddRosterNames (const QStringList& nicks);
+
+		/** Adds all the participants buffered by AddRosterNames() at
+		 * once, announcing the new ones to Azoth in a single batch and
+		 * posting a single message with their count.
+		 */
+		void FlushRosterNames ();
+
 		void MakeJoinMessage (const QString&);
 		void MakeLeaveMessage (const QString&, const QString&);
 		void MakeKickMessage (const QString&, const QString&,
@@ -152,6 +164,17 @@ namespace Acetamide
 
 		void SetUrl (const QString& url);
 	private:
+		struct UserUpdateResult
+		{
+			QString Nick_;
+			ChannelParticipantEntry_ptr Entry_;
+			bool IsNew_;
+		};
+
+		QStringList GetPrefixList () const;
+		UserUpdateResult UpdateChannelUser (const QString& nick,
+				const QString& user, const QString& host, const QStringList& prefixList);
+
 		bool RemoveUserFromChannel (const QString&);
 		ChannelParticipantEntry_ptr CreateParticipantEntry (const QString&, bool announce = true);
 		void RemoveThis ();
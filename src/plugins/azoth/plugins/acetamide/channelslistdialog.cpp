@@ -81,11 +81,15 @@ namespace Acetamide
 	void ChannelsListDialog::handleGotChannelsEnd ()
 	{
 		BufferTimer_->stop ();
+		appendRows ();
 	}
 
 	void ChannelsListDialog::appendRows ()
 	{
-		auto list = Buffer_;
+		if (Buffer_.isEmpty ())
+			return;
+
+		const auto list = std::move (Buffer_);
 		Buffer_.clear ();
 
 		for (const auto& row : list)
@@ -216,11 +216,7 @@ namespace Acetamide
 	{
 		if (IsChannelExists (channel) &&
 				!ChannelHandlers_ [channel]->IsRosterReceived ())
-		{
-			for (const auto& nick : participants)
-				if (!nick.isEmpty ())
-					ChannelHandlers_ [channel]->SetChannelUser (nick);
-		}
+			ChannelHandlers_ [channel]->AddRosterNames (participants);
 		else
 			ReceiveCmdAnswerMessage ("names", participants.join (" "), false);
 	}
@@ -230,6 +226,7 @@ namespace Acetamide
 		if (ChannelHandlers_.contains (channel) &&
 				!ChannelHandlers_ [channel]->IsRosterReceived ())
 		{
+			ChannelHandlers_ [channel]->FlushRosterNames ();
 			ChannelHandlers_ [channel]->SetRosterReceived (true);
 			ISH_->GetAccount ()->handleGotRosterItems (QObjectList () << ChannelHandlers_ [channel]->GetCLEntry ());
 		}
@@ -0,0 +1,118 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "irclineparser.h"
+#include <algorithm>
+
+namespace LC
+{
+namespace Azoth
+{
+namespace Acetamide
+{
+	namespace
+	{
+		bool IsValidCommand (std::string_view cmd)
+		{
+			const auto isDigit = [] (char c) { return c >= '0' && c <= '9'; };
+			const auto isAlpha = [] (char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); };
+
+			if (cmd.size () == 3 && std::all_of (cmd.begin (), cmd.end (), isDigit))
+				return true;
+
+			return !cmd.empty () && std::all_of (cmd.begin (), cmd.end (), isAlpha);
+		}
+
+		void ParsePrefix (std::string_view prefix, IrcLine& line)
+		{
+			const auto at = prefix.find ('@');
+			const auto excl = prefix.find ('!');
+			if (at == std::string_view::npos && excl == std::string_view::npos)
+			{
+				line.Host_ = prefix;
+				line.Nick_ = prefix.substr (0, prefix.find ('.'));
+				return;
+			}
+
+			line.Nick_ = prefix.substr (0, std::min (at, excl));
+			if (excl < at)
+				line.User_ = prefix.substr (excl + 1,
+						at == std::string_view::npos ? at : at - excl - 1);
+			if (at != std::string_view::npos)
+				line.Host_ = prefix.substr (at + 1);
+		}
+	}
+
+	std::optional<IrcLine> ParseIrcLine (std::string_view str)
+	{
+		while (!str.empty () && (str.back () == '\n' || str.back () == '\r'))
+			str.remove_suffix (1);
+
+		IrcLine line;
+
+		if (!str.empty () && str.front () == ':')
+		{
+			const auto prefixEnd = str.find (' ');
+			if (prefixEnd == std::string_view::npos)
+				return {};
+
+			ParsePrefix (str.substr (1, prefixEnd - 1), line);
+			str.remove_prefix (prefixEnd + 1);
+		}
+
+		const auto commandEnd = std::min (str.find (' '), str.size ());
+		line.Command_ = str.substr (0, commandEnd);
+		if (!IsValidCommand (line.Command_))
+			return {};
+		str.remove_prefix (commandEnd);
+
+		// Here str is either empty or starts with a space.
+		while (!str.empty ())
+		{
+			str.remove_prefix (1);
+			if (str.empty ())
+				break;
+
+			if (str.front () == ':')
+			{
+				line.Trailing_ = str.substr (1);
+				break;
+			}
+
+			const auto paramEnd = std::min (str.find (' '), str.size ());
+			if (paramEnd)
+				line.Params_.append (str.substr (0, paramEnd));
+			str.remove_prefix (paramEnd);
+		}
+
+		return line;
+	}
+}
+}
+}
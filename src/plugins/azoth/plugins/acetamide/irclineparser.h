@@ -0,0 +1,72 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <optional>
+#include <string_view>
+#include <QVarLengthArray>
+
+namespace LC
+{
+namespace Azoth
+{
+namespace Acetamide
+{
+	/** @brief A single IRC protocol line split into its components.
+	 *
+	 * All the views point into the buffer passed to ParseIrcLine() and
+	 * stay valid only as long as that buffer is alive.
+	 *
+	 * For prefixes without a user or host part (like server names) the
+	 * Host_ is the whole prefix, and the Nick_ is its part up to the
+	 * first dot.
+	 */
+	struct IrcLine
+	{
+		std::string_view Nick_;
+		std::string_view User_;
+		std::string_view Host_;
+		std::string_view Command_;
+		QVarLengthArray<std::string_view, 16> Params_;
+		std::string_view Trailing_;
+	};
+
+	/** @brief Splits the raw IRC \em line into its components.
+	 *
+	 * The trailing CR/LF, if any, is ignored.
+	 *
+	 * @param[in] line The raw line as received from the server.
+	 * @return The parsed line, or an empty optional if the line is not
+	 * a valid IRC message.
+	 */
+	std::optional<IrcLine> ParseIrcLine (std::string_view line);
+}
+}
+}
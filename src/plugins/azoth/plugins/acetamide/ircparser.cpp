@@ -28,12 +28,10 @@
  **********************************************************************/
 
 #include "ircparser.h"
-#include <boost/spirit/include/classic_core.hpp>
-#include <boost/spirit/include/classic_loops.hpp>
-#include <boost/spirit/include/classic_push_back_actor.hpp>
 #include <QTextCodec>
 #include <util/sll/prelude.h>
 #include "ircaccount.h"
+#include "irclineparser.h"
 #include "ircserverhandler.h"
 
 namespace LC
@@ -42,8 +40,6 @@ namespace Azoth
 {
 namespace Acetamide
 {
-	using namespace boost::spirit::classic;
-
 	IrcParser::IrcParser (IrcServerHandler *sh)
 	: QObject (sh)
 	, ISH_ (sh)
@@ -413,85 +409,47 @@ namespace Acetamide
 		ISH_->SendCommand (chListCmd);
 	}
 
+	namespace
+	{
+		QString ToQString (std::string_view view)
+		{
+			return QString::fromUtf8 (view.data (), view.size ());
+		}
+	}
+
 	bool IrcParser::ParseMessage (const QByteArray& message)
 	{
-		const auto& msg = GetCodec ()->toUnicode (message);
+		const auto codec = GetCodec ();
 
-		IrcMessageOptions_.Command_.clear ();
-		IrcMessageOptions_.Nick_.clear ();
-		IrcMessageOptions_.Message_.clear ();
-		IrcMessageOptions_.Parameters_.clear ();
-		IrcMessageOptions_.UserName_.clear ();
-		IrcMessageOptions_.Host_.clear ();
-
-		std::string nickStr;
-		std::string userStr;
-		std::string hostStr;
-		std::string commandStr;
-		std::string msgStr;
-		QList<std::string> opts;
-
-		range<> ascii (char (0x01), char (0x7F));
-		rule<> special = lexeme_d [ch_p ('[') | ']' | '\\' | '`' |
-				'_' | '^' | '{' | '|' | '}'];
-		rule<> shortname = *(alnum_p
-				>> *(alnum_p || ch_p ('-'))
-				>> *alnum_p);
-		rule<> hostname = (shortname
-				>> *(ch_p ('.')
-				>> shortname)) [assign_a (hostStr)];
-		rule<> nickname = (alpha_p | special)
-				>> *(alnum_p | special | ch_p ('-'));
-		rule<> user =  +(ascii - '\r' - '\n' - ' ' - '@' - '\0');
-		rule<> host = lexeme_d [+(anychar_p - ' ')] ;
-		rule<> nick = lexeme_d [nickname [assign_a (nickStr)]
-				>> !(!(ch_p ('!')
-				>> user [assign_a (userStr)])
-				>> ch_p ('@')
-				>> host [assign_a (hostStr)])];
-		rule<> nospcrlfcl = (anychar_p - '\0' - '\r' - '\n' -
-				' ' - ':');
-		rule<> lastParam = lexeme_d [ch_p (' ')
-				>> !ch_p (':')
-				>> (*(ch_p (':') | ch_p (' ') | nospcrlfcl))
-					[assign_a (msgStr)]];
-		rule<> firsParam = lexeme_d [ch_p (' ')
-				>> (nospcrlfcl
-				>> *(ch_p (':') | nospcrlfcl))
-					[push_back_a (opts)]];
-		rule<> params =  *firsParam
-				>> !lastParam;
-		rule<> command = longest_d [(+alpha_p) |
-				(repeat_p (3) [digit_p])] [assign_a (commandStr)];
-		rule<> prefix = longest_d [hostname | nick];
-		rule<> reply = (lexeme_d [!(ch_p (':')
-				>> prefix >> ch_p (' '))]
-				>> command
-				>> !params
-				>> eol_p);
-
-		bool res = parse (msg.toUtf8 ().constData (), reply).full;
-
-		if (!res)
+		// The line is parsed as UTF-8, so only the non-UTF-8 servers need transcoding.
+		const auto& utf8 = codec->mibEnum () == 106 ?
+				message :
+				codec->toUnicode (message).toUtf8 ();
+
+		const auto& line = ParseIrcLine ({ utf8.constData (), static_cast<size_t> (utf8.size ()) });
+		if (!line)
 		{
-			qWarning () << "input string is not a valide IRC command"
-					<< msg;
+			qWarning () << Q_FUNC_INFO
+					<< "input string is not a valid IRC command"
+					<< message;
 			return false;
 		}
-		else
-		{
-			IrcMessageOptions_.Nick_ = QString::fromUtf8 (nickStr.c_str ());
-			IrcMessageOptions_.Command_ = QString::fromUtf8 (commandStr.c_str ()).toLower ();
-			IrcMessageOptions_.Message_ = QString::fromUtf8 (msgStr.c_str ());
-			IrcMessageOptions_.UserName_ = QString::fromUtf8 (userStr.c_str ());
-			IrcMessageOptions_.Host_ = QString::fromUtf8 (hostStr.c_str ());
-			IrcMessageOptions_.Parameters_ = opts;
-		}
+
+		IrcMessageOptions_.Nick_ = ToQString (line->Nick_);
+		IrcMessageOptions_.Command_ = ToQString (line->Command_).toLower ();
+		IrcMessageOptions_.Message_ = ToQString (line->Trailing_);
+		IrcMessageOptions_.UserName_ = ToQString (line->User_);
+		IrcMessageOptions_.Host_ = ToQString (line->Host_);
+
+		IrcMessageOptions_.Parameters_.clear ();
+		IrcMessageOptions_.Parameters_.reserve (line->Params_.size ());
+		for (const auto& param : line->Params_)
+			IrcMessageOptions_.Parameters_.append (std::string { param });
 
 		return true;
 	}
 
-	IrcMessageOptions IrcParser::GetIrcMessageOptions () const
+	const IrcMessageOptions& IrcParser::GetIrcMessageOptions () const
 	{
 		return IrcMessageOptions_;
 	}
@@ -499,18 +457,22 @@ namespace Acetamide
 	QTextCodec* IrcParser::GetCodec ()
 	{
 		const auto& encoding = ISH_->GetServerOptions ().ServerEncoding_;
+		if (LastCodec_ && encoding == LastEncoding_)
+			return LastCodec_;
+
+		LastEncoding_ = encoding;
 
 		const auto codec = encoding == "System" ?
 				QTextCodec::codecForLocale () :
 				QTextCodec::codecForName (encoding.toLatin1 ());
 		if (codec)
-			return codec;
+			return LastCodec_ = codec;
 
 		qWarning () << Q_FUNC_INFO
 				<< "unknown encoding"
 				<< encoding
 				<< ", will fall back to the system encoding";
-		return QTextCodec::codecForLocale ();
+		return LastCodec_ = QTextCodec::codecForLocale ();
 	}
 
 	QStringList IrcParser::EncodingList (const QStringList& list)
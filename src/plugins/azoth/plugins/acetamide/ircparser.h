@@ -50,6 +50,9 @@ namespace Acetamide
 		IrcMessageOptions IrcMessageOptions_;
 
 		QStringList LongAnswerCommands_;
+
+		QString LastEncoding_;
+		QTextCodec *LastCodec_ = nullptr;
 	public:
 		IrcParser (IrcServerHandler*);
 
@@ -102,7 +105,7 @@ namespace Acetamide
 		/** Automatically converts the \em ba to UTF-8.
 		 */
 		bool ParseMessage (const QByteArray& ba);
-		IrcMessageOptions GetIrcMessageOptions () const;
+		const IrcMessageOptions& GetIrcMessageOptions () const;
 	private:
 		QTextCodec* GetCodec ();
 		QStringList EncodingList (const QStringList&);
@@ -70,6 +70,8 @@ namespace Acetamide
 
 	void IrcServerSocket::ConnectToHost (const QString& host, int port)
 	{
+		ReadBuffer_.clear ();
+
 		Util::Visit (Socket_,
 				[&] (const Tcp_ptr& ptr) { ptr->connectToHost (host, port); },
 				[&] (const Ssl_ptr& ptr) { ptr->connectToHostEncrypted (host, port); });
@@ -185,9 +187,16 @@ namespace Acetamide
 
 	void IrcServerSocket::readReply ()
 	{
-		const auto socket = GetSocketPtr ();
-		while (socket->canReadLine ())
-			ISH_->ReadReply (socket->readLine ());
+		ReadBuffer_ += GetSocketPtr ()->readAll ();
+
+		int lineStart = 0;
+		int lineEnd = 0;
+		while ((lineEnd = ReadBuffer_.indexOf ('\n', lineStart)) != -1)
+		{
+			ISH_->ReadReply (ReadBuffer_.mid (lineStart, lineEnd - lineStart + 1));
+			lineStart = lineEnd + 1;
+		}
+		ReadBuffer_.remove (0, lineStart);
 	}
 
 	namespace
@@ -57,6 +57,8 @@ namespace Acetamide
 		std::variant<Tcp_ptr, Ssl_ptr> Socket_;
 
 		QTextCodec *LastCodec_ = nullptr;
+
+		QByteArray ReadBuffer_;
 	public:
 		IrcServerSocket (IrcServerHandler*);
 		~IrcServerSocket();
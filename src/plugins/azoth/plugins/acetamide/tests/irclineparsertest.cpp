@@ -0,0 +1,233 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "irclineparsertest.h"
+#include <QtTest>
+#include "irclineparser.cpp"
+#include "rostername.cpp"
+
+QTEST_APPLESS_MAIN (LC::Azoth::Acetamide::IrcLineParserTest)
+
+namespace LC
+{
+namespace Azoth
+{
+namespace Acetamide
+{
+	namespace
+	{
+		std::optional<IrcLine> Parse (const QByteArray& str)
+		{
+			return ParseIrcLine ({ str.constData (), static_cast<size_t> (str.size ()) });
+		}
+
+		QByteArray ToBA (std::string_view view)
+		{
+			return QByteArray { view.data (), static_cast<int> (view.size ()) };
+		}
+
+		QList<QByteArray> ToBAs (const QVarLengthArray<std::string_view, 16>& views)
+		{
+			QList<QByteArray> result;
+			for (const auto& view : views)
+				result << ToBA (view);
+			return result;
+		}
+
+		const QByteArray ServerName = "irc.example.net";
+		const QByteArray Channel = "#bigchannel";
+		const int ChannelUsers = 10000;
+		const int ListedChannels = 20000;
+		const int Messages = 20000;
+	}
+
+	// A synthetic session shaped like a captured one: joining a channel
+	// with 10k users, requesting a big LIST and chatting for a while.
+	void IrcLineParserTest::initTestCase ()
+	{
+		Session_ << ":" + ServerName + " 001 me :Welcome to the network me\r\n"
+				<< ":" + ServerName + " 005 me PREFIX=(qaohv)~&@%+ CHANTYPES=#& :are supported by this server\r\n"
+				<< ":me!~me@host.example.com JOIN " + Channel + "\r\n";
+
+		const QByteArray signs = "~&@%+";
+		QByteArray namesLine;
+		for (int i = 0; i < ChannelUsers; ++i)
+		{
+			if (!namesLine.isEmpty ())
+				namesLine += ' ';
+			if (i % 10 == 0)
+				namesLine += signs [i % signs.size ()];
+			namesLine += "user" + QByteArray::number (i);
+
+			if (namesLine.size () > 400 || i == ChannelUsers - 1)
+			{
+				Session_ << ":" + ServerName + " 353 me = " + Channel + " :" + namesLine + "\r\n";
+				namesLine.clear ();
+			}
+		}
+		Session_ << ":" + ServerName + " 366 me " + Channel + " :End of /NAMES list.\r\n";
+
+		Session_ << ":" + ServerName + " 321 me Channel :Users  Name\r\n";
+		for (int i = 0; i < ListedChannels; ++i)
+			Session_ << ":" + ServerName + " 322 me #chan" + QByteArray::number (i) + " " +
+					QByteArray::number (i % 500) + " :[+nt] Topic of the channel number " +
+					QByteArray::number (i) + "\r\n";
+		Session_ << ":" + ServerName + " 323 me :End of /LIST\r\n";
+
+		for (int i = 0; i < Messages; ++i)
+			Session_ << ":user" + QByteArray::number (i % ChannelUsers) +
+					"!~user@gateway/web/" + QByteArray::number (i) +
+					" PRIVMSG " + Channel + " :hey there, this is message " +
+					QByteArray::number (i) + " with some: colons\r\n";
+	}
+
+	void IrcLineParserTest::parseServerPrefix ()
+	{
+		const auto& line = Parse (":irc.example.net NOTICE * :*** Looking up your hostname\r\n");
+		QVERIFY (line);
+		QCOMPARE (ToBA (line->Host_), QByteArray { "irc.example.net" });
+		QCOMPARE (ToBA (line->Nick_), QByteArray { "irc" });
+		QCOMPARE (ToBA (line->User_), QByteArray {});
+		QCOMPARE (ToBA (line->Command_), QByteArray { "NOTICE" });
+		QCOMPARE (ToBAs (line->Params_), QList<QByteArray> { "*" });
+		QCOMPARE (ToBA (line->Trailing_), QByteArray { "*** Looking up your hostname" });
+	}
+
+	void IrcLineParserTest::parseUserPrefix ()
+	{
+		const auto& line = Parse (":[nick]!~user@host.example.com PRIVMSG #chan :hi\r\n");
+		QVERIFY (line);
+		QCOMPARE (ToBA (line->Nick_), QByteArray { "[nick]" });
+		QCOMPARE (ToBA (line->User_), QByteArray { "~user" });
+		QCOMPARE (ToBA (line->Host_), QByteArray { "host.example.com" });
+		QCOMPARE (ToBA (line->Command_), QByteArray { "PRIVMSG" });
+		QCOMPARE (ToBAs (line->Params_), QList<QByteArray> { "#chan" });
+		QCOMPARE (ToBA (line->Trailing_), QByteArray { "hi" });
+	}
+
+	void IrcLineParserTest::parseNoPrefix ()
+	{
+		const auto& line = Parse ("PING :irc.example.net\r\n");
+		QVERIFY (line);
+		QVERIFY (line->Nick_.empty ());
+		QVERIFY (line->Host_.empty ());
+		QCOMPARE (ToBA (line->Command_), QByteArray { "PING" });
+		QVERIFY (line->Params_.isEmpty ());
+		QCOMPARE (ToBA (line->Trailing_), QByteArray { "irc.example.net" });
+	}
+
+	void IrcLineParserTest::parseTrailing ()
+	{
+		const auto& line = Parse (":n!u@h PRIVMSG #chan :some text :with colons  and spaces \r\n");
+		QVERIFY (line);
+		QCOMPARE (ToBA (line->Trailing_), QByteArray { "some text :with colons  and spaces " });
+	}
+
+	void IrcLineParserTest::parseEmptyTrailing ()
+	{
+		const auto& line = Parse (":n!u@h TOPIC #chan :\r\n");
+		QVERIFY (line);
+		QCOMPARE (ToBAs (line->Params_), QList<QByteArray> { "#chan" });
+		QVERIFY (line->Trailing_.empty ());
+	}
+
+	void IrcLineParserTest::parseExtraSpaces ()
+	{
+		const auto& line = Parse (":n!u@h MODE  #chan +o:x   nick\n");
+		QVERIFY (line);
+		QCOMPARE (ToBAs (line->Params_), (QList<QByteArray> { "#chan", "+o:x", "nick" }));
+		QVERIFY (line->Trailing_.empty ());
+	}
+
+	void IrcLineParserTest::parseNumeric ()
+	{
+		const auto& line = Parse (":srv 353 me = #chan :@op +voiced plain");
+		QVERIFY (line);
+		QCOMPARE (ToBA (line->Command_), QByteArray { "353" });
+		QCOMPARE (ToBAs (line->Params_), (QList<QByteArray> { "me", "=", "#chan" }));
+		QCOMPARE (ToBA (line->Trailing_), QByteArray { "@op +voiced plain" });
+	}
+
+	void IrcLineParserTest::rejectInvalidCommand ()
+	{
+		QVERIFY (!Parse (":srv 35 me :x\r\n"));
+		QVERIFY (!Parse (":srv 3531 me :x\r\n"));
+		QVERIFY (!Parse (":srv PRIV-MSG me :x\r\n"));
+		QVERIFY (!Parse ("\r\n"));
+	}
+
+	void IrcLineParserTest::rejectPrefixOnly ()
+	{
+		QVERIFY (!Parse (":irc.example.net\r\n"));
+	}
+
+	void IrcLineParserTest::replaySession ()
+	{
+		int params = 0;
+		QBENCHMARK
+		{
+			params = 0;
+			for (const auto& str : Session_)
+				if (const auto& line = Parse (str))
+					params += line->Params_.size ();
+		}
+		QVERIFY (params > 0);
+	}
+
+	// The part of handling the NAMES reply that doesn't depend on Azoth:
+	// parsing the lines and splitting the role prefixes off the nicks.
+	void IrcLineParserTest::replayNames ()
+	{
+		const QStringList prefixList { "(qaohv", "~&@%+" };
+
+		QList<RosterName> names;
+		QBENCHMARK
+		{
+			names.clear ();
+			for (const auto& str : Session_)
+			{
+				const auto& line = Parse (str);
+				if (!line || line->Command_ != "353")
+					continue;
+
+				const auto& nicks = QString::fromUtf8 (line->Trailing_.data (), line->Trailing_.size ())
+						.split (' ', QString::SkipEmptyParts);
+				for (const auto& nick : nicks)
+					names << ParseRosterName (nick, prefixList);
+			}
+		}
+
+		QCOMPARE (names.size (), ChannelUsers);
+		QCOMPARE (names.at (0).Nick_, QString { "user0" });
+		QCOMPARE (names.at (0).Role_, ChannelRole::Owner);
+		QCOMPARE (names.at (1).Role_, ChannelRole::Participant);
+	}
+}
+}
+}
@@ -166,6 +166,7 @@ namespace AdiumStyles
 		{
 			Coloring2Colors_.clear ();
 			Frame2LastContact_.clear ();
+			Frame2BlockSizes_.clear ();
 			LastPack_ = srcPack;
 
 			StylesLoader_->FlushCache ();
@@ -181,6 +182,7 @@ namespace AdiumStyles
 
 		Frame2Pack_ [frame] = pack;
 		Frame2LastContact_.remove (frame);
+		Frame2BlockSizes_.remove (frame);
 
 		const QString& prefix = pack + "/Contents/Resources/";
 
@@ -280,6 +282,143 @@ namespace AdiumStyles
 
 	bool AdiumStyleSource::AppendMessage (QWebFrame *frame,
 			QObject *msgObj, const ChatMsgAppendInfo& info)
+	{
+		const auto& formatted = FormatMessage (frame, msgObj, info, Frame2LastContact_);
+		if (!formatted)
+			return false;
+
+		const auto& bodyS = formatted->HTML_;
+		QString body;
+		body.reserve (bodyS.size () * 1.2);
+		for (int i = 0, size = bodyS.size (); i < size; ++i)
+		{
+			switch (bodyS.at (i).unicode ())
+			{
+			case L'\"':
+				body += "\\\"";
+				break;
+			case L'\n':
+				body += "\\n";
+				break;
+			case L'\t':
+				body += "\\t";
+				break;
+			case L'\\':
+				body += "\\\\";
+				break;
+			case L'\r':
+				body += "\\r";
+				break;
+			default:
+				body += bodyS.at (i);
+				break;
+			}
+		}
+
+		const QString& command = formatted->IsNext_ ? "appendNextMessage(\"%1\");" : "appendMessage(\"%1\");";
+		frame->evaluateJavaScript (command.arg (body));
+
+		auto& blocks = Frame2BlockSizes_ [frame];
+		if (formatted->IsNext_ && !blocks.isEmpty ())
+			++blocks.last ();
+		else
+			blocks << 1;
+
+		SetDeliveryState (frame, msgObj, *formatted);
+
+		return true;
+	}
+
+	namespace
+	{
+		const QRegExp& GetInsertRx ()
+		{
+			static const QRegExp rx ("<(\\w+)[^>]*id=[\"']insert[\"'][^>]*>\\s*</\\1>");
+			return rx;
+		}
+	}
+
+	bool AdiumStyleSource::PrependMessages (QWebFrame *frame, const MessagesBatch_t& messages)
+	{
+		auto chat = frame->findFirstElement ("#Chat");
+		if (chat.isNull ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "no chat element in"
+					<< Frame2Pack_.value (frame);
+			return false;
+		}
+
+		/* Consecutive messages are grouped into the insertion point of
+		 * the block they continue, just like the style's appendNextMessage()
+		 * does. The messages are prepended independently of the current
+		 * last contact, so a separate one is tracked for the batch.
+		 */
+		QHash<QWebFrame*, QObject*> lastContacts;
+		QStringList blocksHTML;
+		QList<int> blockSizes;
+		QList<QPair<QObject*, MessageHTML>> formattedMessages;
+		for (const auto& pair : messages)
+		{
+			const auto& formatted = FormatMessage (frame, pair.first, pair.second, lastContacts);
+			if (!formatted)
+				continue;
+
+			formattedMessages.append ({ pair.first, *formatted });
+
+			if (formatted->IsNext_ && !blocksHTML.isEmpty ())
+			{
+				auto& last = blocksHTML.last ();
+				const auto pos = GetInsertRx ().indexIn (last);
+				if (pos >= 0)
+				{
+					last.replace (pos, GetInsertRx ().matchedLength (), formatted->HTML_);
+					++blockSizes.last ();
+					continue;
+				}
+			}
+
+			blocksHTML << formatted->HTML_;
+			blockSizes << 1;
+		}
+
+		// The live insertion point must remain the first one in the document.
+		auto html = blocksHTML.join (QString {});
+		html.remove (GetInsertRx ());
+
+		chat.prependInside (html);
+		Frame2BlockSizes_ [frame] = blockSizes + Frame2BlockSizes_.value (frame);
+
+		for (const auto& pair : formattedMessages)
+			SetDeliveryState (frame, pair.first, pair.second);
+
+		return true;
+	}
+
+	int AdiumStyleSource::RemoveFirstMessages (QWebFrame *frame, int count)
+	{
+		/* Each appended Content or Action template makes a top level
+		 * element of the chat, and the messages continuing it are put
+		 * inside, so only the whole blocks are removed.
+		 */
+		auto& blocks = Frame2BlockSizes_ [frame];
+		auto child = frame->findFirstElement ("#Chat").firstChild ();
+
+		int removed = 0;
+		while (!blocks.isEmpty () && !child.isNull () &&
+				removed + blocks.first () <= count)
+		{
+			const auto next = child.nextSibling ();
+			child.removeFromDocument ();
+			child = next;
+
+			removed += blocks.takeFirst ();
+		}
+		return removed;
+	}
+
+	std::optional<AdiumStyleSource::MessageHTML> AdiumStyleSource::FormatMessage (QWebFrame *frame,
+			QObject *msgObj, const ChatMsgAppendInfo& info, QHash<QWebFrame*, QObject*>& lastContacts)
 	{
 		IMessage *msg = qobject_cast<IMessage*> (msgObj);
 		if (!msg)
@@ -287,7 +426,7 @@ namespace AdiumStyles
 			qWarning () << Q_FUNC_INFO
 					<< msgObj
 					<< "doesn't implement IMessage";
-			return false;
+			return {};
 		}
 
 		const QString& pack = Frame2Pack_ [frame];
@@ -297,13 +436,14 @@ namespace AdiumStyles
 					<< "empty pack for"
 					<< msgObj
 					<< msg->OtherPart ();
-			return false;
+			return {};
 		}
 
 		connect (msgObj,
 				SIGNAL (destroyed ()),
 				this,
-				SLOT (handleMessageDestroyed ()));
+				SLOT (handleMessageDestroyed ()),
+				Qt::UniqueConnection);
 
 		const bool in = GetMsgDirection (msg) == IMessage::Direction::In;
 
@@ -313,8 +453,8 @@ namespace AdiumStyles
 		const bool alwaysNotNext = isSlashMe ||
 				!(msg->GetMessageType () == IMessage::Type::ChatMessage || msg->GetMessageType () == IMessage::Type::MUCMessage);
 		const bool isNextMsg = !alwaysNotNext &&
-				Frame2LastContact_.contains (frame) &&
-				kindaSender == Frame2LastContact_ [frame];
+				lastContacts.contains (frame) &&
+				kindaSender == lastContacts [frame];
 
 		const QString& root = pack + "/Contents/Resources/";
 		const QString& prefix = root +
@@ -333,11 +473,11 @@ namespace AdiumStyles
 
 		if (msg->GetMessageType () != IMessage::Type::MUCMessage &&
 				msg->GetMessageType () != IMessage::Type::ChatMessage)
-			Frame2LastContact_.remove (frame);
+			lastContacts.remove (frame);
 		else if (!isNextMsg && !alwaysNotNext)
-			Frame2LastContact_ [frame] = kindaSender;
+			lastContacts [frame] = kindaSender;
 		else if (alwaysNotNext)
-			Frame2LastContact_.remove (frame);
+			lastContacts.remove (frame);
 
 		QStringList templCands;
 		templCands << (prefix + filename);
@@ -359,7 +499,7 @@ namespace AdiumStyles
 					<< "unable to load content template for"
 					<< pack
 					<< prefix;
-			return false;
+			return {};
 		}
 
 		if (!content->open (QIODevice::ReadOnly))
@@ -369,71 +509,50 @@ namespace AdiumStyles
 					<< pack
 					<< prefix
 					<< content->errorString ();
-			return false;
+			return {};
 		}
 
 		QString templ = QString::fromUtf8 (content->readAll ());
 		FixSelfClosing (templ);
-		QString bodyS = ParseMsgTemplate (templ, prefix, frame, msgObj, info);
-		QString body;
-		body.reserve (bodyS.size () * 1.2);
-		for (int i = 0, size = bodyS.size (); i < size; ++i)
-		{
-			switch (bodyS.at (i).unicode ())
-			{
-			case L'\"':
-				body += "\\\"";
-				break;
-			case L'\n':
-				body += "\\n";
-				break;
-			case L'\t':
-				body += "\\t";
-				break;
-			case L'\\':
-				body += "\\\\";
-				break;
-			case L'\r':
-				body += "\\r";
-				break;
-			default:
-				body += bodyS.at (i);
-				break;
-			}
-		}
-
-		const QString& command = isNextMsg ? "appendNextMessage(\"%1\");" : "appendMessage(\"%1\");";
-		frame->evaluateJavaScript (command.arg (body));
 
-		if (templ.contains ("%stateElementId%"))
-		{
-			const auto advMsg = qobject_cast<IAdvancedMessage*> (msgObj);
-			QString fname;
-			if (!advMsg || advMsg->IsDelivered () || in)
-				fname = "StateSent.html";
-			else
-			{
-				fname = "StateSending.html";
-				connect (msgObj,
-						SIGNAL (messageDelivered ()),
-						this,
-						SLOT (handleMessageDelivered ()),
-						Qt::UniqueConnection);
-				Msg2Frame_ [msgObj] = frame;
-			}
+		MessageHTML result;
+		result.HTML_ = ParseMsgTemplate (templ, prefix, frame, msgObj, info);
+		result.Prefix_ = prefix;
+		result.IsNext_ = isNextMsg;
+		result.IsIncoming_ = in;
+		result.HasDeliveryState_ = templ.contains ("%stateElementId%");
+		return result;
+	}
 
-			const auto& stateContent = StylesLoader_->Load ({ prefix + fname });
-			QString replacement;
-			if (stateContent && stateContent->open (QIODevice::ReadOnly))
-				replacement = QString::fromUtf8 (stateContent->readAll ());
+	void AdiumStyleSource::SetDeliveryState (QWebFrame *frame, QObject *msgObj, const MessageHTML& formatted)
+	{
+		if (!formatted.HasDeliveryState_)
+			return;
 
-			const QString& selector = QString ("*[id=\"delivery_state_%1\"]")
-					.arg (GetMessageID (msgObj));
-			QWebElement elem = frame->findFirstElement (selector);
-			elem.setInnerXml (replacement);
+		const auto advMsg = qobject_cast<IAdvancedMessage*> (msgObj);
+		QString fname;
+		if (!advMsg || advMsg->IsDelivered () || formatted.IsIncoming_)
+			fname = "StateSent.html";
+		else
+		{
+			fname = "StateSending.html";
+			connect (msgObj,
+					SIGNAL (messageDelivered ()),
+					this,
+					SLOT (handleMessageDelivered ()),
+					Qt::UniqueConnection);
+			Msg2Frame_ [msgObj] = frame;
 		}
 
-		return true;
+		const auto& stateContent = StylesLoader_->Load ({ formatted.Prefix_ + fname });
+		QString replacement;
+		if (stateContent && stateContent->open (QIODevice::ReadOnly))
+			replacement = QString::fromUtf8 (stateContent->readAll ());
+
+		const QString& selector = QString ("*[id=\"delivery_state_%1\"]")
+				.arg (GetMessageID (msgObj));
+		QWebElement elem = frame->findFirstElement (selector);
+		elem.setInnerXml (replacement);
 	}
 
 	void AdiumStyleSource::FrameFocused (QWebFrame*)
@@ -731,6 +850,7 @@ namespace AdiumStyles
 				++i;
 
 		Frame2LastContact_.remove (static_cast<QWebFrame*> (sender ()));
+		Frame2BlockSizes_.remove (static_cast<QWebFrame*> (sender ()));
 		Frame2Pack_.remove (static_cast<QWebFrame*> (sender ()));
 	}
 }
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <QObject>
 #include <QDateTime>
 #include <QHash>
@@ -73,6 +74,20 @@ namespace AdiumStyles
 		QHash<QObject*, QWebFrame*> Msg2Frame_;
 
 		mutable QHash<QWebFrame*, QObject*> Frame2LastContact_;
+
+		/** The number of messages in each of the top level blocks of
+		 * the chat, in the document order.
+		 */
+		QHash<QWebFrame*, QList<int>> Frame2BlockSizes_;
+
+		struct MessageHTML
+		{
+			QString HTML_;
+			QString Prefix_;
+			bool IsNext_;
+			bool IsIncoming_;
+			bool HasDeliveryState_;
+		};
 	public:
 		AdiumStyleSource (IProxyObject*, QObject* = 0);
 
@@ -81,9 +96,15 @@ namespace AdiumStyles
 		QString GetHTMLTemplate (const QString&,
 				const QString&, QObject*, QWebFrame*) const;
 		bool AppendMessage (QWebFrame*, QObject*, const ChatMsgAppendInfo&);
+		bool PrependMessages (QWebFrame*, const MessagesBatch_t&) override;
+		int RemoveFirstMessages (QWebFrame*, int) override;
 		void FrameFocused (QWebFrame*);
 		QStringList GetVariantsForPack (const QString&);
 	private:
+		std::optional<MessageHTML> FormatMessage (QWebFrame*, QObject*,
+				const ChatMsgAppendInfo&, QHash<QWebFrame*, QObject*>&);
+		void SetDeliveryState (QWebFrame*, QObject*, const MessageHTML&);
+
 		void PercentTemplate (QString&, const QMap<QString, QString>&) const;
 		void SubstituteUserIcon (QString&,
 				const QString&, bool, ICLEntry*, IAccount*);
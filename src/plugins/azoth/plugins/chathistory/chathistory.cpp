@@ -182,10 +182,10 @@ namespace ChatHistory
 		return StorageMgr_->GetMaxTimestamp (acc->GetAccountID ());
 	}
 
-	void Plugin::AddRawMessages (const QString& accountId, const QString& entryId,
-			const QString& visibleName, const QList<HistoryItem>& items)
+	QFuture<Plugin::AddRawMessagesResult_t> Plugin::AddRawMessages (const QString& accountId,
+			const QString& entryId, const QString& visibleName, const QList<HistoryItem>& items)
 	{
-		StorageMgr_->AddLogItems (accountId, entryId, visibleName, items, true);
+		return StorageMgr_->AddLogItems (accountId, entryId, visibleName, items, true);
 	}
 
 	void Plugin::InitWidget (ChatHistoryWidget *wh)
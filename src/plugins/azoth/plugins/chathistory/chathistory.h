@@ -113,7 +113,8 @@ namespace ChatHistory
 		bool IsHistoryEnabledFor (QObject*) const;
 		void RequestLastMessages (QObject*, int);
 		QFuture<MaxTimestampResult_t> RequestMaxTimestamp (IAccount*);
-		void AddRawMessages (const QString&, const QString&, const QString&, const QList<HistoryItem>&);
+		QFuture<AddRawMessagesResult_t> AddRawMessages (const QString&, const QString&,
+				const QString&, const QList<HistoryItem>&);
 	private:
 		void InitWidget (ChatHistoryWidget*);
 
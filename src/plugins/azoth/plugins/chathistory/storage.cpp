@@ -124,13 +124,13 @@ namespace ChatHistory
 		AccountInserter_.prepare ("INSERT INTO azoth_accounts (AccountID) VALUES (:account_id);");
 
 		MessageDumper_ = QSqlQuery (*DB_);
-		MessageDumper_.prepare ("INSERT INTO azoth_history (Id, AccountID, Date, Direction, Message, Variant, Type, RichMessage, EscapePolicy) "
-				"VALUES (:id, :account_id, :date, :direction, :message, :variant, :type, :rich_message, :escape_policy);");
+		MessageDumper_.prepare ("INSERT INTO azoth_history (Id, AccountID, Date, Direction, Message, Variant, Type, RichMessage, EscapePolicy, StanzaID) "
+				"VALUES (:id, :account_id, :date, :direction, :message, :variant, :type, :rich_message, :escape_policy, :stanza_id);");
 
 		MessageDumperFuzzy_ = QSqlQuery (*DB_);
 		MessageDumperFuzzy_.prepare (R"(
-				INSERT INTO azoth_history (Id, AccountID, Date, Direction, Message, Variant, Type, RichMessage, EscapePolicy)
-				SELECT :id, :account_id, :date, :direction, :message, :variant, :type, :rich_message, :escape_policy
+				INSERT INTO azoth_history (Id, AccountID, Date, Direction, Message, Variant, Type, RichMessage, EscapePolicy, StanzaID)
+				SELECT :id, :account_id, :date, :direction, :message, :variant, :type, :rich_message, :escape_policy, :stanza_id
 				WHERE NOT EXISTS (
 					SELECT 1 FROM azoth_history
 					WHERE Id = :id_inner
@@ -139,6 +139,12 @@ namespace ChatHistory
 						AND Message = :message_inner
 						AND abs(Date - :date_inner) < :tolerance
 				)
+				AND NOT EXISTS (
+					SELECT 1 FROM azoth_history
+					WHERE Id = :id_stanza
+						AND AccountID = :account_id_stanza
+						AND StanzaID = :stanza_id_inner
+				)
 				)");
 
 		UsersForAccountGetter_ = QSqlQuery (*DB_);
@@ -282,6 +288,7 @@ namespace ChatHistory
 					"Type INTEGER, "
 					"RichMessage TEXT, "
 					"EscapePolicy VARCHAR(3), "
+					"StanzaID TEXT, "
 					"UNIQUE (Id, AccountId, Date, Direction, Message, Variant, Type) ON CONFLICT IGNORE);"
 			},
 			{
@@ -328,6 +335,12 @@ namespace ChatHistory
 			throw std::runtime_error ("Unable to index `azoth_history`.");
 		}
 
+		if (!query.exec ("CREATE INDEX IF NOT EXISTS azoth_history_stanzaid ON azoth_history (Id, AccountId, StanzaID);"))
+		{
+			Util::DBLock::DumpError (query);
+			throw std::runtime_error ("Unable to index `azoth_history` by stanza IDs.");
+		}
+
 		if (!hadAcc2User)
 			RegenUsersCache ();
 
@@ -367,6 +380,16 @@ namespace ChatHistory
 					<< columns;
 			throw std::runtime_error ("Unable to add column `EscapePolicy` to `azoth_history`.");
 		}
+
+		if (!columns.contains ("StanzaID") &&
+				!query.exec ("ALTER TABLE azoth_history ADD COLUMN StanzaID TEXT;"))
+		{
+			Util::DBLock::DumpError (query);
+			qWarning () << Q_FUNC_INFO
+					<< "existing columns:"
+					<< columns;
+			throw std::runtime_error ("Unable to add column `StanzaID` to `azoth_history`.");
+		}
 	}
 
 	QHash<QString, qint32> Storage::GetUsers ()
@@ -778,6 +801,9 @@ namespace ChatHistory
 			dumper.bindValue (":rich_message", logItem.RichMessage_);
 			dumper.bindValue (":escape_policy", ToVariant (logItem.EscPolicy_));
 			dumper.bindValue (":type", ToVariant (logItem.Type_));
+			dumper.bindValue (":stanza_id", logItem.StanzaID_.isEmpty () ?
+					QVariant {} :
+					QVariant { logItem.StanzaID_ });
 		}
 
 		void BindFuzzy (QSqlQuery& dumper, qint32 userId, qint32 accountId, const LogItem& logItem)
@@ -790,13 +816,23 @@ namespace ChatHistory
 			dumper.bindValue (":direction_inner", ToVariant (logItem.Dir_));
 			dumper.bindValue (":message_inner", logItem.Message_);
 			dumper.bindValue (":tolerance", 0.1);
+
+			// NULL never compares equal, so items without a stanza ID
+			// are only matched by the check above.
+			dumper.bindValue (":id_stanza", userId);
+			dumper.bindValue (":account_id_stanza", accountId);
+			dumper.bindValue (":stanza_id_inner", logItem.StanzaID_.isEmpty () ?
+					QVariant {} :
+					QVariant { logItem.StanzaID_ });
 		}
 	}
 
-	void Storage::AddMessages (const QString& accountID,
+	IHistoryPlugin::AddRawMessagesResult_t Storage::AddMessages (const QString& accountID,
 			const QString& entryID, const QString& visibleName,
 			const QList<LogItem>& items, bool fuzzy)
 	{
+		using R_t = IHistoryPlugin::AddRawMessagesResult_t;
+
 		Util::DBLock lock (*DB_);
 		try
 		{
@@ -807,7 +843,7 @@ namespace ChatHistory
 			qWarning () << Q_FUNC_INFO
 					<< "unable to start transaction:"
 					<< e.what ();
-			return;
+			return R_t::Left ("Unable to start transaction.");
 		}
 
 		if (!Accounts_.contains (accountID))
@@ -821,7 +857,7 @@ namespace ChatHistory
 						<< accountID
 						<< "unable to add account ID to the DB:"
 						<< e.what ();
-				return;
+				return R_t::Left ("Unable to add the account to the DB.");
 			}
 
 		if (!Users_.contains (entryID))
@@ -835,7 +871,7 @@ namespace ChatHistory
 						<< entryID
 						<< "unable to add the user to the DB:"
 						<< e.what ();
-				return;
+				return R_t::Left ("Unable to add the user to the DB.");
 			}
 
 		auto userId = Users_ [entryID];
@@ -861,11 +897,12 @@ namespace ChatHistory
 			if (!query.exec ())
 			{
 				Util::DBLock::DumpError (query);
-				return;
+				return R_t::Left ("Error executing the SQL query.");
 			}
 		}
 
 		lock.Good ();
+		return R_t::Right ({});
 	}
 
 	IHistoryPlugin::MaxTimestampResult_t Storage::GetMaxTimestamp (const QString& accountId)
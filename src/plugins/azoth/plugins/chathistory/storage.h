@@ -116,7 +116,7 @@ namespace ChatHistory
 		ChatLogsResult_t GetChatLogs (const QString& accountId,
 				const QString& entryId, int backpages, int amount);
 
-		void AddMessages (const QString& accountId, const QString& entryId,
+		IHistoryPlugin::AddRawMessagesResult_t AddMessages (const QString& accountId, const QString& entryId,
 				const QString& visibleName, const QList<LogItem>&, bool fuzzy);
 
 		SearchResult_t Search (const QString& accountId, const QString& entryId,
@@ -159,10 +159,10 @@ namespace ChatHistory
 				false);
 	}
 
-	void StorageManager::AddLogItems (const QString& accountId, const QString& entryId,
-			const QString& visibleName, const QList<LogItem>& items, bool fuzzy)
+	QFuture<IHistoryPlugin::AddRawMessagesResult_t> StorageManager::AddLogItems (const QString& accountId,
+			const QString& entryId, const QString& visibleName, const QList<LogItem>& items, bool fuzzy)
 	{
-		StorageThread_->ScheduleImpl (&Storage::AddMessages,
+		return StorageThread_->ScheduleImpl (&Storage::AddMessages,
 				accountId,
 				entryId,
 				visibleName,
@@ -51,7 +51,8 @@ namespace ChatHistory
 		StorageManager (LoggingStateKeeper*);
 
 		void Process (QObject*);
-		void AddLogItems (const QString&, const QString&, const QString&, const QList<LogItem>&, bool);
+		QFuture<IHistoryPlugin::AddRawMessagesResult_t> AddLogItems (const QString&,
+				const QString&, const QString&, const QList<LogItem>&, bool);
 
 		QFuture<IHistoryPlugin::MaxTimestampResult_t> GetMaxTimestamp (const QString&);
 
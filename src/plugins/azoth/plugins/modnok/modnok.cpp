@@ -65,6 +65,8 @@ namespace Modnok
 					"TextColor"
 				},
 				this, "clearCaches");
+		XmlSettingsManager::Instance ().RegisterObject ("OnDisplayRendering",
+				this, "bodyTransformersChanged");
 
 		const QStringList candidates
 		{
@@ -234,39 +236,23 @@ namespace Modnok
 		return body;
 	}
 
-	void Plugin::hookFormatBodyEnd (IHookProxy_ptr proxy, QObject*)
+	BodyTransformers_t Plugin::GetBodyTransformers ()
 	{
 		if (ConvScriptPath_.isEmpty ())
-			return;
-
-		if (!XmlSettingsManager::Instance ()
-				.property ("OnDisplayRendering").toBool ())
-			return;
-
-		const QString& body = proxy->GetValue ("body").toString ();
-
-		if (!body.contains ("$$"))
-			return;
-
-		const QString newBody = HandleBody (body);
-		if (body != newBody)
-			proxy->SetValue ("body", newBody);
-	}
-
-	void Plugin::hookGonnaHandleSmiles (IHookProxy_ptr proxy,
-			QString body, QString)
-	{
-		if (ConvScriptPath_.isEmpty ())
-			return;
+			return {};
 
 		if (!XmlSettingsManager::Instance ()
 				.property ("OnDisplayRendering").toBool ())
-			return;
+			return {};
 
-		if (!body.contains ("$$"))
-			return;
-
-		proxy->CancelDefault ();
+		// The rendered formulas are images, so the emoticons and other
+		// transformers never see the formulas text.
+		const auto transform = [this] (const QString& text, IMessage*)
+		{
+			const auto& newText = HandleBody (text);
+			return newText == text ? QString {} : newText;
+		};
+		return { { "$$", transform } };
 	}
 
 	void Plugin::hookMessageCreated (IHookProxy_ptr, QObject*, QObject *msgObj)
@@ -314,6 +300,7 @@ namespace Modnok
 	void Plugin::clearCaches ()
 	{
 		FormulasCache_.clear ();
+		emit bodyTransformersChanged ();
 	}
 
 	void Plugin::handleCacheSize ()
@@ -37,6 +37,7 @@
 #include <interfaces/iplugin2.h>
 #include <interfaces/ihavesettings.h>
 #include <interfaces/core/ihookproxy.h>
+#include <interfaces/azoth/iprovidebodytransformers.h>
 
 class QTranslator;
 class QImage;
@@ -51,9 +52,10 @@ namespace Modnok
 				 , public IInfo
 				 , public IPlugin2
 				 , public IHaveSettings
+				 , public IProvideBodyTransformers
 	{
 		Q_OBJECT
-		Q_INTERFACES (IInfo IPlugin2 IHaveSettings)
+		Q_INTERFACES (IInfo IPlugin2 IHaveSettings LC::Azoth::IProvideBodyTransformers)
 
 		LC_PLUGIN_METADATA ("org.LeechCraft.Azoth.Modnok")
 
@@ -74,21 +76,20 @@ namespace Modnok
 		QSet<QByteArray> GetPluginClasses () const;
 
 		Util::XmlSettingsDialog_ptr GetSettingsDialog () const;
+
+		BodyTransformers_t GetBodyTransformers ();
 	private:
 		QImage GetRenderedImage (const QString&);
 		QString HandleBody (QString);
 	public slots:
-		void hookFormatBodyEnd (LC::IHookProxy_ptr proxy,
-				QObject *message);
-		void hookGonnaHandleSmiles (LC::IHookProxy_ptr proxy,
-				QString body,
-				QString pack);
 		void hookMessageCreated (LC::IHookProxy_ptr proxy,
 				QObject *chatTab,
 				QObject *message);
 	private slots:
 		void clearCaches ();
 		void handleCacheSize ();
+	signals:
+		void bodyTransformersChanged ();
 	};
 }
 }
@@ -28,6 +28,7 @@
  **********************************************************************/
 
 #include "standardstylesource.h"
+#include <algorithm>
 #include <QTextDocument>
 #include <QWebElement>
 #include <QWebFrame>
@@ -80,9 +81,10 @@ namespace StandardStyles
 	}
 
 	QString StandardStyleSource::GetHTMLTemplate (const QString& pack,
-			const QString&, QObject *entryObj, QWebFrame*) const
+			const QString&, QObject *entryObj, QWebFrame *frame) const
 	{
 		Coloring2Colors_.clear ();
+		Frame2BgColor_.remove (frame);
 		if (pack != LastPack_)
 		{
 			LastPack_ = pack;
@@ -141,6 +143,70 @@ namespace StandardStyles
 
 	bool StandardStyleSource::AppendMessage (QWebFrame *frame,
 			QObject *msgObj, const ChatMsgAppendInfo& info)
+	{
+		return AppendMessages (frame, { { msgObj, info } });
+	}
+
+	bool StandardStyleSource::AppendMessages (QWebFrame *frame, const MessagesBatch_t& messages)
+	{
+		const QString separator { "<hr class=\"lastSeparator\" />" };
+
+		auto elem = frame->findFirstElement ("body");
+
+		QString html;
+		for (const auto& pair : messages)
+		{
+			const auto msgObj = pair.first;
+			const auto msg = qobject_cast<IMessage*> (msgObj);
+			if (msg->GetMessageType () == IMessage::Type::ChatMessage ||
+				msg->GetMessageType () == IMessage::Type::MUCMessage)
+			{
+				const auto isRead = Proxy_->IsMessageRead (msgObj);
+				if (!pair.second.IsActiveChat_ &&
+						!isRead && IsLastMsgRead_.value (frame, false))
+				{
+					const auto pos = html.indexOf (separator);
+					if (pos >= 0)
+						html.remove (pos, separator.size ());
+					else
+					{
+						auto hr = elem.findFirst ("hr[class=\"lastSeparator\"]");
+						if (!hr.isNull ())
+							hr.removeFromDocument ();
+					}
+					html += separator;
+				}
+				IsLastMsgRead_ [frame] = isRead;
+			}
+
+			html += FormatMessage (frame, msgObj, pair.second);
+		}
+
+		elem.appendInside (html);
+		return true;
+	}
+
+	bool StandardStyleSource::PrependMessages (QWebFrame *frame, const MessagesBatch_t& messages)
+	{
+		QString html;
+		for (const auto& pair : messages)
+			html += FormatMessage (frame, pair.first, pair.second);
+
+		frame->findFirstElement ("body").prependInside (html);
+		return true;
+	}
+
+	int StandardStyleSource::RemoveFirstMessages (QWebFrame *frame, int count)
+	{
+		const auto& elems = frame->findAllElements ("body > div[data-azoth-message]");
+		const auto removed = std::min (count, elems.count ());
+		for (int i = 0; i < removed; ++i)
+			elems.at (i).removeFromDocument ();
+		return removed;
+	}
+
+	QString StandardStyleSource::FormatMessage (QWebFrame *frame,
+			QObject *msgObj, const ChatMsgAppendInfo& info)
 	{
 		QObject *azothSettings = Proxy_->GetSettingsManager ();
 		const auto& colors = CreateColors (frame->metaData ().value ("coloring"), frame);
@@ -309,27 +375,9 @@ namespace StandardStyles
 					.arg (msgId));
 		string.append (body);
 
-		QWebElement elem = frame->findFirstElement ("body");
-
-		if (msg->GetMessageType () == IMessage::Type::ChatMessage ||
-			msg->GetMessageType () == IMessage::Type::MUCMessage)
-		{
-			const auto isRead = Proxy_->IsMessageRead (msgObj);
-			if (!info.IsActiveChat_ &&
-					!isRead && IsLastMsgRead_.value (frame, false))
-			{
-				auto hr = elem.findFirst ("hr[class=\"lastSeparator\"]");
-				if (!hr.isNull ())
-					hr.removeFromDocument ();
-				elem.appendInside ("<hr class=\"lastSeparator\" />");
-			}
-			IsLastMsgRead_ [frame] = isRead;
-		}
-
-		elem.appendInside (QString ("<div class='%1' style='word-wrap: break-word;'>%2</div>")
+		return QString ("<div class='%1' data-azoth-message='' style='word-wrap: break-word;'>%2</div>")
 					.arg (divClass)
-					.arg (string));
-		return true;
+					.arg (string);
 	}
 
 	void StandardStyleSource::FrameFocused (QWebFrame *frame)
@@ -342,8 +390,15 @@ namespace StandardStyles
 		return {};
 	}
 
-	QList<QColor> StandardStyleSource::CreateColors (const QString& scheme, QWebFrame *frame)
+	QColor StandardStyleSource::GetBgColor (QWebFrame *frame)
 	{
+		// Querying the computed style forces a style recalculation in the
+		// middle of appending messages, so the color is cached until the
+		// frame gets a new template.
+		const auto pos = Frame2BgColor_.find (frame);
+		if (pos != Frame2BgColor_.end ())
+			return *pos;
+
 		QColor bgColor;
 
 		const auto js = "window.getComputedStyle(document.body) ['background-color']";
@@ -357,6 +412,18 @@ namespace StandardStyles
 			bgColor.setRgb (vals.value (0).toInt (),
 					vals.value (1).toInt (), vals.value (2).toInt ());
 
+		connect (frame,
+				SIGNAL (destroyed (QObject*)),
+				this,
+				SLOT (handleFrameDestroyed ()),
+				Qt::UniqueConnection);
+		Frame2BgColor_ [frame] = bgColor;
+		return bgColor;
+	}
+
+	QList<QColor> StandardStyleSource::CreateColors (const QString& scheme, QWebFrame *frame)
+	{
+		const auto& bgColor = GetBgColor (frame);
 		const auto& mangledScheme = scheme + bgColor.name ();
 
 		if (!Coloring2Colors_.contains (mangledScheme))
@@ -405,6 +472,7 @@ namespace StandardStyles
 	void StandardStyleSource::handleFrameDestroyed ()
 	{
 		IsLastMsgRead_.remove (static_cast<QWebFrame*> (sender ()));
+		Frame2BgColor_.remove (static_cast<QWebFrame*> (sender ()));
 		const QObject *snd = sender ();
 		for (QHash<QObject*, QWebFrame*>::iterator i = Msg2Frame_.begin ();
 				i != Msg2Frame_.end (); )
@@ -62,6 +62,7 @@ namespace StandardStyles
 		IProxyObject *Proxy_;
 
 		mutable QHash<QString, QList<QColor>> Coloring2Colors_;
+		mutable QHash<QWebFrame*, QColor> Frame2BgColor_;
 		mutable QString LastPack_;
 
 		QHash<QObject*, QWebFrame*> Msg2Frame_;
@@ -73,9 +74,15 @@ namespace StandardStyles
 		QString GetHTMLTemplate (const QString&,
 				const QString&, QObject*, QWebFrame*) const;
 		bool AppendMessage (QWebFrame*, QObject*, const ChatMsgAppendInfo&);
+		bool AppendMessages (QWebFrame*, const MessagesBatch_t&) override;
+		bool PrependMessages (QWebFrame*, const MessagesBatch_t&) override;
+		int RemoveFirstMessages (QWebFrame*, int) override;
 		void FrameFocused (QWebFrame*);
 		QStringList GetVariantsForPack (const QString&);
 	private:
+		QString FormatMessage (QWebFrame*, QObject*, const ChatMsgAppendInfo&);
+
+		QColor GetBgColor (QWebFrame*);
 		QList<QColor> CreateColors (const QString&, QWebFrame*);
 		QString GetMessageID (QObject*);
 		QString GetStatusImage (const QString&);
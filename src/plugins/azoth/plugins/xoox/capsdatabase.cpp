@@ -29,6 +29,7 @@
 
 #include "capsdatabase.h"
 #include <QDataStream>
+#include <QDateTime>
 #include <QFile>
 #include <QTimer>
 #include <util/util.h>
@@ -41,12 +42,26 @@ namespace Azoth
 {
 namespace Xoox
 {
+	namespace
+	{
+		const int FlushInterval = 2000;
+
+		/** Unanswered requests are repeated after this timeout.
+		 */
+		const qint64 RequestTimeout = 5 * 60 * 1000;
+	}
+
 	CapsDatabase::CapsDatabase (const ILoadProgressReporter_ptr& lpr, QObject *parent)
 	: QObject { parent }
 	, Storage_ { new CapsStorageOnDisk { lpr, this } }
 	{
 	}
 
+	CapsDatabase::~CapsDatabase ()
+	{
+		Flush ();
+	}
+
 	bool CapsDatabase::Contains (const QByteArray& hash) const
 	{
 		if (Ver2Features_.contains (hash) && Ver2Identities_.contains (hash))
@@ -55,6 +70,20 @@ namespace Xoox
 		return Preload (hash);
 	}
 
+	bool CapsDatabase::ShouldRequest (const QByteArray& hash)
+	{
+		const auto now = QDateTime::currentMSecsSinceEpoch ();
+		const auto requested = RequestedVers_.find (hash);
+		if (requested != RequestedVers_.end () && now - *requested < RequestTimeout)
+			return false;
+
+		if (Contains (hash))
+			return false;
+
+		RequestedVers_ [hash] = now;
+		return true;
+	}
+
 	QStringList CapsDatabase::Get (const QByteArray& hash) const
 	{
 		if (!Ver2Features_.contains (hash))
@@ -65,8 +94,16 @@ namespace Xoox
 
 	void CapsDatabase::Set (const QByteArray& hash, const QStringList& features)
 	{
+		RequestedVers_.remove (hash);
+
+		// the ver is the hash of the caps, so known caps never change
+		const auto pos = Ver2Features_.find (hash);
+		if (pos != Ver2Features_.end () && *pos == features)
+			return;
+
 		Ver2Features_ [hash] = features;
-		Storage_->AddFeatures (hash, features);
+		PendingFeatures_ [hash] = features;
+		ScheduleFlush ();
 	}
 
 	QList<QXmppDiscoveryIq::Identity> CapsDatabase::GetIdentities (const QByteArray& hash) const
@@ -80,8 +117,12 @@ namespace Xoox
 	void CapsDatabase::SetIdentities (const QByteArray& hash,
 			const QList<QXmppDiscoveryIq::Identity>& ids)
 	{
+		if (Ver2Identities_.contains (hash))
+			return;
+
 		Ver2Identities_ [hash] = ids;
-		Storage_->AddIdentities (hash, ids);
+		PendingIdentities_ [hash] = ids;
+		ScheduleFlush ();
 	}
 
 	bool CapsDatabase::Preload (const QByteArray& hash) const
@@ -95,6 +136,27 @@ namespace Xoox
 		Ver2Identities_ [hash] = *identities;
 		return true;
 	}
+
+	void CapsDatabase::ScheduleFlush ()
+	{
+		if (FlushScheduled_)
+			return;
+
+		FlushScheduled_ = true;
+		QTimer::singleShot (FlushInterval, this, [this] { Flush (); });
+	}
+
+	void CapsDatabase::Flush ()
+	{
+		FlushScheduled_ = false;
+
+		if (PendingFeatures_.isEmpty () && PendingIdentities_.isEmpty ())
+			return;
+
+		Storage_->AddBatch (PendingFeatures_, PendingIdentities_);
+		PendingFeatures_.clear ();
+		PendingIdentities_.clear ();
+	}
 }
 }
 }
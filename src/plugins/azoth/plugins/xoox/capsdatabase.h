@@ -43,17 +43,38 @@ namespace Xoox
 {
 	class CapsStorageOnDisk;
 
+	/** @brief Entity capabilities cache shared by all the accounts.
+	 *
+	 * New entries are kept in memory and written to the disk in
+	 * batches, one transaction per batch.
+	 */
 	class CapsDatabase : public QObject
 	{
 		mutable QHash<QByteArray, QStringList> Ver2Features_;
 		mutable QHash<QByteArray, QList<QXmppDiscoveryIq::Identity>> Ver2Identities_;
 
+		QHash<QByteArray, QStringList> PendingFeatures_;
+		QHash<QByteArray, QList<QXmppDiscoveryIq::Identity>> PendingIdentities_;
+		bool FlushScheduled_ = false;
+
+		QHash<QByteArray, qint64> RequestedVers_;
+
 		CapsStorageOnDisk * const Storage_;
 	public:
 		CapsDatabase (const ILoadProgressReporter_ptr&, QObject* = 0);
+		~CapsDatabase () override;
 
 		bool Contains (const QByteArray&) const;
 
+		/** @brief Checks whether the caps for the given ver should be
+		 * requested.
+		 *
+		 * Returns false if the caps are already known or if they have
+		 * recently been requested by this or any other account.
+		 * Otherwise, marks them as requested and returns true.
+		 */
+		bool ShouldRequest (const QByteArray&);
+
 		QStringList Get (const QByteArray&) const;
 		void Set (const QByteArray&, const QStringList&);
 
@@ -61,6 +82,9 @@ namespace Xoox
 		void SetIdentities (const QByteArray&, const QList<QXmppDiscoveryIq::Identity>&);
 	private:
 		bool Preload (const QByteArray&) const;
+
+		void ScheduleFlush ();
+		void Flush ();
 	};
 }
 }
@@ -31,8 +31,8 @@
 #include <QHash>
 #include <QDir>
 #include <QDataStream>
-#include <QElapsedTimer>
 #include <QSqlError>
+#include <QTimer>
 #include <QXmppDiscoveryIq.h>
 #include <util/sll/qtutil.h>
 #include <util/sll/util.h>
@@ -49,6 +49,11 @@ namespace Azoth
 {
 namespace Xoox
 {
+	namespace
+	{
+		const int MigrationChunkSize = 256;
+	}
+
 	CapsStorageOnDisk::CapsStorageOnDisk (const ILoadProgressReporter_ptr& lpr, QObject *parent)
 	: QObject { parent }
 	{
@@ -98,6 +103,10 @@ namespace Xoox
 
 	boost::optional<QStringList> CapsStorageOnDisk::GetFeatures (const QByteArray& ver) const
 	{
+		const auto legacy = LegacyFeatures_.find (ver);
+		if (legacy != LegacyFeatures_.end ())
+			return *legacy;
+
 		SelectFeatures_.bindValue (":ver", ver);
 		Util::DBLock::Execute (SelectFeatures_);
 
@@ -110,6 +119,15 @@ namespace Xoox
 	}
 
 	boost::optional<QList<QXmppDiscoveryIq::Identity>> CapsStorageOnDisk::GetIdentities (const QByteArray& ver) const
+	{
+		const auto legacy = LegacyIdentities_.find (ver);
+		if (legacy != LegacyIdentities_.end ())
+			return *legacy;
+
+		return SelectIdentities (ver);
+	}
+
+	QList<QXmppDiscoveryIq::Identity> CapsStorageOnDisk::SelectIdentities (const QByteArray& ver) const
 	{
 		SelectIdentities_.bindValue (":ver", ver);
 		Util::DBLock::Execute (SelectIdentities_);
@@ -161,6 +179,21 @@ namespace Xoox
 		lock.Good ();
 	}
 
+	void CapsStorageOnDisk::AddBatch (const QHash<QByteArray, QStringList>& features,
+			const QHash<QByteArray, QList<QXmppDiscoveryIq::Identity>>& identities)
+	{
+		Util::DBLock lock { DB_ };
+		lock.Init ();
+
+		for (const auto& pair : Util::Stlize (features))
+			AddFeatures (pair.first, pair.second);
+
+		for (const auto& pair : Util::Stlize (identities))
+			AddIdentities (pair.first, pair.second);
+
+		lock.Good ();
+	}
+
 	void CapsStorageOnDisk::InitTables ()
 	{
 		if (DB_.tables ().contains ("Features"))
@@ -223,39 +256,60 @@ namespace Xoox
 		if (ver >= 2)
 			stream >> identities;
 
-		const auto& proc = lpr->InitiateProcess (tr ("Migrating capabilities database..."),
-				0, features.size () + identities.size ());
+		LegacyFeatures_ = features;
+		LegacyIdentities_ = identities;
 
-		QElapsedTimer timer;
-		timer.start ();
+		MigrationTotal_ = features.size () + identities.size ();
+		MigrationProc_ = lpr->InitiateProcess (tr ("Migrating capabilities database..."),
+				0, MigrationTotal_);
+		MigrationTimer_.start ();
 
+		QTimer::singleShot (0, this, [this] { MigrateChunk (); });
+	}
+
+	void CapsStorageOnDisk::MigrateChunk ()
+	{
 		Util::DBLock lock { DB_ };
 		lock.Init ();
 
-		for (const auto& pair : Util::Stlize (features))
+		int migrated = 0;
+		for (auto it = LegacyFeatures_.begin ();
+				it != LegacyFeatures_.end () && migrated < MigrationChunkSize; ++migrated)
 		{
-			AddFeatures (pair.first, pair.second);
-			++*proc;
+			AddFeatures (it.key (), it.value ());
+			it = LegacyFeatures_.erase (it);
 		}
 
-		for (const auto& pair : Util::Stlize (identities))
+		for (auto it = LegacyIdentities_.begin ();
+				it != LegacyIdentities_.end () && migrated < MigrationChunkSize; ++migrated)
 		{
-			AddIdentities (pair.first, pair.second);
-			++*proc;
+			// the identities have no unique key, and an interrupted
+			// migration is started over on the next run
+			if (SelectIdentities (it.key ()).isEmpty ())
+				AddIdentities (it.key (), it.value ());
+			it = LegacyIdentities_.erase (it);
 		}
 
 		lock.Good ();
 
+		const auto left = LegacyFeatures_.size () + LegacyIdentities_.size ();
+		MigrationProc_->ReportValue (MigrationTotal_ - left);
+
+		if (left)
+		{
+			QTimer::singleShot (0, this, [this] { MigrateChunk (); });
+			return;
+		}
+
 		qDebug () << Q_FUNC_INFO
 				<< "migration of"
-				<< features.size ()
-				<< "features and"
-				<< identities.size ()
-				<< "identities took"
-				<< timer.elapsed ()
+				<< MigrationTotal_
+				<< "entries took"
+				<< MigrationTimer_.elapsed ()
 				<< "ms";
 
-		file.remove ();
+		MigrationProc_.reset ();
+		QFile::remove (Util::CreateIfNotExists ("azoth/xoox").filePath ("caps_s.db"));
 	}
 }
 }
@@ -30,9 +30,11 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <QHash>
 #include <QObject>
 #include <QSqlDatabase>
 #include <QSqlQuery>
+#include <QElapsedTimer>
 #include <QXmppDiscoveryIq.h>
 #include <interfaces/core/iloadprogressreporter.h>
 
@@ -51,6 +53,16 @@ namespace Xoox
 
 		mutable QSqlQuery SelectFeatures_;
 		mutable QSqlQuery SelectIdentities_;
+
+		/* The entries of the legacy storage that are not migrated yet.
+		 * They are migrated in chunks from the event loop to avoid
+		 * blocking the startup.
+		 */
+		QHash<QByteArray, QStringList> LegacyFeatures_;
+		QHash<QByteArray, QList<QXmppDiscoveryIq::Identity>> LegacyIdentities_;
+		ILoadProcess_ptr MigrationProc_;
+		int MigrationTotal_ = 0;
+		QElapsedTimer MigrationTimer_;
 	public:
 		CapsStorageOnDisk (const ILoadProgressReporter_ptr&, QObject* = nullptr);
 
@@ -59,11 +71,17 @@ namespace Xoox
 
 		void AddFeatures (const QByteArray&, const QStringList&);
 		void AddIdentities (const QByteArray&, const QList<QXmppDiscoveryIq::Identity>&);
+
+		void AddBatch (const QHash<QByteArray, QStringList>& features,
+				const QHash<QByteArray, QList<QXmppDiscoveryIq::Identity>>& identities);
 	private:
 		void InitTables ();
 		void InitQueries ();
 
+		QList<QXmppDiscoveryIq::Identity> SelectIdentities (const QByteArray&) const;
+
 		void Migrate (const ILoadProgressReporter_ptr&);
+		void MigrateChunk ();
 	};
 }
 }
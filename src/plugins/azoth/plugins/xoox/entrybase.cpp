@@ -292,7 +292,10 @@ namespace Xoox
 		switch (field)
 		{
 		case DataField::BirthDate:
-			return GetVCard ().birthday ();
+		{
+			const auto storage = Account_->GetParentProtocol ()->GetVCardStorage ();
+			return storage->GetVCardBirthday (GetHumanReadableID ()).value_or (QDate {});
+		}
 		}
 
 		qWarning () << Q_FUNC_INFO
@@ -437,21 +440,25 @@ namespace Xoox
 
 	namespace
 	{
-		QByteArray ComputeVCardPhotoHash (const QXmppVCardIq& vcard)
+		QByteArray ComputePhotoHash (const QByteArray& photo)
 		{
-			const auto& photo = vcard.photo ();
 			return photo.isEmpty () ?
 					QByteArray {} :
 					QCryptographicHash::hash (photo, QCryptographicHash::Sha1);
 		}
+
+		QByteArray ComputeVCardPhotoHash (const QXmppVCardIq& vcard)
+		{
+			return ComputePhotoHash (vcard.photo ());
+		}
 	}
 
 	QFuture<QImage> EntryBase::RefreshAvatar (Size)
 	{
-		const auto maybeVCard = Account_->GetParentProtocol ()->
-				GetVCardStorage ()->GetVCard (GetHumanReadableID ());
-		if (maybeVCard && VCardPhotoHash_ == ComputeVCardPhotoHash (*maybeVCard))
-			return Util::MakeReadyFuture (QImage::fromData (maybeVCard->photo ()));
+		const auto maybePhoto = Account_->GetParentProtocol ()->
+				GetVCardStorage ()->GetVCardPhoto (GetHumanReadableID ());
+		if (maybePhoto && VCardPhotoHash_ == ComputePhotoHash (*maybePhoto))
+			return Util::MakeReadyFuture (QImage::fromData (*maybePhoto));
 
 		if (!Account_->GetClientConnection ()->IsConnected ())
 			return Util::MakeReadyFuture (QImage {});
@@ -72,6 +72,7 @@
 #include "xeps/xep0313manager.h"
 #include "xep0313prefsdialog.h"
 #include "xep0313modelmanager.h"
+#include "xep0313syncer.h"
 #include "pendinglastactivityrequest.h"
 #include "xeps/lastactivitymanager.h"
 #include "roomhandler.h"
@@ -603,10 +604,8 @@ namespace Xoox
 		{
 		case ServerHistoryFeature::AccountSupportsHistory:
 		case ServerHistoryFeature::Configurable:
-			return supportsMam;
 		case ServerHistoryFeature::DatedFetching:
-			// TODO
-			return false;
+			return supportsMam;
 		}
 
 		qWarning () << Q_FUNC_INFO
@@ -638,9 +637,23 @@ namespace Xoox
 		return { 0, Qt::DisplayRole, Qt::AscendingOrder };
 	}
 
-	QFuture<IHaveServerHistory::DatedFetchResult_t> GlooxAccount::FetchServerHistory (const QDateTime&)
+	QFuture<IHaveServerHistory::DatedFetchResult_t> GlooxAccount::FetchServerHistory (const QDateTime& since)
 	{
-		return Util::MakeReadyFuture (IHaveServerHistory::DatedFetchResult_t::Left ("Not implemented yet."));
+		if (Xep0313Syncer_)
+			Xep0313Syncer_->deleteLater ();
+
+		Xep0313Syncer_ = new Xep0313Syncer { since, this, ClientConnection_->GetXep0313Manager (), this };
+		return Xep0313Syncer_->GetFuture ();
+	}
+
+	void GlooxAccount::HandleServerHistoryStored ()
+	{
+		if (!Xep0313Syncer_)
+			return;
+
+		Xep0313Syncer_->CommitCheckpoints ();
+		Xep0313Syncer_->deleteLater ();
+		Xep0313Syncer_ = nullptr;
 	}
 
 	bool GlooxAccount::SupportsBlacklists () const
@@ -33,6 +33,7 @@
 #include <QObject>
 #include <QMap>
 #include <QIcon>
+#include <QPointer>
 #include <QXmppRosterIq.h>
 #include <QXmppBookmarkSet.h>
 #include <interfaces/azoth/iaccount.h>
@@ -84,6 +85,7 @@ namespace Xoox
 	class GlooxProtocol;
 	class GlooxMessage;
 	class Xep0313ModelManager;
+	class Xep0313Syncer;
 
 	class GlooxAccount : public QObject
 					   , public IAccount
@@ -157,6 +159,7 @@ namespace Xoox
 		QAction *CarbonsAction_;
 
 		Xep0313ModelManager * const Xep0313ModelMgr_;
+		QPointer<Xep0313Syncer> Xep0313Syncer_;
 	public:
 		GlooxAccount (const QString&, GlooxProtocol*, QObject*);
 
@@ -245,6 +248,7 @@ namespace Xoox
 		void FetchServerHistory (const QModelIndex&, const QByteArray&, int) override;
 		DefaultSortParams GetSortParams () const override;
 		QFuture<DatedFetchResult_t> FetchServerHistory (const QDateTime&) override;
+		void HandleServerHistoryStored () override;
 
 		// IHaveBlacklists
 		bool SupportsBlacklists () const override;
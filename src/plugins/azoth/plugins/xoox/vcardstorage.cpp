@@ -28,10 +28,9 @@
  **********************************************************************/
 
 #include "vcardstorage.h"
-#include <QXmlStreamWriter>
+#include <QTimer>
 #include <QtDebug>
 #include <util/threads/futures.h>
-#include "vcardstorageondisk.h"
 #include "vcardstorageondiskwriter.h"
 
 namespace LC
@@ -40,6 +39,16 @@ namespace Azoth
 {
 namespace Xoox
 {
+	namespace
+	{
+		const int FlushInterval = 1000;
+
+		int GetCost (const QXmppVCardIq& vcard)
+		{
+			return vcard.photo ().size () + 1024;
+		}
+	}
+
 	VCardStorage::VCardStorage (QObject *parent)
 	: QObject { parent }
 	, DB_ { new VCardStorageOnDisk { this } }
@@ -55,74 +64,135 @@ namespace Xoox
 	}
 	, VCardCache_ { 1024 * 1024 }
 	{
+		// The migration may take a while, so it is done by the writer
+		// before any batches instead of blocking the startup.
+		Writer_->MigrateLegacyVCards ();
+
 		Writer_->start (QThread::IdlePriority);
 	}
 
-	void VCardStorage::SetVCard (const QString& jid, const QString& vcard)
+	VCardStorage::~VCardStorage ()
 	{
-		PendingVCards_ [jid] = vcard;
+		Writer_->quit ();
+		Writer_->wait (5000);
+
+		// the writer won't process the batches queued after it's asked to quit,
+		// so just write them synchronously, rewriting the already written ones
+		VCardStorageOnDisk::Batch unsaved;
+		for (const auto& batch : InFlight_)
+			unsaved.Merge (batch);
+		unsaved.Merge (Pending_);
+
+		if (!unsaved.IsEmpty ())
+			DB_->Write (unsaved);
+	}
 
-		Util::Sequence (this, Writer_->SetVCard (jid, vcard)) >>
-				[this, jid] { PendingVCards_.remove (jid); };
+	void VCardStorage::SetVCard (const QString& jid, const QString& vcard)
+	{
+		if (const auto parsed = VCardStorageOnDisk::ParseVCard (vcard))
+			SetVCard (jid, *parsed);
 	}
 
 	void VCardStorage::SetVCard (const QString& jid, const QXmppVCardIq& vcard)
 	{
-		QString serialized;
-		QXmlStreamWriter writer { &serialized };
-		vcard.toXml (&writer);
-
-		SetVCard (jid, serialized);
+		Pending_.VCards_ [jid] = vcard;
+		VCardCache_.insert (jid, new QXmppVCardIq { vcard }, GetCost (vcard));
+		ScheduleFlush ();
 	}
 
 	std::optional<QXmppVCardIq> VCardStorage::GetVCard (const QString& jid) const
 	{
-		if (const auto vcard = VCardCache_.object (jid))
+		if (const auto vcard = GetUnsavedVCard (jid))
 			return *vcard;
 
-		const auto res = GetVCardString (jid);
-		if (!res)
-			return {};
+		const auto vcard = DB_->GetVCard (jid);
+		if (vcard)
+			VCardCache_.insert (jid, new QXmppVCardIq { *vcard }, GetCost (*vcard));
+		return vcard;
+	}
 
-		QDomDocument vcardDoc;
-		if (!vcardDoc.setContent (*res))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to parse"
-					<< *res;
-			return {};
-		}
+	std::optional<QByteArray> VCardStorage::GetVCardPhoto (const QString& jid) const
+	{
+		if (const auto vcard = GetUnsavedVCard (jid))
+			return vcard->photo ();
 
-		QXmppVCardIq vcard;
-		vcard.parse (vcardDoc.documentElement ());
+		return DB_->GetVCardPhoto (jid);
+	}
 
-		VCardCache_.insert (jid, new QXmppVCardIq { vcard }, res->size ());
+	std::optional<QDate> VCardStorage::GetVCardBirthday (const QString& jid) const
+	{
+		if (const auto vcard = GetUnsavedVCard (jid))
+			return vcard->birthday ();
 
-		return vcard;
+		return DB_->GetVCardBirthday (jid);
 	}
 
 	void VCardStorage::SetVCardPhotoHash (const QString& jid, const QByteArray& hash)
 	{
-		PendingHashes_ [jid] = hash;
+		GetPhotoHashes () [jid] = hash;
 
-		Util::Sequence (this, Writer_->SetVCardPhotoHash (jid, hash)) >>
-				[this, jid] { PendingHashes_.remove (jid); };
+		Pending_.PhotoHashes_ [jid] = hash;
+		ScheduleFlush ();
 	}
 
 	std::optional<QByteArray> VCardStorage::GetVCardPhotoHash (const QString& jid) const
 	{
-		if (PendingHashes_.contains (jid))
-			return PendingHashes_.value (jid);
+		const auto& hashes = GetPhotoHashes ();
+		const auto pos = hashes.find (jid);
+		if (pos == hashes.end ())
+			return {};
+
+		return *pos;
+	}
+
+	const QXmppVCardIq* VCardStorage::GetUnsavedVCard (const QString& jid) const
+	{
+		if (const auto vcard = VCardCache_.object (jid))
+			return vcard;
+
+		const auto pending = Pending_.VCards_.find (jid);
+		if (pending != Pending_.VCards_.end ())
+			return &*pending;
+
+		for (auto batch = InFlight_.rbegin (); batch != InFlight_.rend (); ++batch)
+		{
+			const auto pos = batch->VCards_.find (jid);
+			if (pos != batch->VCards_.end ())
+				return &*pos;
+		}
 
-		return DB_->GetVCardPhotoHash (jid);
+		return nullptr;
 	}
 
-	std::optional<QString> VCardStorage::GetVCardString (const QString& jid) const
+	QHash<QString, QByteArray>& VCardStorage::GetPhotoHashes () const
 	{
-		if (PendingVCards_.contains (jid))
-			return PendingVCards_.value (jid);
+		if (!PhotoHashes_)
+			PhotoHashes_ = DB_->GetVCardPhotoHashes ();
+
+		return *PhotoHashes_;
+	}
+
+	void VCardStorage::ScheduleFlush ()
+	{
+		if (FlushScheduled_)
+			return;
+
+		FlushScheduled_ = true;
+		QTimer::singleShot (FlushInterval, this, [this] { Flush (); });
+	}
+
+	void VCardStorage::Flush ()
+	{
+		FlushScheduled_ = false;
+
+		if (Pending_.IsEmpty ())
+			return;
+
+		InFlight_ << Pending_;
+		Pending_ = {};
 
-		return DB_->GetVCard (jid);
+		Util::Sequence (this, Writer_->Write (InFlight_.last ())) >>
+				[this] { InFlight_.removeFirst (); };
 	}
 }
 }
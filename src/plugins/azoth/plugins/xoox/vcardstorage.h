@@ -34,6 +34,7 @@
 #include <QObject>
 #include <QCache>
 #include <QXmppVCardIq.h>
+#include "vcardstorageondisk.h"
 
 namespace LC
 {
@@ -41,30 +42,54 @@ namespace Azoth
 {
 namespace Xoox
 {
-	class VCardStorageOnDisk;
 	class VCardStorageOnDiskWriter;
 
+	/** @brief Caches the vCards and the photo hashes of the entries.
+	 *
+	 * The changes are accumulated and written to the disk in batches by
+	 * a background thread. The photo hashes of all the entries are
+	 * loaded at once on first access.
+	 */
 	class VCardStorage : public QObject
 	{
 		VCardStorageOnDisk * const DB_;
 		const std::shared_ptr<VCardStorageOnDiskWriter> Writer_;
 
-		QMap<QString, QString> PendingVCards_;
-		QMap<QString, QByteArray> PendingHashes_;
+		VCardStorageOnDisk::Batch Pending_;
+		QList<VCardStorageOnDisk::Batch> InFlight_;
+		bool FlushScheduled_ = false;
 
+		mutable std::optional<QHash<QString, QByteArray>> PhotoHashes_;
 		mutable QCache<QString, QXmppVCardIq> VCardCache_;
 	public:
 		VCardStorage (QObject* = nullptr);
+		~VCardStorage () override;
 
 		void SetVCard (const QString& jid, const QString& vcard);
 		void SetVCard (const QString& jid, const QXmppVCardIq& vcard);
 
 		std::optional<QXmppVCardIq> GetVCard (const QString& jid) const;
 
+		/** @brief Returns the photo from the vCard of the given jid.
+		 *
+		 * This function doesn't load the rest of the vCard.
+		 */
+		std::optional<QByteArray> GetVCardPhoto (const QString& jid) const;
+
+		/** @brief Returns the birthday from the vCard of the given jid.
+		 *
+		 * This function doesn't load the rest of the vCard.
+		 */
+		std::optional<QDate> GetVCardBirthday (const QString& jid) const;
+
 		void SetVCardPhotoHash (const QString& jid, const QByteArray& hash);
 		std::optional<QByteArray> GetVCardPhotoHash (const QString& jid) const;
 	private:
-		std::optional<QString> GetVCardString (const QString& jid) const;
+		const QXmppVCardIq* GetUnsavedVCard (const QString& jid) const;
+		QHash<QString, QByteArray>& GetPhotoHashes () const;
+
+		void ScheduleFlush ();
+		void Flush ();
 	};
 }
 }
@@ -29,7 +29,9 @@
 
 #include "vcardstorageondisk.h"
 #include <QDir>
+#include <QDomDocument>
 #include <QSqlError>
+#include <QXmlStreamWriter>
 #include <util/db/dblock.h>
 #include <util/db/util.h>
 #include <util/db/oral/oral.h>
@@ -41,7 +43,7 @@ namespace Azoth
 {
 namespace Xoox
 {
-	struct VCardStorageOnDisk::VCardRecord
+	struct VCardStorageOnDisk::LegacyVCardRecord
 	{
 		Util::oral::PKey<QString, Util::oral::NoAutogen> JID_;
 		QString VCardIq_;
@@ -52,6 +54,22 @@ namespace Xoox
 		}
 	};
 
+	struct VCardStorageOnDisk::VCardRecord
+	{
+		Util::oral::PKey<QString, Util::oral::NoAutogen> JID_;
+		QString FullName_;
+		QString NickName_;
+		QString Birthday_;
+		QByteArray Photo_;
+		QString PhotoType_;
+		QString Extra_;
+
+		static QString ClassName ()
+		{
+			return "VCardFields";
+		}
+	};
+
 	struct VCardStorageOnDisk::PhotoHashRecord
 	{
 		Util::oral::PKey<QString, Util::oral::NoAutogen> JID_;
@@ -66,10 +84,19 @@ namespace Xoox
 }
 }
 
-BOOST_FUSION_ADAPT_STRUCT (LC::Azoth::Xoox::VCardStorageOnDisk::VCardRecord,
+BOOST_FUSION_ADAPT_STRUCT (LC::Azoth::Xoox::VCardStorageOnDisk::LegacyVCardRecord,
 		JID_,
 		VCardIq_)
 
+BOOST_FUSION_ADAPT_STRUCT (LC::Azoth::Xoox::VCardStorageOnDisk::VCardRecord,
+		JID_,
+		FullName_,
+		NickName_,
+		Birthday_,
+		Photo_,
+		PhotoType_,
+		Extra_)
+
 BOOST_FUSION_ADAPT_STRUCT (LC::Azoth::Xoox::VCardStorageOnDisk::PhotoHashRecord,
 		JID_,
 		Hash_)
@@ -82,6 +109,19 @@ namespace Xoox
 {
 	namespace sph = Util::oral::sph;
 
+	bool VCardStorageOnDisk::Batch::IsEmpty () const
+	{
+		return VCards_.isEmpty () && PhotoHashes_.isEmpty ();
+	}
+
+	void VCardStorageOnDisk::Batch::Merge (const Batch& other)
+	{
+		for (auto i = other.VCards_.begin (); i != other.VCards_.end (); ++i)
+			VCards_ [i.key ()] = i.value ();
+		for (auto i = other.PhotoHashes_.begin (); i != other.PhotoHashes_.end (); ++i)
+			PhotoHashes_ [i.key ()] = i.value ();
+	}
+
 	VCardStorageOnDisk::VCardStorageOnDisk (QObject *parent)
 	: QObject { parent }
 	, DB_ { QSqlDatabase::addDatabase ("QSQLITE",
@@ -104,24 +144,137 @@ namespace Xoox
 		AdaptedPhotoHashes_ = Util::oral::AdaptPtr<PhotoHashRecord> (DB_);
 	}
 
-	void VCardStorageOnDisk::SetVCard (const QString& jid, const QString& vcard)
+	namespace
+	{
+		QString SerializeVCard (const QXmppVCardIq& vcard)
+		{
+			QString serialized;
+			QXmlStreamWriter writer { &serialized };
+			vcard.toXml (&writer);
+			return serialized;
+		}
+
+		VCardStorageOnDisk::VCardRecord ToRecord (const QString& jid, const QXmppVCardIq& vcard)
+		{
+			// the fields with their own columns are dropped from the XML part
+			auto extra = vcard;
+			extra.setFullName ({});
+			extra.setNickName ({});
+			extra.setBirthday ({});
+			extra.setPhoto ({});
+			extra.setPhotoType ({});
+
+			return
+			{
+				jid,
+				vcard.fullName (),
+				vcard.nickName (),
+				vcard.birthday ().toString (Qt::ISODate),
+				vcard.photo (),
+				vcard.photoType (),
+				SerializeVCard (extra)
+			};
+		}
+
+		QXmppVCardIq FromRecord (const VCardStorageOnDisk::VCardRecord& rec)
+		{
+			auto vcard = VCardStorageOnDisk::ParseVCard (rec.Extra_).value_or (QXmppVCardIq {});
+			vcard.setFullName (rec.FullName_);
+			vcard.setNickName (rec.NickName_);
+			vcard.setBirthday (QDate::fromString (rec.Birthday_, Qt::ISODate));
+			vcard.setPhoto (rec.Photo_);
+			vcard.setPhotoType (rec.PhotoType_);
+			return vcard;
+		}
+	}
+
+	void VCardStorageOnDisk::Write (const Batch& batch)
+	{
+		Util::DBLock lock { DB_ };
+		lock.Init ();
+
+		for (auto i = batch.VCards_.begin (); i != batch.VCards_.end (); ++i)
+			AdaptedVCards_->Insert (ToRecord (i.key (), i.value ()),
+					Util::oral::InsertAction::Replace::PKey<VCardRecord>);
+
+		for (auto i = batch.PhotoHashes_.begin (); i != batch.PhotoHashes_.end (); ++i)
+			AdaptedPhotoHashes_->Insert ({ i.key (), i.value () },
+					Util::oral::InsertAction::Replace::PKey<PhotoHashRecord>);
+
+		lock.Good ();
+	}
+
+	std::optional<QXmppVCardIq> VCardStorageOnDisk::GetVCard (const QString& jid) const
 	{
-		AdaptedVCards_->Insert ({ jid, vcard }, Util::oral::InsertAction::Replace::PKey<VCardRecord>);
+		const auto rec = AdaptedVCards_->SelectOne (sph::f<&VCardRecord::JID_> == jid);
+		if (!rec)
+			return {};
+
+		return FromRecord (*rec);
 	}
 
-	std::optional<QString> VCardStorageOnDisk::GetVCard (const QString& jid) const
+	std::optional<QByteArray> VCardStorageOnDisk::GetVCardPhoto (const QString& jid) const
 	{
-		return AdaptedVCards_->SelectOne (sph::fields<&VCardRecord::VCardIq_>, sph::f<&VCardRecord::JID_> == jid);
+		return AdaptedVCards_->SelectOne (sph::fields<&VCardRecord::Photo_>, sph::f<&VCardRecord::JID_> == jid);
 	}
 
-	void VCardStorageOnDisk::SetVCardPhotoHash (const QString& jid, const QByteArray& hash)
+	std::optional<QDate> VCardStorageOnDisk::GetVCardBirthday (const QString& jid) const
 	{
-		AdaptedPhotoHashes_->Insert ({ jid, hash }, Util::oral::InsertAction::Replace::PKey<PhotoHashRecord>);
+		const auto str = AdaptedVCards_->SelectOne (sph::fields<&VCardRecord::Birthday_>, sph::f<&VCardRecord::JID_> == jid);
+		if (!str)
+			return {};
+
+		return QDate::fromString (*str, Qt::ISODate);
 	}
 
-	std::optional<QByteArray> VCardStorageOnDisk::GetVCardPhotoHash (const QString& jid) const
+	QHash<QString, QByteArray> VCardStorageOnDisk::GetVCardPhotoHashes () const
 	{
-		return AdaptedPhotoHashes_->SelectOne (sph::fields<&PhotoHashRecord::Hash_>, sph::f<&PhotoHashRecord::JID_> == jid);
+		QHash<QString, QByteArray> result;
+		for (const auto& rec : AdaptedPhotoHashes_->Select ())
+			result [*rec.JID_] = rec.Hash_;
+		return result;
+	}
+
+	void VCardStorageOnDisk::MigrateLegacyVCards ()
+	{
+		if (!DB_.tables ().contains (LegacyVCardRecord::ClassName ()))
+			return;
+
+		const auto& legacy = Util::oral::AdaptPtr<LegacyVCardRecord> (DB_)->Select ();
+
+		Batch batch;
+		for (const auto& rec : legacy)
+			if (const auto vcard = ParseVCard (rec.VCardIq_))
+				batch.VCards_ [*rec.JID_] = *vcard;
+
+		Util::DBLock lock { DB_ };
+		lock.Init ();
+		Write (batch);
+		Util::RunTextQuery (DB_, "DROP TABLE " + LegacyVCardRecord::ClassName () + ";");
+		lock.Good ();
+
+		qDebug () << Q_FUNC_INFO
+				<< "migrated"
+				<< batch.VCards_.size ()
+				<< "of"
+				<< legacy.size ()
+				<< "vcards";
+	}
+
+	std::optional<QXmppVCardIq> VCardStorageOnDisk::ParseVCard (const QString& str)
+	{
+		QDomDocument vcardDoc;
+		if (!vcardDoc.setContent (str))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to parse"
+					<< str;
+			return {};
+		}
+
+		QXmppVCardIq vcard;
+		vcard.parse (vcardDoc.documentElement ());
+		return vcard;
 	}
 }
 }
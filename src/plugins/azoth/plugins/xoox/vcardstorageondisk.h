@@ -31,7 +31,9 @@
 
 #include <optional>
 #include <QObject>
+#include <QHash>
 #include <QSqlDatabase>
+#include <QXmppVCardIq.h>
 #include <util/db/oral/oralfwd.h>
 
 namespace LC
@@ -40,11 +42,27 @@ namespace Azoth
 {
 namespace Xoox
 {
+	/** @brief Persistent storage of the vCards and photo hashes.
+	 *
+	 * The vCards are stored field by field, so that the frequently used
+	 * fields like the photo or the birthday can be fetched without
+	 * parsing the whole vCard. The rarely used fields are kept as XML.
+	 */
 	class VCardStorageOnDisk : public QObject
 	{
 	public:
+		struct LegacyVCardRecord;
 		struct VCardRecord;
 		struct PhotoHashRecord;
+
+		struct Batch
+		{
+			QHash<QString, QXmppVCardIq> VCards_;
+			QHash<QString, QByteArray> PhotoHashes_;
+
+			bool IsEmpty () const;
+			void Merge (const Batch&);
+		};
 	private:
 		QSqlDatabase DB_;
 
@@ -53,11 +71,26 @@ namespace Xoox
 	public:
 		VCardStorageOnDisk (QObject* = nullptr);
 
-		void SetVCard (const QString& jid, const QString& vcard);
-		std::optional<QString> GetVCard (const QString& jid) const;
+		/** @brief Writes the whole batch in a single transaction.
+		 */
+		void Write (const Batch&);
+
+		std::optional<QXmppVCardIq> GetVCard (const QString& jid) const;
+		std::optional<QByteArray> GetVCardPhoto (const QString& jid) const;
+		std::optional<QDate> GetVCardBirthday (const QString& jid) const;
+
+		QHash<QString, QByteArray> GetVCardPhotoHashes () const;
+
+		/** @brief Converts the vCards stored by older versions as XML
+		 * documents to the current format.
+		 *
+		 * This function should be called before any batches are written
+		 * via this instance, so that the migrated vCards don't overwrite
+		 * the newer ones.
+		 */
+		void MigrateLegacyVCards ();
 
-		void SetVCardPhotoHash (const QString& jid, const QByteArray& hash);
-		std::optional<QByteArray> GetVCardPhotoHash (const QString& jid) const;
+		static std::optional<QXmppVCardIq> ParseVCard (const QString&);
 	};
 }
 }
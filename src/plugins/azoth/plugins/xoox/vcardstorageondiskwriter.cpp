@@ -36,15 +36,14 @@ namespace Azoth
 {
 namespace Xoox
 {
-	QFuture<void> VCardStorageOnDiskWriter::SetVCard (const QString& jid, const QString& vcard)
+	QFuture<void> VCardStorageOnDiskWriter::Write (const VCardStorageOnDisk::Batch& batch)
 	{
-		return ScheduleImpl ([=] { Storage_->SetVCard (jid, vcard); });
+		return ScheduleImpl ([=] { Storage_->Write (batch); });
 	}
 
-	QFuture<void> VCardStorageOnDiskWriter::SetVCardPhotoHash (const QString& jid,
-			const QByteArray& hash)
+	QFuture<void> VCardStorageOnDiskWriter::MigrateLegacyVCards ()
 	{
-		return ScheduleImpl ([=] { Storage_->SetVCardPhotoHash (jid, hash); });
+		return ScheduleImpl ([this] { Storage_->MigrateLegacyVCards (); });
 	}
 
 	void VCardStorageOnDiskWriter::Initialize ()
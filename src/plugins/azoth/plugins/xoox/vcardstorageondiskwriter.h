@@ -47,8 +47,8 @@ namespace Xoox
 	public:
 		using Util::WorkerThreadBase::WorkerThreadBase;
 
-		QFuture<void> SetVCard (const QString&, const QString&);
-		QFuture<void> SetVCardPhotoHash (const QString&, const QByteArray&);
+		QFuture<void> Write (const VCardStorageOnDisk::Batch&);
+		QFuture<void> MigrateLegacyVCards ();
 	protected:
 		void Initialize () override;
 		void Cleanup () override;
@@ -0,0 +1,282 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "xep0313syncer.h"
+#include <memory>
+#include <QCoreApplication>
+#include <QSettings>
+#include <QtDebug>
+#include <QXmppUtils.h>
+#include <util/sll/either.h>
+#include <util/sll/visitor.h>
+#include <util/threads/futures.h>
+#include "accountsettingsholder.h"
+#include "glooxaccount.h"
+#include "roomclentry.h"
+#include "roomhandler.h"
+
+namespace LC
+{
+namespace Azoth
+{
+namespace Xoox
+{
+	namespace
+	{
+		const auto PageSize = 250;
+
+		/** The rest is fetched during the next sync, starting from the
+		 * saved checkpoints.
+		 */
+		const auto MaxMessagesPerSync = 50000;
+
+		QSettings* MakeCheckpointsSettings (const QByteArray& accId)
+		{
+			const auto settings = new QSettings
+			{
+				QSettings::IniFormat,
+				QSettings::UserScope,
+				QCoreApplication::organizationName (),
+				QCoreApplication::applicationName () + "_Azoth_Xoox_MAM"
+			};
+			settings->beginGroup (QString::fromUtf8 (accId));
+			return settings;
+		}
+	}
+
+	bool Xep0313Syncer::Archive::IsMUC () const
+	{
+		return !OurNick_.isEmpty ();
+	}
+
+	Xep0313Syncer::Xep0313Syncer (const QDateTime& since,
+			GlooxAccount *acc, Xep0313Manager *manager, QObject *parent)
+	: QObject { parent }
+	, Since_ { since }
+	, Acc_ { acc }
+	, Manager_ { manager }
+	{
+		Iface_.reportStarted ();
+		TotalTimer_.start ();
+
+		Archives_.append ({ Acc_->GetSettings ()->GetJID (), {} });
+		for (const auto entryObj : Acc_->GetCLEntries ())
+			if (const auto room = qobject_cast<RoomCLEntry*> (entryObj))
+			{
+				const auto handler = room->GetRoomHandler ();
+				Archives_.append ({ handler->GetRoomJID (), handler->GetOurNick () });
+			}
+
+		StartArchive ();
+	}
+
+	Xep0313Syncer::~Xep0313Syncer ()
+	{
+		if (!Iface_.isFinished ())
+			Util::ReportFutureResult (Iface_,
+					IHaveServerHistory::DatedFetchResult_t::Left ("Sync has been aborted."));
+	}
+
+	QFuture<IHaveServerHistory::DatedFetchResult_t> Xep0313Syncer::GetFuture ()
+	{
+		return Iface_.future ();
+	}
+
+	void Xep0313Syncer::CommitCheckpoints ()
+	{
+		const std::unique_ptr<QSettings> settings { MakeCheckpointsSettings (Acc_->GetAccountID ()) };
+		for (auto i = Checkpoints_.begin (); i != Checkpoints_.end (); ++i)
+			settings->setValue (i.key (), i.value ());
+		Checkpoints_.clear ();
+	}
+
+	void Xep0313Syncer::StartArchive ()
+	{
+		if (Archives_.isEmpty ())
+		{
+			HandleDone ();
+			return;
+		}
+
+		const std::unique_ptr<QSettings> settings { MakeCheckpointsSettings (Acc_->GetAccountID ()) };
+		LastId_ = settings->value (Archives_.first ().JID_).toString ();
+
+		ArchiveMessages_ = 0;
+		ArchiveTimer_.start ();
+
+		Request ();
+	}
+
+	void Xep0313Syncer::Request ()
+	{
+		const auto& archive = Archives_.first ();
+		Util::Sequence (this, Manager_->RequestArchivePage (archive.JID_, Since_, LastId_, PageSize)) >>
+				Util::Visitor
+				{
+					[this] (const QString& err)
+					{
+						qWarning () << Q_FUNC_INFO
+								<< "unable to fetch"
+								<< Archives_.first ().JID_
+								<< err;
+						FinishArchive ();
+						StartArchive ();
+					},
+					[this] (const Xep0313Manager::ArchivePage& page) { HandlePage (page); }
+				};
+	}
+
+	void Xep0313Syncer::HandlePage (const Xep0313Manager::ArchivePage& page)
+	{
+		const auto& archive = Archives_.first ();
+		for (const auto& message : page.Messages_)
+			HandleMessage (archive, message);
+
+		if (!page.Last_.isEmpty ())
+			LastId_ = page.Last_;
+
+		ArchiveMessages_ += page.Messages_.size ();
+		TotalMessages_ += page.Messages_.size ();
+
+		if (TotalMessages_ >= MaxMessagesPerSync)
+		{
+			qDebug () << Q_FUNC_INFO
+					<< "reached the messages limit, the rest will be fetched during the next sync";
+			FinishArchive ();
+			Archives_.clear ();
+			StartArchive ();
+			return;
+		}
+
+		if (page.Complete_ || page.Last_.isEmpty ())
+		{
+			FinishArchive ();
+			StartArchive ();
+		}
+		else
+			Request ();
+	}
+
+	void Xep0313Syncer::HandleMessage (const Archive& archive,
+			const Xep0313Manager::ArchivedMessage& archived)
+	{
+		if (SeenIds_.contains (archived.ArchiveID_))
+			return;
+		SeenIds_ << archived.ArchiveID_;
+
+		const auto& message = archived.Message_;
+		if (message.body ().isEmpty ())
+			return;
+
+		const auto& from = message.from ();
+		const auto& to = message.to ();
+
+		QString otherJid;
+		HistoryItem item
+		{
+			message.stamp (),
+			IMessage::Direction::In,
+			message.body (),
+			{},
+			IMessage::Type::ChatMessage,
+			message.xhtml (),
+			IMessage::EscapePolicy::Escape,
+			archived.ArchiveID_
+		};
+
+		if (archive.IsMUC ())
+		{
+			otherJid = archive.JID_;
+			item.Variant_ = QXmppUtils::jidToResource (from);
+			item.Type_ = IMessage::Type::MUCMessage;
+			if (item.Variant_ == archive.OurNick_)
+				item.Dir_ = IMessage::Direction::Out;
+		}
+		else
+		{
+			if (message.type () == QXmppMessage::GroupChat || to.isEmpty ())
+				return;
+
+			if (QXmppUtils::jidToBareJid (from) == archive.JID_)
+			{
+				item.Dir_ = IMessage::Direction::Out;
+				otherJid = QXmppUtils::jidToBareJid (to);
+				item.Variant_ = QXmppUtils::jidToResource (to);
+			}
+			else
+			{
+				otherJid = QXmppUtils::jidToBareJid (from);
+				item.Variant_ = QXmppUtils::jidToResource (from);
+			}
+		}
+
+		const auto& entryId = Acc_->GetAccountID () + '_' + otherJid;
+		auto& info = Messages_ [entryId];
+		info.VisibleName_ = otherJid;
+		info.Messages_ << item;
+	}
+
+	void Xep0313Syncer::FinishArchive ()
+	{
+		const auto archive = Archives_.takeFirst ();
+
+		const auto elapsed = std::max<qint64> (ArchiveTimer_.elapsed (), 1);
+		qDebug () << Q_FUNC_INFO
+				<< archive.JID_
+				<< ArchiveMessages_
+				<< "messages in"
+				<< elapsed
+				<< "ms,"
+				<< ArchiveMessages_ * 1000 / elapsed
+				<< "messages/s";
+
+		if (!LastId_.isEmpty ())
+			Checkpoints_ [archive.JID_] = LastId_;
+	}
+
+	void Xep0313Syncer::HandleDone ()
+	{
+		const auto elapsed = std::max<qint64> (TotalTimer_.elapsed (), 1);
+		qDebug () << Q_FUNC_INFO
+				<< Acc_->GetAccountID ()
+				<< TotalMessages_
+				<< "messages for"
+				<< Messages_.size ()
+				<< "entries in"
+				<< elapsed
+				<< "ms,"
+				<< TotalMessages_ * 1000 / elapsed
+				<< "messages/s";
+
+		const auto res = IHaveServerHistory::DatedFetchResult_t::Right (Messages_);
+		Iface_.reportFinished (&res);
+	}
+}
+}
+}
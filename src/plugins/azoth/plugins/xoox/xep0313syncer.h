@@ -0,0 +1,107 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFutureInterface>
+#include <QSet>
+#include <interfaces/azoth/ihaveserverhistory.h>
+#include "xeps/xep0313manager.h"
+
+namespace LC
+{
+namespace Azoth
+{
+namespace Xoox
+{
+	class GlooxAccount;
+
+	/** @brief Fetches the server-side history since the given date.
+	 *
+	 * The personal archive and the archives of the joined MUC rooms are
+	 * paged through one by one in chronological order. The archive ID of
+	 * the last fetched message is remembered for each archive, so the
+	 * next sync continues from that message instead of refetching the
+	 * archive from the given date.
+	 *
+	 * The fetched messages carry their archive IDs as stanza IDs, so
+	 * history storages skip the ones they already have.
+	 *
+	 * The archive IDs are only saved by CommitCheckpoints(), which is to
+	 * be called once the fetched messages are stored, so the messages
+	 * aren't skipped by the next sync if storing them fails.
+	 */
+	class Xep0313Syncer : public QObject
+	{
+		const QDateTime Since_;
+		GlooxAccount * const Acc_;
+		Xep0313Manager * const Manager_;
+
+		struct Archive
+		{
+			QString JID_;
+			QString OurNick_;
+
+			bool IsMUC () const;
+		};
+		QList<Archive> Archives_;
+		QString LastId_;
+		QHash<QString, QString> Checkpoints_;
+
+		QSet<QString> SeenIds_;
+		int ArchiveMessages_ = 0;
+		int TotalMessages_ = 0;
+		QElapsedTimer ArchiveTimer_;
+		QElapsedTimer TotalTimer_;
+
+		QFutureInterface<IHaveServerHistory::DatedFetchResult_t> Iface_;
+
+		IHaveServerHistory::MessagesSyncMap_t Messages_;
+	public:
+		Xep0313Syncer (const QDateTime&, GlooxAccount*, Xep0313Manager*, QObject* = nullptr);
+		~Xep0313Syncer ();
+
+		QFuture<IHaveServerHistory::DatedFetchResult_t> GetFuture ();
+
+		void CommitCheckpoints ();
+	private:
+		void StartArchive ();
+		void Request ();
+		void HandlePage (const Xep0313Manager::ArchivePage&);
+		void HandleMessage (const Archive&, const Xep0313Manager::ArchivedMessage&);
+		void FinishArchive ();
+
+		void HandleDone ();
+	};
+}
+}
+}
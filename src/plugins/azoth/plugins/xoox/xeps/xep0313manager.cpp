@@ -30,6 +30,7 @@
 #include "xep0313manager.h"
 #include <cstdlib>
 #include <QDomDocument>
+#include <util/threads/futures.h>
 #include <QXmppClient.h>
 #include <QXmppMessage.h>
 #include <QXmppResultSet.h>
@@ -84,17 +85,30 @@ namespace Xoox
 				const auto& fin = element.firstChildElement ("fin");
 				if (fin.namespaceURI () == NsMam)
 				{
-					HandleHistoryQueryFinished (fin);
+					const auto& pageQueryId = PageIqId2QueryId_.take (element.attribute ("id"));
+					if (!pageQueryId.isEmpty ())
+						HandlePageFinished (pageQueryId, fin);
+					else
+						HandleHistoryQueryFinished (fin);
 					return true;
 				}
 			}
+			else if (element.attribute ("type") == "error" &&
+					PageIqId2QueryId_.contains (element.attribute ("id")))
+			{
+				HandlePageError (element);
+				return true;
+			}
 		}
 		else if (tagName == "message")
 		{
 			const auto& res = element.firstChildElement ("result");
 			if (res.namespaceURI () == NsMam)
 			{
-				HandleMessage (res);
+				if (PendingPages_.contains (res.attribute ("queryid")))
+					HandlePageMessage (res);
+				else
+					HandleMessage (res);
 				return true;
 			}
 
@@ -144,6 +158,43 @@ namespace Xoox
 		client ()->sendPacket (iq);
 	}
 
+	QFuture<Xep0313Manager::ArchivePageResult_t> Xep0313Manager::RequestArchivePage (const QString& archiveJid,
+			const QDateTime& start, const QString& afterId, int count)
+	{
+		const auto& queryId = "xep0313_" + QString::number (++NextQueryNumber_);
+
+		Xep0313ReqIq iq
+		{
+			{},
+			afterId,
+			count,
+			Xep0313ReqIq::Direction::After,
+			queryId
+		};
+		if (afterId.isEmpty ())
+			iq.SetStart (start);
+		if (archiveJid != client ()->configuration ().jidBare ())
+			iq.setTo (archiveJid);
+
+		auto& pending = PendingPages_ [queryId];
+		pending.Iface_.reportStarted ();
+		PageIqId2QueryId_ [iq.id ()] = queryId;
+
+		client ()->sendPacket (iq);
+
+		return pending.Iface_.future ();
+	}
+
+	void Xep0313Manager::setClient (QXmppClient *client)
+	{
+		QXmppClientExtension::setClient (client);
+
+		connect (client,
+				&QXmppClient::disconnected,
+				this,
+				&Xep0313Manager::AbortPendingPages);
+	}
+
 	void Xep0313Manager::HandleMessage (const QXmppElement& resultExt)
 	{
 		const auto& id = resultExt.attribute ("id");
@@ -203,6 +254,54 @@ namespace Xoox
 		emit serverHistoryFetched (jid, resultSet.last (), messages);
 	}
 
+	void Xep0313Manager::HandlePageMessage (const QDomElement& resultElem)
+	{
+		auto& pending = PendingPages_ [resultElem.attribute ("queryid")];
+		pending.Messages_.append ({ resultElem.attribute ("id"), XooxUtil::Forwarded2Message (resultElem) });
+	}
+
+	void Xep0313Manager::HandlePageFinished (const QString& queryId, const QDomElement& finElem)
+	{
+		auto pending = PendingPages_.take (queryId);
+
+		QXmppResultSetReply resultSet;
+		resultSet.parse (finElem.firstChildElement ("set"));
+
+		ArchivePage page;
+		page.Messages_ = std::move (pending.Messages_);
+		page.Last_ = resultSet.last ();
+		page.Complete_ = finElem.attribute ("complete") == "true" ||
+				page.Messages_.isEmpty ();
+
+		Util::ReportFutureResult (pending.Iface_, ArchivePageResult_t::Right (page));
+	}
+
+	void Xep0313Manager::HandlePageError (const QDomElement& element)
+	{
+		const auto& queryId = PageIqId2QueryId_.take (element.attribute ("id"));
+		auto pending = PendingPages_.take (queryId);
+
+		QXmppIq iq;
+		iq.parse (element);
+
+		const auto& text = iq.error ().text ();
+		Util::ReportFutureResult (pending.Iface_,
+				ArchivePageResult_t::Left (text.isEmpty () ?
+						tr ("Archive request failed for %1.").arg (element.attribute ("from")) :
+						text));
+	}
+
+	void Xep0313Manager::AbortPendingPages ()
+	{
+		auto pages = std::move (PendingPages_);
+		PendingPages_.clear ();
+		PageIqId2QueryId_.clear ();
+
+		for (auto& page : pages)
+			Util::ReportFutureResult (page.Iface_,
+					ArchivePageResult_t::Left (tr ("Disconnected from the server.")));
+	}
+
 	void Xep0313Manager::HandlePrefs (const QDomElement& element)
 	{
 		Xep0313PrefIq iq;
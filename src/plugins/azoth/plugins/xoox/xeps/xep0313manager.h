@@ -29,7 +29,10 @@
 
 #pragma once
 
+#include <QFutureInterface>
 #include <QXmppClientExtension.h>
+#include <QXmppMessage.h>
+#include <util/sll/either.h>
 #include <interfaces/azoth/ihaveserverhistory.h>
 
 class QXmppMessage;
@@ -53,6 +56,41 @@ namespace Xoox
 		QMap<QString, QString> QueryId2Jid_;
 
 		int NextQueryNumber_ = 0;
+	public:
+		struct ArchivedMessage
+		{
+			QString ArchiveID_;
+			QXmppMessage Message_;
+		};
+
+		/** @brief A single page of the archive returned by
+		 * RequestArchivePage().
+		 */
+		struct ArchivePage
+		{
+			QList<ArchivedMessage> Messages_;
+
+			/** @brief The archive ID of the last message in this page.
+			 *
+			 * Pass it as the afterId parameter of RequestArchivePage()
+			 * to get the next page.
+			 */
+			QString Last_;
+
+			/** @brief Whether this is the last page of the archive.
+			 */
+			bool Complete_ = false;
+		};
+
+		using ArchivePageResult_t = Util::Either<QString, ArchivePage>;
+	private:
+		struct PendingPage
+		{
+			QFutureInterface<ArchivePageResult_t> Iface_;
+			QList<ArchivedMessage> Messages_;
+		};
+		QHash<QString, PendingPage> PendingPages_;
+		QHash<QString, QString> PageIqId2QueryId_;
 	public:
 		static bool Supports0313 (const QStringList& features);
 		static QString GetNsUri ();
@@ -66,10 +104,32 @@ namespace Xoox
 		void SetPrefs (const Xep0313PrefIq&);
 
 		void RequestHistory (const QString& jid, QString baseId, int count);
+
+		/** @brief Requests a page of the archive kept by the given JID.
+		 *
+		 * The messages are requested in chronological order, starting
+		 * right after the message with the given archive ID if it is
+		 * not empty, or since the given date otherwise.
+		 *
+		 * @param[in] archiveJid The JID of the archive: our own bare JID
+		 * for the personal archive or the JID of a MUC room.
+		 * @param[in] start The date to start from if the afterId is empty.
+		 * @param[in] afterId The archive ID of the last known message.
+		 * @param[in] count The maximum number of messages in the page.
+		 */
+		QFuture<ArchivePageResult_t> RequestArchivePage (const QString& archiveJid,
+				const QDateTime& start, const QString& afterId, int count);
+	protected:
+		void setClient (QXmppClient*) override;
 	private:
 		void HandleMessage (const QXmppElement&);
 		void HandleHistoryQueryFinished (const QDomElement&);
 
+		void HandlePageMessage (const QDomElement&);
+		void HandlePageFinished (const QString&, const QDomElement&);
+		void HandlePageError (const QDomElement&);
+		void AbortPendingPages ();
+
 		void HandlePrefs (const QDomElement&);
 	signals:
 		void gotPrefs (const Xep0313PrefIq&);
@@ -31,6 +31,7 @@
 #include <QDomElement>
 #include <QtDebug>
 #include <QXmppResultSet.h>
+#include <QXmppUtils.h>
 #include <util/sll/util.h>
 #include "xep0313manager.h"
 
@@ -51,6 +52,11 @@ namespace Xoox
 	{
 	}
 
+	void Xep0313ReqIq::SetStart (const QDateTime& start)
+	{
+		Start_ = start;
+	}
+
 	void Xep0313ReqIq::parseElementFromChild (const QDomElement& element)
 	{
 		QXmppIq::parseElementFromChild (element);
@@ -61,8 +67,12 @@ namespace Xoox
 		form.parse (queryElem.firstChildElement ("x"));
 		if (!form.isNull ())
 			for (const auto& field : form.fields ())
+			{
 				if (field.key () == "with")
 					JID_ = field.value ().toString ();
+				else if (field.key () == "start")
+					Start_ = QXmppUtils::datetimeFromString (field.value ().toString ());
+			}
 
 		QXmppResultSetQuery q;
 		q.parse (queryElem.firstChildElement ("set"));
@@ -94,21 +104,35 @@ namespace Xoox
 		if (!QueryID_.isEmpty ())
 			writer->writeAttribute ("queryid", QueryID_);
 
-		if (JID_.isEmpty () && !Count_ && ItemId_.isEmpty ())
+		if (JID_.isEmpty () && !Start_.isValid () && !Count_ && ItemId_.isEmpty ())
 			return;
 
-		if (!JID_.isEmpty ())
+		if (!JID_.isEmpty () || Start_.isValid ())
 		{
 			QXmppDataForm::Field formTypeField { QXmppDataForm::Field::HiddenField };
 			formTypeField.setKey ("FORM_TYPE");
 			formTypeField.setValue (Xep0313Manager::GetNsUri ());
 
-			QXmppDataForm::Field jidField { QXmppDataForm::Field::JidSingleField };
-			jidField.setKey ("with");
-			jidField.setValue (JID_);
+			QList<QXmppDataForm::Field> fields { formTypeField };
+
+			if (!JID_.isEmpty ())
+			{
+				QXmppDataForm::Field jidField { QXmppDataForm::Field::JidSingleField };
+				jidField.setKey ("with");
+				jidField.setValue (JID_);
+				fields << jidField;
+			}
+
+			if (Start_.isValid ())
+			{
+				QXmppDataForm::Field startField;
+				startField.setKey ("start");
+				startField.setValue (QXmppUtils::datetimeToString (Start_));
+				fields << startField;
+			}
 
 			QXmppDataForm form { QXmppDataForm::Form };
-			form.setFields ({ formTypeField, jidField });
+			form.setFields (fields);
 			form.toXml (writer);
 		}
 
@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <QDateTime>
 #include <QXmppIq.h>
 
 namespace LC
@@ -44,6 +45,8 @@ namespace Xoox
 		int Count_;
 
 		QString QueryID_;
+
+		QDateTime Start_;
 	public:
 		enum class Direction
 		{
@@ -55,6 +58,10 @@ namespace Xoox
 		Direction Dir_ = Direction::Unspecified;
 	public:
 		Xep0313ReqIq (const QString&, const QString&, int, Direction, const QString& queryId);
+
+		/** @brief Limits the query to the messages since the given date.
+		 */
+		void SetStart (const QDateTime&);
 	protected:
 		void parseElementFromChild (const QDomElement&);
 		void toXmlElementFromChild (QXmlStreamWriter*) const;
@@ -7,10 +7,17 @@ function ScrollToBottom() {
 function TestScroll() {
 	window.ShouldScroll = document.documentElement.scrollHeight <= (window.innerHeight + window.pageYOffset + window.innerHeight / 5);
 }
+function ScheduleScrollToBottom() {
+	if (window.ScrollScheduled)
+		return;
+
+	window.ScrollScheduled = true;
+	setTimeout (function () { window.ScrollScheduled = false; ScrollToBottom (); }, 0);
+}
 function InstallEventListeners() {
 	window.ShouldScroll = true;
-	document.body.addEventListener ("DOMNodeInserted", function () { setTimeout (ScrollToBottom, 0); }, false);
-	document.body.addEventListener ("DOMSubtreeModified", function () { setTimeout (ScrollToBottom, 0); }, false);
+	document.body.addEventListener ("DOMNodeInserted", ScheduleScrollToBottom, false);
+	document.body.addEventListener ("DOMSubtreeModified", ScheduleScrollToBottom, false);
 	window.addEventListener ("resize", function () { setTimeout (ScrollToBottom, 0); });
 	window.addEventListener ("scroll", TestScroll);
 }
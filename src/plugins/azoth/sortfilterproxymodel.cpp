@@ -141,6 +141,12 @@ namespace Azoth
 		{
 			return qobject_cast<ICLEntry*> (idx.data (Core::CLREntryObject).value<QObject*> ());
 		}
+
+		State GetState (const QModelIndex& idx)
+		{
+			const auto& var = idx.data (Core::CLREntryState);
+			return var.isNull () ? SOffline : static_cast<State> (var.toInt ());
+		}
 	}
 
 	bool SortFilterProxyModel::filterAcceptsRow (int row, const QModelIndex& parent) const
@@ -169,7 +175,8 @@ namespace Azoth
 		const auto lE = GetEntry (left);
 		const auto rE = GetEntry (right);
 
-		if (lE->GetEntryType () == ICLEntry::EntryType::PrivateChat &&
+		if (lE && rE &&
+				lE->GetEntryType () == ICLEntry::EntryType::PrivateChat &&
 				rE->GetEntryType () == ICLEntry::EntryType::PrivateChat &&
 				lE->GetParentCLEntry () == rE->GetParentCLEntry ())
 			if (const auto lp = qobject_cast<IMUCPerms*> (lE->GetParentCLEntryObject ()))
@@ -180,11 +187,11 @@ namespace Azoth
 					return more;
 			}
 
-		const auto lState = lE->GetStatus ().State_;
-		const auto rState = rE->GetStatus ().State_;
+		const auto lState = GetState (left);
+		const auto rState = GetState (right);
 		if (lState == rState ||
 				!OrderByStatus_)
-			return lE->GetEntryName ().localeAwareCompare (rE->GetEntryName ()) < 0;
+			return Collator_.compare (left.data ().toString (), right.data ().toString ()) < 0;
 		else
 			return IsLess (lState, rState);
 	}
@@ -229,7 +236,7 @@ namespace Azoth
 		if (type == Core::CLETContact)
 		{
 			const auto entry = GetEntry (idx);
-			const auto state = entry->GetStatus ().State_;
+			const auto state = GetState (idx);
 
 			if (!ShowOffline_ &&
 					HideErroring_ &&
@@ -242,10 +249,12 @@ namespace Azoth
 				return false;
 
 			if (HideMUCParts_ &&
+					entry &&
 					entry->GetEntryType () == ICLEntry::EntryType::PrivateChat)
 				return false;
 
 			if (!ShowSelfContacts_ &&
+					entry &&
 					entry->GetEntryFeatures () & ICLEntry::FSelfContact)
 				return false;
 		}
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <QSortFilterProxyModel>
+#include <QCollator>
 
 namespace LC
 {
@@ -46,6 +47,8 @@ namespace Azoth
 		bool ShowSelfContacts_ = true;
 		bool HideErroring_ = true;
 		QObject *MUCEntry_ = nullptr;
+
+		QCollator Collator_;
 	public:
 		SortFilterProxyModel (QObject* = nullptr);
 
@@ -0,0 +1,269 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "formatpipelinebench.h"
+#include <memory>
+#include <vector>
+#include <QtTest>
+#include <QMap>
+#include <QRegularExpression>
+#include "formatpipeline.cpp"
+
+QTEST_APPLESS_MAIN (LC::Azoth::FormatPipelineBench)
+
+namespace LC
+{
+namespace Azoth
+{
+	namespace
+	{
+		const int LogSize = 5000;
+
+		QString GetSrc (const QString& str)
+		{
+			return "data:image/png;base64," + str.toUtf8 ().toBase64 ();
+		}
+
+		// The emoticon handling as it was done over the whole body.
+		QString NaiveSmiles (QString body, const QStringList& smiles)
+		{
+			QMap<int, QString> pos2smile;
+			for (const auto& str : smiles)
+			{
+				const auto& escaped = str.toHtmlEscaped ();
+				int pos = 0;
+				while ((pos = body.indexOf (escaped, pos)) != -1)
+				{
+					if (!pos || body [pos - 1].isSpace ())
+						pos2smile [pos] = str;
+					pos += escaped.size ();
+				}
+			}
+
+			for (auto i = pos2smile.begin (); i != pos2smile.end (); ++i)
+				for (int j = 1; j < i.value ().toHtmlEscaped ().size (); ++j)
+					pos2smile.remove (i.key () + j);
+
+			for (auto i = pos2smile.end (); i != pos2smile.begin (); )
+			{
+				--i;
+				const auto& str = i.value ();
+				body.replace (i.key (), str.toHtmlEscaped ().size (),
+						QString ("<img src=\"%2\" title=\"%1\" />")
+							.arg (str.toHtmlEscaped ())
+							.arg (GetSrc (str)));
+			}
+
+			return body;
+		}
+
+		// Mimic Modnok rendering the formulas and a plugin linking the
+		// post numbers, like Juick does.
+		const QRegularExpression FormulaRx { "\\$\\$(.+?)\\$\\$" };
+		const QRegularExpression PostRx { "#(\\d+)" };
+
+		QString RenderFormulas (QString text)
+		{
+			return text.replace (FormulaRx, "<img src=\"formula:\\1\" alt=\"\\1\" />");
+		}
+
+		QString LinkPosts (QString text)
+		{
+			return text.replace (PostRx, "<a href=\"azoth://msgeditinsert/%23\\1\">#\\1</a>");
+		}
+
+		QString AsTransform (const QString& text, QString (*f) (QString))
+		{
+			const auto& result = f (text);
+			return result == text ? QString {} : result;
+		}
+
+		const BodyTransformers_t Transformers
+		{
+			{ "$$", [] (const QString& text, IMessage*) { return AsTransform (text, &RenderFormulas); } },
+			{ "#", [] (const QString& text, IMessage*) { return AsTransform (text, &LinkPosts); } }
+		};
+	}
+
+	void FormatPipelineBench::initTestCase ()
+	{
+		Smiles_ = QStringList { ":)", ":-)", ":(", ":-(", ";)", ";-)", ":D", ":-D", ":P", ":-P",
+				"8)", ":O", ":'(", ":|", ":*", ">:(", "O:)", "xD", "^_^", "-_-" };
+		for (int i = 0; i < 80; ++i)
+			Smiles_ << QString ("*smile%1*").arg (i);
+
+		// Mimics a busy MUC: short lines, some links, some emoticons,
+		// occasional multiline pastes and nick mentions.
+		const QStringList fragments
+		{
+			"hi all",
+			"have you seen http://example.com/some/long/path?with=query&amp;and=more ?",
+			"lol :D",
+			"nick1: that's not how it works ;)",
+			"try www.example.org/docs",
+			"meh :( it segfaults again",
+			"a\nmultiline\npaste\n  with  indentation",
+			"&lt;b&gt;not a tag&lt;/b&gt; :P",
+			"ok *smile42*",
+			"nick2, nick3: ping",
+			"so it's $$e^{i\\pi} + 1 = 0$$ obviously",
+			"see #123456 for details"
+		};
+
+		qsrand (42);
+		for (int i = 0; i < LogSize; ++i)
+		{
+			auto line = fragments.at (qrand () % fragments.size ());
+			if (qrand () % 4 == 0)
+				line += ' ' + fragments.at (qrand () % fragments.size ());
+			Log_ << line;
+		}
+	}
+
+	void FormatPipelineBench::tokenize ()
+	{
+		QBENCHMARK
+		{
+			for (const auto& line : Log_)
+				JoinSpans (TokenizeBody (line));
+		}
+	}
+
+	void FormatPipelineBench::tokenizeLinks ()
+	{
+		const auto& body = QString { "text <a href=\"http://x.org/:)\">http://x.org/:)</a> :) more" };
+		const auto& spans = TokenizeBody (body);
+		QCOMPARE (JoinSpans (spans), body);
+		QCOMPARE (spans.size (), 5);
+		QVERIFY (spans.at (2).InLink_);
+		QVERIFY (!spans.at (4).InLink_);
+
+		SmilesMatcher matcher { Smiles_, true, &GetSrc };
+		auto transformed = spans;
+		TransformTextSpans (transformed, [&matcher] (const QString& text) { return matcher (text); });
+
+		QCOMPARE (transformed.at (2).Str_, spans.at (2).Str_);
+		QVERIFY (JoinSpans (transformed).contains ("<img"));
+		QCOMPARE (JoinSpans (transformed).count ("<img"), 1);
+	}
+
+	void FormatPipelineBench::smilesNaive ()
+	{
+		QBENCHMARK
+		{
+			for (const auto& line : Log_)
+				NaiveSmiles (line, Smiles_);
+		}
+	}
+
+	void FormatPipelineBench::smilesMatcher ()
+	{
+		const SmilesMatcher matcher { Smiles_, true, &GetSrc };
+
+		for (const auto& line : Log_.mid (0, 100))
+		{
+			const auto& matched = matcher (line);
+			QCOMPARE (matched.isNull () ? line : matched, NaiveSmiles (line, Smiles_));
+		}
+
+		QBENCHMARK
+		{
+			for (const auto& line : Log_)
+			{
+				auto spans = TokenizeBody (line);
+				TransformTextSpans (spans, [&matcher] (const QString& text) { return matcher (text); });
+				JoinSpans (spans);
+			}
+		}
+	}
+
+	void FormatPipelineBench::pluginHooks ()
+	{
+		// Each plugin got the whole HTML body in a hook, and the core had
+		// to tokenize the result again.
+		QBENCHMARK
+		{
+			for (const auto& line : Log_)
+				TokenizeBody (LinkPosts (RenderFormulas (line)));
+		}
+	}
+
+	void FormatPipelineBench::pluginTransformers ()
+	{
+		const auto& body = QString { "$$x^2$$ in #42 and <a href=\"http://x.org/#7\">#7</a>" };
+		auto spans = TokenizeBody (body);
+		ApplyBodyTransformers (spans, Transformers, nullptr);
+		QCOMPARE (JoinSpans (spans),
+				QString { "<img src=\"formula:x^2\" alt=\"x^2\" /> in "
+						"<a href=\"azoth://msgeditinsert/%2342\">#42</a> and "
+						"<a href=\"http://x.org/#7\">#7</a>" });
+
+		QBENCHMARK
+		{
+			for (const auto& line : Log_)
+			{
+				auto spans = TokenizeBody (line);
+				ApplyBodyTransformers (spans, Transformers, nullptr);
+			}
+		}
+	}
+
+	void FormatPipelineBench::formattedCache ()
+	{
+		FormattedBodiesCache cache { 4 * 1024 * 1024 };
+
+		auto msg = std::make_unique<QObject> ();
+		cache.Insert (msg.get (), "body", "ctx", "formatted");
+		QCOMPARE (cache.Get (msg.get (), "body", "ctx"), QString { "formatted" });
+		QVERIFY (cache.Get (msg.get (), "other body", "ctx").isNull ());
+		QVERIFY (cache.Get (msg.get (), "body", "other ctx").isNull ());
+
+		const auto oldAddress = msg.get ();
+		msg.reset ();
+		QVERIFY (cache.Get (oldAddress, "body", "ctx").isNull ());
+
+		// A chat view reload with all the bodies already formatted.
+		std::vector<std::unique_ptr<QObject>> msgs;
+		for (const auto& line : Log_)
+		{
+			msgs.push_back (std::make_unique<QObject> ());
+			auto spans = TokenizeBody (line);
+			ApplyBodyTransformers (spans, Transformers, nullptr);
+			cache.Insert (msgs.back ().get (), line, "ctx", JoinSpans (spans));
+		}
+
+		QBENCHMARK
+		{
+			for (int i = 0; i < Log_.size (); ++i)
+				if (cache.Get (msgs [i].get (), Log_ [i], "ctx").isNull ())
+					QFAIL ("cache miss");
+		}
+	}
+}
+}
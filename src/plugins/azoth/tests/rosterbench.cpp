@@ -0,0 +1,148 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "rosterbench.h"
+#include <QtTest>
+#include <QStandardItemModel>
+#include <QHash>
+#include "core.h"
+#include "rosterstate.h"
+#include "sortfilterproxymodel.h"
+
+QTEST_GUILESS_MAIN (LC::Azoth::RosterBench)
+
+namespace LC
+{
+namespace Azoth
+{
+	namespace
+	{
+		const int CategoriesCount = 50;
+		const int ContactsCount = 10000;
+		const int StormSize = 2000;
+
+		const State States [] = { SOffline, SOnline, SAway, SXA, SDND, SChat };
+
+		State GetState (int seed)
+		{
+			return States [seed % (sizeof (States) / sizeof (States [0]))];
+		}
+
+		// Presence storms typically flap the same entries a few times
+		// in a row, like offline → online → away on login.
+		QList<QPair<QStandardItem*, State>> MakeStorm (const QList<QStandardItem*>& contacts, int round)
+		{
+			QList<QPair<QStandardItem*, State>> result;
+			for (int i = 0; i < StormSize; ++i)
+			{
+				const auto item = contacts.at ((i * 7919 + round) % contacts.size ());
+				for (int flap = 0; flap < 3; ++flap)
+					result.append ({ item, GetState (i + flap + round) });
+			}
+			return result;
+		}
+	}
+
+	void RosterBench::initTestCase ()
+	{
+		Model_ = std::make_shared<QStandardItemModel> ();
+
+		QList<QStandardItem*> cats;
+		for (int i = 0; i < CategoriesCount; ++i)
+		{
+			const auto cat = new QStandardItem (QString ("Group %1").arg (i));
+			cat->setData (QVariant::fromValue (Core::CLETCategory), Core::CLREntryType);
+			cat->setData (0, Core::CLRNumOnline);
+			Model_->appendRow (cat);
+			cats << cat;
+		}
+
+		for (int i = 0; i < ContactsCount; ++i)
+		{
+			const auto item = new QStandardItem (QString ("contact %1").arg ((i * 104729) % ContactsCount));
+			item->setData (QVariant::fromValue (Core::CLETContact), Core::CLREntryType);
+			cats.at (i % CategoriesCount)->appendRow (item);
+			UpdateItemState (item, GetState (i));
+			Contacts_ << item;
+		}
+
+		Proxy_ = std::make_shared<SortFilterProxyModel> ();
+		Proxy_->setSourceModel (Model_.get ());
+		Proxy_->sort (0);
+	}
+
+	void RosterBench::cleanupTestCase ()
+	{
+		Proxy_.reset ();
+		Model_.reset ();
+		Contacts_.clear ();
+	}
+
+	void RosterBench::sort ()
+	{
+		QBENCHMARK
+		{
+			Proxy_->invalidate ();
+		}
+	}
+
+	void RosterBench::filterOffline ()
+	{
+		QBENCHMARK
+		{
+			Proxy_->showOfflineContacts (false);
+			Proxy_->showOfflineContacts (true);
+		}
+	}
+
+	void RosterBench::statusStormPerChange ()
+	{
+		int round = 0;
+		QBENCHMARK
+		{
+			for (const auto& pair : MakeStorm (Contacts_, ++round))
+				UpdateItemState (pair.first, pair.second);
+		}
+	}
+
+	void RosterBench::statusStormCoalesced ()
+	{
+		int round = 0;
+		QBENCHMARK
+		{
+			QHash<QStandardItem*, State> pending;
+			for (const auto& pair : MakeStorm (Contacts_, ++round))
+				pending [pair.first] = pair.second;
+
+			for (auto i = pending.begin (), end = pending.end (); i != end; ++i)
+				UpdateItemState (i.key (), i.value ());
+		}
+	}
+}
+}
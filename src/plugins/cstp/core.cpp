@@ -53,6 +53,7 @@
 #include <util/xpc/notificationactionhandler.h>
 #include <util/xpc/util.h>
 #include "task.h"
+#include "diskwriter.h"
 #include "xmlsettingsmanager.h"
 #include "addtask.h"
 
@@ -81,6 +82,21 @@ namespace CSTP
 		qRegisterMetaType<std::shared_ptr<QFile>> ("std::shared_ptr<QFile>");
 		qRegisterMetaType<QNetworkReply*> ("QNetworkReply*");
 
+		Writer_.reset (new DiskWriter,
+				[] (DiskWriter *writer)
+				{
+					// A write in progress can't be interrupted, and deleting
+					// a running thread would crash, so wait as long as needed.
+					writer->quit ();
+					writer->wait ();
+					delete writer;
+				});
+		Writer_->start (QThread::HighPriority);
+
+		XmlSettingsManager::Instance ().RegisterObject ({ "GlobalSpeedLimit", "TaskSpeedLimit" },
+				this, "handleSpeedLimitsChanged");
+		handleSpeedLimitsChanged ();
+
 		ReadSettings ();
 	}
 
@@ -93,6 +109,11 @@ namespace CSTP
 	void Core::Release ()
 	{
 		writeSettings ();
+
+		for (const auto& td : ActiveTasks_)
+			if (td.Task_->IsRunning ())
+				td.Task_->Stop ();
+		Writer_.reset ();
 	}
 
 	void Core::SetCoreProxy (ICoreProxy_ptr proxy)
@@ -407,6 +428,21 @@ namespace CSTP
 		FinishedReplies_.remove (rep);
 	}
 
+	DiskWriter* Core::GetDiskWriter () const
+	{
+		return Writer_.get ();
+	}
+
+	RateLimiter* Core::GetGlobalLimiter ()
+	{
+		return &GlobalLimiter_;
+	}
+
+	qint64 Core::GetTaskSpeedLimit () const
+	{
+		return TaskSpeedLimit_;
+	}
+
 	int Core::columnCount (const QModelIndex&) const
 	{
 		return Headers_.size ();
@@ -736,6 +772,16 @@ namespace CSTP
 		FinishedReplies_.insert (rep);
 	}
 
+	void Core::handleSpeedLimitsChanged ()
+	{
+		const auto& xsm = XmlSettingsManager::Instance ();
+		GlobalLimiter_.SetRate (xsm.property ("GlobalSpeedLimit").toLongLong () * 1024);
+		TaskSpeedLimit_ = xsm.property ("TaskSpeedLimit").toLongLong () * 1024;
+
+		for (const auto& td : ActiveTasks_)
+			td.Task_->SetSpeedLimit (TaskSpeedLimit_);
+	}
+
 	void Core::ReadSettings ()
 	{
 		QSettings settings (QCoreApplication::organizationName (),
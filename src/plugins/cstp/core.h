@@ -41,6 +41,7 @@
 #include <interfaces/iinfo.h>
 #include <interfaces/structures.h>
 #include <interfaces/idownload.h>
+#include "ratelimiter.h"
 
 class QFile;
 class QToolBar;
@@ -52,6 +53,7 @@ namespace LC
 namespace CSTP
 {
 	class Task;
+	class DiskWriter;
 
 	class Core : public QAbstractItemModel
 	{
@@ -77,6 +79,10 @@ namespace CSTP
 		QModelIndex Selected_;
 		ICoreProxy_ptr CoreProxy_;
 
+		std::shared_ptr<DiskWriter> Writer_;
+		RateLimiter GlobalLimiter_;
+		qint64 TaskSpeedLimit_ = 0;
+
 		explicit Core ();
 	public:
 		enum
@@ -111,6 +117,10 @@ namespace CSTP
 		bool HasFinishedReply (QNetworkReply*) const;
 		void RemoveFinishedReply (QNetworkReply*);
 
+		DiskWriter* GetDiskWriter () const;
+		RateLimiter* GetGlobalLimiter ();
+		qint64 GetTaskSpeedLimit () const;
+
 		int columnCount (const QModelIndex& = QModelIndex ()) const override;
 		QVariant data (const QModelIndex&, int = Qt::DisplayRole) const override;
 		Qt::ItemFlags flags (const QModelIndex&) const override;
@@ -131,6 +141,7 @@ namespace CSTP
 		void updateInterface ();
 		void writeSettings ();
 		void finishedReply (QNetworkReply*);
+		void handleSpeedLimitsChanged ();
 	private:
 		QFuture<IDownload::Result> AddTask (const QUrl&,
 				const QString&,
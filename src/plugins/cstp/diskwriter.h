@@ -0,0 +1,67 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <util/threads/workerthreadbase.h>
+
+class QFile;
+
+namespace LC
+{
+namespace CSTP
+{
+	/** @brief Writes downloaded data to the files off the GUI thread.
+	 *
+	 * Writes are executed in the order they are scheduled. A file
+	 * must not be touched from other threads while it has writes
+	 * pending, see TransferGate::Sync().
+	 */
+	class DiskWriter final : public Util::WorkerThreadBase
+	{
+	public:
+		using Util::WorkerThreadBase::WorkerThreadBase;
+
+		/** @brief Schedules writing the data to the file.
+		 *
+		 * @param[in] file The file to write to.
+		 * @param[in] pos The position to write at, or -1 to write at
+		 * the current position of the file.
+		 * @param[in] data The data to write.
+		 * @return The error string, or an empty string if the data has
+		 * been written successfully.
+		 */
+		QFuture<QString> Write (const std::shared_ptr<QFile>& file, qint64 pos, const QByteArray& data);
+	protected:
+		void Initialize () override;
+		void Cleanup () override;
+	};
+}
+}
@@ -0,0 +1,103 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "ratelimiter.h"
+#include <algorithm>
+#include <limits>
+
+namespace LC
+{
+namespace CSTP
+{
+	namespace
+	{
+		const qint64 MinChunk = 4 * 1024;
+	}
+
+	void RateLimiter::SetRate (qint64 rate)
+	{
+		Rate_ = std::max<qint64> (rate, 0);
+		Tokens_ = GetCapacity ();
+		Clock_.start ();
+		LastRefill_ = 0;
+	}
+
+	qint64 RateLimiter::GetRate () const
+	{
+		return Rate_;
+	}
+
+	bool RateLimiter::IsLimited () const
+	{
+		return Rate_ > 0;
+	}
+
+	qint64 RateLimiter::GetAvailable ()
+	{
+		if (!IsLimited ())
+			return std::numeric_limits<qint64>::max ();
+
+		Refill ();
+		return std::max<qint64> (Tokens_, 0);
+	}
+
+	void RateLimiter::Consume (qint64 bytes)
+	{
+		if (IsLimited ())
+			Tokens_ -= bytes;
+	}
+
+	int RateLimiter::GetRefillDelay () const
+	{
+		if (!IsLimited ())
+			return 0;
+
+		const auto needed = std::min (MinChunk, GetCapacity ()) - Tokens_;
+		if (needed <= 0)
+			return 0;
+
+		return static_cast<int> (needed * 1000 / Rate_) + 1;
+	}
+
+	qint64 RateLimiter::GetCapacity () const
+	{
+		return std::max (Rate_ / 4, MinChunk);
+	}
+
+	void RateLimiter::Refill ()
+	{
+		// Frequent refills would lose the sub-millisecond remainders with
+		// the millisecond resolution, so the nanoseconds are counted.
+		const auto now = Clock_.nsecsElapsed ();
+		const auto elapsed = now - LastRefill_;
+		LastRefill_ = now;
+		Tokens_ = std::min<double> (Tokens_ + Rate_ * (elapsed / 1e9), GetCapacity ());
+	}
+}
+}
@@ -0,0 +1,69 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+
+namespace LC
+{
+namespace CSTP
+{
+	/** @brief A token bucket limiting the transfer rate.
+	 *
+	 * The bucket is refilled at the configured rate and holds at most a
+	 * quarter of a second worth of tokens, so short bursts are allowed
+	 * while the long-term rate is kept. A zero rate means no limit.
+	 */
+	class RateLimiter
+	{
+		qint64 Rate_ = 0;
+		double Tokens_ = 0;
+
+		QElapsedTimer Clock_;
+		// Nanoseconds on the Clock_ up to which the tokens are credited.
+		qint64 LastRefill_ = 0;
+	public:
+		void SetRate (qint64 bytesPerSecond);
+		qint64 GetRate () const;
+		bool IsLimited () const;
+
+		qint64 GetAvailable ();
+		void Consume (qint64 bytes);
+
+		/** @return The time in milliseconds until a reasonably sized
+		 * chunk of data can be transferred.
+		 */
+		int GetRefillDelay () const;
+	private:
+		qint64 GetCapacity () const;
+		void Refill ();
+	};
+}
+}
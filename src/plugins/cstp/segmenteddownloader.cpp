@@ -0,0 +1,489 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "segmenteddownloader.h"
+#include <algorithm>
+#include <numeric>
+#include <QNetworkAccessManager>
+#include <QPointer>
+#include <QTimer>
+#include <QtDebug>
+#include "transfergate.h"
+
+namespace LC
+{
+namespace CSTP
+{
+	std::optional<ContentRange> ParseContentRange (const QByteArray& header)
+	{
+		const auto& value = header.trimmed ();
+		if (!value.startsWith ("bytes "))
+			return {};
+
+		const auto dash = value.indexOf ('-');
+		const auto slash = value.indexOf ('/', dash);
+		if (dash < 0 || slash < 0)
+			return {};
+
+		bool firstOk = false;
+		bool lastOk = false;
+		const auto first = value.mid (6, dash - 6).trimmed ().toLongLong (&firstOk);
+		const auto last = value.mid (dash + 1, slash - dash - 1).trimmed ().toLongLong (&lastOk);
+		if (!firstOk || !lastOk || first < 0 || last < first)
+			return {};
+
+		const auto& totalStr = value.mid (slash + 1).trimmed ();
+		qint64 total = -1;
+		if (totalStr != "*")
+		{
+			bool totalOk = false;
+			total = totalStr.toLongLong (&totalOk);
+			if (!totalOk || total <= last)
+				return {};
+		}
+
+		return ContentRange { first, last, total };
+	}
+
+	QByteArray GetValidator (const QNetworkReply *reply)
+	{
+		const auto& etag = reply->rawHeader ("ETag");
+		if (!etag.isEmpty () && !etag.startsWith ("W/"))
+			return etag;
+
+		return reply->rawHeader ("Last-Modified");
+	}
+
+	bool IsValidatorChanged (const QNetworkReply *reply, const QByteArray& validator)
+	{
+		if (validator.isEmpty ())
+			return false;
+
+		const auto& current = reply->rawHeader (validator.startsWith ('"') ? "ETag" : "Last-Modified");
+		return !current.isEmpty () && current != validator;
+	}
+
+	SegmentedDownloader::SegmentedDownloader (QNetworkAccessManager *nam,
+			const QNetworkRequest& request,
+			TransferGate *gate,
+			qint64 total,
+			const QByteArray& validator,
+			const QList<Segment>& remaining,
+			int maxConnections,
+			qint64 minSegmentSize,
+			QObject *parent)
+	: QObject { parent }
+	, NAM_ { nam }
+	, Request_ { request }
+	, Gate_ { gate }
+	, Total_ { total }
+	, Validator_ { validator }
+	, MaxConnections_ { std::max (maxConnections, 1) }
+	, MinSegmentSize_ { std::max<qint64> (minSegmentSize, 1) }
+	{
+		for (const auto& segment : remaining)
+			if (segment.first < segment.second)
+				Segments_.push_back ({ segment.first, segment.second });
+
+		std::sort (Segments_.begin (), Segments_.end (),
+				[] (const SegmentState& left, const SegmentState& right)
+					{ return left.Pos_ < right.Pos_; });
+
+		connect (Gate_,
+				&TransferGate::ready,
+				this,
+				&SegmentedDownloader::HandleGateReady);
+		connect (Gate_,
+				&TransferGate::writeError,
+				this,
+				&SegmentedDownloader::HandleWriteError);
+	}
+
+	SegmentedDownloader::~SegmentedDownloader ()
+	{
+		Stop ();
+	}
+
+	void SegmentedDownloader::AdoptReply (QNetworkReply *reply)
+	{
+		const auto pos = std::find_if (Segments_.begin (), Segments_.end (),
+				[] (const SegmentState& segment) { return !segment.Reply_; });
+		if (pos == Segments_.end ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "no free segment for the reply"
+					<< reply->url ();
+			reply->abort ();
+			reply->deleteLater ();
+			return;
+		}
+
+		pos->Reply_ = reply;
+		pos->Verified_ = true;
+		reply->setReadBufferSize (TransferGate::ReadBufferSize);
+		ConnectReply (reply);
+
+		if (reply->bytesAvailable ())
+			QTimer::singleShot (0, this,
+					[this, safeReply = QPointer<QNetworkReply> { reply }]
+					{
+						if (safeReply)
+							HandleReadyRead (safeReply);
+					});
+	}
+
+	void SegmentedDownloader::Start ()
+	{
+		Stopped_ = false;
+		Schedule ();
+	}
+
+	void SegmentedDownloader::Stop ()
+	{
+		Stopped_ = true;
+		for (auto& segment : Segments_)
+			if (segment.Reply_)
+				ReleaseReply (segment);
+	}
+
+	QList<Segment> SegmentedDownloader::GetRemaining () const
+	{
+		QList<Segment> result;
+		for (const auto& segment : Segments_)
+			result << Segment { segment.Pos_, segment.End_ };
+		std::sort (result.begin (), result.end ());
+		return result;
+	}
+
+	qint64 SegmentedDownloader::GetDone () const
+	{
+		return std::accumulate (Segments_.begin (), Segments_.end (), Total_,
+				[] (qint64 done, const SegmentState& segment)
+					{ return done - (segment.End_ - segment.Pos_); });
+	}
+
+	qint64 SegmentedDownloader::GetTotal () const
+	{
+		return Total_;
+	}
+
+	int SegmentedDownloader::GetActiveConnections () const
+	{
+		return std::count_if (Segments_.begin (), Segments_.end (),
+				[] (const SegmentState& segment) { return segment.Reply_; });
+	}
+
+	QString SegmentedDownloader::GetErrorString () const
+	{
+		return ErrorString_;
+	}
+
+	std::vector<SegmentedDownloader::SegmentState>::iterator SegmentedDownloader::FindSegment (QNetworkReply *reply)
+	{
+		return std::find_if (Segments_.begin (), Segments_.end (),
+				[reply] (const SegmentState& segment) { return segment.Reply_ == reply; });
+	}
+
+	void SegmentedDownloader::Schedule ()
+	{
+		if (Stopped_ || Finished_)
+			return;
+
+		if (Segments_.empty ())
+		{
+			if (Gate_->GetPending ())
+				return;
+
+			Finished_ = true;
+			emit finished ();
+			return;
+		}
+
+		auto active = GetActiveConnections ();
+		for (auto& segment : Segments_)
+		{
+			if (active >= MaxConnections_)
+				break;
+
+			if (segment.Reply_)
+				continue;
+
+			StartSegment (segment);
+			++active;
+		}
+
+		while (active < MaxConnections_ && SplitLargest ())
+			++active;
+	}
+
+	bool SegmentedDownloader::SplitLargest ()
+	{
+		auto largest = Segments_.end ();
+		for (auto it = Segments_.begin (); it != Segments_.end (); ++it)
+			if (it->Reply_ &&
+					(largest == Segments_.end () ||
+						it->End_ - it->Pos_ > largest->End_ - largest->Pos_))
+				largest = it;
+
+		if (largest == Segments_.end ())
+			return false;
+
+		const auto remaining = largest->End_ - largest->Pos_;
+		if (remaining < 2 * MinSegmentSize_)
+			return false;
+
+		const auto middle = largest->Pos_ + remaining / 2;
+		const auto end = largest->End_;
+		largest->End_ = middle;
+
+		Segments_.push_back ({ middle, end });
+		StartSegment (Segments_.back ());
+		return true;
+	}
+
+	void SegmentedDownloader::StartSegment (SegmentState& segment)
+	{
+		auto req = Request_;
+		req.setRawHeader ("Range",
+				QString ("bytes=%1-%2").arg (segment.Pos_).arg (segment.End_ - 1).toLatin1 ());
+		if (!Validator_.isEmpty ())
+			req.setRawHeader ("If-Range", Validator_);
+
+		segment.Reply_ = NAM_->get (req);
+		segment.Reply_->setReadBufferSize (TransferGate::ReadBufferSize);
+		segment.Verified_ = false;
+		ConnectReply (segment.Reply_);
+	}
+
+	void SegmentedDownloader::ConnectReply (QNetworkReply *reply)
+	{
+		connect (reply,
+				&QNetworkReply::readyRead,
+				this,
+				[this, reply] { HandleReadyRead (reply); });
+		connect (reply,
+				&QNetworkReply::finished,
+				this,
+				[this, reply] { HandleFinished (reply); });
+	}
+
+	void SegmentedDownloader::ReleaseReply (SegmentState& segment)
+	{
+		const auto reply = segment.Reply_;
+		segment.Reply_ = nullptr;
+
+		disconnect (reply,
+				nullptr,
+				this,
+				nullptr);
+		reply->abort ();
+		reply->deleteLater ();
+	}
+
+	void SegmentedDownloader::HandleReadyRead (QNetworkReply *reply)
+	{
+		const auto segment = FindSegment (reply);
+		if (segment == Segments_.end ())
+			return;
+
+		if (!segment->Verified_)
+		{
+			if (!VerifyReply (*segment, reply))
+				return;
+			segment->Verified_ = true;
+		}
+
+		while (reply->bytesAvailable () && segment->Pos_ < segment->End_)
+		{
+			const auto allowance = Gate_->GetAllowance ();
+			if (!allowance)
+				return;
+
+			const auto& data = reply->read (std::min ({ reply->bytesAvailable (), segment->End_ - segment->Pos_, allowance }));
+			if (!Gate_->Write (segment->Pos_, data))
+				return;
+
+			segment->Pos_ += data.size ();
+		}
+
+		emit progress (GetDone (), Total_);
+
+		if (segment->Pos_ < segment->End_)
+			return;
+
+		ReleaseReply (*segment);
+		Segments_.erase (segment);
+		Schedule ();
+	}
+
+	bool SegmentedDownloader::VerifyReply (SegmentState& segment, QNetworkReply *reply)
+	{
+		const auto code = reply->attribute (QNetworkRequest::HttpStatusCodeAttribute).toInt ();
+		if (code == 200 && IsValidatorChanged (reply, Validator_))
+		{
+			HandleResourceChanged (reply);
+			return false;
+		}
+
+		if (code != 206)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "server ignored the range request for"
+					<< reply->url ()
+					<< code;
+			HandleSegmentFailure (segment,
+					QNetworkReply::ProtocolFailure,
+					tr ("Server ignored the range request."));
+			return false;
+		}
+
+		const auto& range = ParseContentRange (reply->rawHeader ("Content-Range"));
+		if (range && range->Total_ >= 0 && range->Total_ != Total_)
+		{
+			HandleResourceChanged (reply);
+			return false;
+		}
+
+		if (IsValidatorChanged (reply, Validator_))
+		{
+			HandleResourceChanged (reply);
+			return false;
+		}
+
+		if (!range || range->First_ != segment.Pos_)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unexpected range"
+					<< reply->rawHeader ("Content-Range")
+					<< "for"
+					<< reply->url ()
+					<< "starting at"
+					<< segment.Pos_;
+			HandleSegmentFailure (segment,
+					QNetworkReply::ProtocolFailure,
+					tr ("Server returned an unexpected range."));
+			return false;
+		}
+
+		return true;
+	}
+
+	void SegmentedDownloader::HandleFinished (QNetworkReply *reply)
+	{
+		HandleReadyRead (reply);
+
+		const auto segment = FindSegment (reply);
+		if (segment == Segments_.end ())
+			return;
+
+		// throttled by the gate, the rest will be read once it's ready
+		if (reply->error () == QNetworkReply::NoError && reply->bytesAvailable ())
+			return;
+
+		if (reply->error () != QNetworkReply::NoError)
+			HandleSegmentFailure (*segment, reply->error (), reply->errorString ());
+		else
+			HandleSegmentFailure (*segment,
+					QNetworkReply::RemoteHostClosedError,
+					tr ("Connection closed before the range has been downloaded."));
+	}
+
+	void SegmentedDownloader::HandleSegmentFailure (SegmentState& segment,
+			QNetworkReply::NetworkError error, const QString& errorString)
+	{
+		ReleaseReply (segment);
+
+		if (++segment.Failures_ > MaxFailures)
+		{
+			ErrorString_ = errorString;
+			Stop ();
+			emit networkError (error, errorString);
+			return;
+		}
+
+		qWarning () << Q_FUNC_INFO
+				<< "retrying range"
+				<< segment.Pos_
+				<< segment.End_
+				<< "after"
+				<< errorString;
+		QTimer::singleShot (500 * segment.Failures_,
+				this,
+				[this] { Schedule (); });
+	}
+
+	void SegmentedDownloader::HandleResourceChanged (QNetworkReply *reply)
+	{
+		qWarning () << Q_FUNC_INFO
+				<< reply->url ()
+				<< "has changed on the server, expected"
+				<< Validator_
+				<< Total_
+				<< "got"
+				<< GetValidator (reply)
+				<< reply->rawHeader ("Content-Range");
+
+		ErrorString_ = tr ("The file has changed on the server.");
+		Stop ();
+		emit resourceChanged ();
+	}
+
+	void SegmentedDownloader::HandleGateReady ()
+	{
+		if (Stopped_)
+			return;
+
+		QList<QNetworkReply*> replies;
+		for (const auto& segment : Segments_)
+			if (segment.Reply_ && segment.Reply_->bytesAvailable ())
+				replies << segment.Reply_;
+
+		for (const auto reply : replies)
+		{
+			const auto isFinished = reply->isFinished ();
+			HandleReadyRead (reply);
+			if (isFinished)
+				HandleFinished (reply);
+		}
+
+		if (Segments_.empty ())
+			Schedule ();
+	}
+
+	void SegmentedDownloader::HandleWriteError (const QString& errorString)
+	{
+		if (Stopped_)
+			return;
+
+		ErrorString_ = errorString;
+		Stop ();
+		emit writeError (ErrorString_);
+	}
+}
+}
@@ -0,0 +1,196 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+#include <QObject>
+#include <QList>
+#include <QPair>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+
+class QNetworkAccessManager;
+
+namespace LC
+{
+namespace CSTP
+{
+	class TransferGate;
+
+	/** A [first, second) byte range of the file that is yet to be
+	 * downloaded.
+	 */
+	using Segment = QPair<qint64, qint64>;
+
+	/** The byte range of a 206 Partial Content response.
+	 */
+	struct ContentRange
+	{
+		qint64 First_;
+		qint64 Last_;
+
+		/** The full size of the entity, or -1 if the server doesn't
+		 * know it.
+		 */
+		qint64 Total_;
+	};
+
+	/** Parses the value of the Content-Range header, like
+	 * <code>bytes 100-199/1000</code>.
+	 */
+	std::optional<ContentRange> ParseContentRange (const QByteArray&);
+
+	/** @brief Returns the validator of the entity served by the reply.
+	 *
+	 * This is the ETag, unless it is a weak one, or the Last-Modified
+	 * date otherwise, suitable for the If-Range header. An empty array
+	 * is returned if there is no usable validator.
+	 */
+	QByteArray GetValidator (const QNetworkReply*);
+
+	/** Returns whether the reply carries a validator of the same kind
+	 * as the given one, which is different from it.
+	 */
+	bool IsValidatorChanged (const QNetworkReply*, const QByteArray& validator);
+
+	/** @brief Downloads a file over several parallel range requests.
+	 *
+	 * The remaining ranges are written into the (already preallocated)
+	 * file at their offsets through the given TransferGate. Whenever a connection finishes its range
+	 * and there are fewer connections than allowed, the largest range
+	 * being downloaded is split in half, and the upper half is given to
+	 * a new connection, so slow connections don't hold the whole
+	 * download back.
+	 *
+	 * Each range request carries the validator of the entity in the
+	 * If-Range header, and the Content-Range of the response is checked
+	 * against the requested range. If the entity has changed on the
+	 * server, the download is stopped and resourceChanged() is emitted,
+	 * since the data already in the file can't be reused.
+	 */
+	class SegmentedDownloader : public QObject
+	{
+		Q_OBJECT
+
+		QNetworkAccessManager * const NAM_;
+		const QNetworkRequest Request_;
+		TransferGate * const Gate_;
+		const qint64 Total_;
+		const QByteArray Validator_;
+		const int MaxConnections_;
+		const qint64 MinSegmentSize_;
+
+		struct SegmentState
+		{
+			qint64 Pos_;
+			qint64 End_;
+			QNetworkReply *Reply_ = nullptr;
+			bool Verified_ = false;
+			int Failures_ = 0;
+		};
+		std::vector<SegmentState> Segments_;
+
+		QString ErrorString_;
+		bool Stopped_ = false;
+		bool Finished_ = false;
+	public:
+		static constexpr int MaxFailures = 3;
+
+		/** @param[in] nam The network access manager to issue the range
+		 * requests with.
+		 * @param[in] request The request to base the range requests
+		 * on, without the Range header.
+		 * @param[in] gate The gate to the file opened for writing,
+		 * already resized to total bytes.
+		 * @param[in] total The total size of the file.
+		 * @param[in] validator The validator of the entity, as returned
+		 * by GetValidator() for the response the download has started
+		 * with.
+		 * @param[in] remaining The ranges yet to be downloaded.
+		 * @param[in] maxConnections The maximum number of parallel
+		 * connections.
+		 * @param[in] minSegmentSize The minimum size of the range that
+		 * can be handed to a new connection.
+		 */
+		SegmentedDownloader (QNetworkAccessManager *nam,
+				const QNetworkRequest& request,
+				TransferGate *gate,
+				qint64 total,
+				const QByteArray& validator,
+				const QList<Segment>& remaining,
+				int maxConnections,
+				qint64 minSegmentSize,
+				QObject *parent = nullptr);
+		~SegmentedDownloader () override;
+
+		/** @brief Makes an already running reply serve the first range.
+		 *
+		 * The reply is expected to deliver the file contents starting
+		 * at the beginning of the first remaining range. This allows
+		 * reusing the probing request instead of throwing it away. The
+		 * downloader takes the ownership of the reply.
+		 */
+		void AdoptReply (QNetworkReply *reply);
+
+		void Start ();
+		void Stop ();
+
+		QList<Segment> GetRemaining () const;
+		qint64 GetDone () const;
+		qint64 GetTotal () const;
+		int GetActiveConnections () const;
+		QString GetErrorString () const;
+	private:
+		std::vector<SegmentState>::iterator FindSegment (QNetworkReply*);
+
+		void Schedule ();
+		bool SplitLargest ();
+		void StartSegment (SegmentState&);
+		void ConnectReply (QNetworkReply*);
+		void ReleaseReply (SegmentState&);
+		bool VerifyReply (SegmentState&, QNetworkReply*);
+
+		void HandleReadyRead (QNetworkReply*);
+		void HandleFinished (QNetworkReply*);
+		void HandleSegmentFailure (SegmentState&, QNetworkReply::NetworkError, const QString&);
+		void HandleResourceChanged (QNetworkReply*);
+		void HandleGateReady ();
+		void HandleWriteError (const QString&);
+	signals:
+		void progress (qint64 done, qint64 total);
+		void finished ();
+		void resourceChanged ();
+		void networkError (QNetworkReply::NetworkError, const QString&);
+		void writeError (const QString&);
+	};
+}
+}
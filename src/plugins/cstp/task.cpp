@@ -46,6 +46,7 @@
 #include <interfaces/core/icoreproxy.h>
 #include <interfaces/core/ientitymanager.h>
 #include "core.h"
+#include "transfergate.h"
 #include "xmlsettingsmanager.h"
 
 namespace LC
@@ -54,6 +55,8 @@ namespace CSTP
 {
 	namespace
 	{
+		const qint64 MinSegmentSize = 1024 * 1024;
+
 		void LateDelete (QNetworkReply *rep)
 		{
 			if (rep)
@@ -93,6 +96,10 @@ namespace CSTP
 	{
 		StartTime_.start ();
 
+		connect (Timer_,
+				&QTimer::timeout,
+				this,
+				&Task::RecalculateSpeed);
 		connect (Timer_,
 				SIGNAL (timeout ()),
 				this,
@@ -113,6 +120,10 @@ namespace CSTP
 	{
 		StartTime_.start ();
 
+		connect (Timer_,
+				&QTimer::timeout,
+				this,
+				&Task::RecalculateSpeed);
 		connect (Timer_,
 				SIGNAL (timeout ()),
 				this,
@@ -190,6 +201,9 @@ namespace CSTP
 	{
 		FileSizeAtStart_ = tof->size ();
 		To_ = tof;
+		ErrorString_.clear ();
+		FinishPending_ = false;
+		SetupGate ();
 
 		if (!Reply_)
 		{
@@ -201,32 +215,43 @@ namespace CSTP
 				return;
 			}
 
-			auto ua = XmlSettingsManager::Instance ().property ("UserUserAgent").toString ();
-			if (ua.isEmpty ())
-				ua = XmlSettingsManager::Instance ().property ("PredefinedUserAgent").toString ();
+			if (!Segments_.isEmpty ())
+			{
+				// Without a validator there is no way to make sure the
+				// new ranges belong to the same file.
+				if (Operation_ == QNetworkAccessManager::GetOperation &&
+						tof->size () == Total_ &&
+						!Validator_.isEmpty ())
+				{
+					StartTime_.restart ();
+					StartSegmented (nullptr);
+					return;
+				}
 
-			if (ua == "%leechcraft%")
-				ua = "LeechCraft.CSTP/" + Core::Instance ().GetCoreProxy ()->GetVersion ();
+				qWarning () << Q_FUNC_INFO
+						<< "file size"
+						<< tof->size ()
+						<< "or the validator"
+						<< Validator_
+						<< "don't match the segmented download size"
+						<< Total_
+						<< ", restarting from scratch";
+				Segments_.clear ();
+				Validator_.clear ();
+				tof->resize (0);
+				FileSizeAtStart_ = 0;
+			}
 
-			QNetworkRequest req { URL_ };
+			auto req = MakeRequest ();
 			if (tof->size ())
+			{
 				req.setRawHeader ("Range", QString ("bytes=%1-").arg (tof->size ()).toLatin1 ());
-			req.setRawHeader ("User-Agent", ua.toLatin1 ());
-
-			if (Referer_.isEmpty ())
-				req.setRawHeader ("Referer", QString (QString ("http://") + URL_.host ()).toLatin1 ());
-			else
-				req.setRawHeader ("Referer", Referer_.toEncoded ());
-
-			req.setRawHeader ("Host", URL_.host ().toLatin1 ());
-			req.setRawHeader ("Origin", URL_.scheme ().toLatin1 () + "://" + URL_.host ().toLatin1 ());
-			req.setRawHeader ("Accept", "*/*");
+				if (!Validator_.isEmpty ())
+					req.setRawHeader ("If-Range", Validator_);
+			}
 
 			StartTime_.restart ();
 
-			for (const auto& pair : Util::Stlize (Headers_))
-				req.setRawHeader (pair.first.toLatin1 (), pair.second.toByteArray ());
-
 			auto nam = Core::Instance ().GetNetworkAccessManager ();
 			switch (Operation_)
 			{
@@ -270,6 +295,7 @@ namespace CSTP
 			Timer_->start (3000);
 
 		Reply_->setParent (nullptr);
+		Reply_->setReadBufferSize (TransferGate::ReadBufferSize);
 		connect (Reply_.get (),
 				SIGNAL (downloadProgress (qint64, qint64)),
 				this,
@@ -297,6 +323,18 @@ namespace CSTP
 	{
 		if (Reply_)
 			Reply_->abort ();
+
+		if (Downloader_)
+		{
+			Segments_ = Downloader_->GetRemaining ();
+			delete Downloader_;
+			Downloader_ = nullptr;
+		}
+
+		if (Gate_)
+			Gate_->Sync ();
+
+		Speed_ = 0;
 	}
 
 	void Task::ForbidNameChanges ()
@@ -304,18 +342,26 @@ namespace CSTP
 		CanChangeName_ = false;
 	}
 
+	void Task::SetSpeedLimit (qint64 rate)
+	{
+		if (Gate_)
+			Gate_->SetTaskRate (rate);
+	}
+
 	QByteArray Task::Serialize () const
 	{
 		QByteArray result;
 		{
 			QDataStream out (&result, QIODevice::WriteOnly);
-			out << 2
+			out << 4
 				<< URL_
 				<< StartTime_
 				<< Done_
 				<< Total_
 				<< Speed_
-				<< CanChangeName_;
+				<< CanChangeName_
+				<< (Downloader_ ? Downloader_->GetRemaining () : Segments_)
+				<< Validator_;
 		}
 		return result;
 	}
@@ -325,7 +371,7 @@ namespace CSTP
 		QDataStream in (&data, QIODevice::ReadOnly);
 		int version = 0;
 		in >> version;
-		if (version < 1 || version > 2)
+		if (version < 1 || version > 4)
 			throw std::runtime_error ("Unknown version");
 
 		in >> URL_
@@ -336,6 +382,10 @@ namespace CSTP
 
 		if (version >= 2)
 			in >> CanChangeName_;
+		if (version >= 3)
+			in >> Segments_;
+		if (version >= 4)
+			in >> Validator_;
 	}
 
 	double Task::GetSpeed () const
@@ -355,7 +405,7 @@ namespace CSTP
 
 	QString Task::GetState () const
 	{
-		if (!Reply_)
+		if (!Reply_ && !Downloader_)
 			return tr ("Stopped");
 		else if (Done_ == Total_)
 			return tr ("Finished");
@@ -375,12 +425,16 @@ namespace CSTP
 
 	bool Task::IsRunning () const
 	{
-		return Reply_ && !URL_.isEmpty ();
+		return (Reply_ || Downloader_) && !URL_.isEmpty ();
 	}
 
 	QString Task::GetErrorString () const
 	{
-		return Reply_ ? Reply_->errorString () : tr ("Task isn't initialized properly");
+		if (Reply_)
+			return Reply_->errorString ();
+		if (!ErrorString_.isEmpty ())
+			return ErrorString_;
+		return tr ("Task isn't initialized properly");
 	}
 
 	QFuture<IDownload::Result> Task::GetFuture ()
@@ -400,7 +454,217 @@ namespace CSTP
 
 	void Task::RecalculateSpeed ()
 	{
-		Speed_ = static_cast<double> (Done_ * 1000) / static_cast<double> (StartTime_.elapsed ());
+		if (!Gate_)
+			return;
+
+		if (!SpeedTimer_.isValid ())
+		{
+			SpeedTimer_.start ();
+			LastTransferred_ = Gate_->GetTransferred ();
+			return;
+		}
+
+		const auto elapsed = SpeedTimer_.elapsed ();
+		if (elapsed < 500)
+			return;
+
+		const auto transferred = Gate_->GetTransferred ();
+		const auto current = static_cast<double> (transferred - LastTransferred_) * 1000 / elapsed;
+		Speed_ = Speed_ > 0 ? Speed_ * 0.6 + current * 0.4 : current;
+
+		LastTransferred_ = transferred;
+		SpeedTimer_.restart ();
+	}
+
+	void Task::SetupGate ()
+	{
+		if (Gate_)
+		{
+			if (Gate_->GetFile () == To_)
+				return;
+
+			// The task has been restarted with another file, so the gate
+			// writing to the old one is flushed and replaced.
+			Gate_->Sync ();
+			disconnect (Gate_, nullptr, this, nullptr);
+			Gate_->deleteLater ();
+			Gate_ = nullptr;
+
+			SpeedTimer_.invalidate ();
+		}
+
+		auto& core = Core::Instance ();
+		Gate_ = new TransferGate { To_, core.GetDiskWriter (), core.GetGlobalLimiter (), this };
+		Gate_->SetTaskRate (core.GetTaskSpeedLimit ());
+
+		connect (Gate_,
+				&TransferGate::ready,
+				this,
+				[this]
+				{
+					if (Reply_)
+						handleReadyRead ();
+					if (FinishPending_)
+						handleFinished ();
+				});
+		connect (Gate_,
+				&TransferGate::writeError,
+				this,
+				[this] (const QString& error)
+				{
+					// the segmented downloader reports its own write errors
+					if (Downloader_)
+						return;
+
+					ErrorString_ = error;
+					if (Reply_)
+						Reply_->abort ();
+					HandleError (IDownload::Error::Type::LocalError, error);
+				});
+	}
+
+	QNetworkRequest Task::MakeRequest () const
+	{
+		auto ua = XmlSettingsManager::Instance ().property ("UserUserAgent").toString ();
+		if (ua.isEmpty ())
+			ua = XmlSettingsManager::Instance ().property ("PredefinedUserAgent").toString ();
+
+		if (ua == "%leechcraft%")
+			ua = "LeechCraft.CSTP/" + Core::Instance ().GetCoreProxy ()->GetVersion ();
+
+		QNetworkRequest req { URL_ };
+		req.setRawHeader ("User-Agent", ua.toLatin1 ());
+
+		if (Referer_.isEmpty ())
+			req.setRawHeader ("Referer", QString (QString ("http://") + URL_.host ()).toLatin1 ());
+		else
+			req.setRawHeader ("Referer", Referer_.toEncoded ());
+
+		req.setRawHeader ("Host", URL_.host ().toLatin1 ());
+		req.setRawHeader ("Origin", URL_.scheme ().toLatin1 () + "://" + URL_.host ().toLatin1 ());
+		req.setRawHeader ("Accept", "*/*");
+
+		for (const auto& pair : Util::Stlize (Headers_))
+			req.setRawHeader (pair.first.toLatin1 (), pair.second.toByteArray ());
+
+		return req;
+	}
+
+	void Task::StartSegmented (QNetworkReply *initial)
+	{
+		const auto maxConnections = XmlSettingsManager::Instance ()
+				.property ("MaxConnectionsPerTask").toInt ();
+		Downloader_ = new SegmentedDownloader
+		{
+			Core::Instance ().GetNetworkAccessManager (),
+			MakeRequest (),
+			Gate_,
+			Total_,
+			Validator_,
+			Segments_,
+			maxConnections,
+			MinSegmentSize,
+			this
+		};
+		Segments_.clear ();
+
+		connect (Downloader_,
+				&SegmentedDownloader::progress,
+				this,
+				[this] (qint64 done, qint64 total)
+				{
+					Done_ = done;
+					Total_ = total;
+					RecalculateSpeed ();
+				});
+		connect (Downloader_,
+				&SegmentedDownloader::finished,
+				this,
+				[this]
+				{
+					Done_ = Total_;
+					Downloader_->deleteLater ();
+					Downloader_ = nullptr;
+					handleFinished ();
+				});
+
+		connect (Downloader_,
+				&SegmentedDownloader::resourceChanged,
+				this,
+				&Task::RestartFromScratch);
+
+		const auto handleFailure = [this] (IDownload::Error::Type type)
+		{
+			ErrorString_ = Downloader_->GetErrorString ();
+			Segments_ = Downloader_->GetRemaining ();
+			Downloader_->deleteLater ();
+			Downloader_ = nullptr;
+			HandleError (type, ErrorString_);
+		};
+		connect (Downloader_,
+				&SegmentedDownloader::networkError,
+				this,
+				[handleFailure] (QNetworkReply::NetworkError err)
+					{ handleFailure (MapError (err)); });
+		connect (Downloader_,
+				&SegmentedDownloader::writeError,
+				this,
+				[handleFailure] { handleFailure (IDownload::Error::Type::LocalError); });
+
+		if (initial)
+			Downloader_->AdoptReply (initial);
+		Downloader_->Start ();
+
+		if (!Timer_->isActive ())
+			Timer_->start (3000);
+	}
+
+	void Task::RestartFromScratch ()
+	{
+		if (Downloader_)
+		{
+			Downloader_->deleteLater ();
+			Downloader_ = nullptr;
+		}
+
+		if (Reply_)
+		{
+			disconnect (Reply_.get (),
+					nullptr,
+					this,
+					nullptr);
+			Reply_->abort ();
+			Reply_.reset ();
+		}
+
+		Segments_.clear ();
+		Validator_.clear ();
+
+		// The file is likely to keep changing, or the mirrors serve
+		// different versions of it, so don't restart forever.
+		if (RestartedOnChange_)
+		{
+			ErrorString_ = tr ("The file has changed on the server during the download.");
+			HandleError (IDownload::Error::Type::ContentError, ErrorString_);
+			return;
+		}
+		RestartedOnChange_ = true;
+
+		qWarning () << Q_FUNC_INFO
+				<< URL_
+				<< "has changed on the server, restarting from scratch";
+
+		Gate_->Sync ();
+		if (!To_->resize (0) || !To_->seek (0))
+		{
+			ErrorString_ = tr ("Unable to truncate the file: %1.")
+					.arg (To_->errorString ());
+			HandleError (IDownload::Error::Type::LocalError, ErrorString_);
+			return;
+		}
+
+		Done_ = 0;
+		Start (To_);
 	}
 
 	void Task::HandleMetadataRedirection ()
@@ -516,6 +780,9 @@ namespace CSTP
 
 	void Task::HandleError (IDownload::Error::Type err, const QString& msg)
 	{
+		if (Gate_)
+			Gate_->Sync ();
+
 		// TODO don't emit this when the file is already fully downloaded
 		Util::ReportFutureResult (Promise_, IDownload::Result::Left ({ err, msg }));
 
@@ -551,6 +818,7 @@ namespace CSTP
 		}
 
 		const auto openMode = To_->openMode ();
+		Gate_->Sync ();
 		To_->close ();
 
 		if (!To_->rename (path))
@@ -570,6 +838,126 @@ namespace CSTP
 		}
 	}
 
+	bool Task::HandleMetadataValidator ()
+	{
+		if (!Reply_ ||
+				URL_.isEmpty () ||
+				Operation_ != QNetworkAccessManager::GetOperation)
+			return true;
+
+		switch (Reply_->attribute (QNetworkRequest::HttpStatusCodeAttribute).toInt ())
+		{
+		case 200:
+			// The whole file is sent instead of the requested range,
+			// either since it has changed and If-Range has failed, or
+			// since the server doesn't support ranges, so the data
+			// already in the file is to be overwritten.
+			if (FileSizeAtStart_ > 0 && !Reply_->request ().rawHeader ("Range").isEmpty ())
+			{
+				Gate_->Sync ();
+				if (!To_->resize (0) || !To_->seek (0))
+				{
+					ErrorString_ = tr ("Unable to truncate the file: %1.")
+							.arg (To_->errorString ());
+					Reply_->abort ();
+					HandleError (IDownload::Error::Type::LocalError, ErrorString_);
+					return false;
+				}
+				FileSizeAtStart_ = 0;
+			}
+
+			Validator_ = GetValidator (Reply_.get ());
+			return true;
+		case 206:
+		{
+			const auto& range = ParseContentRange (Reply_->rawHeader ("Content-Range"));
+			if (!range ||
+					range->First_ != FileSizeAtStart_ ||
+					IsValidatorChanged (Reply_.get (), Validator_))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unexpected range"
+						<< Reply_->rawHeader ("Content-Range")
+						<< GetValidator (Reply_.get ())
+						<< "when resuming at"
+						<< FileSizeAtStart_
+						<< Validator_;
+				RestartFromScratch ();
+				return false;
+			}
+
+			if (Validator_.isEmpty ())
+				Validator_ = GetValidator (Reply_.get ());
+			return true;
+		}
+		default:
+			return true;
+		}
+	}
+
+	void Task::HandleMetadataSegmenting ()
+	{
+		if (Downloader_ ||
+				!Reply_ ||
+				URL_.isEmpty () ||
+				Operation_ != QNetworkAccessManager::GetOperation)
+			return;
+
+		if (XmlSettingsManager::Instance ().property ("MaxConnectionsPerTask").toInt () < 2)
+			return;
+
+		// The ranges couldn't be checked to belong to the same file.
+		if (Validator_.isEmpty ())
+			return;
+
+		const auto& encoding = Reply_->rawHeader ("Content-Encoding");
+		if (!encoding.isEmpty () && encoding != "identity")
+			return;
+
+		qint64 start = 0;
+		switch (Reply_->attribute (QNetworkRequest::HttpStatusCodeAttribute).toInt ())
+		{
+		case 200:
+			if (!Reply_->rawHeader ("Accept-Ranges").contains ("bytes"))
+				return;
+			break;
+		case 206:
+			start = FileSizeAtStart_;
+			break;
+		default:
+			return;
+		}
+
+		bool ok = false;
+		const auto length = Reply_->header (QNetworkRequest::ContentLengthHeader).toLongLong (&ok);
+		if (!ok || length < 2 * MinSegmentSize)
+			return;
+
+		const auto total = start + length;
+		Gate_->Sync ();
+		if (To_->size () != total && !To_->resize (total))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to preallocate"
+					<< To_->fileName ()
+					<< "to"
+					<< total
+					<< To_->errorString ()
+					<< ", falling back to a single connection";
+			return;
+		}
+
+		disconnect (Reply_.get (),
+				0,
+				this,
+				0);
+
+		Done_ = start;
+		Total_ = total;
+		Segments_ = { { start, total } };
+		StartSegmented (Reply_.release ());
+	}
+
 	void Task::handleDataTransferProgress (qint64 done, qint64 total)
 	{
 		Done_ = done;
@@ -585,6 +973,8 @@ namespace CSTP
 	{
 		if (To_ && FileSizeAtStart_ >= 0)
 		{
+			if (Gate_)
+				Gate_->Sync ();
 			To_->close ();
 			To_->resize (FileSizeAtStart_);
 			if (!To_->open (QIODevice::ReadWrite))
@@ -608,6 +998,8 @@ namespace CSTP
 	{
 		HandleMetadataRedirection ();
 		HandleMetadataFilename ();
+		if (HandleMetadataValidator ())
+			HandleMetadataSegmenting ();
 	}
 
 	void Task::handleLocalTransfer ()
@@ -676,23 +1068,16 @@ namespace CSTP
 	bool Task::handleReadyRead ()
 	{
 		if (Reply_)
-		{
-			quint64 avail = Reply_->bytesAvailable ();
-			quint64 res = To_->write (Reply_->readAll ());
-			if (static_cast<quint64> (-1) == res ||
-					res != avail)
+			while (const auto avail = Reply_->bytesAvailable ())
 			{
-				qWarning () << Q_FUNC_INFO
-						<< "Error writing to file:"
-						<< To_->fileName ()
-						<< To_->errorString ();
+				const auto allowance = Gate_->GetAllowance ();
+				if (!allowance)
+					break;
 
-				const auto& errString = tr ("Error writing to file %1: %2")
-						.arg (To_->fileName ())
-						.arg (To_->errorString ());
-				HandleError (IDownload::Error::Type::LocalError, errString);
+				if (!Gate_->Write (-1, Reply_->read (std::min (avail, allowance))))
+					break;
 			}
-		}
+
 		if (URL_.isEmpty () &&
 				Core::Instance ().HasFinishedReply (Reply_.get ()))
 		{
@@ -704,6 +1089,17 @@ namespace CSTP
 
 	void Task::handleFinished ()
 	{
+		FinishPending_ = true;
+
+		// there is still throttled data in the reply or data queued
+		// for writing, the gate will get us back here once it's done
+		if (Reply_ && Reply_->bytesAvailable ())
+			return;
+		if (Gate_ && Gate_->GetPending ())
+			return;
+
+		FinishPending_ = false;
+
 		Util::ReportFutureResult (Promise_, IDownload::Result::Right ({}));
 
 		emit done (false);
@@ -34,12 +34,14 @@
 #include <QObject>
 #include <QUrl>
 #include <QTime>
+#include <QElapsedTimer>
 #include <QNetworkReply>
 #include <QStringList>
 #include <QFutureInterface>
 #include <util/sll/either.h>
 #include <interfaces/structures.h>
 #include <interfaces/idownload.h>
+#include "segmenteddownloader.h"
 
 class QAuthenticator;
 class QNetworkProxy;
@@ -51,6 +53,8 @@ namespace LC
 {
 namespace CSTP
 {
+	class TransferGate;
+
 	class Task : public QObject
 	{
 		Q_OBJECT
@@ -60,11 +64,26 @@ namespace CSTP
 		QTime StartTime_;
 		qint64 Done_ = -1, Total_ = 0, FileSizeAtStart_ = -1;
 		double Speed_ = 0;
+		QElapsedTimer SpeedTimer_;
+		qint64 LastTransferred_ = 0;
 		QList<QByteArray> RedirectHistory_;
 		std::shared_ptr<QFile> To_;
 		QTimer *Timer_;
 		bool CanChangeName_ = true;
 
+		TransferGate *Gate_ = nullptr;
+		bool FinishPending_ = false;
+
+		SegmentedDownloader *Downloader_ = nullptr;
+		QList<Segment> Segments_;
+
+		/** The ETag or Last-Modified of the file being downloaded, sent
+		 * in the If-Range header when resuming.
+		 */
+		QByteArray Validator_;
+		bool RestartedOnChange_ = false;
+		QString ErrorString_;
+
 		QUrl Referer_;
 
 		const QNetworkAccessManager::Operation Operation_;
@@ -81,6 +100,7 @@ namespace CSTP
 		void Start (const std::shared_ptr<QFile>&);
 		void Stop ();
 		void ForbidNameChanges ();
+		void SetSpeedLimit (qint64 bytesPerSecond);
 
 		QByteArray Serialize () const;
 		void Deserialize (QByteArray&);
@@ -98,8 +118,14 @@ namespace CSTP
 	private:
 		void Reset ();
 		void RecalculateSpeed ();
+		void SetupGate ();
+		QNetworkRequest MakeRequest () const;
+		void StartSegmented (QNetworkReply*);
+		void RestartFromScratch ();
 		void HandleMetadataRedirection ();
 		void HandleMetadataFilename ();
+		bool HandleMetadataValidator ();
+		void HandleMetadataSegmenting ();
 
 		void HandleError (IDownload::Error::Type, const QString&);
 	private slots:
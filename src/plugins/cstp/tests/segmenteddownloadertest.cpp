@@ -0,0 +1,416 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "segmenteddownloadertest.h"
+#include <memory>
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryFile>
+#include <QNetworkAccessManager>
+#include "segmenteddownloader.h"
+#include "transfergate.h"
+#include "diskwriter.h"
+
+QTEST_GUILESS_MAIN (LC::CSTP::SegmentedDownloaderTest)
+
+namespace LC
+{
+namespace CSTP
+{
+	namespace
+	{
+		const qint64 MinSegmentSize = 64 * 1024;
+
+		/** A tiny HTTP server serving a single file with optional range
+		 * requests support.
+		 */
+		class RangeServer
+		{
+			QTcpServer Server_;
+			const QByteArray Data_;
+		public:
+			bool SupportsRanges_ = true;
+			int TruncateRanged_ = 0;
+			int ShiftRanged_ = 0;
+			QByteArray ETag_ = "\"v1\"";
+			QList<QByteArray> Ranges_;
+			QList<QByteArray> IfRanges_;
+
+			explicit RangeServer (const QByteArray& data)
+			: Data_ { data }
+			{
+				QObject::connect (&Server_,
+						&QTcpServer::newConnection,
+						[this]
+						{
+							while (const auto socket = Server_.nextPendingConnection ())
+								HandleConnection (socket);
+						});
+				Server_.listen (QHostAddress::LocalHost);
+			}
+
+			QUrl GetUrl () const
+			{
+				return QUrl { QString ("http://127.0.0.1:%1/file.bin").arg (Server_.serverPort ()) };
+			}
+		private:
+			void HandleConnection (QTcpSocket *socket)
+			{
+				auto buffer = std::make_shared<QByteArray> ();
+				QObject::connect (socket,
+						&QTcpSocket::readyRead,
+						[this, socket, buffer]
+						{
+							*buffer += socket->readAll ();
+							const auto headersEnd = buffer->indexOf ("\r\n\r\n");
+							if (headersEnd >= 0)
+								Respond (socket, buffer->left (headersEnd).split ('\n'));
+						});
+				QObject::connect (socket,
+						&QTcpSocket::disconnected,
+						socket,
+						&QObject::deleteLater);
+			}
+
+			void Respond (QTcpSocket *socket, const QList<QByteArray>& lines)
+			{
+				QByteArray range;
+				QByteArray ifRange;
+				for (const auto& line : lines)
+				{
+					const auto& lower = line.toLower ();
+					if (lower.startsWith ("range:"))
+						range = line.mid (line.indexOf ('=') + 1).trimmed ();
+					else if (lower.startsWith ("if-range:"))
+						ifRange = line.mid (line.indexOf (':') + 1).trimmed ();
+				}
+
+				if (!range.isEmpty ())
+				{
+					Ranges_ << range;
+					IfRanges_ << ifRange;
+				}
+
+				const auto etagHeader = "ETag: " + ETag_ + "\r\n";
+				if (range.isEmpty () || !SupportsRanges_ ||
+						(!ifRange.isEmpty () && ifRange != ETag_))
+				{
+					socket->write ("HTTP/1.1 200 OK\r\n");
+					socket->write (etagHeader);
+					if (SupportsRanges_)
+						socket->write ("Accept-Ranges: bytes\r\n");
+					socket->write ("Content-Length: " + QByteArray::number (Data_.size ()) + "\r\n");
+					socket->write ("Connection: close\r\n\r\n");
+					socket->write (Data_);
+					socket->disconnectFromHost ();
+					return;
+				}
+
+				const auto dash = range.indexOf ('-');
+				const auto start = range.left (dash).toInt () + ShiftRanged_;
+				const auto endStr = range.mid (dash + 1);
+				const auto end = endStr.isEmpty () ? Data_.size () - 1 : endStr.toInt ();
+				const auto length = end - start + 1;
+
+				socket->write ("HTTP/1.1 206 Partial Content\r\n");
+				socket->write (etagHeader);
+				socket->write ("Content-Range: bytes " + QByteArray::number (start) + "-" +
+						QByteArray::number (end) + "/" + QByteArray::number (Data_.size ()) + "\r\n");
+				socket->write ("Content-Length: " + QByteArray::number (length) + "\r\n");
+				socket->write ("Connection: close\r\n\r\n");
+
+				if (TruncateRanged_ > 0)
+				{
+					--TruncateRanged_;
+					socket->write (Data_.mid (start, length / 2));
+				}
+				else
+					socket->write (Data_.mid (start, length));
+				socket->disconnectFromHost ();
+			}
+		};
+
+		QByteArray MakeData (int size)
+		{
+			QByteArray result;
+			result.reserve (size);
+			quint32 state = 42;
+			for (int i = 0; i < size; ++i)
+			{
+				state = state * 1664525 + 1013904223;
+				result.append (static_cast<char> (state >> 24));
+			}
+			return result;
+		}
+
+		std::shared_ptr<QTemporaryFile> MakeFile (const QByteArray& contents)
+		{
+			auto file = std::make_shared<QTemporaryFile> ();
+			if (!file->open ())
+				return {};
+			file->write (contents);
+			return file;
+		}
+
+		QByteArray ReadAll (QFile& file)
+		{
+			file.flush ();
+			file.seek (0);
+			return file.readAll ();
+		}
+	}
+
+	void SegmentedDownloaderTest::testFreshDownload ()
+	{
+		const auto& data = MakeData (1024 * 1024);
+		RangeServer server { data };
+		QNetworkAccessManager nam;
+
+		const auto file = MakeFile (QByteArray (data.size (), 0));
+		QVERIFY (file);
+
+		const QNetworkRequest req { server.GetUrl () };
+		const auto initial = nam.get (req);
+		QSignalSpy metaSpy { initial, &QNetworkReply::metaDataChanged };
+		QVERIFY (metaSpy.wait ());
+		QCOMPARE (initial->rawHeader ("Accept-Ranges"), QByteArray { "bytes" });
+
+		TransferGate gate { file, nullptr, nullptr };
+		SegmentedDownloader downloader { &nam, req, &gate, data.size (), server.ETag_, { { 0, data.size () } }, 4, MinSegmentSize };
+		QSignalSpy finishedSpy { &downloader, &SegmentedDownloader::finished };
+		downloader.AdoptReply (initial);
+		downloader.Start ();
+		QCOMPARE (downloader.GetActiveConnections (), 4);
+
+		QVERIFY (finishedSpy.wait (10000));
+		QCOMPARE (downloader.GetDone (), qint64 { data.size () });
+		QVERIFY (downloader.GetRemaining ().isEmpty ());
+		QVERIFY (server.Ranges_.size () >= 3);
+		QVERIFY (ReadAll (*file) == data);
+	}
+
+	void SegmentedDownloaderTest::testResume ()
+	{
+		const auto& data = MakeData (1024 * 1024);
+		RangeServer server { data };
+		QNetworkAccessManager nam;
+
+		const QList<Segment> remaining { { 100000, 300000 }, { 700000, data.size () } };
+
+		auto partial = data;
+		for (const auto& segment : remaining)
+			partial.replace (segment.first, segment.second - segment.first,
+					QByteArray (segment.second - segment.first, 0));
+		const auto file = MakeFile (partial);
+		QVERIFY (file);
+
+		TransferGate gate { file, nullptr, nullptr };
+		SegmentedDownloader downloader { &nam, QNetworkRequest { server.GetUrl () },
+				&gate, data.size (), server.ETag_, remaining, 2, MinSegmentSize };
+		QCOMPARE (downloader.GetDone (), qint64 { data.size () - 200000 - (data.size () - 700000) });
+
+		QSignalSpy finishedSpy { &downloader, &SegmentedDownloader::finished };
+		downloader.Start ();
+
+		QVERIFY (finishedSpy.wait (10000));
+		QVERIFY (server.Ranges_.contains ("100000-299999"));
+		QVERIFY (server.Ranges_.contains ("700000-" + QByteArray::number (data.size () - 1)));
+		QVERIFY (ReadAll (*file) == data);
+	}
+
+	void SegmentedDownloaderTest::testRetry ()
+	{
+		const auto& data = MakeData (512 * 1024);
+		RangeServer server { data };
+		server.TruncateRanged_ = 2;
+		QNetworkAccessManager nam;
+
+		const auto file = MakeFile (QByteArray (data.size (), 0));
+		QVERIFY (file);
+
+		TransferGate gate { file, nullptr, nullptr };
+		SegmentedDownloader downloader { &nam, QNetworkRequest { server.GetUrl () },
+				&gate, data.size (), server.ETag_, { { 0, data.size () } }, 2, MinSegmentSize };
+		QSignalSpy finishedSpy { &downloader, &SegmentedDownloader::finished };
+		QSignalSpy errorSpy { &downloader, &SegmentedDownloader::networkError };
+		downloader.Start ();
+
+		QVERIFY (finishedSpy.wait (10000));
+		QVERIFY (errorSpy.isEmpty ());
+		QVERIFY (ReadAll (*file) == data);
+	}
+
+	void SegmentedDownloaderTest::testRangesIgnored ()
+	{
+		const auto& data = MakeData (256 * 1024);
+		RangeServer server { data };
+		server.SupportsRanges_ = false;
+		QNetworkAccessManager nam;
+
+		const auto file = MakeFile (QByteArray (data.size (), 0));
+		QVERIFY (file);
+
+		TransferGate gate { file, nullptr, nullptr };
+		SegmentedDownloader downloader { &nam, QNetworkRequest { server.GetUrl () },
+				&gate, data.size (), server.ETag_, { { 1000, data.size () } }, 1, MinSegmentSize };
+		QSignalSpy finishedSpy { &downloader, &SegmentedDownloader::finished };
+		QSignalSpy errorSpy { &downloader, &SegmentedDownloader::networkError };
+		downloader.Start ();
+
+		QVERIFY (errorSpy.wait (10000));
+		QVERIFY (finishedSpy.isEmpty ());
+		QCOMPARE (server.Ranges_.size (), SegmentedDownloader::MaxFailures + 1);
+		QCOMPARE (downloader.GetRemaining (), (QList<Segment> { { 1000, data.size () } }));
+		QCOMPARE (downloader.GetActiveConnections (), 0);
+	}
+
+	void SegmentedDownloaderTest::testUnexpectedRange ()
+	{
+		const auto& data = MakeData (256 * 1024);
+		RangeServer server { data };
+		server.ShiftRanged_ = 1;
+		QNetworkAccessManager nam;
+
+		const auto file = MakeFile (QByteArray (data.size (), 0));
+		QVERIFY (file);
+
+		TransferGate gate { file, nullptr, nullptr };
+		SegmentedDownloader downloader { &nam, QNetworkRequest { server.GetUrl () },
+				&gate, data.size (), server.ETag_, { { 1000, data.size () } }, 1, MinSegmentSize };
+		QSignalSpy finishedSpy { &downloader, &SegmentedDownloader::finished };
+		QSignalSpy errorSpy { &downloader, &SegmentedDownloader::networkError };
+		downloader.Start ();
+
+		QVERIFY (errorSpy.wait (10000));
+		QVERIFY (finishedSpy.isEmpty ());
+		QCOMPARE (downloader.GetRemaining (), (QList<Segment> { { 1000, data.size () } }));
+		QVERIFY (ReadAll (*file) == QByteArray (data.size (), 0));
+	}
+
+	void SegmentedDownloaderTest::testResourceChanged ()
+	{
+		const auto& data = MakeData (256 * 1024);
+		RangeServer server { data };
+		QNetworkAccessManager nam;
+
+		const auto file = MakeFile (QByteArray (data.size (), 0));
+		QVERIFY (file);
+
+		TransferGate gate { file, nullptr, nullptr };
+		SegmentedDownloader downloader { &nam, QNetworkRequest { server.GetUrl () },
+				&gate, data.size (), "\"v0\"", { { 1000, data.size () } }, 1, MinSegmentSize };
+		QSignalSpy changedSpy { &downloader, &SegmentedDownloader::resourceChanged };
+		QSignalSpy finishedSpy { &downloader, &SegmentedDownloader::finished };
+		QSignalSpy errorSpy { &downloader, &SegmentedDownloader::networkError };
+		downloader.Start ();
+
+		QVERIFY (changedSpy.wait (10000));
+		QCOMPARE (server.IfRanges_, (QList<QByteArray> { "\"v0\"" }));
+		QVERIFY (finishedSpy.isEmpty ());
+		QVERIFY (errorSpy.isEmpty ());
+		QCOMPARE (downloader.GetActiveConnections (), 0);
+		QVERIFY (ReadAll (*file) == QByteArray (data.size (), 0));
+	}
+
+	void SegmentedDownloaderTest::testParseContentRange ()
+	{
+		const auto& range = ParseContentRange ("bytes 100-199/1000");
+		QVERIFY (range);
+		QCOMPARE (range->First_, qint64 { 100 });
+		QCOMPARE (range->Last_, qint64 { 199 });
+		QCOMPARE (range->Total_, qint64 { 1000 });
+
+		const auto& unknownTotal = ParseContentRange ("bytes 0-9/*");
+		QVERIFY (unknownTotal);
+		QCOMPARE (unknownTotal->Total_, qint64 { -1 });
+
+		QVERIFY (!ParseContentRange ("bytes */1000"));
+		QVERIFY (!ParseContentRange ("bytes 200-100/1000"));
+		QVERIFY (!ParseContentRange ("bytes 0-1000/1000"));
+		QVERIFY (!ParseContentRange ("items 0-9/10"));
+	}
+
+	void SegmentedDownloaderTest::testDiskWriter ()
+	{
+		const auto& data = MakeData (1024 * 1024);
+		RangeServer server { data };
+		QNetworkAccessManager nam;
+
+		const auto file = MakeFile (QByteArray (data.size (), 0));
+		QVERIFY (file);
+
+		DiskWriter writer;
+		writer.start ();
+
+		TransferGate gate { file, &writer, nullptr };
+		SegmentedDownloader downloader { &nam, QNetworkRequest { server.GetUrl () },
+				&gate, data.size (), server.ETag_, { { 0, data.size () } }, 4, MinSegmentSize };
+		QSignalSpy finishedSpy { &downloader, &SegmentedDownloader::finished };
+		downloader.Start ();
+
+		QVERIFY (finishedSpy.wait (10000));
+		QCOMPARE (gate.GetPending (), qint64 { 0 });
+		QCOMPARE (gate.GetTransferred (), qint64 { data.size () });
+
+		writer.quit ();
+		writer.wait ();
+
+		QVERIFY (ReadAll (*file) == data);
+	}
+
+	void SegmentedDownloaderTest::testRateLimit ()
+	{
+		const auto& data = MakeData (256 * 1024);
+		RangeServer server { data };
+		QNetworkAccessManager nam;
+
+		const auto file = MakeFile (QByteArray (data.size (), 0));
+		QVERIFY (file);
+
+		RateLimiter globalLimiter;
+		globalLimiter.SetRate (512 * 1024);
+
+		TransferGate gate { file, nullptr, &globalLimiter };
+		SegmentedDownloader downloader { &nam, QNetworkRequest { server.GetUrl () },
+				&gate, data.size (), server.ETag_, { { 0, data.size () } }, 2, MinSegmentSize };
+		QSignalSpy finishedSpy { &downloader, &SegmentedDownloader::finished };
+
+		QElapsedTimer timer;
+		timer.start ();
+		downloader.Start ();
+
+		QVERIFY (finishedSpy.wait (10000));
+
+		// the first 128 KiB fit into the bucket, the rest takes 250 ms
+		QVERIFY (timer.elapsed () >= 200);
+		QVERIFY (ReadAll (*file) == data);
+	}
+}
+}
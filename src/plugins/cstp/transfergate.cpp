@@ -0,0 +1,168 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "transfergate.h"
+#include <algorithm>
+#include <QFile>
+#include <QTimer>
+#include <QtDebug>
+#include <util/threads/futures.h>
+#include "diskwriter.h"
+
+namespace LC
+{
+namespace CSTP
+{
+	TransferGate::TransferGate (const std::shared_ptr<QFile>& file,
+			DiskWriter *writer, RateLimiter *globalLimiter, QObject *parent)
+	: QObject { parent }
+	, File_ { file }
+	, Writer_ { writer }
+	, GlobalLimiter_ { globalLimiter }
+	, RefillTimer_ { new QTimer { this } }
+	{
+		RefillTimer_->setSingleShot (true);
+		connect (RefillTimer_,
+				SIGNAL (timeout ()),
+				this,
+				SIGNAL (ready ()));
+	}
+
+	void TransferGate::SetTaskRate (qint64 rate)
+	{
+		TaskLimiter_.SetRate (rate);
+		emit ready ();
+	}
+
+	qint64 TransferGate::GetAllowance ()
+	{
+		if (!ErrorString_.isEmpty ())
+			return 0;
+
+		auto allowance = MaxPending - Pending_;
+		if (allowance <= 0)
+			return 0;
+
+		int delay = 0;
+		for (const auto limiter : { GlobalLimiter_, &TaskLimiter_ })
+		{
+			if (!limiter || !limiter->IsLimited ())
+				continue;
+
+			const auto available = limiter->GetAvailable ();
+			allowance = std::min (allowance, available);
+			if (!available)
+				delay = std::max (delay, limiter->GetRefillDelay ());
+		}
+
+		if (!allowance && !RefillTimer_->isActive ())
+			RefillTimer_->start (delay);
+
+		return allowance;
+	}
+
+	bool TransferGate::Write (qint64 pos, const QByteArray& data)
+	{
+		if (!ErrorString_.isEmpty ())
+			return false;
+
+		const auto size = data.size ();
+		for (const auto limiter : { GlobalLimiter_, &TaskLimiter_ })
+			if (limiter)
+				limiter->Consume (size);
+		Transferred_ += size;
+
+		if (!Writer_)
+		{
+			if ((pos >= 0 && !File_->seek (pos)) ||
+					File_->write (data) != size)
+			{
+				HandleWriteError (File_->errorString ());
+				return false;
+			}
+			return true;
+		}
+
+		Pending_ += size;
+		LastWrite_ = Writer_->Write (File_, pos, data);
+		Util::Sequence (this, LastWrite_) >>
+				[this, size] (const QString& error)
+				{
+					Pending_ -= size;
+
+					if (!error.isEmpty ())
+						HandleWriteError (error);
+					else
+						emit ready ();
+				};
+		return true;
+	}
+
+	void TransferGate::Sync ()
+	{
+		LastWrite_.waitForFinished ();
+	}
+
+	const std::shared_ptr<QFile>& TransferGate::GetFile () const
+	{
+		return File_;
+	}
+
+	qint64 TransferGate::GetPending () const
+	{
+		return Pending_;
+	}
+
+	qint64 TransferGate::GetTransferred () const
+	{
+		return Transferred_;
+	}
+
+	QString TransferGate::GetErrorString () const
+	{
+		return ErrorString_;
+	}
+
+	void TransferGate::HandleWriteError (const QString& error)
+	{
+		if (!ErrorString_.isEmpty ())
+			return;
+
+		qWarning () << Q_FUNC_INFO
+				<< "error writing to file:"
+				<< File_->fileName ()
+				<< error;
+
+		ErrorString_ = tr ("Error writing to file %1: %2")
+				.arg (File_->fileName ())
+				.arg (error);
+		emit writeError (ErrorString_);
+	}
+}
+}
@@ -0,0 +1,123 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <QObject>
+#include <QFuture>
+#include "ratelimiter.h"
+
+class QFile;
+class QTimer;
+
+namespace LC
+{
+namespace CSTP
+{
+	class DiskWriter;
+
+	/** @brief Shapes the data flow from the network replies to a file.
+	 *
+	 * The gate decides how much data can be read from the replies
+	 * right now, taking both the global and the per-task rate limits
+	 * and the amount of data queued for writing into account, and
+	 * passes the data to the DiskWriter. Once reading is possible again
+	 * after it has been throttled, the ready() signal is emitted.
+	 *
+	 * If no DiskWriter is given, the data is written synchronously.
+	 */
+	class TransferGate : public QObject
+	{
+		Q_OBJECT
+
+		const std::shared_ptr<QFile> File_;
+		DiskWriter * const Writer_;
+		RateLimiter * const GlobalLimiter_;
+		RateLimiter TaskLimiter_;
+
+		QTimer * const RefillTimer_;
+
+		qint64 Pending_ = 0;
+		QFuture<QString> LastWrite_;
+
+		qint64 Transferred_ = 0;
+		QString ErrorString_;
+	public:
+		/** The maximum amount of data queued for writing per task.
+		 */
+		static constexpr qint64 MaxPending = 4 * 1024 * 1024;
+
+		/** The read buffer size for the replies feeding the gate, so
+		 * that the network stack stops receiving when we are throttled.
+		 */
+		static constexpr qint64 ReadBufferSize = 1024 * 1024;
+
+		TransferGate (const std::shared_ptr<QFile>& file,
+				DiskWriter *writer,
+				RateLimiter *globalLimiter,
+				QObject *parent = nullptr);
+
+		void SetTaskRate (qint64 bytesPerSecond);
+
+		/** @return The number of bytes that can be read and written
+		 * right now. If it is zero, the ready() signal will be emitted
+		 * once it is worth trying again.
+		 */
+		qint64 GetAllowance ();
+
+		/** @brief Writes the data at the given position.
+		 *
+		 * @param[in] pos The position to write at, or -1 to write at
+		 * the current position of the file.
+		 * @param[in] data The data to write.
+		 * @return false if a write error has occurred, in which case
+		 * the writeError() signal has been emitted.
+		 */
+		bool Write (qint64 pos, const QByteArray& data);
+
+		/** @brief Blocks until all the pending writes are done.
+		 *
+		 * This should be called before touching the file from the GUI
+		 * thread, like closing or renaming it.
+		 */
+		void Sync ();
+
+		const std::shared_ptr<QFile>& GetFile () const;
+		qint64 GetPending () const;
+		qint64 GetTransferred () const;
+		QString GetErrorString () const;
+	private:
+		void HandleWriteError (const QString&);
+	signals:
+		void ready ();
+		void writeError (const QString&);
+	};
+}
+}
@@ -57,8 +57,6 @@ namespace LC
 {
 namespace LackMan
 {
-	QMap<Dependency::Relation, Comparator_t> Relation2comparator;
-
 	Core::Core ()
 	: ExternalResourceManager_ (new ExternalResourceManager (this))
 	, Storage_ (new Storage (this))
@@ -68,12 +66,6 @@ namespace LackMan
 	, ReposModel_ (new QStandardItemModel (this))
 	, UpdatesEnabled_ (true)
 	{
-		Relation2comparator [Dependency::L] = IsVersionLess;
-		Relation2comparator [Dependency::G] = [] (QString l, QString r) { return Relation2comparator [Dependency::L] (r, l); };
-		Relation2comparator [Dependency::GE] = [] (QString l, QString r) { return !Relation2comparator [Dependency::L] (l, r); };
-		Relation2comparator [Dependency::E] = [] (QString l, QString r) { return r == l; };
-		Relation2comparator [Dependency::LE] = [] (QString l, QString r) { return !Relation2comparator [Dependency::G] (l, r); };
-
 		connect (PendingManager_,
 				SIGNAL (packageUpdateToggled (int, bool)),
 				PackagesModel_,
@@ -159,9 +151,9 @@ namespace LackMan
 				SLOT (handleComponentFetched (const PackageShortInfoList&,
 						const QString&, int)));
 		connect (RepoInfoFetcher_,
-				SIGNAL (packageFetched (const PackageInfo&, int)),
+				SIGNAL (packagesFetched (const ComponentPackageInfoList&)),
 				this,
-				SLOT (handlePackageFetched (const PackageInfo&, int)));
+				SLOT (handlePackagesFetched (const ComponentPackageInfoList&)));
 	}
 
 	ICoreProxy_ptr Core::GetProxy () const
@@ -199,58 +191,16 @@ namespace LackMan
 		return UpdatesNotificationManager_;
 	}
 
-	DependencyList Core::GetDependencies (int packageId) const
-	{
-		return Util::Filter (Storage_->GetDependencies (packageId),
-				[] (const auto& dep) { return dep.Type_ == Dependency::TRequires; });
-	}
-
-	QList<ListPackageInfo> Core::GetDependencyFulfillers (const Dependency& dep) const
-	{
-		return Storage_->GetFulfillers (dep);
-	}
-
 	bool Core::IsVersionOk (const QString& candidate, QString refVer) const
 	{
-		Dependency::Relation relation;
-
-		if (refVer.startsWith (">="))
-		{
-			relation = Dependency::GE;
-			refVer = refVer.mid (2);
-		}
-		else if (refVer.startsWith ("<="))
-		{
-			relation = Dependency::LE;
-			refVer = refVer.mid (2);
-		}
-		else if (refVer.startsWith ('>'))
-		{
-			relation = Dependency::G;
-			refVer = refVer.mid (1);
-		}
-		else if (refVer.startsWith ('<'))
-		{
-			relation = Dependency::L;
-			refVer = refVer.mid (1);
-		}
-		else
-		{
-			relation = Dependency::E;
-			if (refVer.startsWith ('='))
-				refVer = refVer.mid (1);
-		}
-		refVer = refVer.trimmed ();
-
-		return Relation2comparator [relation] (candidate, refVer);
+		return LackMan::IsVersionOk (candidate, refVer);
 	}
 
-	bool Core::IsFulfilled (const Dependency& dep) const
+	const PackageUniverse& Core::GetPackageUniverse () const
 	{
-		const auto& all = GetAllInstalledPackages ();
-		return std::any_of (all.begin (), all.end (),
-				[this, &dep] (const InstalledDependencyInfo& info)
-					{ return info.Dep_.Name_ == dep.Name_ && IsVersionOk (info.Dep_.Version_, dep.Version_); });
+		if (!Universe_)
+			Universe_.emplace (Storage_->GetAllPackagesWithDeps (), GetAllInstalledPackages ());
+		return *Universe_;
 	}
 
 	QIcon Core::GetIconForLPI (const ListPackageInfo& packageInfo)
@@ -451,7 +401,7 @@ namespace LackMan
 		{
 			QUrl compUrl = url;
 			compUrl.setPath ((compUrl.path () + "/dists/%1/all/").arg (component));
-			RepoInfoFetcher_->FetchComponent (compUrl, id, component);
+			RepoInfoFetcher_->FetchComponent (compUrl, id, component, ourComponents.contains (component));
 		}
 	}
 
@@ -627,6 +577,9 @@ namespace LackMan
 				}
 			}
 
+		auto componentUrl = repoUrl;
+		componentUrl.setPath ((componentUrl.path () + "/dists/%1/all/").arg (component));
+
 		for (const QString& packageName : PackageName2NewVersions_.keys ())
 		{
 			auto packageUrl = repoUrl;
@@ -638,7 +591,8 @@ namespace LackMan
 			RepoInfoFetcher_->ScheduleFetchPackageInfo (packageUrl,
 					packageName,
 					PackageName2NewVersions_ [packageName],
-					componentId);
+					componentId,
+					componentUrl);
 		}
 
 		if (newPackages)
@@ -698,6 +652,8 @@ namespace LackMan
 
 	bool Core::RecordInstalled (int packageId)
 	{
+		Universe_.reset ();
+
 		try
 		{
 			Storage_->AddToInstalled (packageId);
@@ -729,6 +685,8 @@ namespace LackMan
 
 	bool Core::RecordUninstalled (int packageId)
 	{
+		Universe_.reset ();
+
 		try
 		{
 			Storage_->RemoveFromInstalled (packageId);
@@ -1066,51 +1024,88 @@ namespace LackMan
 		HandleNewPackages (shortInfos, componentId, component, repoUrl);
 	}
 
-	void Core::handlePackageFetched (const PackageInfo& pInfo,
-			int componentId)
+	void Core::handlePackagesFetched (const ComponentPackageInfoList& infos)
 	{
+		Universe_.reset ();
+
+		auto added = infos;
 		try
 		{
-			Storage_->AddPackages (pInfo);
+			Storage_->AddPackages (infos);
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to add a batch of"
+					<< infos.size ()
+					<< "packages, falling back to adding them one by one:"
+					<< e.what ();
 
-			QStringList versions = pInfo.Versions_;
-			std::sort (versions.begin (), versions.end (), IsVersionLess);
-			const auto& greatest = versions.last ();
+			added.clear ();
+			for (const auto& info : infos)
+				try
+				{
+					Storage_->AddPackages (ComponentPackageInfoList { info });
+					added << info;
+				}
+				catch (const std::exception& e)
+				{
+					RepoInfoFetcher_->InvalidateComponent (info.ComponentId_);
 
-			for (const auto& version : pInfo.Versions_)
-			{
-				const int packageId = Storage_->FindPackage (pInfo.Name_, version);
-				Storage_->AddLocation (packageId, componentId);
+					info.Info_.Dump ();
+					qWarning () << Q_FUNC_INFO
+							<< e.what ();
+					emit gotEntity (Util::MakeNotification (tr ("Error retrieving package"),
+							tr ("Unable to save package %1.")
+								.arg (info.Info_.Name_),
+							Priority::Critical));
+				}
+		}
 
-				if (version == greatest)
+		for (const auto& info : added)
+		{
+			const auto& pInfo = info.Info_;
+			try
+			{
+				if (pInfo.Versions_.isEmpty ())
+					continue;
+
+				QStringList versions = pInfo.Versions_;
+				std::sort (versions.begin (), versions.end (), IsVersionLess);
+				const auto& greatest = versions.last ();
+
+				const auto& existing = PackagesModel_->FindPackage (pInfo.Name_).Version_;
+				if (!existing.isEmpty () && !IsVersionLess (existing, greatest))
+					continue;
+
+				const int packageId = Storage_->FindPackage (pInfo.Name_, greatest);
+				auto listInfo = Storage_->GetSingleListPackageInfo (packageId);
+				if (existing.isEmpty ())
+					PackagesModel_->AddRow (listInfo);
+				else
 				{
-					const auto& existing = PackagesModel_->FindPackage (pInfo.Name_).Version_;
-					if (existing.isEmpty ())
-						PackagesModel_->AddRow (Storage_->GetSingleListPackageInfo (packageId));
-					else if (IsVersionLess (existing, greatest))
-					{
-						auto info = Storage_->GetSingleListPackageInfo (packageId);
-						info.HasNewVersion_ = info.IsInstalled_;
-						PackagesModel_->UpdateRow (info);
-					}
+					listInfo.HasNewVersion_ = listInfo.IsInstalled_;
+					PackagesModel_->UpdateRow (listInfo);
 				}
 			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to update the model for"
+						<< pInfo.Name_
+						<< e.what ();
+			}
+		}
 
+		if (!added.isEmpty ())
 			emit tagsUpdated (GetAllTags ());
-		}
-		catch (const std::runtime_error& e)
-		{
-			pInfo.Dump ();
-			qWarning () << Q_FUNC_INFO
-					<< e.what ();
-			emit gotEntity (Util::MakeNotification (tr ("Error retrieving package"),
-					tr ("Unable to save package %1.")
-						.arg (pInfo.Name_),
-					Priority::Critical));
-		}
 
-		if (pInfo.IconURL_.isValid ())
+		for (const auto& info : infos)
 		{
+			const auto& pInfo = info.Info_;
+			if (!pInfo.IconURL_.isValid ())
+				continue;
+
 			try
 			{
 				ExternalResourceManager_->GetResourceData (pInfo.IconURL_);
@@ -1218,6 +1213,7 @@ namespace LackMan
 
 	void Core::handlePackageRemoved (int packageId)
 	{
+		Universe_.reset ();
 		PackagesModel_->RemovePackage (packageId);
 	}
 }
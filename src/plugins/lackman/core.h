@@ -29,10 +29,12 @@
 
 #ifndef PLUGINS_LACKMAN_CORE_H
 #define PLUGINS_LACKMAN_CORE_H
+#include <optional>
 #include <QObject>
 #include <QModelIndex>
 #include <interfaces/iinfo.h>
 #include "repoinfo.h"
+#include "packageuniverse.h"
 
 class QAbstractItemModel;
 class QStandardItemModel;
@@ -65,6 +67,8 @@ namespace LackMan
 		UpdatesNotificationManager *UpdatesNotificationManager_ = nullptr;
 		bool UpdatesEnabled_;
 
+		mutable std::optional<PackageUniverse> Universe_;
+
 		enum ReposColumns
 		{
 			RCURL
@@ -87,10 +91,14 @@ namespace LackMan
 		QAbstractItemModel* GetRepositoryModel () const;
 		UpdatesNotificationManager* GetUpdatesNotificationManager () const;
 
-		DependencyList GetDependencies (int) const;
-		QList<ListPackageInfo> GetDependencyFulfillers (const Dependency&) const;
 		bool IsVersionOk (const QString& candidate, QString refVer) const;
-		bool IsFulfilled (const Dependency&) const;
+
+		/** @brief Returns the snapshot of all known packages.
+			*
+			* The snapshot is loaded lazily and is invalidated whenever
+			* the set of known or installed packages changes.
+			*/
+		const PackageUniverse& GetPackageUniverse () const;
 		QIcon GetIconForLPI (const ListPackageInfo&);
 		QList<QUrl> GetPackageURLs (int) const;
 		ListPackageInfo GetListPackageInfo (int);
@@ -126,7 +134,7 @@ namespace LackMan
 		void handleInfoFetched (const RepoInfo&);
 		void handleComponentFetched (const PackageShortInfoList&,
 				const QString&, int);
-		void handlePackageFetched (const PackageInfo&, int);
+		void handlePackagesFetched (const ComponentPackageInfoList&);
 		void handlePackageInstallError (int, const QString&);
 		void handlePackageInstalled (int);
 		void handlePackageUpdated (int from, int to);
@@ -0,0 +1,152 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "fetchqueue.h"
+#include <algorithm>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QtDebug>
+#include <util/threads/futures.h>
+#include "indexcache.h"
+
+namespace LC
+{
+namespace LackMan
+{
+	FetchQueue::FetchQueue (QNetworkAccessManager *nam,
+			IndexCache *cache, int maxConnections, QObject *parent)
+	: QObject { parent }
+	, NAM_ { nam }
+	, Cache_ { cache }
+	, MaxConnections_ { std::max (maxConnections, 1) }
+	{
+	}
+
+	QFuture<FetchQueue::Result_t> FetchQueue::Fetch (const QUrl& url)
+	{
+		QFutureInterface<Result_t> promise;
+		promise.reportStarted ();
+		const auto& future = promise.future ();
+
+		Queue_.enqueue ({ url, promise });
+		Rotate ();
+
+		return future;
+	}
+
+	int FetchQueue::GetRunningCount () const
+	{
+		return Running_;
+	}
+
+	int FetchQueue::GetQueuedCount () const
+	{
+		return Queue_.size ();
+	}
+
+	void FetchQueue::Rotate ()
+	{
+		while (Running_ < MaxConnections_ && !Queue_.isEmpty ())
+			Start (Queue_.dequeue ());
+	}
+
+	void FetchQueue::Start (PendingFetch fetch)
+	{
+		QNetworkRequest req { fetch.URL_ };
+		req.setAttribute (QNetworkRequest::FollowRedirectsAttribute, true);
+		req.setAttribute (QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+		req.setAttribute (QNetworkRequest::CacheSaveControlAttribute, false);
+
+		if (Cache_)
+			if (const auto& entry = Cache_->Get (fetch.URL_))
+			{
+				if (!entry->ETag_.isEmpty ())
+					req.setRawHeader ("If-None-Match", entry->ETag_);
+				if (!entry->LastModified_.isEmpty ())
+					req.setRawHeader ("If-Modified-Since", entry->LastModified_);
+			}
+
+		++Running_;
+
+		const auto reply = NAM_->get (req);
+		connect (reply,
+				&QNetworkReply::finished,
+				this,
+				[this, reply, fetch] () mutable
+				{
+					reply->deleteLater ();
+					--Running_;
+
+					Util::ReportFutureResult (fetch.Promise_, HandleFinished (reply, fetch.URL_));
+
+					Rotate ();
+				});
+	}
+
+	FetchQueue::Result_t FetchQueue::HandleFinished (QNetworkReply *reply, const QUrl& url)
+	{
+		const auto status = reply->attribute (QNetworkRequest::HttpStatusCodeAttribute).toInt ();
+
+		if (status == 304 && Cache_)
+		{
+			if (const auto& entry = Cache_->Get (url))
+				return Result_t::Right ({ entry->Data_, true });
+
+			qWarning () << Q_FUNC_INFO
+					<< "got 304 for"
+					<< url
+					<< "but the cache entry is gone";
+			return Result_t::Left (tr ("Cached copy of %1 is missing.").arg (url.toString ()));
+		}
+
+		if (reply->error () != QNetworkReply::NoError)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "error fetching"
+					<< url
+					<< reply->errorString ();
+			return Result_t::Left (reply->errorString ());
+		}
+
+		const auto& data = reply->readAll ();
+
+		if (Cache_)
+		{
+			const auto& etag = reply->rawHeader ("ETag");
+			const auto& lastModified = reply->rawHeader ("Last-Modified");
+			if (!etag.isEmpty () || !lastModified.isEmpty ())
+				Cache_->Put (url, { data, etag, lastModified });
+			else
+				Cache_->Remove (url);
+		}
+
+		return Result_t::Right ({ data, false });
+	}
+}
+}
@@ -0,0 +1,93 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QQueue>
+#include <QUrl>
+#include <QFutureInterface>
+#include <util/sll/either.h>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+namespace LC
+{
+namespace LackMan
+{
+	class IndexCache;
+
+	/** @brief Fetches repository files with a limited number of
+	 * parallel connections.
+	 *
+	 * If an IndexCache is given, the files are fetched with conditional
+	 * requests based on the cached validators, and the cached contents
+	 * are returned if the server says they are not modified.
+	 */
+	class FetchQueue : public QObject
+	{
+		Q_OBJECT
+	public:
+		struct Fetched
+		{
+			QByteArray Data_;
+			bool NotModified_;
+		};
+
+		using Result_t = Util::Either<QString, Fetched>;
+	private:
+		QNetworkAccessManager * const NAM_;
+		IndexCache * const Cache_;
+		const int MaxConnections_;
+
+		struct PendingFetch
+		{
+			QUrl URL_;
+			QFutureInterface<Result_t> Promise_;
+		};
+		QQueue<PendingFetch> Queue_;
+		int Running_ = 0;
+	public:
+		FetchQueue (QNetworkAccessManager *nam,
+				IndexCache *cache,
+				int maxConnections,
+				QObject *parent = nullptr);
+
+		QFuture<Result_t> Fetch (const QUrl& url);
+
+		int GetRunningCount () const;
+		int GetQueuedCount () const;
+	private:
+		void Rotate ();
+		void Start (PendingFetch);
+		Result_t HandleFinished (QNetworkReply*, const QUrl&);
+	};
+}
+}
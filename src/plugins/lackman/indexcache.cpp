@@ -0,0 +1,156 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "indexcache.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QUrl>
+#include <QtDebug>
+
+namespace LC
+{
+namespace LackMan
+{
+	IndexCache::IndexCache (const QDir& dir)
+	: Dir_ { dir }
+	{
+	}
+
+	namespace
+	{
+		const int MetaVersion = 1;
+
+		bool WriteFile (const QString& path, const QByteArray& data)
+		{
+			QSaveFile file { path };
+			if (!file.open (QIODevice::WriteOnly))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to open"
+						<< path
+						<< file.errorString ();
+				return false;
+			}
+
+			file.write (data);
+			if (!file.commit ())
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to commit"
+						<< path
+						<< file.errorString ();
+				return false;
+			}
+
+			return true;
+		}
+	}
+
+	std::optional<IndexCache::Entry> IndexCache::Get (const QUrl& url) const
+	{
+		const auto& base = GetBasePath (url);
+
+		QFile metaFile { base + ".meta" };
+		if (!metaFile.open (QIODevice::ReadOnly))
+			return {};
+
+		QDataStream metaStream { &metaFile };
+		int version = 0;
+		metaStream >> version;
+		if (version != MetaVersion)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown version"
+					<< version
+					<< "for"
+					<< url;
+			return {};
+		}
+
+		QUrl storedUrl;
+		Entry entry;
+		metaStream >> storedUrl
+				>> entry.ETag_
+				>> entry.LastModified_;
+		if (storedUrl != url)
+			return {};
+
+		QFile dataFile { base + ".data" };
+		if (!dataFile.open (QIODevice::ReadOnly))
+			return {};
+
+		entry.Data_ = dataFile.readAll ();
+		return entry;
+	}
+
+	void IndexCache::Put (const QUrl& url, const Entry& entry)
+	{
+		if (!Dir_.exists () && !Dir_.mkpath ("."))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to create"
+					<< Dir_.path ();
+			return;
+		}
+
+		const auto& base = GetBasePath (url);
+
+		QByteArray meta;
+		{
+			QDataStream metaStream { &meta, QIODevice::WriteOnly };
+			metaStream << MetaVersion
+					<< url
+					<< entry.ETag_
+					<< entry.LastModified_;
+		}
+
+		// the data is written first so that the validators never
+		// refer to stale contents
+		QFile::remove (base + ".meta");
+		if (!WriteFile (base + ".data", entry.Data_))
+			return;
+		WriteFile (base + ".meta", meta);
+	}
+
+	void IndexCache::Remove (const QUrl& url)
+	{
+		const auto& base = GetBasePath (url);
+		QFile::remove (base + ".meta");
+		QFile::remove (base + ".data");
+	}
+
+	QString IndexCache::GetBasePath (const QUrl& url) const
+	{
+		const auto& hash = QCryptographicHash::hash (url.toEncoded (), QCryptographicHash::Sha1);
+		return Dir_.filePath (hash.toHex ());
+	}
+}
+}
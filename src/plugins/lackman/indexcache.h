@@ -0,0 +1,68 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <optional>
+#include <QDir>
+#include <QByteArray>
+
+class QUrl;
+
+namespace LC
+{
+namespace LackMan
+{
+	/** @brief On-disk cache of the fetched repository index files.
+	 *
+	 * Along with the file contents the cache keeps the ETag and
+	 * Last-Modified validators, so that the files can be refetched
+	 * with conditional requests.
+	 */
+	class IndexCache
+	{
+		const QDir Dir_;
+	public:
+		struct Entry
+		{
+			QByteArray Data_;
+			QByteArray ETag_;
+			QByteArray LastModified_;
+		};
+
+		explicit IndexCache (const QDir& dir);
+
+		std::optional<Entry> Get (const QUrl& url) const;
+		void Put (const QUrl& url, const Entry& entry);
+		void Remove (const QUrl& url);
+	private:
+		QString GetBasePath (const QUrl&) const;
+	};
+}
+}
@@ -0,0 +1,343 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "packageextractor.h"
+#include <algorithm>
+#include <optional>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryFile>
+#include <QtDebug>
+#include <archive.h>
+#include <archive_entry.h>
+#include <util/sll/util.h>
+
+namespace LC
+{
+namespace LackMan
+{
+	namespace
+	{
+		const QString StagedSuffix = ".lackman-new-XXXXXX";
+		const QString BackupSuffix = ".lackman-old";
+
+		std::optional<QString> CheckDigest (const QString& archivePath, const QByteArray& sha256)
+		{
+			QFile file { archivePath };
+			if (!file.open (QIODevice::ReadOnly))
+				return QObject::tr ("Unable to open package archive %1: %2.")
+						.arg (archivePath)
+						.arg (file.errorString ());
+
+			QCryptographicHash hash { QCryptographicHash::Sha256 };
+			if (!hash.addData (&file))
+				return QObject::tr ("Unable to read package archive %1: %2.")
+						.arg (archivePath)
+						.arg (file.errorString ());
+
+			const auto& actual = hash.result ().toHex ();
+			if (actual != sha256.toLower ())
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "checksum mismatch for"
+						<< archivePath
+						<< actual
+						<< sha256;
+				return QObject::tr ("Package archive %1 is corrupted: checksum mismatch.")
+						.arg (QFileInfo { archivePath }.fileName ());
+			}
+
+			return {};
+		}
+
+		/** Returns the cleaned relative path of the entry, an empty
+		 * string for the target directory itself, or nothing if the entry
+		 * tries to escape the target directory.
+		 */
+		std::optional<QString> GetRelativePath (archive_entry *entry)
+		{
+			auto path = QString::fromUtf8 (archive_entry_pathname (entry));
+			if (path.startsWith ("./"))
+				path = path.mid (2);
+			path = QDir::cleanPath (path);
+
+			if (path.isEmpty () || path == ".")
+				return QString {};
+
+			if (QDir::isAbsolutePath (path) ||
+					path == ".." ||
+					path.startsWith ("../"))
+				return {};
+
+			return path;
+		}
+
+		std::optional<QString> WriteData (archive *arch, QFile& file)
+		{
+			const void *buf = nullptr;
+			size_t size = 0;
+			std::int64_t offset = 0;
+
+			while (true)
+			{
+				switch (archive_read_data_block (arch, &buf, &size, &offset))
+				{
+				case ARCHIVE_EOF:
+					return {};
+				case ARCHIVE_OK:
+				case ARCHIVE_WARN:
+					break;
+				default:
+					return QString::fromUtf8 (archive_error_string (arch));
+				}
+
+				if (file.pos () != offset && !file.seek (offset))
+					return file.errorString ();
+
+				if (file.write (static_cast<const char*> (buf), size) != static_cast<qint64> (size))
+					return file.errorString ();
+			}
+		}
+
+		QFileDevice::Permissions ToPermissions (int mode)
+		{
+			QFileDevice::Permissions result;
+			const std::initializer_list<std::pair<int, QFileDevice::Permissions>> bits
+			{
+				{ 0400, QFileDevice::ReadOwner | QFileDevice::ReadUser },
+				{ 0200, QFileDevice::WriteOwner | QFileDevice::WriteUser },
+				{ 0100, QFileDevice::ExeOwner | QFileDevice::ExeUser },
+				{ 0040, QFileDevice::ReadGroup },
+				{ 0020, QFileDevice::WriteGroup },
+				{ 0010, QFileDevice::ExeGroup },
+				{ 0004, QFileDevice::ReadOther },
+				{ 0002, QFileDevice::WriteOther },
+				{ 0001, QFileDevice::ExeOther }
+			};
+			for (const auto& pair : bits)
+				if (mode & pair.first)
+					result |= pair.second;
+			return result;
+		}
+
+		bool MakePath (const QDir& targetDir, const QString& relPath, ExtractedPackage& result)
+		{
+			QString path;
+			for (const auto& component : relPath.split ('/', QString::SkipEmptyParts))
+			{
+				path += path.isEmpty () ? component : '/' + component;
+				if (targetDir.exists (path))
+					continue;
+
+				// another package may be unpacked into the same tree in parallel
+				if (targetDir.mkdir (path))
+					result.CreatedDirs_ << path;
+				else if (!targetDir.exists (path))
+					return false;
+			}
+			return true;
+		}
+
+		std::optional<QString> ExtractEntries (archive *arch, const QDir& targetDir, ExtractedPackage& result)
+		{
+			archive_entry *entry = nullptr;
+			while (true)
+			{
+				switch (archive_read_next_header (arch, &entry))
+				{
+				case ARCHIVE_EOF:
+					return {};
+				case ARCHIVE_OK:
+				case ARCHIVE_WARN:
+					break;
+				default:
+					return QObject::tr ("Unable to read package archive: %1.")
+							.arg (QString::fromUtf8 (archive_error_string (arch)));
+				}
+
+				const auto& maybeRelPath = GetRelativePath (entry);
+				if (!maybeRelPath)
+					return QObject::tr ("Package contains an entry %1 outside of the target directory.")
+							.arg (QString::fromUtf8 (archive_entry_pathname (entry)));
+
+				// The "./" entry of the archive root.
+				const auto& relPath = *maybeRelPath;
+				if (relPath.isEmpty ())
+					continue;
+
+				// Links may point outside of the target directory, and the
+				// packages have no legitimate use for them.
+				if (archive_entry_hardlink (entry))
+					return QObject::tr ("Package contains a hard link %1, which is not supported.")
+							.arg (relPath);
+
+				switch (archive_entry_filetype (entry))
+				{
+				case AE_IFDIR:
+					if (!MakePath (targetDir, relPath, result))
+						return QObject::tr ("Unable to create directory %1.")
+								.arg (relPath);
+					break;
+				case AE_IFREG:
+				{
+					const auto& parent = QFileInfo { relPath }.path ();
+					if (parent != "." && !MakePath (targetDir, parent, result))
+						return QObject::tr ("Unable to create directory %1.")
+								.arg (parent);
+
+					// The same file may be staged by another package in parallel.
+					QTemporaryFile file { targetDir.filePath (relPath + StagedSuffix) };
+					file.setAutoRemove (false);
+					if (!file.open ())
+						return QObject::tr ("Unable to write file %1: %2.")
+								.arg (relPath)
+								.arg (file.errorString ());
+					result.StagedFiles_.append ({ relPath, targetDir.relativeFilePath (file.fileName ()) });
+
+					if (const auto error = WriteData (arch, file))
+						return QObject::tr ("Unable to unpack file %1: %2.")
+								.arg (relPath)
+								.arg (*error);
+
+					if (const auto perm = archive_entry_perm (entry))
+						file.setPermissions (ToPermissions (perm));
+					break;
+				}
+				case AE_IFLNK:
+					return QObject::tr ("Package contains a symbolic link %1, which is not supported.")
+							.arg (relPath);
+				default:
+					return QObject::tr ("Package contains an entry %1 of unsupported type.")
+							.arg (relPath);
+				}
+
+				result.Entries_ << relPath;
+			}
+		}
+	}
+
+	ExtractResult_t ExtractPackage (const QString& archivePath,
+			const QByteArray& sha256, const QDir& targetDir)
+	{
+		if (!sha256.isEmpty ())
+			if (const auto error = CheckDigest (archivePath, sha256))
+				return ExtractResult_t::Left (*error);
+
+		const auto arch = archive_read_new ();
+		const auto archGuard = Util::MakeScopeGuard ([arch] { archive_read_free (arch); });
+		archive_read_support_filter_all (arch);
+		archive_read_support_format_tar (arch);
+
+		if (archive_read_open_filename (arch, archivePath.toUtf8 ().constData (), 64 * 1024) != ARCHIVE_OK)
+			return ExtractResult_t::Left (QObject::tr ("Unable to open package archive %1: %2.")
+					.arg (archivePath)
+					.arg (QString::fromUtf8 (archive_error_string (arch))));
+
+		ExtractedPackage result;
+		if (const auto error = ExtractEntries (arch, targetDir, result))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to extract"
+					<< archivePath
+					<< *error;
+			DiscardPackage (result, targetDir);
+			return ExtractResult_t::Left (*error);
+		}
+
+		return ExtractResult_t::Right (result);
+	}
+
+	CommitResult_t CommitPackage (const ExtractedPackage& pkg, const QDir& targetDir)
+	{
+		QStringList backedUp;
+		QStringList committed;
+
+		auto rollback = [&]
+		{
+			for (const auto& name : committed)
+				targetDir.remove (name);
+			for (const auto& name : backedUp)
+				targetDir.rename (name + BackupSuffix, name);
+			DiscardPackage (pkg, targetDir);
+		};
+
+		for (const auto& pair : pkg.StagedFiles_)
+		{
+			const auto& name = pair.first;
+			const auto& staged = pair.second;
+
+			if (targetDir.exists (name))
+			{
+				targetDir.remove (name + BackupSuffix);
+				if (!targetDir.rename (name, name + BackupSuffix))
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "unable to back up"
+							<< name;
+					rollback ();
+					return CommitResult_t::Left (QObject::tr ("Unable to replace file %1.")
+							.arg (name));
+				}
+				backedUp << name;
+			}
+
+			if (!targetDir.rename (staged, name))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to move"
+						<< staged
+						<< "to"
+						<< name;
+				rollback ();
+				return CommitResult_t::Left (QObject::tr ("Unable to move file %1 into place.")
+						.arg (name));
+			}
+			committed << name;
+		}
+
+		for (const auto& name : backedUp)
+			targetDir.remove (name + BackupSuffix);
+
+		return CommitResult_t::Right ({});
+	}
+
+	void DiscardPackage (const ExtractedPackage& pkg, const QDir& targetDir)
+	{
+		for (const auto& pair : pkg.StagedFiles_)
+			targetDir.remove (pair.second);
+
+		auto dirs = pkg.CreatedDirs_;
+		std::sort (dirs.begin (), dirs.end ());
+		std::reverse (dirs.begin (), dirs.end ());
+		for (const auto& dir : dirs)
+			targetDir.rmdir (dir);
+	}
+}
+}
@@ -0,0 +1,98 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QDir>
+#include <QStringList>
+#include <util/sll/either.h>
+#include <util/sll/void.h>
+
+namespace LC
+{
+namespace LackMan
+{
+	/** @brief Describes a package archive unpacked next to its target.
+	 *
+	 * The files are not visible under their final names until the
+	 * package is committed via CommitPackage().
+	 */
+	struct ExtractedPackage
+	{
+		/** @brief All entries of the archive, relative to the target
+		 * directory, in archive order.
+		 */
+		QStringList Entries_;
+
+		/** @brief Pairs of the final and the staged file names.
+		 */
+		QList<QPair<QString, QString>> StagedFiles_;
+
+		/** @brief Directories that did not exist before extraction.
+		 */
+		QStringList CreatedDirs_;
+	};
+
+	using ExtractResult_t = Util::Either<QString, ExtractedPackage>;
+	using CommitResult_t = Util::Either<QString, Util::Void>;
+
+	/** @brief Unpacks the archive into the given directory.
+	 *
+	 * If \em sha256 is not empty, the archive is verified against it
+	 * before anything is unpacked. Each file is streamed into a uniquely
+	 * named staging file next to its final location, so the extraction
+	 * is safe to run in a separate thread and can be undone by
+	 * DiscardPackage(). The permissions of the files are preserved.
+	 *
+	 * Archives containing symbolic or hard links, special files or
+	 * entries outside of the target directory are rejected.
+	 *
+	 * On failure everything created so far is removed.
+	 *
+	 * @param[in] archivePath The path to the package archive.
+	 * @param[in] sha256 The expected hex-encoded SHA-256 of the archive.
+	 * @param[in] targetDir The directory the package is installed to.
+	 * @return The extracted package or the human-readable error.
+	 */
+	ExtractResult_t ExtractPackage (const QString& archivePath,
+			const QByteArray& sha256, const QDir& targetDir);
+
+	/** @brief Moves the staged files to their final names.
+	 *
+	 * Files that are overwritten are kept aside until all the staged
+	 * files are in place, so if any rename fails the target directory
+	 * is restored to its previous state.
+	 */
+	CommitResult_t CommitPackage (const ExtractedPackage&, const QDir& targetDir);
+
+	/** @brief Removes the staged files and the created directories.
+	 */
+	void DiscardPackage (const ExtractedPackage&, const QDir& targetDir);
+}
+}
@@ -30,10 +30,12 @@
 #include "packageprocessor.h"
 #include <stdexcept>
 #include <QFile>
-#include <QDirIterator>
 #include <QFileInfo>
+#include <QSaveFile>
+#include <QtConcurrentRun>
 #include <util/util.h>
 #include <util/sys/paths.h>
+#include <util/threads/futures.h>
 #include "core.h"
 #include "externalresourcemanager.h"
 #include "storage.h"
@@ -49,6 +51,11 @@ namespace LackMan
 	}
 
 	void PackageProcessor::Remove (int packageId)
+	{
+		RemoveExcept (packageId, {});
+	}
+
+	void PackageProcessor::RemoveExcept (int packageId, const QSet<QString>& keep)
 	{
 		QString filename = QString::number (packageId);
 		if (!DBDir_.exists (filename))
@@ -84,6 +91,9 @@ namespace LackMan
 		std::reverse (files.begin (), files.end ());
 		for (const auto& packageFilename : files)
 		{
+			if (keep.contains (packageFilename))
+				continue;
+
 			const QString& fullName = packageDir.filePath (packageFilename);
 #ifndef QT_NO_DEBUG
 			qDebug () << Q_FUNC_INFO
@@ -182,49 +192,25 @@ namespace LackMan
 			HandleFile (URL2Id_.take (url), url, URL2Mode_.take (url));
 	}
 
-	void PackageProcessor::handlePackageUnarchFinished (int ret, QProcess::ExitStatus)
+	void PackageProcessor::HandleFile (int packageId,
+			const QUrl& url, PackageProcessor::Mode mode)
 	{
-		sender ()->deleteLater ();
-
-		QProcess *unarch = qobject_cast<QProcess*> (sender ());
-		int packageId = unarch->property ("PackageID").toInt ();
-		const auto& stagingDir = unarch->property ("StagingDirectory").toString ();
-		Mode mode = static_cast<Mode> (unarch->property ("Mode").toInt ());
+		const auto& path = Core::Instance ().GetExtResourceManager ()->GetResourcePath (url);
 
-		auto cleanupGuard = std::shared_ptr<void> (nullptr,
-				[&stagingDir, this] (void*) { CleanupDir (stagingDir); });
-
-		if (ret)
+		PackageShortInfo info;
+		try
+		{
+			info = Core::Instance ().GetStorage ()->GetPackage (packageId);
+		}
+		catch (const std::exception& e)
 		{
-			QString errString = QString::fromUtf8 (unarch->readAllStandardError ());
 			qWarning () << Q_FUNC_INFO
-					<< "unpacker exited with"
-					<< ret
-					<< errString
-					<< "for"
+					<< "unable to get package info for"
 					<< packageId
-					<< unarch->property ("Path").toString ();
-
-			QString errorString = tr ("Unable to unpack package archive, unpacker exited with %1: %2.")
-					.arg (ret)
-					.arg (errString);
-			emit packageInstallError (packageId, errorString);
-
+					<< e.what ();
 			return;
 		}
 
-		int oldId = -1;
-		if (mode == MUpdate)
-		{
-			oldId = Core::Instance ().GetStorage ()->FindInstalledPackage (packageId);
-			if (!CleanupBeforeUpdate (oldId, packageId))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cleanup";
-				return;
-			}
-		}
-
 		QDir packageDir;
 		try
 		{
@@ -243,163 +229,18 @@ namespace LackMan
 			return;
 		}
 
-		QDirIterator dirIt (stagingDir,
-				QDir::NoDotAndDotDot |
-					QDir::Readable |
-					QDir::NoSymLinks |
-					QDir::Dirs |
-					QDir::Files,
-				QDirIterator::Subdirectories);
-		while (dirIt.hasNext ())
-		{
-			dirIt.next ();
-			QFileInfo fi = dirIt.fileInfo ();
-
-			if (fi.isDir () ||
-					fi.isFile ())
-				if (!HandleEntry (packageId, fi, stagingDir, packageDir))
-				{
-					try
-					{
-						Remove (packageId);
-					}
-					catch (const std::exception& e)
-					{
-						qWarning () << Q_FUNC_INFO
-								<< "while removing partially installed package"
-								<< packageId
-								<< "got:"
-								<< e.what ();
-					}
-
-					QString errorString = tr ("Unable to copy "
-							"files from staging area to "
-							"destination directory.");
-					emit packageInstallError (packageId, errorString);
-					return;
-				}
-		}
-
-		switch (mode)
-		{
-		case MInstall:
-			emit packageInstalled (packageId);
-			break;
-		case MUpdate:
-			emit packageUpdated (oldId, packageId);
-			break;
-		}
-	}
-
-	void PackageProcessor::handleUnarchError (QProcess::ProcessError error)
-	{
-		sender ()->deleteLater ();
-
-		QByteArray errString = qobject_cast<QProcess*> (sender ())->readAllStandardError ();
-		qWarning () << Q_FUNC_INFO
-				<< "unable to unpack for"
-				<< sender ()->property ("PackageID").toInt ()
-				<< sender ()->property ("Path").toString ()
-				<< "with"
-				<< error
-				<< errString;
-
-		QString errorString = tr ("Unable to unpack package archive, unpacker died with %1: %2.")
-				.arg (error)
-				.arg (QString::fromUtf8 (errString));
-		emit packageInstallError (sender ()->property ("PackageID").toInt (),
-				errorString);
-
-		CleanupDir (sender ()->property ("StagingDirectory").toString ());
-	}
-
-	void PackageProcessor::HandleFile (int packageId,
-			const QUrl& url, PackageProcessor::Mode mode)
-	{
-		QString path = Core::Instance ().GetExtResourceManager ()->GetResourcePath (url);
-
-		PackageShortInfo info;
-		try
-		{
-			info = Core::Instance ().GetStorage ()->GetPackage (packageId);
-		}
-		catch (const std::exception& e)
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to get package info for"
-					<< packageId
-					<< e.what ();
-			return;
-		}
-
-		QProcess *unarch = new QProcess (this);
-		connect (unarch,
-				SIGNAL (finished (int, QProcess::ExitStatus)),
-				this,
-				SLOT (handlePackageUnarchFinished (int, QProcess::ExitStatus)));
-		connect (unarch,
-				SIGNAL (error (QProcess::ProcessError)),
-				this,
-				SLOT (handleUnarchError (QProcess::ProcessError)));
-
-		QString dirname = Util::GetTemporaryName ("lackman_stagingarea");
-		QStringList args;
-#ifdef Q_OS_WIN32
-		args << "x"
-			<< "-ttar"
-			<< "-y"
-			<< "-si";
-
-		QString outDirArg ("-o");
-		outDirArg.append (dirname);
-		args << outDirArg;
-
-		QProcess *firstStep = new QProcess (unarch);
-		firstStep->setStandardOutputProcess (unarch);
-		QStringList firstStepArgs;
-		firstStepArgs << "x"
-			<< "-y"
-			<< "-so"
-			<< path;
-#else
-		const auto& archiver = info.VersionArchivers_.value (info.Versions_.value (0), "gz");
-		if (archiver == "lzma")
-			args << "--lzma";
-		args << "-xf";
-		args << path;
-		args << "-C";
-		args << dirname;
-#endif
-		unarch->setProperty ("PackageID", packageId);
-		unarch->setProperty ("StagingDirectory", dirname);
-		unarch->setProperty ("Path", path);
-		unarch->setProperty ("Mode", mode);
-
-		QFileInfo sdInfo (dirname);
-		QDir stagingParentDir (sdInfo.path ());
-		if (!stagingParentDir.exists (sdInfo.fileName ()) &&
-				!stagingParentDir.mkdir (sdInfo.fileName ()))
-		{
+		const auto& checksum = info.VersionChecksums_.value (info.Versions_.value (0));
+		if (checksum.isEmpty ())
 			qWarning () << Q_FUNC_INFO
-					<< "unable to create staging directory"
-					<< sdInfo.fileName ()
-					<< "in"
-					<< sdInfo.path ();
-
-			QString errorString = tr ("Unable to create staging directory %1.")
-					.arg (sdInfo.fileName ());
-			emit packageInstallError (packageId, errorString);
-
-			return;
-		}
-
-#ifdef Q_OS_WIN32
-		QString command = "7za";
-		firstStep->start (command, firstStepArgs);
-#else
-		QString command = "tar";
-#endif
-		unarch->start (command, args);
+					<< "no checksum for"
+					<< info.Name_
+					<< info.Versions_
+					<< ", the archive won't be verified";
+
+		Util::Sequence (this,
+				QtConcurrent::run ([path, checksum, packageDir]
+						{ return ExtractPackage (path, checksum, packageDir); })) >>
+				[=] (const ExtractResult_t& result) { HandleExtracted (packageId, mode, packageDir, result); };
 	}
 
 	QUrl PackageProcessor::GetURLFor (int packageId) const
@@ -429,156 +270,95 @@ namespace LackMan
 		return erm;
 	}
 
-	bool PackageProcessor::HandleEntry (int packageId, const QFileInfo& fi,
-			const QString& stagingDir, QDir& packageDir)
+	void PackageProcessor::HandleExtracted (int packageId, Mode mode,
+			const QDir& packageDir, const ExtractResult_t& result)
 	{
-		QFile dbFile (DBDir_.filePath (QString::number (packageId)));
-		if (!dbFile.open (QIODevice::WriteOnly | QIODevice::Append))
+		if (result.IsLeft ())
 		{
 			qWarning () << Q_FUNC_INFO
-					<< "could not open DB file"
-					<< dbFile.fileName ()
-					<< "for write:"
-					<< dbFile.errorString ();
-			return false;
+					<< "unable to unpack"
+					<< packageId
+					<< result.GetLeft ();
+			emit packageInstallError (packageId, result.GetLeft ());
+			return;
 		}
 
-		QString sourceName = fi.absoluteFilePath ();
-		sourceName = sourceName.mid (stagingDir.length ());
-		if (sourceName.at (0) == '/')
-			sourceName = sourceName.mid (1);
+		const auto& extracted = result.GetRight ();
+		if (!WriteFilesDB (packageId, extracted.Entries_))
+		{
+			DiscardPackage (extracted, packageDir);
+			emit packageInstallError (packageId,
+					tr ("Unable to write the list of files for the package."));
+			return;
+		}
 
-		if (fi.isFile ())
+		const auto& commitResult = CommitPackage (extracted, packageDir);
+		if (commitResult.IsLeft ())
 		{
-			QString destName = packageDir.filePath (sourceName);
-#ifndef QT_NO_DEBUG
-			qDebug () << Q_FUNC_INFO
-					<< "gotta copy"
-					<< fi.absoluteFilePath ()
-					<< "to"
-					<< destName;
-#endif
+			DBDir_.remove (QString::number (packageId));
+			emit packageInstallError (packageId, commitResult.GetLeft ());
+			return;
+		}
 
-			QFile file (fi.absoluteFilePath ());
-			if (!file.copy (destName))
+		switch (mode)
+		{
+		case MInstall:
+			emit packageInstalled (packageId);
+			break;
+		case MUpdate:
+		{
+			// The new version is already in place at this point, so the
+			// leftovers of the old one are only removed on a best-effort basis.
+			const auto oldId = Core::Instance ().GetStorage ()->FindInstalledPackage (packageId);
+			try
 			{
-				qWarning () << Q_FUNC_INFO
-						<< "could not copy"
-						<< fi.absoluteFilePath ()
-						<< "to"
-						<< destName
-						<< "because of"
-						<< file.errorString ();
-
-				QString errorString = tr ("Could not copy file %1 because of %2.")
-						.arg (sourceName)
-						.arg (file.errorString ());
-				emit packageInstallError (packageId, errorString);
-				return false;
+				RemoveExcept (oldId, extracted.Entries_.toSet ());
 			}
-		}
-		else if (fi.isDir ())
-		{
-#ifndef QT_NO_DEBUG
-			qDebug () << Q_FUNC_INFO
-					<< "gotta create"
-					<< sourceName
-					<< "for"
-					<< fi.absoluteFilePath ();
-#endif
-
-			if (!packageDir.mkpath (sourceName))
+			catch (const std::exception& e)
 			{
 				qWarning () << Q_FUNC_INFO
-						<< "unable to mkdir"
-						<< sourceName
-						<< "in"
-						<< packageDir.path ();
-
-				QString errorString = tr ("Unable to create directory %1.")
-						.arg (sourceName);
-				emit packageInstallError (packageId, errorString);
-				return false;
+						<< "while removing package"
+						<< oldId
+						<< "for update to"
+						<< packageId
+						<< "got exception:"
+						<< e.what ();
 			}
+			emit packageUpdated (oldId, packageId);
+			break;
+		}
 		}
-
-		dbFile.write (sourceName.toUtf8 ());
-		dbFile.write ("\n");
-
-		return true;
 	}
 
-	bool PackageProcessor::CleanupBeforeUpdate (int oldId, int newId)
+	bool PackageProcessor::WriteFilesDB (int packageId, const QStringList& files)
 	{
-		try
-		{
-			Remove (oldId);
-		}
-		catch (const std::exception& e)
+		QSaveFile dbFile (DBDir_.filePath (QString::number (packageId)));
+		if (!dbFile.open (QIODevice::WriteOnly))
 		{
 			qWarning () << Q_FUNC_INFO
-					<< "while removing package"
-					<< oldId
-					<< "for update to"
-					<< newId
-					<< "got exception:"
-					<< e.what ();
-			const auto& str = tr ("Unable to update package: %1.")
-					.arg (QString::fromUtf8 (e.what ()));
-			emit packageInstallError (newId, str);
+					<< "could not open DB file"
+					<< dbFile.fileName ()
+					<< "for write:"
+					<< dbFile.errorString ();
 			return false;
 		}
-		return true;
-	}
 
-	bool PackageProcessor::CleanupDir (const QString& directory)
-	{
-#ifndef QT_NO_DEBUG
-		qDebug () << Q_FUNC_INFO
-				<< directory;
-#endif
-
-		QDir dir (directory);
-		for (const auto& subdir : dir.entryList (QDir::Dirs | QDir::NoDotAndDotDot))
-			if (!CleanupDir (dir.absoluteFilePath (subdir)))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "failed to cleanup subdir"
-						<< subdir
-						<< "for"
-						<< directory;
-				return false;
-			}
-
-		for (const auto& entry : dir.entryList (QDir::Files | QDir::Hidden | QDir::System))
-			if (!dir.remove (entry))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "failed to remove file"
-						<< entry
-						<< "for dir"
-						<< directory;
-				return false;
-			}
+		for (const auto& file : files)
+		{
+			dbFile.write (file.toUtf8 ());
+			dbFile.write ("\n");
+		}
 
-		const auto& dirName = dir.dirName ();
-		if (!dir.cdUp ())
+		if (!dbFile.commit ())
 		{
 			qWarning () << Q_FUNC_INFO
-					<< "cannot cd up from"
-					<< directory;
+					<< "could not commit DB file"
+					<< dbFile.fileName ()
+					<< dbFile.errorString ();
 			return false;
 		}
 
-		const auto res = dir.rmdir (dirName);
-		if (!res)
-			qWarning () << Q_FUNC_INFO
-					<< "cannot remove directory"
-					<< dirName
-					<< "from parent"
-					<< dir.absolutePath ();
-
-		return res;
+		return true;
 	}
 }
 }
@@ -33,7 +33,7 @@
 #include <QDir>
 #include <QHash>
 #include <QUrl>
-#include <QProcess>
+#include "packageextractor.h"
 
 namespace LC
 {
@@ -63,8 +63,6 @@ namespace LackMan
 		void Update (int);
 	private slots:
 		void handleResourceFetched (const QUrl&);
-		void handlePackageUnarchFinished (int, QProcess::ExitStatus);
-		void handleUnarchError (QProcess::ProcessError);
 	private:
 		/** @brief This does all the heavy duty of installing a
 			* package.
@@ -78,6 +76,11 @@ namespace LackMan
 			* This function expects that the package at the url is
 			* already fetched.
 			*
+			* The archive is verified and unpacked in a separate
+			* thread, so several packages may be processed at once.
+			* The unpacked files are moved into place by
+			* HandleExtracted().
+			*
 			* @param[in] id The ID of the package.
 			* @param[in] url The exact URL from which the package
 			* @param[in] mode The handling mode.
@@ -88,10 +91,10 @@ namespace LackMan
 		QUrl GetURLFor (int id) const;
 		ExternalResourceManager* PrepareResourceManager ();
 
-		bool HandleEntry (int id, const QFileInfo& fi,
-				const QString& stagingDir, QDir& packageDir);
-		bool CleanupBeforeUpdate (int oldId, int toId);
-		bool CleanupDir (const QString&);
+		void HandleExtracted (int id, Mode mode,
+				const QDir& packageDir, const ExtractResult_t& result);
+		bool WriteFilesDB (int id, const QStringList& files);
+		void RemoveExcept (int id, const QSet<QString>& keep);
 	signals:
 		void packageInstallError (int, const QString&);
 		void packageInstalled (int);
@@ -0,0 +1,109 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "packageuniverse.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "versioncomparator.h"
+
+namespace LC
+{
+namespace LackMan
+{
+	PackageUniverse::PackageUniverse (const QList<Package>& packages,
+			const InstalledDependencyInfoList& installed)
+	{
+		for (const auto& package : packages)
+		{
+			Packages_ [package.ID_] = package;
+
+			Providers_ [package.Name_] << package.ID_;
+			for (const auto& provided : package.Provides_)
+			{
+				auto& providers = Providers_ [provided.Name_];
+				if (!providers.contains (package.ID_))
+					providers << package.ID_;
+			}
+		}
+
+		for (const auto& info : installed)
+			Installed_ [info.Dep_.Name_] << info.Dep_.Version_;
+	}
+
+	bool PackageUniverse::Contains (int packageId) const
+	{
+		return Packages_.contains (packageId);
+	}
+
+	const PackageUniverse::Package& PackageUniverse::GetPackage (int packageId) const
+	{
+		const auto pos = Packages_.find (packageId);
+		if (pos == Packages_.end ())
+			throw std::runtime_error ("unknown package " + std::to_string (packageId));
+		return *pos;
+	}
+
+	bool PackageUniverse::IsInstalled (const Dependency& dep) const
+	{
+		const auto& versions = Installed_.value (dep.Name_);
+		return std::any_of (versions.begin (), versions.end (),
+				[&dep] (const QString& version) { return IsVersionOk (version, dep.Version_); });
+	}
+
+	bool PackageUniverse::IsFulfilledBy (const Dependency& dep, int packageId) const
+	{
+		const auto& package = GetPackage (packageId);
+		if (package.Name_ == dep.Name_ && IsVersionOk (package.Version_, dep.Version_))
+			return true;
+
+		return std::any_of (package.Provides_.begin (), package.Provides_.end (),
+				[&dep] (const Dependency& provided)
+				{
+					return provided.Name_ == dep.Name_ &&
+							IsVersionOk (provided.Version_, dep.Version_);
+				});
+	}
+
+	QList<int> PackageUniverse::GetFulfillers (const Dependency& dep) const
+	{
+		QList<int> result;
+		for (const auto id : Providers_.value (dep.Name_))
+			if (IsFulfilledBy (dep, id))
+				result << id;
+
+		std::stable_sort (result.begin (), result.end (),
+				[this] (int left, int right)
+				{
+					return IsVersionLess (Packages_ [right].Version_, Packages_ [left].Version_);
+				});
+		return result;
+	}
+}
+}
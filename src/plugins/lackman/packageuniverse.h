@@ -0,0 +1,86 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include "repoinfo.h"
+
+namespace LC
+{
+namespace LackMan
+{
+	/** @brief In-memory snapshot of all the known packages.
+	 *
+	 * The universe is built once from the storage and then queried by
+	 * the Resolver without touching the database.
+	 */
+	class PackageUniverse
+	{
+	public:
+		struct Package
+		{
+			int ID_;
+			QString Name_;
+			QString Version_;
+			DependencyList Requires_;
+			DependencyList Provides_;
+		};
+	private:
+		QHash<int, Package> Packages_;
+		QHash<QString, QList<int>> Providers_;
+		QHash<QString, QStringList> Installed_;
+	public:
+		PackageUniverse () = default;
+		PackageUniverse (const QList<Package>& packages,
+				const InstalledDependencyInfoList& installed);
+
+		bool Contains (int packageId) const;
+		const Package& GetPackage (int packageId) const;
+
+		/** @brief Checks whether the dependency is satisfied by an
+		 * already installed package.
+		 */
+		bool IsInstalled (const Dependency&) const;
+
+		/** @brief Checks whether the given package satisfies the
+		 * dependency, either by its own name or via a provided one.
+		 */
+		bool IsFulfilledBy (const Dependency&, int packageId) const;
+
+		/** @brief Returns the packages satisfying the dependency.
+		 *
+		 * The packages are ordered from the most preferable to the
+		 * least preferable one, that is, by descending version.
+		 */
+		QList<int> GetFulfillers (const Dependency&) const;
+	};
+}
+}
@@ -33,8 +33,8 @@
 #include <QTimer>
 #include <interfaces/core/icoreproxy.h>
 #include <interfaces/core/iiconthememanager.h>
-#include "deptreebuilder.h"
 #include "core.h"
+#include "resolver.h"
 
 namespace LC
 {
@@ -126,22 +126,32 @@ namespace LackMan
 
 	void PendingManager::EnablePackageInto (int id, PendingManager::Action action)
 	{
-		DepTreeBuilder builder (id);
-		if (!builder.IsFulfilled ())
+		QList<int> deps;
+		if (action != Action::Remove)
 		{
-			QStringList unful = builder.GetUnfulfilled ();
-			qWarning () << Q_FUNC_INFO
-					<< id
-					<< "isn't fulfilled, aborting:"
-					<< unful;
-			QString list = QString ("<ul><li>%1</li></ul>")
-					.arg (unful.join ("</li><li>"));
-			throw std::runtime_error (tr ("Package dependencies "
-					"could not be fulfilled: %1").arg (list)
-					.toUtf8 ().constData ());
+			// Resolve against the already scheduled packages, so that
+			// the pending actions stay consistent with each other.
+			Resolver resolver { Core::Instance ().GetPackageUniverse () };
+			for (const auto otherAction : { Action::Install, Action::Update })
+				for (const auto otherId : ScheduledForAction_ [otherAction])
+					for (const auto dep : Deps_.value (otherId))
+						resolver.Pin (dep);
+
+			const auto& result = resolver.Resolve ({ id });
+			if (result.IsLeft ())
+			{
+				const auto& conflict = result.GetLeft ();
+				qWarning () << Q_FUNC_INFO
+						<< id
+						<< "isn't fulfilled, aborting:"
+						<< conflict.Reason_;
+				throw std::runtime_error (tr ("Package dependencies "
+						"could not be fulfilled: %1").arg (ToHtml (conflict))
+						.toUtf8 ().constData ());
+			}
+
+			deps = result.GetRight ();
 		}
-
-		const auto& deps = builder.GetPackagesToInstall ();
 		Deps_ [id] = deps;
 
 		ScheduledForAction_ [action] << id;
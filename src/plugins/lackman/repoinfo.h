@@ -81,6 +81,11 @@ namespace LackMan
 		QString Name_;
 		QStringList Versions_;
 		QMap<QString, QString> VersionArchivers_;
+
+		/** Maps versions to the hex-encoded SHA-256 of their archives,
+			* for those versions the repository provides it for.
+			*/
+		QMap<QString, QByteArray> VersionChecksums_;
 	};
 
 	using PackageShortInfoList = QList<PackageShortInfo>;
@@ -182,6 +187,16 @@ namespace LackMan
 		void Dump () const;
 	};
 
+	/** A package description fetched for the given component.
+		*/
+	struct ComponentPackageInfo
+	{
+		PackageInfo Info_;
+		int ComponentId_;
+	};
+
+	using ComponentPackageInfoList = QList<ComponentPackageInfo>;
+
 	/** This contains those and only those fields which are
 		* displayed in the Packages list.
 		*/
@@ -202,10 +217,6 @@ namespace LackMan
 
 	bool operator== (const ListPackageInfo&, const ListPackageInfo&);
 
-	using Comparator_t = std::function<bool (const QString&, const QString&)>;
-
-	extern QMap<Dependency::Relation, Comparator_t> Relation2comparator;
-
 	/** Describes an installed dependency. Installed dependency may
 		* come either from system package manager of be installed
 		* by LackMan. Source enum is used to distinguish between
@@ -235,5 +246,6 @@ Q_DECLARE_METATYPE (LC::LackMan::RepoInfo)
 Q_DECLARE_METATYPE (LC::LackMan::PackageShortInfo)
 Q_DECLARE_METATYPE (LC::LackMan::PackageShortInfoList)
 Q_DECLARE_METATYPE (LC::LackMan::PackageInfo)
+Q_DECLARE_METATYPE (LC::LackMan::ComponentPackageInfoList)
 
 #endif
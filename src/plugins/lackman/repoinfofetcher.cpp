@@ -28,15 +28,17 @@
  **********************************************************************/
 
 #include "repoinfofetcher.h"
-#include <QTimer>
+#include <memory>
 #include <util/sll/either.h>
 #include <util/sll/overload.h>
 #include <util/sll/visitor.h>
 #include <util/sys/paths.h>
 #include <util/threads/futures.h>
 #include <util/xpc/util.h>
+#include <interfaces/core/icoreproxy.h>
 #include <interfaces/core/ientitymanager.h>
 #include "core.h"
+#include "fetchqueue.h"
 #include "xmlparsers.h"
 #include "lackmanutil.h"
 
@@ -44,50 +46,49 @@ namespace LC
 {
 namespace LackMan
 {
+	namespace
+	{
+		const int MaxParallelFetches = 6;
+
+		/** The fetched packages are passed to the storage in batches of
+		 * at most this size.
+		 */
+		const int PackagesBatchSize = 64;
+
+		QUrl GetComponentIndexURL (QUrl url)
+		{
+			if (!url.path ().endsWith ("/Packages.xml.gz"))
+				url.setPath (url.path () + "/Packages.xml.gz");
+			return url;
+		}
+	}
+
 	RepoInfoFetcher::RepoInfoFetcher (const ICoreProxy_ptr& proxy, QObject *parent)
 	: QObject { parent }
 	, Proxy_ { proxy }
+	, Cache_ { Util::GetUserDir (Util::UserDir::Cache, "lackman/index") }
+	, Queue_ { new FetchQueue { proxy->GetNetworkAccessManager (), &Cache_, MaxParallelFetches, this } }
 	{
 	}
 
 	namespace
 	{
-		template<typename SuccessF>
-		void FetchImpl (const QUrl& url, const ICoreProxy_ptr& proxy, QObject *object,
-				const QString& failureHeading, SuccessF&& successFun)
+		template<typename SuccessF, typename FailureF>
+		void FetchImpl (const QUrl& url, FetchQueue *queue, const ICoreProxy_ptr& proxy, QObject *object,
+				const QString& failureHeading, SuccessF&& successFun, FailureF&& failureFun)
 		{
-			const auto& location = Util::GetTemporaryName ("lackman_XXXXXX.gz");
-
-			const auto iem = proxy->GetEntityManager ();
-
-			const auto& e = Util::MakeEntity (url,
-					location,
-					Internal |
-						DoNotNotifyUser |
-						DoNotSaveInHistory |
-						NotPersistent |
-						DoNotAnnounceEntity);
-			const auto& result = iem->DelegateEntity (e);
-			if (!result)
-			{
-				iem->HandleEntity (Util::MakeNotification (RepoInfoFetcher::tr ("Error fetching repository"),
-						RepoInfoFetcher::tr ("Could not find any plugins to fetch %1.")
-							.arg ("<em>" + url.toString () + "</em>"),
-						Priority::Critical));
-				return;
-			}
-
-			Util::Sequence (object, result.DownloadResult_) >>
+			Util::Sequence (object, queue->Fetch (url)) >>
 					Util::Visitor
 					{
-						[successFun, location] (IDownload::Success) { successFun (location); },
-						[proxy, url, failureHeading, location] (const IDownload::Error&)
+						[successFun] (const FetchQueue::Fetched& fetched) { successFun (fetched); },
+						[proxy, url, failureHeading, failureFun] (const QString& error)
 						{
 							proxy->GetEntityManager ()->HandleEntity (Util::MakeNotification (failureHeading,
-									RepoInfoFetcher::tr ("Error downloading file from %1.")
-											.arg (url.toString ()),
+									RepoInfoFetcher::tr ("Error downloading file from %1: %2.")
+											.arg (url.toString ())
+											.arg (error),
 									Priority::Critical));
-							QFile::remove (location);
+							failureFun ();
 						}
 					};
 		}
@@ -105,38 +106,55 @@ namespace LackMan
 		QUrl baseUrl = url;
 		baseUrl.setPath (baseUrl.path ().remove ("/Repo.xml.gz"));
 
-		FetchImpl (url, Proxy_, this, tr ("Error fetching repository"),
-				[this, baseUrl] (const QString& location) { HandleRIFinished (location, baseUrl); });
+		FetchImpl (url, Queue_, Proxy_, this, tr ("Error fetching repository"),
+				[this, baseUrl] (const FetchQueue::Fetched& fetched) { HandleRIFinished (fetched.Data_, baseUrl); },
+				[] {});
 	}
 
-	void RepoInfoFetcher::FetchComponent (QUrl url, int repoId, const QString& component)
+	void RepoInfoFetcher::FetchComponent (QUrl url, int repoId, const QString& component, bool stored)
 	{
-		if (!url.path ().endsWith ("/Packages.xml.gz"))
-			url.setPath (url.path () + "/Packages.xml.gz");
+		url = GetComponentIndexURL (url);
 
-		FetchImpl (url, Proxy_, this, tr ("Error fetching component"),
-				[=] (const QString& location) { HandleComponentFinished (url, location, component, repoId); });
+		FetchImpl (url, Queue_, Proxy_, this, tr ("Error fetching component"),
+				[=] (const FetchQueue::Fetched& fetched)
+				{
+					if (stored && fetched.NotModified_)
+					{
+						qDebug () << Q_FUNC_INFO
+								<< "skipping not modified component"
+								<< component
+								<< "of"
+								<< repoId;
+						return;
+					}
+
+					HandleComponentFinished (url, fetched.Data_, component, repoId);
+				},
+				[] {});
 	}
 
 	void RepoInfoFetcher::ScheduleFetchPackageInfo (const QUrl& url,
 			const QString& name,
 			const QList<QString>& newVers,
-			int componentId)
+			int componentId,
+			const QUrl& componentUrl)
 	{
-		ScheduledPackageFetch f =
-		{
-			url,
-			name,
-			newVers,
-			componentId
-		};
-
-		if (ScheduledPackages_.isEmpty ())
-			QTimer::singleShot (0,
-					this,
-					SLOT (rotatePackageFetchQueue ()));
-
-		ScheduledPackages_ << f;
+		ComponentId2IndexURL_ [componentId] = GetComponentIndexURL (componentUrl);
+
+		++PendingPackageFetches_;
+		FetchPackageInfo (url, name, newVers, componentId);
+	}
+
+	void RepoInfoFetcher::InvalidateComponent (int componentId)
+	{
+		const auto& url = ComponentId2IndexURL_.value (componentId);
+		if (url.isEmpty ())
+			return;
+
+		qDebug () << Q_FUNC_INFO
+				<< "invalidating"
+				<< url;
+		Cache_.Remove (url);
 	}
 
 	void RepoInfoFetcher::FetchPackageInfo (const QUrl& baseUrl,
@@ -148,28 +166,21 @@ namespace LackMan
 		packageUrl.setPath (packageUrl.path () +
 				LackManUtil::NormalizePackageName (packageName) + ".xml.gz");
 
-		FetchImpl (packageUrl, Proxy_, this, tr ("Error fetching package info"),
-				[=] (const QString& location)
+		FetchImpl (packageUrl, Queue_, Proxy_, this, tr ("Error fetching package info"),
+				[=] (const FetchQueue::Fetched& fetched)
 				{
-					HandlePackageFinished ({ packageUrl, baseUrl, location, packageName, newVersions, componentId });
+					HandlePackageFinished ({ packageUrl, baseUrl, fetched.Data_, packageName, newVersions, componentId });
+				},
+				[=]
+				{
+					InvalidateComponent (componentId);
+					HandlePackageDone ();
 				});
 	}
 
-	void RepoInfoFetcher::rotatePackageFetchQueue ()
-	{
-		if (ScheduledPackages_.isEmpty ())
-			return;
-
-		const auto& f = ScheduledPackages_.takeFirst ();
-		FetchPackageInfo (f.BaseUrl_, f.PackageName_, f.NewVersions_, f.ComponentId_);
-
-		if (!ScheduledPackages_.isEmpty ())
-			QTimer::singleShot (50, this, SLOT (rotatePackageFetchQueue ()));
-	}
-
 	namespace
 	{
-		void HandleUnarchError (QProcess *proc, IEntityManager *iem, const QUrl& url, const QString& filename)
+		void HandleUnarchError (QProcess *proc, IEntityManager *iem, const QUrl& url)
 		{
 			proc->deleteLater ();
 
@@ -178,63 +189,86 @@ namespace LackMan
 			qWarning () << Q_FUNC_INFO
 					<< "unable to unpack for"
 					<< url
-					<< filename
 					<< "with"
 					<< error
 					<< proc->readAllStandardError ();
 			const auto& notification = Util::MakeNotification (RepoInfoFetcher::tr ("Component unpack error"),
-					RepoInfoFetcher::tr ("Unable to unpack file. Exit code: %1. Problematic file is at %2.")
+					RepoInfoFetcher::tr ("Unable to unpack file. Exit code: %1. Problematic file is %2.")
 						.arg (error)
-						.arg (filename),
+						.arg (url.toString ()),
 					Priority::Critical);
 			iem->HandleEntity (notification);
 		}
 
-		template<typename Handler>
+		template<typename Handler, typename FailureF>
 		void HandleUnarch (QObject *parent,
-				const ICoreProxy_ptr& proxy, const QUrl& url, const QString& location, Handler&& handler)
+				const ICoreProxy_ptr& proxy, const QUrl& url, const QByteArray& data,
+				Handler&& handler, FailureF&& failureFun)
 		{
 			auto iem = proxy->GetEntityManager ();
 
+			// a crashed process emits both errorOccurred() and finished()
+			const auto handled = std::make_shared<bool> (false);
+
 			auto unarch = new QProcess { parent };
 			QObject::connect (unarch,
 					Util::Overload<int, QProcess::ExitStatus> (&QProcess::finished),
 					parent,
-					[=] (int exitCode)
+					[=] (int exitCode, QProcess::ExitStatus status)
 					{
+						if (*handled)
+							return;
+						*handled = true;
+
 						unarch->deleteLater ();
 
+						if (status == QProcess::CrashExit)
+						{
+							HandleUnarchError (unarch, iem, url);
+							failureFun ();
+							return;
+						}
+
 						if (exitCode)
 						{
 							iem->HandleEntity (Util::MakeNotification (RepoInfoFetcher::tr ("Repository unpack error"),
 									RepoInfoFetcher::tr ("Unable to unpack the repository file. gunzip error: %1. "
-										"Problematic file is at %2.")
+										"Problematic file is %2.")
 											.arg (exitCode)
-											.arg (location),
+											.arg (url.toString ()),
 									Priority::Critical));
+							failureFun ();
 							return;
 						}
 
-						QFile::remove (location);
-
 						std::invoke (handler, unarch->readAllStandardOutput ());
 					});
 
 			QObject::connect (unarch,
 					&QProcess::errorOccurred,
-					[=] { HandleUnarchError (unarch, iem, url, location); });
+					[=]
+					{
+						if (*handled)
+							return;
+						*handled = true;
+
+						HandleUnarchError (unarch, iem, url);
+						failureFun ();
+					});
 
 #ifdef Q_OS_WIN32
-			unarch->start ("7za", { "e", "-so", location });
+			unarch->start ("7za", { "e", "-tgzip", "-si", "-so" });
 #else
-			unarch->start ("gunzip", { "-c", location });
+			unarch->start ("gunzip", { "-c" });
 #endif
+			unarch->write (data);
+			unarch->closeWriteChannel ();
 		}
 	}
 
-	void RepoInfoFetcher::HandleRIFinished (const QString& location, const QUrl& url)
+	void RepoInfoFetcher::HandleRIFinished (const QByteArray& gzipped, const QUrl& url)
 	{
-		HandleUnarch (this, Proxy_, url, location,
+		HandleUnarch (this, Proxy_, url, gzipped,
 				[=] (const QByteArray& data)
 				{
 					try
@@ -250,13 +284,14 @@ namespace LackMan
 										.arg (error),
 								Priority::Critical));
 					}
-				});
+				},
+				[] {});
 	}
 
 	void RepoInfoFetcher::HandleComponentFinished (const QUrl& url,
-			const QString& location, const QString& component, int repoId)
+			const QByteArray& gzipped, const QString& component, int repoId)
 	{
-		HandleUnarch (this, Proxy_, url, location,
+		HandleUnarch (this, Proxy_, url, gzipped,
 				[=] (const QByteArray& data)
 				{
 					try
@@ -272,17 +307,21 @@ namespace LackMan
 										.arg (component),
 								Priority::Critical));
 					}
-				});
+				},
+				[] {});
 	}
 
 	void RepoInfoFetcher::HandlePackageFinished (const PendingPackage& pp)
 	{
-		HandleUnarch (this, Proxy_, pp.URL_, pp.Location_,
+		HandleUnarch (this, Proxy_, pp.URL_, pp.Data_,
 				[=] (const QByteArray& data)
 				{
 					try
 					{
-						emit packageFetched (ParsePackage (data, pp.BaseURL_, pp.PackageName_, pp.NewVersions_), pp.ComponentId_);
+						FetchedPackages_.append ({
+									ParsePackage (data, pp.BaseURL_, pp.PackageName_, pp.NewVersions_),
+									pp.ComponentId_
+								});
 					}
 					catch (const std::exception& e)
 					{
@@ -291,8 +330,33 @@ namespace LackMan
 						Proxy_->GetEntityManager ()->HandleEntity (Util::MakeNotification (tr ("Package parse error"),
 								tr ("Unable to parse package description file."),
 								Priority::Critical));
+						InvalidateComponent (pp.ComponentId_);
 					}
+
+					HandlePackageDone ();
+				},
+				[=]
+				{
+					InvalidateComponent (pp.ComponentId_);
+					HandlePackageDone ();
 				});
 	}
+
+	void RepoInfoFetcher::HandlePackageDone ()
+	{
+		--PendingPackageFetches_;
+
+		if (!PendingPackageFetches_ || FetchedPackages_.size () >= PackagesBatchSize)
+			FlushFetchedPackages ();
+	}
+
+	void RepoInfoFetcher::FlushFetchedPackages ()
+	{
+		if (FetchedPackages_.isEmpty ())
+			return;
+
+		emit packagesFetched (FetchedPackages_);
+		FetchedPackages_.clear ();
+	}
 }
 }
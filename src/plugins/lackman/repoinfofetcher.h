@@ -33,35 +33,35 @@
 #include <QUrl>
 #include <QProcess>
 #include <QHash>
-#include <interfaces/idownload.h>
 #include <interfaces/core/icoreproxyfwd.h>
 #include "repoinfo.h"
+#include "indexcache.h"
 
 namespace LC
 {
 namespace LackMan
 {
+	class FetchQueue;
+
 	class RepoInfoFetcher : public QObject
 	{
 		Q_OBJECT
 
 		const ICoreProxy_ptr Proxy_;
 
-		struct ScheduledPackageFetch
-		{
-			QUrl BaseUrl_;
-			QString PackageName_;
-			QList<QString> NewVersions_;
-			int ComponentId_;
-		};
-		QList<ScheduledPackageFetch> ScheduledPackages_;
+		IndexCache Cache_;
+		FetchQueue * const Queue_;
+
+		int PendingPackageFetches_ = 0;
+		ComponentPackageInfoList FetchedPackages_;
 
+		QHash<int, QUrl> ComponentId2IndexURL_;
 	public:
 		struct PendingPackage
 		{
 			QUrl URL_;
 			QUrl BaseURL_;
-			QString Location_;
+			QByteArray Data_;
 			QString PackageName_;
 			QList<QString> NewVersions_;
 			int ComponentId_;
@@ -70,27 +70,39 @@ namespace LackMan
 		RepoInfoFetcher (const ICoreProxy_ptr& proxy, QObject*);
 
 		void FetchFor (QUrl);
-		void FetchComponent (QUrl, int, const QString& component);
+		/** If the component is \em stored already and its index hasn't
+		 * been modified since the last fetch, it is not parsed again
+		 * and componentFetched() is not emitted.
+		 */
+		void FetchComponent (QUrl, int, const QString& component, bool stored);
 		void ScheduleFetchPackageInfo (const QUrl& url,
 				const QString& name,
 				const QList<QString>& newVers,
-				int componentId);
+				int componentId,
+				const QUrl& componentUrl);
+
+		/** Drops the cached index of the given component, so that it is
+		 * parsed again during the next update even if it hasn't been
+		 * modified. This is needed if some of its packages failed to be
+		 * fetched or stored.
+		 */
+		void InvalidateComponent (int componentId);
 	private:
 		void FetchPackageInfo (const QUrl& url,
 				const QString& name,
 				const QList<QString>& newVers,
 				int componentId);
 
-		void HandleRIFinished (const QString&, const QUrl&);
-		void HandleComponentFinished (const QUrl&, const QString&, const QString&, int);
+		void HandleRIFinished (const QByteArray&, const QUrl&);
+		void HandleComponentFinished (const QUrl&, const QByteArray&, const QString&, int);
 		void HandlePackageFinished (const PendingPackage&);
-	private slots:
-		void rotatePackageFetchQueue ();
+		void HandlePackageDone ();
+		void FlushFetchedPackages ();
 	signals:
 		void infoFetched (const RepoInfo&);
 		void componentFetched (const PackageShortInfoList& packages,
 				const QString& component, int repoId);
-		void packageFetched (const PackageInfo&, int componentId);
+		void packagesFetched (const ComponentPackageInfoList&);
 	};
 }
 }
@@ -0,0 +1,264 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "resolver.h"
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <QHash>
+#include "packageuniverse.h"
+
+namespace LC
+{
+namespace LackMan
+{
+	namespace
+	{
+		/** Bounds the backtracking on pathological package sets.
+		 */
+		const int MaxSteps = 100000;
+
+		struct Goal
+		{
+			Dependency Dep_;
+			int RequiredBy_;
+		};
+
+		struct State
+		{
+			QHash<QString, int> ChosenByName_;
+			QList<int> Chosen_;
+		};
+
+		class Solver
+		{
+			const PackageUniverse& U_;
+			int StepsLeft_ = MaxSteps;
+		public:
+			explicit Solver (const PackageUniverse& u)
+			: U_ { u }
+			{
+			}
+
+			bool IsExhausted () const
+			{
+				return StepsLeft_ <= 0;
+			}
+
+			std::optional<ResolveConflict> Select (State& state, int id, QList<Goal>& agenda)
+			{
+				const auto& package = U_.GetPackage (id);
+				const auto pos = state.ChosenByName_.find (package.Name_);
+				if (pos != state.ChosenByName_.end ())
+				{
+					if (*pos == id)
+						return {};
+
+					return ResolveConflict
+					{
+						Resolver::tr ("%1 conflicts with %2, which is already selected.")
+								.arg (Describe (id))
+								.arg (Describe (*pos)),
+						{}
+					};
+				}
+
+				state.ChosenByName_ [package.Name_] = id;
+				state.Chosen_ << id;
+				for (const auto& dep : package.Requires_)
+					agenda.append ({ dep, id });
+				return {};
+			}
+
+			std::optional<ResolveConflict> Solve (State& state, QList<Goal> agenda)
+			{
+				while (!agenda.isEmpty ())
+				{
+					if (--StepsLeft_ <= 0)
+						return ResolveConflict { {}, {} };
+
+					const auto goal = agenda.takeFirst ();
+					if (U_.IsInstalled (goal.Dep_) || IsSatisfied (state, goal.Dep_))
+						continue;
+
+					const auto& requirement = Resolver::tr ("%1 requires %2")
+							.arg (Describe (goal.RequiredBy_))
+							.arg (Describe (goal.Dep_));
+
+					const auto& candidates = U_.GetFulfillers (goal.Dep_);
+					if (candidates.isEmpty ())
+						return ResolveConflict
+						{
+							Resolver::tr ("%1, but no package provides it.").arg (requirement),
+							{}
+						};
+
+					ResolveConflict conflict
+					{
+						Resolver::tr ("%1, but none of its candidates can be installed:").arg (requirement),
+						{}
+					};
+					for (const auto candidate : candidates)
+					{
+						auto nextState = state;
+						auto nextAgenda = agenda;
+						auto failure = Select (nextState, candidate, nextAgenda);
+						if (!failure)
+							failure = Solve (nextState, nextAgenda);
+
+						if (!failure)
+						{
+							state = nextState;
+							return {};
+						}
+
+						if (IsExhausted ())
+							return failure;
+
+						conflict.Causes_ << *failure;
+					}
+					return conflict;
+				}
+
+				return {};
+			}
+
+			Resolver::Plan_t MakePlan (const State& state, const QList<int>& pinned) const
+			{
+				Resolver::Plan_t plan;
+				QSet<int> visited;
+
+				std::function<void (int)> visit = [&] (int id)
+				{
+					if (visited.contains (id))
+						return;
+					visited << id;
+
+					for (const auto& dep : U_.GetPackage (id).Requires_)
+					{
+						if (U_.IsInstalled (dep))
+							continue;
+
+						for (const auto other : state.Chosen_)
+							if (other != id && U_.IsFulfilledBy (dep, other))
+							{
+								visit (other);
+								break;
+							}
+					}
+
+					if (!pinned.contains (id))
+						plan << id;
+				};
+
+				for (const auto id : state.Chosen_)
+					visit (id);
+
+				return plan;
+			}
+		private:
+			bool IsSatisfied (const State& state, const Dependency& dep) const
+			{
+				return std::any_of (state.Chosen_.begin (), state.Chosen_.end (),
+						[this, &dep] (int id) { return U_.IsFulfilledBy (dep, id); });
+			}
+
+			QString Describe (int id) const
+			{
+				const auto& package = U_.GetPackage (id);
+				return package.Name_ + ' ' + package.Version_;
+			}
+
+			QString Describe (const Dependency& dep) const
+			{
+				return dep.Version_.isEmpty () ?
+						dep.Name_ :
+						dep.Name_ + ' ' + dep.Version_;
+			}
+		};
+	}
+
+	Resolver::Resolver (const PackageUniverse& universe)
+	: Universe_ { universe }
+	{
+	}
+
+	void Resolver::Pin (int packageId)
+	{
+		if (!Pinned_.contains (packageId))
+			Pinned_ << packageId;
+	}
+
+	Resolver::Result_t Resolver::Resolve (const QList<int>& requested) const
+	{
+		Solver solver { Universe_ };
+
+		State state;
+		QList<Goal> agenda;
+
+		for (const auto id : Pinned_)
+			if (Universe_.Contains (id))
+			{
+				state.ChosenByName_ [Universe_.GetPackage (id).Name_] = id;
+				state.Chosen_ << id;
+			}
+
+		for (const auto id : requested)
+		{
+			if (!Universe_.Contains (id))
+				return Result_t::Left ({ tr ("Unknown package %1.").arg (id), {} });
+
+			if (const auto failure = solver.Select (state, id, agenda))
+				return Result_t::Left (*failure);
+		}
+
+		if (const auto failure = solver.Solve (state, agenda))
+		{
+			if (solver.IsExhausted ())
+				return Result_t::Left ({ tr ("The dependencies are too complex to be resolved."), {} });
+			return Result_t::Left (*failure);
+		}
+
+		return Result_t::Right (solver.MakePlan (state, Pinned_));
+	}
+
+	QString ToHtml (const ResolveConflict& conflict)
+	{
+		auto result = conflict.Reason_.toHtmlEscaped ();
+		if (!conflict.Causes_.isEmpty ())
+		{
+			result += "<ul>";
+			for (const auto& cause : conflict.Causes_)
+				result += "<li>" + ToHtml (cause) + "</li>";
+			result += "</ul>";
+		}
+		return result;
+	}
+}
+}
@@ -0,0 +1,100 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QCoreApplication>
+#include <QList>
+#include <QSet>
+#include <util/sll/either.h>
+#include "repoinfo.h"
+
+namespace LC
+{
+namespace LackMan
+{
+	class PackageUniverse;
+
+	/** @brief Explains why a package could not be resolved.
+	 *
+	 * Each conflict may be caused by several other conflicts, one for
+	 * each alternative that has been tried.
+	 */
+	struct ResolveConflict
+	{
+		QString Reason_;
+		QList<ResolveConflict> Causes_;
+	};
+
+	/** @brief Computes the packages to install along with the
+	 * requested ones.
+	 *
+	 * The resolver works on an in-memory PackageUniverse. It picks at
+	 * most one version of each package, preferring the already
+	 * installed or already selected packages and then the most recent
+	 * versions, and backtracks when a choice leads to a conflict.
+	 */
+	class Resolver
+	{
+		Q_DECLARE_TR_FUNCTIONS (LC::LackMan::Resolver)
+
+		const PackageUniverse& Universe_;
+		QList<int> Pinned_;
+	public:
+		/** Package IDs in the installation order: each package comes
+		 * after all the packages it depends on.
+		 */
+		using Plan_t = QList<int>;
+		using Result_t = Util::Either<ResolveConflict, Plan_t>;
+
+		explicit Resolver (const PackageUniverse&);
+
+		/** @brief Marks the package as already selected.
+		 *
+		 * Pinned packages satisfy dependencies and constrain the
+		 * versions of other packages, but are never included in the
+		 * resulting plan. This is used to resolve a package against the
+		 * set of the already pending ones.
+		 */
+		void Pin (int packageId);
+
+		/** @brief Resolves the given packages.
+		 *
+		 * @param[in] requested The packages to install or update to.
+		 * @return Either the installation plan including the requested
+		 * packages or the explanation of the failure.
+		 */
+		Result_t Resolve (const QList<int>& requested) const;
+	};
+
+	/** @brief Formats the conflict as a nested HTML list.
+	 */
+	QString ToHtml (const ResolveConflict&);
+}
+}
@@ -0,0 +1,4 @@
+CREATE TABLE packagechecksums (
+	package_id INTEGER PRIMARY KEY,
+	sha256 VARCHAR(64) NOT NULL
+);
@@ -470,6 +470,17 @@ namespace LackMan
 		info.VersionArchivers_ [version] = QueryGetPackageArchiver_.next () ?
 				QueryGetPackageArchiver_.value (0).toString () :
 				"gz";
+		QueryGetPackageArchiver_.finish ();
+
+		QueryGetPackageChecksum_.bindValue (":package_id", packageId);
+		if (!QueryGetPackageChecksum_.exec ())
+		{
+			Util::DBLock::DumpError (QueryGetPackageChecksum_);
+			throw std::runtime_error ("checksum query execution failed");
+		}
+		if (QueryGetPackageChecksum_.next ())
+			info.VersionChecksums_ [version] = QueryGetPackageChecksum_.value (0).toByteArray ();
+		QueryGetPackageChecksum_.finish ();
 
 		return info;
 	}
@@ -530,6 +541,13 @@ namespace LackMan
 			throw std::runtime_error ("Query execution failed");
 		}
 
+		QueryRemovePackageChecksum_.bindValue (":package_id", packageId);
+		if (!QueryRemovePackageChecksum_.exec ())
+		{
+			Util::DBLock::DumpError (QueryRemovePackageChecksum_);
+			throw std::runtime_error ("Query execution failed");
+		}
+
 		QSqlQuery others (DB_);
 		others.prepare ("SELECT COUNT(1) FROM packages WHERE name = :name;");
 		others.bindValue (":name", name);
@@ -623,6 +641,14 @@ namespace LackMan
 					pInfo.VersionArchivers_.value (version, "gz"));
 			Exec (QueryAddPackageArchiver_);
 
+			const auto& checksum = pInfo.VersionChecksums_.value (version);
+			if (!checksum.isEmpty ())
+			{
+				QueryAddPackageChecksum_.bindValue (":package_id", packageId);
+				QueryAddPackageChecksum_.bindValue (":sha256", QString::fromLatin1 (checksum));
+				Exec (QueryAddPackageChecksum_);
+			}
+
 			const qint64 size = pInfo.PackageSizes_.value (version, -1);
 			if (size == -1)
 				continue;
@@ -634,6 +660,7 @@ namespace LackMan
 		QueryAddPackage_.finish ();
 		QueryAddPackageSize_.finish ();
 		QueryAddPackageArchiver_.finish ();
+		QueryAddPackageChecksum_.finish ();
 
 		QueryClearPackageInfos_.bindValue (":name", pInfo.Name_);
 		Exec (QueryClearPackageInfos_);
@@ -724,6 +751,36 @@ namespace LackMan
 		lock.Good ();
 	}
 
+	void Storage::AddPackages (const ComponentPackageInfoList& infos)
+	{
+		Util::DBLock lock (DB_);
+		try
+		{
+			lock.Init ();
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< e.what ()
+					<< "while acquiring lock";
+			throw;
+		}
+
+		for (const auto& info : infos)
+		{
+			AddPackages (info.Info_);
+
+			for (const auto& version : info.Info_.Versions_)
+			{
+				const int packageId = FindPackage (info.Info_.Name_, version);
+				if (!HasLocation (packageId, info.ComponentId_))
+					AddLocation (packageId, info.ComponentId_);
+			}
+		}
+
+		lock.Good ();
+	}
+
 	QMap<int, QList<QString>> Storage::GetPackageLocations (int packageId)
 	{
 		QueryGetPackageLocations_.bindValue (":package_id", packageId);
@@ -951,6 +1008,69 @@ namespace LackMan
 		return result;
 	}
 
+	QList<PackageUniverse::Package> Storage::GetAllPackagesWithDeps ()
+	{
+		QSqlQuery packagesQuery (DB_);
+		if (!packagesQuery.exec ("SELECT package_id, name, version FROM packages;"))
+		{
+			Util::DBLock::DumpError (packagesQuery);
+			throw std::runtime_error ("Query execution failed");
+		}
+
+		QHash<int, PackageUniverse::Package> packages;
+		while (packagesQuery.next ())
+		{
+			const auto id = packagesQuery.value (0).toInt ();
+			packages [id] =
+			{
+				id,
+				packagesQuery.value (1).toString (),
+				packagesQuery.value (2).toString (),
+				{},
+				{}
+			};
+		}
+
+		QSqlQuery depsQuery (DB_);
+		if (!depsQuery.exec ("SELECT package_id, name, version, type FROM deps;"))
+		{
+			Util::DBLock::DumpError (depsQuery);
+			throw std::runtime_error ("Query execution failed");
+		}
+
+		while (depsQuery.next ())
+		{
+			const auto pos = packages.find (depsQuery.value (0).toInt ());
+			if (pos == packages.end ())
+				continue;
+
+			const Dependency dep
+			{
+				static_cast<Dependency::Type> (depsQuery.value (3).toInt ()),
+				depsQuery.value (1).toString (),
+				depsQuery.value (2).toString ()
+			};
+			switch (dep.Type_)
+			{
+			case Dependency::TRequires:
+				pos->Requires_ << dep;
+				break;
+			case Dependency::TProvides:
+				pos->Provides_ << dep;
+				break;
+			default:
+				qWarning () << Q_FUNC_INFO
+						<< "unknown dependency type"
+						<< dep.Type_
+						<< "for"
+						<< pos->Name_;
+				break;
+			}
+		}
+
+		return packages.values ();
+	}
+
 	QStringList Storage::GetPackageTags (int packageId)
 	{
 		QueryGetPackageTags_.bindValue (":package_id", packageId);
@@ -1075,6 +1195,7 @@ namespace LackMan
 			"packages",
 			"packagesizes",
 			"packagearchivers",
+			"packagechecksums",
 			"deps",
 			"infos",
 			"locations",
@@ -1168,6 +1289,16 @@ namespace LackMan
 		QueryRemovePackageArchiver_ = QSqlQuery (DB_);
 		QueryRemovePackageArchiver_.prepare ("DELETE FROM packagearchivers WHERE package_id = :package_id;");
 
+		QueryAddPackageChecksum_ = QSqlQuery (DB_);
+		QueryAddPackageChecksum_.prepare ("INSERT INTO packagechecksums (package_id, sha256) "
+				"VALUES (:package_id, :sha256);");
+
+		QueryGetPackageChecksum_ = QSqlQuery (DB_);
+		QueryGetPackageChecksum_.prepare ("SELECT sha256 FROM packagechecksums WHERE package_id = :package_id;");
+
+		QueryRemovePackageChecksum_ = QSqlQuery (DB_);
+		QueryRemovePackageChecksum_.prepare ("DELETE FROM packagechecksums WHERE package_id = :package_id;");
+
 		QueryHasLocation_ = QSqlQuery (DB_);
 		QueryHasLocation_.prepare ("SELECT COUNT (package_id) "
 				"FROM locations WHERE package_id = :package_id AND component_id = :component_id;");
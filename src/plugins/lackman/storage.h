@@ -33,6 +33,7 @@
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include "repoinfo.h"
+#include "packageuniverse.h"
 
 class QUrl;
 
@@ -69,6 +70,9 @@ namespace LackMan
 		QSqlQuery QueryAddPackageArchiver_;
 		QSqlQuery QueryGetPackageArchiver_;
 		QSqlQuery QueryRemovePackageArchiver_;
+		QSqlQuery QueryAddPackageChecksum_;
+		QSqlQuery QueryGetPackageChecksum_;
+		QSqlQuery QueryRemovePackageChecksum_;
 		QSqlQuery QueryHasLocation_;
 		QSqlQuery QueryAddLocation_;
 		QSqlQuery QueryRemovePackageFromLocation_;
@@ -118,6 +122,11 @@ namespace LackMan
 		void RemovePackage (int packageId);
 		void AddPackages (const PackageInfo&);
 
+		/** Adds the packages along with their locations in a single
+		 * transaction, so either all of them are added or none.
+		 */
+		void AddPackages (const ComponentPackageInfoList&);
+
 		QMap<int, QList<QString>> GetPackageLocations (int);
 		QList<int> GetPackagesInComponent (int);
 		QMap<QString, QList<ListPackageInfo>> GetListPackageInfos ();
@@ -126,6 +135,11 @@ namespace LackMan
 		DependencyList GetDependencies (int);
 		QList<ListPackageInfo> GetFulfillers (const Dependency&);
 
+		/** Returns all the known packages along with their
+		 * dependencies, fetched in two queries.
+		 */
+		QList<PackageUniverse::Package> GetAllPackagesWithDeps ();
+
 		QStringList GetPackageTags (int);
 		QStringList GetAllTags ();
 
@@ -0,0 +1,267 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "fetchqueuetest.h"
+#include <memory>
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QNetworkAccessManager>
+#include <util/sll/either.h>
+#include "fetchqueue.h"
+#include "indexcache.h"
+
+QTEST_GUILESS_MAIN (LC::LackMan::FetchQueueTest)
+
+namespace LC
+{
+namespace LackMan
+{
+	namespace
+	{
+		/** Serves a static repository directory over HTTP, with ETags
+		 * derived from the file contents.
+		 */
+		class StaticServer
+		{
+			QTcpServer Server_;
+			const QDir Root_;
+		public:
+			int Requests_ = 0;
+			int NotModified_ = 0;
+			int Running_ = 0;
+			int MaxRunning_ = 0;
+
+			explicit StaticServer (const QDir& root)
+			: Root_ { root }
+			{
+				QObject::connect (&Server_,
+						&QTcpServer::newConnection,
+						[this]
+						{
+							while (const auto socket = Server_.nextPendingConnection ())
+								HandleConnection (socket);
+						});
+				Server_.listen (QHostAddress::LocalHost);
+			}
+
+			QUrl GetUrl (const QString& path) const
+			{
+				return QUrl { QString ("http://127.0.0.1:%1/%2").arg (Server_.serverPort ()).arg (path) };
+			}
+		private:
+			void HandleConnection (QTcpSocket *socket)
+			{
+				auto buffer = std::make_shared<QByteArray> ();
+				QObject::connect (socket,
+						&QTcpSocket::readyRead,
+						[this, socket, buffer]
+						{
+							*buffer += socket->readAll ();
+							const auto headersEnd = buffer->indexOf ("\r\n\r\n");
+							if (headersEnd < 0)
+								return;
+
+							++Requests_;
+							MaxRunning_ = std::max (MaxRunning_, ++Running_);
+
+							// delay the response a bit so that the requests overlap
+							const auto& lines = buffer->left (headersEnd).split ('\n');
+							buffer->clear ();
+							QTimer::singleShot (50, socket,
+									[this, socket, lines]
+									{
+										--Running_;
+										Respond (socket, lines);
+									});
+						});
+				QObject::connect (socket,
+						&QTcpSocket::disconnected,
+						socket,
+						&QObject::deleteLater);
+			}
+
+			void Respond (QTcpSocket *socket, const QList<QByteArray>& lines)
+			{
+				const auto& path = lines.value (0).split (' ').value (1);
+				QByteArray ifNoneMatch;
+				for (const auto& line : lines)
+					if (line.toLower ().startsWith ("if-none-match:"))
+						ifNoneMatch = line.mid (line.indexOf (':') + 1).trimmed ();
+
+				QFile file { Root_.filePath (QString::fromUtf8 (path.mid (1))) };
+				if (!file.open (QIODevice::ReadOnly))
+				{
+					socket->write ("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+					socket->disconnectFromHost ();
+					return;
+				}
+
+				const auto& data = file.readAll ();
+				const auto& etag = '"' + QCryptographicHash::hash (data, QCryptographicHash::Md5).toHex () + '"';
+				if (ifNoneMatch == etag)
+				{
+					++NotModified_;
+					socket->write ("HTTP/1.1 304 Not Modified\r\nETag: " + etag + "\r\nConnection: close\r\n\r\n");
+					socket->disconnectFromHost ();
+					return;
+				}
+
+				socket->write ("HTTP/1.1 200 OK\r\n");
+				socket->write ("ETag: " + etag + "\r\n");
+				socket->write ("Content-Length: " + QByteArray::number (data.size ()) + "\r\n");
+				socket->write ("Connection: close\r\n\r\n");
+				socket->write (data);
+				socket->disconnectFromHost ();
+			}
+		};
+
+		void WriteFile (const QDir& dir, const QString& name, const QByteArray& data)
+		{
+			dir.mkpath (QFileInfo { dir.filePath (name) }.path ());
+
+			QFile file { dir.filePath (name) };
+			QVERIFY (file.open (QIODevice::WriteOnly));
+			file.write (data);
+		}
+
+		void MakeRepo (const QDir& dir, int packagesCount)
+		{
+			WriteFile (dir, "Repo.xml.gz", "repo");
+			WriteFile (dir, "dists/main/all/Packages.xml.gz", "packages");
+			for (int i = 0; i < packagesCount; ++i)
+				WriteFile (dir, QString ("dists/main/all/pkg%1/pkg%1.xml.gz").arg (i),
+						"package " + QByteArray::number (i));
+		}
+
+		FetchQueue::Result_t Wait (const QFuture<FetchQueue::Result_t>& future)
+		{
+			QFutureWatcher<FetchQueue::Result_t> watcher;
+			QSignalSpy spy { &watcher, &QFutureWatcherBase::finished };
+			watcher.setFuture (future);
+			if (!future.isFinished ())
+				spy.wait (5000);
+			return future.result ();
+		}
+
+		QByteArray GetData (const FetchQueue::Result_t& result)
+		{
+			return result.IsRight () ? result.GetRight ().Data_ : QByteArray {};
+		}
+
+		bool IsNotModified (const FetchQueue::Result_t& result)
+		{
+			return result.IsRight () && result.GetRight ().NotModified_;
+		}
+	}
+
+	void FetchQueueTest::testLocalDirectory ()
+	{
+		QTemporaryDir repoDir;
+		MakeRepo (repoDir.path (), 3);
+
+		QNetworkAccessManager nam;
+		FetchQueue queue { &nam, nullptr, 2 };
+
+		const auto& result = Wait (queue.Fetch (QUrl::fromLocalFile (repoDir.filePath ("dists/main/all/pkg1/pkg1.xml.gz"))));
+		QCOMPARE (GetData (result), QByteArray { "package 1" });
+		QVERIFY (!IsNotModified (result));
+	}
+
+	void FetchQueueTest::testConnectionLimit ()
+	{
+		QTemporaryDir repoDir;
+		MakeRepo (repoDir.path (), 20);
+		StaticServer server { repoDir.path () };
+
+		QNetworkAccessManager nam;
+		FetchQueue queue { &nam, nullptr, 4 };
+
+		QList<QFuture<FetchQueue::Result_t>> futures;
+		for (int i = 0; i < 20; ++i)
+			futures << queue.Fetch (server.GetUrl (QString ("dists/main/all/pkg%1/pkg%1.xml.gz").arg (i)));
+
+		QCOMPARE (queue.GetRunningCount (), 4);
+		QCOMPARE (queue.GetQueuedCount (), 16);
+
+		for (int i = 0; i < futures.size (); ++i)
+			QCOMPARE (GetData (Wait (futures.at (i))), "package " + QByteArray::number (i));
+
+		QCOMPARE (server.Requests_, 20);
+		QVERIFY (server.MaxRunning_ > 1);
+		QVERIFY (server.MaxRunning_ <= 4);
+	}
+
+	void FetchQueueTest::testConditionalRequests ()
+	{
+		QTemporaryDir repoDir;
+		MakeRepo (repoDir.path (), 0);
+		StaticServer server { repoDir.path () };
+
+		QTemporaryDir cacheDir;
+		IndexCache cache { QDir { cacheDir.path () } };
+
+		QNetworkAccessManager nam;
+		FetchQueue queue { &nam, &cache, 4 };
+
+		const auto& url = server.GetUrl ("dists/main/all/Packages.xml.gz");
+
+		const auto& first = Wait (queue.Fetch (url));
+		QCOMPARE (GetData (first), QByteArray { "packages" });
+		QVERIFY (!IsNotModified (first));
+		QVERIFY (cache.Get (url));
+
+		const auto& second = Wait (queue.Fetch (url));
+		QCOMPARE (GetData (second), QByteArray { "packages" });
+		QVERIFY (IsNotModified (second));
+		QCOMPARE (server.NotModified_, 1);
+
+		WriteFile (repoDir.path (), "dists/main/all/Packages.xml.gz", "updated packages");
+
+		const auto& third = Wait (queue.Fetch (url));
+		QCOMPARE (GetData (third), QByteArray { "updated packages" });
+		QVERIFY (!IsNotModified (third));
+		QCOMPARE (cache.Get (url)->Data_, QByteArray { "updated packages" });
+	}
+
+	void FetchQueueTest::testMissingFile ()
+	{
+		QTemporaryDir repoDir;
+		MakeRepo (repoDir.path (), 0);
+		StaticServer server { repoDir.path () };
+
+		QNetworkAccessManager nam;
+		FetchQueue queue { &nam, nullptr, 4 };
+
+		QVERIFY (Wait (queue.Fetch (server.GetUrl ("nonexistent.xml.gz"))).IsLeft ());
+		QCOMPARE (queue.GetRunningCount (), 0);
+	}
+}
+}
@@ -0,0 +1,303 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "packageextractortest.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QCryptographicHash>
+#include <archive.h>
+#include <archive_entry.h>
+#include "packageextractor.h"
+
+QTEST_GUILESS_MAIN (LC::LackMan::PackageExtractorTest)
+
+namespace LC
+{
+namespace LackMan
+{
+	namespace
+	{
+		using Entries_t = QList<QPair<QString, QByteArray>>;
+
+		/** Creates a gzipped tarball with the given entries, the names
+		 * ending with a slash denoting directories, and the names
+		 * starting with an @ denoting symbolic links to the contents.
+		 */
+		QString MakeArchive (const QDir& dir, const Entries_t& entries, int fileMode = 0644)
+		{
+			const auto& path = dir.filePath ("package.tar.gz");
+
+			const auto arch = archive_write_new ();
+			archive_write_add_filter_gzip (arch);
+			archive_write_set_format_pax_restricted (arch);
+			archive_write_open_filename (arch, path.toUtf8 ().constData ());
+
+			for (const auto& pair : entries)
+			{
+				const auto entry = archive_entry_new ();
+				if (pair.first.startsWith ('@'))
+				{
+					archive_entry_set_pathname (entry, pair.first.mid (1).toUtf8 ().constData ());
+					archive_entry_set_filetype (entry, AE_IFLNK);
+					archive_entry_set_perm (entry, 0777);
+					archive_entry_set_symlink (entry, pair.second.constData ());
+					archive_write_header (arch, entry);
+					archive_entry_free (entry);
+					continue;
+				}
+
+				archive_entry_set_pathname (entry, pair.first.toUtf8 ().constData ());
+				if (pair.first.endsWith ('/'))
+				{
+					archive_entry_set_filetype (entry, AE_IFDIR);
+					archive_entry_set_perm (entry, 0755);
+				}
+				else
+				{
+					archive_entry_set_filetype (entry, AE_IFREG);
+					archive_entry_set_perm (entry, fileMode);
+					archive_entry_set_size (entry, pair.second.size ());
+				}
+				archive_write_header (arch, entry);
+				archive_write_data (arch, pair.second.constData (), pair.second.size ());
+				archive_entry_free (entry);
+			}
+
+			archive_write_close (arch);
+			archive_write_free (arch);
+			return path;
+		}
+
+		QByteArray ReadFile (const QDir& dir, const QString& name)
+		{
+			QFile file { dir.filePath (name) };
+			if (!file.open (QIODevice::ReadOnly))
+				return {};
+			return file.readAll ();
+		}
+
+		QByteArray GetSha256 (const QString& path)
+		{
+			QFile file { path };
+			file.open (QIODevice::ReadOnly);
+			return QCryptographicHash::hash (file.readAll (), QCryptographicHash::Sha256).toHex ();
+		}
+
+		QStringList ListAll (const QDir& dir)
+		{
+			QStringList result;
+			QDirIterator it { dir.path (), QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden, QDirIterator::Subdirectories };
+			while (it.hasNext ())
+				result << dir.relativeFilePath (it.next ());
+			result.sort ();
+			return result;
+		}
+
+		const Entries_t DefaultEntries
+		{
+			{ "share/", {} },
+			{ "share/plugin/", {} },
+			{ "share/plugin/init.py", "print ('hello')" },
+			{ "share/plugin/data.txt", "some data" }
+		};
+	}
+
+	void PackageExtractorTest::testExtractAndCommit ()
+	{
+		QTemporaryDir archiveDir;
+		QTemporaryDir targetDir;
+		const QDir target { targetDir.path () };
+
+		const auto& path = MakeArchive (archiveDir.path (), DefaultEntries);
+
+		const auto& result = ExtractPackage (path, GetSha256 (path), target);
+		QVERIFY (result.IsRight ());
+
+		const auto& extracted = result.GetRight ();
+		QCOMPARE (extracted.Entries_,
+				(QStringList { "share", "share/plugin", "share/plugin/init.py", "share/plugin/data.txt" }));
+		QVERIFY (!target.exists ("share/plugin/init.py"));
+
+		QVERIFY (CommitPackage (extracted, target).IsRight ());
+		QCOMPARE (ReadFile (target, "share/plugin/init.py"), QByteArray { "print ('hello')" });
+		QCOMPARE (ReadFile (target, "share/plugin/data.txt"), QByteArray { "some data" });
+		QCOMPARE (ListAll (target),
+				(QStringList { "share", "share/plugin", "share/plugin/data.txt", "share/plugin/init.py" }));
+	}
+
+	void PackageExtractorTest::testChecksumMismatch ()
+	{
+		QTemporaryDir archiveDir;
+		QTemporaryDir targetDir;
+		const QDir target { targetDir.path () };
+
+		const auto& path = MakeArchive (archiveDir.path (), DefaultEntries);
+		const auto& result = ExtractPackage (path, QByteArray (64, '0'), target);
+		QVERIFY (result.IsLeft ());
+		QCOMPARE (ListAll (target), QStringList {});
+	}
+
+	void PackageExtractorTest::testUnsafePaths ()
+	{
+		QTemporaryDir archiveDir;
+		QTemporaryDir targetDir;
+		const QDir target { targetDir.path () };
+
+		for (const auto& unsafe : { "../escaped.txt", "/absolute.txt", "sub/../../escaped.txt" })
+		{
+			QTemporaryDir unsafeArchiveDir;
+			const auto& path = MakeArchive (unsafeArchiveDir.path (),
+					{
+						{ "ok.txt", "good" },
+						{ unsafe, "evil" }
+					});
+
+			const auto& result = ExtractPackage (path, {}, target);
+			QVERIFY (result.IsLeft ());
+			QCOMPARE (ListAll (target), QStringList {});
+			QVERIFY (!QFileInfo::exists (QDir { targetDir.path () + "/.." }.filePath ("escaped.txt")));
+		}
+
+		const auto& path = MakeArchive (archiveDir.path (),
+				{
+					{ "./", {} },
+					{ "./ok.txt", "good" }
+				});
+
+		const auto& result = ExtractPackage (path, {}, target);
+		QVERIFY (result.IsRight ());
+		QCOMPARE (result.GetRight ().Entries_, QStringList { "ok.txt" });
+
+		QVERIFY (CommitPackage (result.GetRight (), target).IsRight ());
+		QCOMPARE (ListAll (target), QStringList { "ok.txt" });
+	}
+
+	void PackageExtractorTest::testOverwrite ()
+	{
+		QTemporaryDir archiveDir;
+		QTemporaryDir targetDir;
+		const QDir target { targetDir.path () };
+
+		target.mkpath ("share/plugin");
+		{
+			QFile old { target.filePath ("share/plugin/data.txt") };
+			old.open (QIODevice::WriteOnly);
+			old.write ("old data");
+		}
+
+		const auto& path = MakeArchive (archiveDir.path (), DefaultEntries);
+		const auto& result = ExtractPackage (path, {}, target);
+		QVERIFY (result.IsRight ());
+		QVERIFY (result.GetRight ().CreatedDirs_.isEmpty ());
+		QCOMPARE (ReadFile (target, "share/plugin/data.txt"), QByteArray { "old data" });
+
+		QVERIFY (CommitPackage (result.GetRight (), target).IsRight ());
+		QCOMPARE (ReadFile (target, "share/plugin/data.txt"), QByteArray { "some data" });
+		QCOMPARE (ListAll (target),
+				(QStringList { "share", "share/plugin", "share/plugin/data.txt", "share/plugin/init.py" }));
+	}
+
+	void PackageExtractorTest::testDiscard ()
+	{
+		QTemporaryDir archiveDir;
+		QTemporaryDir targetDir;
+		const QDir target { targetDir.path () };
+
+		target.mkdir ("share");
+
+		const auto& path = MakeArchive (archiveDir.path (), DefaultEntries);
+		const auto& result = ExtractPackage (path, {}, target);
+		QVERIFY (result.IsRight ());
+		QCOMPARE (result.GetRight ().CreatedDirs_, QStringList { "share/plugin" });
+
+		DiscardPackage (result.GetRight (), target);
+		QCOMPARE (ListAll (target), QStringList { "share" });
+	}
+
+	void PackageExtractorTest::testPermissions ()
+	{
+		QTemporaryDir archiveDir;
+		QTemporaryDir targetDir;
+		const QDir target { targetDir.path () };
+
+		const auto& path = MakeArchive (archiveDir.path (), DefaultEntries, 0750);
+		const auto& result = ExtractPackage (path, {}, target);
+		QVERIFY (result.IsRight ());
+		QVERIFY (CommitPackage (result.GetRight (), target).IsRight ());
+
+		const auto perms = QFileInfo { target.filePath ("share/plugin/init.py") }.permissions ();
+		QVERIFY (perms & QFileDevice::ExeOwner);
+		QVERIFY (perms & QFileDevice::ReadGroup);
+		QVERIFY (perms & QFileDevice::ExeGroup);
+		QVERIFY (!(perms & QFileDevice::WriteGroup));
+		QVERIFY (!(perms & QFileDevice::ReadOther));
+	}
+
+	void PackageExtractorTest::testLinks ()
+	{
+		QTemporaryDir archiveDir;
+		QTemporaryDir targetDir;
+		const QDir target { targetDir.path () };
+
+		const auto& path = MakeArchive (archiveDir.path (),
+				{
+					{ "ok.txt", "good" },
+					{ "@link.txt", "/etc/passwd" }
+				});
+
+		const auto& result = ExtractPackage (path, {}, target);
+		QVERIFY (result.IsLeft ());
+		QCOMPARE (ListAll (target), QStringList {});
+	}
+
+	void PackageExtractorTest::testParallelStaging ()
+	{
+		QTemporaryDir firstArchiveDir;
+		QTemporaryDir secondArchiveDir;
+		QTemporaryDir targetDir;
+		const QDir target { targetDir.path () };
+
+		const auto& firstPath = MakeArchive (firstArchiveDir.path (), { { "data.txt", "first" } });
+		const auto& secondPath = MakeArchive (secondArchiveDir.path (), { { "data.txt", "second" } });
+
+		const auto& first = ExtractPackage (firstPath, {}, target);
+		const auto& second = ExtractPackage (secondPath, {}, target);
+		QVERIFY (first.IsRight ());
+		QVERIFY (second.IsRight ());
+		QVERIFY (first.GetRight ().StagedFiles_.value (0).second != second.GetRight ().StagedFiles_.value (0).second);
+
+		QVERIFY (CommitPackage (first.GetRight (), target).IsRight ());
+		QCOMPARE (ReadFile (target, "data.txt"), QByteArray { "first" });
+
+		QVERIFY (CommitPackage (second.GetRight (), target).IsRight ());
+		QCOMPARE (ReadFile (target, "data.txt"), QByteArray { "second" });
+		QCOMPARE (ListAll (target), QStringList { "data.txt" });
+	}
+}
+}
@@ -0,0 +1,304 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "resolvertest.h"
+#include <QtTest>
+#include "packageuniverse.h"
+#include "resolver.h"
+
+QTEST_APPLESS_MAIN (LC::LackMan::ResolverTest)
+
+namespace LC
+{
+namespace LackMan
+{
+	namespace
+	{
+		Dependency Req (const QString& name, const QString& version)
+		{
+			return { Dependency::TRequires, name, version };
+		}
+
+		Dependency Prov (const QString& name, const QString& version)
+		{
+			return { Dependency::TProvides, name, version };
+		}
+
+		InstalledDependencyInfo Inst (const QString& name, const QString& version)
+		{
+			return { Prov (name, version), InstalledDependencyInfo::SSystem };
+		}
+
+		QStringList GetNames (const PackageUniverse& universe, const QList<int>& ids)
+		{
+			QStringList result;
+			for (const auto id : ids)
+			{
+				const auto& package = universe.GetPackage (id);
+				result << package.Name_ + '-' + package.Version_;
+			}
+			return result;
+		}
+
+		QStringList Resolve (const PackageUniverse& universe, const QList<int>& ids)
+		{
+			const auto& result = Resolver { universe }.Resolve (ids);
+			if (result.IsLeft ())
+			{
+				qWarning () << ToHtml (result.GetLeft ());
+				return {};
+			}
+			return GetNames (universe, result.GetRight ());
+		}
+
+		QString Flatten (const ResolveConflict& conflict)
+		{
+			auto result = conflict.Reason_;
+			for (const auto& cause : conflict.Causes_)
+				result += '\n' + Flatten (cause);
+			return result;
+		}
+	}
+
+	void ResolverTest::testNoDeps ()
+	{
+		const PackageUniverse universe { { { 1, "a", "1.0", {}, {} } }, {} };
+		QCOMPARE (Resolve (universe, { 1 }), QStringList { "a-1.0" });
+	}
+
+	void ResolverTest::testChain ()
+	{
+		const PackageUniverse universe
+		{
+			{
+				{ 1, "a", "1.0", { Req ("b", ">=1.0") }, {} },
+				{ 2, "b", "1.2", { Req ("c", ">=0.5") }, {} },
+				{ 3, "c", "0.5", {}, {} }
+			},
+			{}
+		};
+		QCOMPARE (Resolve (universe, { 1 }), (QStringList { "c-0.5", "b-1.2", "a-1.0" }));
+	}
+
+	void ResolverTest::testInstalledDep ()
+	{
+		const PackageUniverse universe
+		{
+			{
+				{ 1, "a", "1.0", { Req ("b", ">=1.0"), Req ("lc", ">=0.6") }, {} },
+				{ 2, "b", "1.2", {}, {} }
+			},
+			{ Inst ("b", "1.1"), Inst ("lc", "0.6.75") }
+		};
+		QCOMPARE (Resolve (universe, { 1 }), QStringList { "a-1.0" });
+	}
+
+	void ResolverTest::testProvides ()
+	{
+		const PackageUniverse universe
+		{
+			{
+				{ 1, "a", "1.0", { Req ("IFoo", ">=2") }, {} },
+				{ 2, "foo-impl", "0.1", {}, { Prov ("IFoo", "1") } },
+				{ 3, "other-impl", "0.3", {}, { Prov ("IFoo", "2") } }
+			},
+			{}
+		};
+		QCOMPARE (Resolve (universe, { 1 }), (QStringList { "other-impl-0.3", "a-1.0" }));
+	}
+
+	void ResolverTest::testPrefersNewest ()
+	{
+		const PackageUniverse universe
+		{
+			{
+				{ 1, "a", "1.0", { Req ("b", ">=1.0") }, {} },
+				{ 2, "b", "1.0", {}, {} },
+				{ 3, "b", "1.10", {}, {} },
+				{ 4, "b", "1.9", {}, {} }
+			},
+			{}
+		};
+		QCOMPARE (Resolve (universe, { 1 }), (QStringList { "b-1.10", "a-1.0" }));
+	}
+
+	void ResolverTest::testBacktracking ()
+	{
+		// The newest c requires an older b than a does, so the older c
+		// has to be picked instead.
+		const PackageUniverse universe
+		{
+			{
+				{ 1, "a", "1.0", { Req ("c", ">=1"), Req ("b", ">=2") }, {} },
+				{ 2, "b", "1", {}, {} },
+				{ 3, "b", "2", {}, {} },
+				{ 4, "c", "2", { Req ("b", "<2") }, {} },
+				{ 5, "c", "1", {}, {} }
+			},
+			{}
+		};
+		QCOMPARE (Resolve (universe, { 1 }), (QStringList { "c-1", "b-2", "a-1.0" }));
+	}
+
+	void ResolverTest::testMissingDep ()
+	{
+		const PackageUniverse universe
+		{
+			{
+				{ 1, "a", "1.0", { Req ("b", ">=1") }, {} },
+				{ 2, "b", "1", { Req ("c", ">=3") }, {} },
+				{ 3, "c", "2", {}, {} }
+			},
+			{}
+		};
+
+		const auto& result = Resolver { universe }.Resolve ({ 1 });
+		QVERIFY (result.IsLeft ());
+
+		const auto& explanation = Flatten (result.GetLeft ());
+		QVERIFY (explanation.contains ("a 1.0 requires b >=1"));
+		QVERIFY (explanation.contains ("b 1 requires c >=3, but no package provides it"));
+	}
+
+	void ResolverTest::testVersionConflict ()
+	{
+		const PackageUniverse universe
+		{
+			{
+				{ 1, "a", "1.0", { Req ("b", ">=2"), Req ("c", ">=1") }, {} },
+				{ 2, "b", "1", {}, {} },
+				{ 3, "b", "2", {}, {} },
+				{ 4, "c", "1", { Req ("b", "<2") }, {} }
+			},
+			{}
+		};
+
+		const auto& result = Resolver { universe }.Resolve ({ 1 });
+		QVERIFY (result.IsLeft ());
+
+		const auto& explanation = Flatten (result.GetLeft ());
+		QVERIFY (explanation.contains ("b 1 conflicts with b 2"));
+	}
+
+	void ResolverTest::testPinned ()
+	{
+		const PackageUniverse universe
+		{
+			{
+				{ 1, "a", "1.0", { Req ("b", ">=1") }, {} },
+				{ 2, "b", "1", {}, {} },
+				{ 3, "b", "2", {}, {} }
+			},
+			{}
+		};
+
+		Resolver resolver { universe };
+		resolver.Pin (2);
+
+		const auto& result = resolver.Resolve ({ 1 });
+		QVERIFY (result.IsRight ());
+		QCOMPARE (GetNames (universe, result.GetRight ()), QStringList { "a-1.0" });
+	}
+
+	void ResolverTest::testPinnedConflict ()
+	{
+		const PackageUniverse universe
+		{
+			{
+				{ 1, "a", "1.0", { Req ("b", ">=2") }, {} },
+				{ 2, "b", "1", {}, {} },
+				{ 3, "b", "2", {}, {} }
+			},
+			{}
+		};
+
+		Resolver resolver { universe };
+		resolver.Pin (2);
+
+		const auto& result = resolver.Resolve ({ 1 });
+		QVERIFY (result.IsLeft ());
+		QVERIFY (Flatten (result.GetLeft ()).contains ("b 2 conflicts with b 1, which is already selected"));
+	}
+
+	void ResolverTest::testCycle ()
+	{
+		const PackageUniverse universe
+		{
+			{
+				{ 1, "a", "1", { Req ("b", ">=1") }, {} },
+				{ 2, "b", "1", { Req ("a", ">=1") }, {} }
+			},
+			{}
+		};
+
+		const auto& names = Resolve (universe, { 1 });
+		QCOMPARE (names.size (), 2);
+		QVERIFY (names.contains ("a-1"));
+		QVERIFY (names.contains ("b-1"));
+	}
+
+	void ResolverTest::benchmarkLargeUniverse ()
+	{
+		// A few thousand packages, each depending on a couple of
+		// libraries available in several versions.
+		QList<PackageUniverse::Package> packages;
+		int id = 0;
+		for (int lib = 0; lib < 200; ++lib)
+			for (int ver = 1; ver <= 5; ++ver)
+				packages.append ({
+						++id,
+						QString ("lib%1").arg (lib),
+						QString::number (ver),
+						lib ? DependencyList { Req (QString ("lib%1").arg (lib - 1), QString (">=%1").arg (ver)) } : DependencyList {},
+						{}
+					});
+
+		const auto firstApp = id + 1;
+		for (int app = 0; app < 2000; ++app)
+			packages.append ({
+					++id,
+					QString ("app%1").arg (app),
+					"1.0",
+					{ Req (QString ("lib%1").arg (app % 200), ">=3"), Req (QString ("lib%1").arg ((app * 7) % 200), ">=1") },
+					{}
+				});
+
+		const PackageUniverse universe { packages, {} };
+
+		QList<int> requested;
+		for (int i = 0; i < 50; ++i)
+			requested << firstApp + i * 37;
+
+		QBENCHMARK
+		{
+			QVERIFY (Resolver { universe }.Resolve (requested).IsRight ());
+		}
+	}
+}
+}
@@ -93,5 +93,21 @@ namespace LackMan
 
 		return false;
 	}
+
+	bool IsVersionOk (const QString& candidate, QString refVer)
+	{
+		if (refVer.startsWith (">="))
+			return !IsVersionLess (candidate, refVer.mid (2).trimmed ());
+		else if (refVer.startsWith ("<="))
+			return !IsVersionLess (refVer.mid (2).trimmed (), candidate);
+		else if (refVer.startsWith ('>'))
+			return IsVersionLess (refVer.mid (1).trimmed (), candidate);
+		else if (refVer.startsWith ('<'))
+			return IsVersionLess (candidate, refVer.mid (1).trimmed ());
+
+		if (refVer.startsWith ('='))
+			refVer = refVer.mid (1);
+		return candidate == refVer.trimmed ();
+	}
 }
 }
@@ -36,6 +36,14 @@ namespace LC
 namespace LackMan
 {
 	bool IsVersionLess (const QString& lver, const QString& rver);
+
+	/** @brief Checks whether the candidate version satisfies the
+		* reference version.
+		*
+		* The reference version may be prefixed with one of the
+		* relations: <, <=, =, >= or >. No prefix means equality.
+		*/
+	bool IsVersionOk (const QString& candidate, QString refVer);
 }
 }
 
@@ -245,6 +245,10 @@ namespace LackMan
 			packageInfo.VersionArchivers_ [verNode.text ()] =
 					verNode.attribute ("archiver", "gz");
 
+			if (verNode.hasAttribute ("sha256"))
+				packageInfo.VersionChecksums_ [verNode.text ()] =
+						verNode.attribute ("sha256").toLatin1 ().toLower ();
+
 			verNode = verNode.nextSiblingElement ("version");
 		}
 
@@ -41,6 +41,13 @@ namespace LC
 {
 namespace LMP
 {
+	LocalFileResolver::LocalFileResolver (QObject *parent)
+	: QObject { parent }
+	, EnableLocalTagsRecoding_ { XmlSettingsManager::Instance (), "EnableLocalTagsRecoding" }
+	, TagsRecodingRegion_ { XmlSettingsManager::Instance (), "TagsRecodingRegion" }
+	{
+	}
+
 	TagLib::FileRef LocalFileResolver::GetFileRef (const QString& file) const
 	{
 #ifdef Q_OS_WIN32
@@ -73,9 +80,8 @@ namespace LMP
 
 		auto audio = r.audioProperties ();
 
-		auto& xsm = XmlSettingsManager::Instance ();
-		const auto& region = xsm.property ("EnableLocalTagsRecoding").toBool () ?
-				xsm.property ("TagsRecodingRegion").toString () :
+		const auto& region = EnableLocalTagsRecoding_ () ?
+				TagsRecodingRegion_ () :
 				QString {};
 		auto ftl = [&region] (const TagLib::String& str)
 		{
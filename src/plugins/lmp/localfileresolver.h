@@ -36,6 +36,7 @@
 #include <QMutex>
 #include <QDateTime>
 #include <taglib/fileref.h>
+#include <xmlsettingsdialog/settingshandle.h>
 #include "interfaces/lmp/itagresolver.h"
 #include "mediainfo.h"
 
@@ -52,8 +53,11 @@ namespace LMP
 		QMutex TaglibMutex_;
 		QReadWriteLock CacheLock_;
 		QHash<QString, QPair<QDateTime, MediaInfo>> Cache_;
+
+		const Util::SettingHandle<bool> EnableLocalTagsRecoding_;
+		const Util::SettingHandle<QString> TagsRecodingRegion_;
 	public:
-		using QObject::QObject;
+		LocalFileResolver (QObject* = nullptr);
 
 		TagLib::FileRef GetFileRef (const QString&) const;
 		ResolveResult_t ResolveInfo (const QString&);
@@ -0,0 +1,97 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <QList>
+#include <QRectF>
+#include <QString>
+#include <QtPlugin>
+
+namespace LC
+{
+namespace Monocle
+{
+	/** @brief Describes a single word on a page along with its position.
+	 */
+	struct TextBox
+	{
+		/** @brief The text of the word.
+		 */
+		QString Text_;
+
+		/** @brief The rectangle occupied by the word.
+		 *
+		 * The rectangle is in relative page coordinates, that is, with
+		 * both width and height from 0 to 1, like the rectangles
+		 * returned by ISearchableDocument::GetTextPositions().
+		 */
+		QRectF Rect_;
+	};
+
+	/** @brief Interface for documents providing the layout of their text.
+	 *
+	 * This interface should be implemented by the documents that are
+	 * able to enumerate the words on their pages along with their
+	 * positions. Monocle uses this to build a full-text index of the
+	 * document in background, so that the search doesn't need to go
+	 * through the whole document for each query.
+	 *
+	 * @sa ISearchableDocument
+	 */
+	class IHaveTextLayout
+	{
+	public:
+		virtual ~IHaveTextLayout () {}
+
+		/** @brief The handler for the text boxes of a single page.
+		 *
+		 * The handler should return \em false if the extraction should
+		 * be stopped, and \em true otherwise.
+		 */
+		using PageHandler_f = std::function<bool (int page, const QList<TextBox>& boxes)>;
+
+		/** @brief Extracts the text boxes of all the pages.
+		 *
+		 * This function is called from a background thread, so it
+		 * should neither touch any state shared with the GUI thread nor
+		 * emit any signals. The \em handler should be invoked for each
+		 * page in order, in the same thread this function is called
+		 * from.
+		 *
+		 * @param[in] handler The handler to invoke for each page.
+		 */
+		virtual void ExtractTextLayout (const PageHandler_f& handler) = 0;
+	};
+}
+}
+
+Q_DECLARE_INTERFACE (LC::Monocle::IHaveTextLayout,
+		"org.LeechCraft.Monocle.IHaveTextLayout/1.0")
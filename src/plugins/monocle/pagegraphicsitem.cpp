@@ -47,6 +47,8 @@
 #include "pixmapcachemanager.h"
 #include "arbitraryrotationwidget.h"
 #include "pageslayoutmanager.h"
+#include "renderscheduler.h"
+#include "interfaces/monocle/isupporttiledrendering.h"
 
 namespace LC
 {
@@ -56,7 +58,11 @@ namespace Monocle
 	: QGraphicsPixmapItem (parent)
 	, Doc_ (doc)
 	, PageNum_ (page)
+	, TiledDoc_ (qobject_cast<ISupportTiledRendering*> (doc->GetQObject ()))
+	, Scheduler_ (RenderScheduler::ForDocument (doc))
 	{
+		Scheduler_->RegisterItem (this);
+
 		setTransformationMode (Qt::SmoothTransformation);
 		setShapeMode (QGraphicsPixmapItem::BoundingRectShape);
 		setPixmap (QPixmap (Doc_->GetPageSize (page)));
@@ -65,6 +71,7 @@ namespace Monocle
 
 	PageGraphicsItem::~PageGraphicsItem ()
 	{
+		Scheduler_->UnregisterItem (this);
 		Core::Instance ().GetPixmapCacheManager ()->PixmapDeleted (this);
 	}
 
@@ -88,6 +95,7 @@ namespace Monocle
 		YScale_ = ys;
 
 		Invalid_ = true;
+		ResetTiles ();
 
 		if (ShouldRender ())
 			update ();
@@ -146,11 +154,13 @@ namespace Monocle
 		setPixmap (QPixmap { QSize { 1, 1 } });
 
 		Invalid_ = true;
+		ResetTiles ();
 	}
 
 	void PageGraphicsItem::UpdatePixmap ()
 	{
 		Invalid_ = true;
+		ResetTiles ();
 		if (ShouldRender ())
 			update ();
 	}
@@ -158,6 +168,23 @@ namespace Monocle
 	void PageGraphicsItem::paint (QPainter *painter,
 			const QStyleOptionGraphicsItem *option, QWidget *w)
 	{
+		if (IsTiled ())
+		{
+			// The whole page pixmap isn't needed anymore, drop it.
+			if (pixmap ().width () > 1)
+			{
+				setPixmap (QPixmap { QSize { 1, 1 } });
+				Core::Instance ().GetPixmapCacheManager ()->PixmapChanged (this);
+			}
+
+			const auto cacheMgr = Core::Instance ().GetPixmapCacheManager ();
+			if (PaintTiles (painter))
+				cacheMgr->PixmapChanged (this);
+			else
+				cacheMgr->PixmapPainted (this);
+			return;
+		}
+
 		if (Invalid_ && IsDisplayed ())
 		{
 			setPixmap (GetEmptyPixmap (true));
@@ -165,16 +192,20 @@ namespace Monocle
 			if (ShouldRender ())
 			{
 				Invalid_ = false;
-				Util::Sequence (this, Doc_->RenderPage (PageNum_, XScale_, YScale_)) >>
-						[&, prevXScale = XScale_, prevYScale = YScale_] (const QImage& img)
+				const auto& future = Scheduler_->Render (this, XScale_, YScale_, RenderScheduler::Priority::Visible);
+				Util::Sequence (this, future) >>
+						[this, prevXScale = XScale_, prevYScale = YScale_] (const QImage& img)
 						{
-							setPixmap (QPixmap::fromImage (img));
+							if (img.isNull ())
+							{
+								Invalid_ = true;
+								return;
+							}
 
-							if (std::abs (prevXScale - XScale_) > std::numeric_limits<double>::epsilon () * XScale_ ||
-								std::abs (prevYScale - YScale_) > std::numeric_limits<double>::epsilon () * YScale_)
-								UpdatePixmap ();
-							else
-								Core::Instance ().GetPixmapCacheManager ()->PixmapChanged (this);
+							HandleRendered (img, prevXScale, prevYScale);
+
+							Scheduler_->SchedulePrefetch (PageNum_ - 1);
+							Scheduler_->SchedulePrefetch (PageNum_ + 1);
 						};
 			}
 		}
@@ -234,6 +265,36 @@ namespace Monocle
 		rotateMenu.exec (event->screenPos ());
 	}
 
+	void PageGraphicsItem::Prefetch ()
+	{
+		if (!Invalid_ || !IsRenderingEnabled_ || IsTiled () || !scene () || IsDisplayed ())
+			return;
+
+		// Invalid_ is kept set so that the prefetch request gets replaced by
+		// a regular one if the page gets displayed before it is rendered.
+		const auto& future = Scheduler_->Render (this, XScale_, YScale_, RenderScheduler::Priority::Prefetch);
+		Util::Sequence (this, future) >>
+				[this, prevXScale = XScale_, prevYScale = YScale_] (const QImage& img)
+				{
+					if (img.isNull ())
+						return;
+
+					Invalid_ = false;
+					HandleRendered (img, prevXScale, prevYScale);
+				};
+	}
+
+	void PageGraphicsItem::HandleRendered (const QImage& img, double prevXScale, double prevYScale)
+	{
+		setPixmap (QPixmap::fromImage (img));
+
+		if (std::abs (prevXScale - XScale_) > std::numeric_limits<double>::epsilon () * XScale_ ||
+			std::abs (prevYScale - YScale_) > std::numeric_limits<double>::epsilon () * YScale_)
+			UpdatePixmap ();
+		else
+			Core::Instance ().GetPixmapCacheManager ()->PixmapChanged (this);
+	}
+
 	QPixmap PageGraphicsItem::GetEmptyPixmap (bool fill) const
 	{
 		auto size = Doc_->GetPageSize (PageNum_);
@@ -276,6 +337,120 @@ namespace Monocle
 		return IsRenderingEnabled_ && IsDisplayed ();
 	}
 
+	namespace
+	{
+		const int TileSize = 512;
+
+		/* Pages whose scaled size exceeds this many pixels are rendered
+		 * tile by tile, and only the visible tiles are rendered.
+		 */
+		const qint64 TiledRenderingThreshold = 2048 * 2048;
+	}
+
+	bool PageGraphicsItem::IsTiled () const
+	{
+		if (!TiledDoc_)
+			return false;
+
+		const auto& size = boundingRect ().size ();
+		return size.width () * size.height () > TiledRenderingThreshold;
+	}
+
+	QRectF PageGraphicsItem::GetVisibleRect () const
+	{
+		QRectF result;
+		for (auto view : scene ()->views ())
+		{
+			const auto& viewRect = view->mapToScene (view->viewport ()->rect ()).boundingRect ();
+			result |= mapFromScene (viewRect).boundingRect ();
+		}
+		return result & boundingRect ();
+	}
+
+	QList<QPixmap> PageGraphicsItem::GetTilePixmaps () const
+	{
+		return Tiles_.values ();
+	}
+
+	bool PageGraphicsItem::PaintTiles (QPainter *painter)
+	{
+		const auto& visible = GetVisibleRect ();
+		if (visible.isEmpty ())
+			return false;
+
+		painter->fillRect (visible, Qt::white);
+
+		const QRect pageRect { QPoint {}, boundingRect ().size ().toSize () };
+		const auto& visiblePageRect = visible.translated (-offset ()).toAlignedRect () & pageRect;
+
+		const auto firstCol = visiblePageRect.left () / TileSize;
+		const auto lastCol = visiblePageRect.right () / TileSize;
+		const auto firstRow = visiblePageRect.top () / TileSize;
+		const auto lastRow = visiblePageRect.bottom () / TileSize;
+
+		for (auto row = firstRow; row <= lastRow; ++row)
+			for (auto col = firstCol; col <= lastCol; ++col)
+			{
+				const TileKey_t key { col, row };
+				const auto& tileRect = QRect { col * TileSize, row * TileSize, TileSize, TileSize } & pageRect;
+
+				const auto pos = Tiles_.find (key);
+				if (pos != Tiles_.end ())
+					painter->drawPixmap (tileRect.topLeft () + offset (), *pos);
+				else if (IsRenderingEnabled_ && !PendingTiles_.contains (key))
+					RequestTile (key, tileRect);
+			}
+
+		// Keep a one-tile margin around the visible area for scrolling.
+		bool dropped = false;
+		for (auto it = Tiles_.begin (); it != Tiles_.end (); )
+		{
+			const auto col = it.key ().first;
+			const auto row = it.key ().second;
+			if (col < firstCol - 1 || col > lastCol + 1 ||
+					row < firstRow - 1 || row > lastRow + 1)
+			{
+				it = Tiles_.erase (it);
+				dropped = true;
+			}
+			else
+				++it;
+		}
+		return dropped;
+	}
+
+	void PageGraphicsItem::RequestTile (const TileKey_t& key, const QRect& rect)
+	{
+		PendingTiles_ << key;
+
+		Util::Sequence (this, Scheduler_->RenderTile (this, XScale_, YScale_, rect)) >>
+				[this, key, generation = TilesGeneration_] (const QImage& img)
+				{
+					if (generation != TilesGeneration_)
+						return;
+
+					PendingTiles_.remove (key);
+
+					// The request has been dropped, the tile will be requested
+					// again once it is painted.
+					if (img.isNull ())
+						return;
+
+					Tiles_ [key] = QPixmap::fromImage (img);
+					Core::Instance ().GetPixmapCacheManager ()->PixmapChanged (this);
+					update ();
+				};
+	}
+
+	void PageGraphicsItem::ResetTiles ()
+	{
+		++TilesGeneration_;
+		Scheduler_->CancelTiles (this);
+
+		Tiles_.clear ();
+		PendingTiles_.clear ();
+	}
+
 	QRectF PageGraphicsItem::boundingRect () const
 	{
 		auto size = Doc_->GetPageSize (PageNum_);
@@ -33,6 +33,8 @@
 #include <memory>
 #include <QGraphicsPixmapItem>
 #include <QPointer>
+#include <QHash>
+#include <QSet>
 #include "interfaces/monocle/idocument.h"
 
 template<typename T>
@@ -44,6 +46,8 @@ namespace Monocle
 {
 	class PagesLayoutManager;
 	class ArbitraryRotationWidget;
+	class ISupportTiledRendering;
+	class RenderScheduler;
 
 	class PageGraphicsItem : public QObject
 						   , public QGraphicsPixmapItem
@@ -60,6 +64,15 @@ namespace Monocle
 
 		bool Invalid_ = true;
 
+		ISupportTiledRendering * const TiledDoc_;
+
+		const std::shared_ptr<RenderScheduler> Scheduler_;
+
+		using TileKey_t = QPair<int, int>;
+		QHash<TileKey_t, QPixmap> Tiles_;
+		QSet<TileKey_t> PendingTiles_;
+		int TilesGeneration_ = 0;
+
 		std::function<void (int, QPointF)> ReleaseHandler_;
 
 		PagesLayoutManager *LayoutManager_ = nullptr;
@@ -96,6 +109,16 @@ namespace Monocle
 
 		bool IsDisplayed () const;
 
+		/** Returns the pixmaps of the rendered tiles if the page is
+		 * rendered tile by tile.
+		 */
+		QList<QPixmap> GetTilePixmaps () const;
+
+		/** Renders the page in background if it is not displayed yet
+		 * so that it is ready by the time it gets scrolled to.
+		 */
+		void Prefetch ();
+
 		void SetRenderingEnabled (bool);
 
 		QRectF boundingRect () const;
@@ -108,6 +131,14 @@ namespace Monocle
 	private:
 		bool ShouldRender () const;
 		QPixmap GetEmptyPixmap (bool fill) const;
+
+		void HandleRendered (const QImage&, double prevXScale, double prevYScale);
+
+		bool IsTiled () const;
+		QRectF GetVisibleRect () const;
+		bool PaintTiles (QPainter*);
+		void RequestTile (const TileKey_t&, const QRect&);
+		void ResetTiles ();
 	private slots:
 		void rotateCCW ();
 		void rotateCW ();
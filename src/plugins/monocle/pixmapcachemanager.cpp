@@ -28,7 +28,8 @@
  **********************************************************************/
 
 #include "pixmapcachemanager.h"
-#include <numeric>
+#include <QTimer>
+#include <QFile>
 #include <QtDebug>
 #include "xmlsettingsmanager.h"
 #include "pagegraphicsitem.h"
@@ -43,6 +44,15 @@ namespace Monocle
 		XmlSettingsManager::Instance ().RegisterObject ("PixmapCacheSize",
 				this, "handleCacheSizeChanged");
 		handleCacheSizeChanged ();
+
+#ifdef Q_OS_LINUX
+		const auto timer = new QTimer { this };
+		connect (timer,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (checkMemoryPressure ()));
+		timer->start (5000);
+#endif
 	}
 
 	namespace
@@ -54,48 +64,82 @@ namespace Monocle
 
 			return px.width () * px.height () * px.defaultDepth () / 8 * 1.5;
 		}
+
+		quint64 GetItemPixmapsSize (const PageGraphicsItem *item)
+		{
+			auto size = GetPixmapSize (item->pixmap ());
+			for (const auto& tile : item->GetTilePixmaps ())
+				size += GetPixmapSize (tile);
+			return size;
+		}
 	}
 
 	void PixmapCacheManager::PixmapPainted (PageGraphicsItem *item)
 	{
-		RecentlyUsed_.removeAll (item);
-		RecentlyUsed_ << item;
+		Touch (item, false);
 	}
 
 	void PixmapCacheManager::PixmapChanged (PageGraphicsItem *item)
 	{
-		if (RecentlyUsed_.removeAll (item))
-			CurrentSize_ = std::accumulate (RecentlyUsed_.begin (), RecentlyUsed_.end (), 0,
-					[] (qint64 size, const PageGraphicsItem *item)
-						{ return size + GetPixmapSize (item->pixmap ()); });
-
-		RecentlyUsed_ << item;
-		CurrentSize_ += GetPixmapSize (item->pixmap ());
+		Touch (item, true);
 		CheckCache ();
 	}
 
 	void PixmapCacheManager::PixmapDeleted (PageGraphicsItem *item)
 	{
-		CurrentSize_ -= GetPixmapSize (item->pixmap ());
-		RecentlyUsed_.removeAll (item);
+		const auto pos = Item2Entry_.find (item);
+		if (pos == Item2Entry_.end ())
+			return;
+
+		CurrentSize_ -= (*pos)->Size_;
+		RecentlyUsed_.erase (*pos);
+		Item2Entry_.erase (pos);
 	}
 
-	void PixmapCacheManager::CheckCache ()
+	void PixmapCacheManager::Touch (PageGraphicsItem *item, bool updateSize)
 	{
-		for (auto i = RecentlyUsed_.begin (); i != RecentlyUsed_.end () && MaxSize_ < CurrentSize_; )
+		const auto pos = Item2Entry_.find (item);
+		if (pos == Item2Entry_.end ())
+		{
+			const qint64 size = GetItemPixmapsSize (item);
+			CurrentSize_ += size;
+			Item2Entry_ [item] = RecentlyUsed_.insert (RecentlyUsed_.end (), { item, size });
+			return;
+		}
+
+		const auto entry = *pos;
+		RecentlyUsed_.splice (RecentlyUsed_.end (), RecentlyUsed_, entry);
+
+		if (updateSize)
 		{
-			const auto page = *i;
+			CurrentSize_ -= entry->Size_;
+			entry->Size_ = GetItemPixmapsSize (item);
+			CurrentSize_ += entry->Size_;
+		}
+	}
+
+	void PixmapCacheManager::Shrink (qint64 targetSize)
+	{
+		for (auto i = RecentlyUsed_.begin (); i != RecentlyUsed_.end () && targetSize < CurrentSize_; )
+		{
+			const auto page = i->Item_;
 			if (page->IsDisplayed ())
 			{
 				++i;
 				continue;
 			}
 
-			const quint64 pxSize = GetPixmapSize (page->pixmap ());
-			CurrentSize_ -= pxSize;
-			page->ClearPixmap ();
+			CurrentSize_ -= i->Size_;
+			Item2Entry_.remove (page);
 			i = RecentlyUsed_.erase (i);
+
+			page->ClearPixmap ();
 		}
+	}
+
+	void PixmapCacheManager::CheckCache ()
+	{
+		Shrink (MaxSize_);
 
 		if (MaxSize_ < CurrentSize_)
 			qWarning () << Q_FUNC_INFO
@@ -114,5 +158,59 @@ namespace Monocle
 
 		CheckCache ();
 	}
+
+	namespace
+	{
+		struct MemInfo
+		{
+			qint64 Total_ = 0;
+			qint64 Available_ = 0;
+		};
+
+		MemInfo ReadMemInfo ()
+		{
+			QFile file { "/proc/meminfo" };
+			if (!file.open (QIODevice::ReadOnly))
+				return {};
+
+			MemInfo info;
+			for (const auto& line : file.readAll ().split ('\n'))
+			{
+				const auto& fields = line.simplified ().split (' ');
+				if (fields.size () < 2)
+					continue;
+
+				if (fields [0] == "MemTotal:")
+					info.Total_ = fields [1].toLongLong () * 1024;
+				else if (fields [0] == "MemAvailable:")
+					info.Available_ = fields [1].toLongLong () * 1024;
+			}
+			return info;
+		}
+	}
+
+	void PixmapCacheManager::checkMemoryPressure ()
+	{
+		if (RecentlyUsed_.empty ())
+			return;
+
+		const auto& info = ReadMemInfo ();
+		if (!info.Total_ || !info.Available_)
+			return;
+
+		if (info.Available_ > info.Total_ / 20)
+			return;
+
+		qWarning () << Q_FUNC_INFO
+				<< "low memory:"
+				<< info.Available_
+				<< "of"
+				<< info.Total_
+				<< "available, dropping"
+				<< CurrentSize_
+				<< "bytes of cached pixmaps";
+
+		Shrink (0);
+	}
 }
 }
@@ -29,7 +29,9 @@
 
 #pragma once
 
+#include <list>
 #include <QObject>
+#include <QHash>
 
 namespace LC
 {
@@ -37,13 +39,33 @@ namespace Monocle
 {
 	class PageGraphicsItem;
 
+	/** Keeps the total size of rendered page pixmaps across all open
+	 * documents under the configured budget, including the tiles of the
+	 * pages rendered tile by tile.
+	 *
+	 * Pages are tracked in LRU order, and all the operations on a single
+	 * page are O(1). When the budget is exceeded, the least recently
+	 * painted pages that aren't displayed get their pixmaps cleared, so
+	 * they will be rendered again once they are scrolled to.
+	 *
+	 * On Linux, the available system memory is polled periodically, and
+	 * all the pages that aren't displayed are evicted when it runs low.
+	 */
 	class PixmapCacheManager : public QObject
 	{
 		Q_OBJECT
 
 		qint64 CurrentSize_ = 0;
 		qint64 MaxSize_ = 0;
-		QList<PageGraphicsItem*> RecentlyUsed_;
+
+		struct Entry
+		{
+			PageGraphicsItem *Item_;
+			qint64 Size_;
+		};
+		using LRU_t = std::list<Entry>;
+		LRU_t RecentlyUsed_;
+		QHash<PageGraphicsItem*, LRU_t::iterator> Item2Entry_;
 	public:
 		PixmapCacheManager (QObject* = 0);
 
@@ -51,9 +73,12 @@ namespace Monocle
 		void PixmapChanged (PageGraphicsItem*);
 		void PixmapDeleted (PageGraphicsItem*);
 	private:
+		void Touch (PageGraphicsItem*, bool updateSize);
+		void Shrink (qint64 targetSize);
 		void CheckCache ();
 	private slots:
 		void handleCacheSizeChanged ();
+		void checkMemoryPressure ();
 	};
 }
 }
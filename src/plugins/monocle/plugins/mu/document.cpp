@@ -31,6 +31,8 @@
 #include <memory>
 #include <cstring>
 #include <QPainter>
+#include <QMutex>
+#include <QtConcurrentRun>
 #include <QtDebug>
 
 namespace LC
@@ -41,6 +43,16 @@ namespace Mu
 {
 	namespace
 	{
+		/* The fz_context is shared by all the documents and is created
+		 * without the locking callbacks, so the calls into MuPDF from the
+		 * render threads and the GUI thread are serialized.
+		 */
+		QMutex& GetContextMutex ()
+		{
+			static QMutex mutex;
+			return mutex;
+		}
+
 		std::shared_ptr<pdf_page> WrapPage (pdf_page *pg, pdf_document *doc)
 		{
 			return std::shared_ptr<pdf_page> (pg,
@@ -54,14 +66,23 @@ namespace Mu
 
 	Document::Document (const QString& filename, fz_context *ctx, QObject *plugin)
 	: MuCtx_ (ctx)
-	, MuDoc_ (pdf_open_document (ctx, filename.toUtf8 ().constData ()))
+	, MuDoc_ (nullptr)
 	, URL_ (QUrl::fromLocalFile (filename))
 	, Plugin_ (plugin)
 	{
+		// The renders are serialized anyway, no point in more threads.
+		RenderPool_.setMaxThreadCount (1);
+
+		QMutexLocker locker { &GetContextMutex () };
+		MuDoc_ = pdf_open_document (ctx, filename.toUtf8 ().constData ());
 	}
 
 	Document::~Document ()
 	{
+		RenderPool_.clear ();
+		RenderPool_.waitForDone ();
+
+		QMutexLocker locker { &GetContextMutex () };
 		pdf_close_document (MuDoc_);
 	}
 
@@ -87,11 +108,13 @@ namespace Mu
 
 	int Document::GetNumPages () const
 	{
+		QMutexLocker locker { &GetContextMutex () };
 		return pdf_count_pages (MuDoc_);
 	}
 
 	QSize Document::GetPageSize (int num) const
 	{
+		QMutexLocker locker { &GetContextMutex () };
 		auto page = WrapPage (pdf_load_page (MuDoc_, num), MuDoc_);
 		if (!page)
 			return QSize ();
@@ -106,8 +129,20 @@ namespace Mu
 				rect.y1 - rect.y0);
 	}
 
-	QImage Document::RenderPage (int num, double xRes, double yRes)
+	QFuture<QImage> Document::RenderPage (int num, double xRes, double yRes)
 	{
+		return QtConcurrent::run (&RenderPool_, [=] { return RenderRect (num, xRes, yRes, {}); });
+	}
+
+	QFuture<QImage> Document::RenderPageTile (int num, double xRes, double yRes, const QRect& rect)
+	{
+		return QtConcurrent::run (&RenderPool_, [=] { return RenderRect (num, xRes, yRes, rect); });
+	}
+
+	QImage Document::RenderRect (int num, double xRes, double yRes, const QRect& tileRect)
+	{
+		QMutexLocker locker { &GetContextMutex () };
+
 		auto page = WrapPage (pdf_load_page (MuDoc_, num), MuDoc_);
 		if (!page)
 			return QImage ();
@@ -119,14 +154,25 @@ namespace Mu
 		pdf_bound_page (MuDoc_, page.get (), &rect);
 #endif
 
-		auto px = fz_new_pixmap (MuCtx_, fz_device_bgr, xRes * (rect.x1 - rect.x0), yRes * (rect.y1 - rect.y0));
+		const auto& targetRect = tileRect.isNull () ?
+				QRect (0, 0, xRes * (rect.x1 - rect.x0), yRes * (rect.y1 - rect.y0)) :
+				tileRect;
+
+		auto px = fz_new_pixmap (MuCtx_, fz_device_bgr, targetRect.width (), targetRect.height ());
 		fz_clear_pixmap (MuCtx_, px);
 		auto dev = fz_new_draw_device (MuCtx_, px);
 #if MUPDF_VERSION < 0x0102
-		pdf_run_page (MuDoc_, page.get (), dev, fz_scale (xRes, yRes), NULL);
+		const auto& matrix = fz_concat (fz_scale (xRes, yRes),
+				fz_translate (-targetRect.x (), -targetRect.y ()));
+		pdf_run_page (MuDoc_, page.get (), dev, matrix, NULL);
 #else
+		fz_matrix scale;
+		fz_scale (&scale, xRes, yRes);
+		fz_matrix translate;
+		fz_translate (&translate, -targetRect.x (), -targetRect.y ());
 		fz_matrix matrix;
-		pdf_run_page (MuDoc_, page.get (), dev, fz_scale (&matrix, xRes, yRes), NULL);
+		fz_concat (&matrix, &scale, &translate);
+		pdf_run_page (MuDoc_, page.get (), dev, &matrix, NULL);
 #endif
 		fz_free_device (dev);
 
@@ -31,6 +31,7 @@
 
 #include <QObject>
 #include <QUrl>
+#include <QThreadPool>
 
 extern "C"
 {
@@ -38,6 +39,7 @@ extern "C"
 }
 
 #include <interfaces/monocle/idocument.h>
+#include <interfaces/monocle/isupporttiledrendering.h>
 
 namespace LC
 {
@@ -47,9 +49,10 @@ namespace Mu
 {
 	class Document : public QObject
 				   , public IDocument
+				   , public ISupportTiledRendering
 	{
 		Q_OBJECT
-		Q_INTERFACES (LC::Monocle::IDocument)
+		Q_INTERFACES (LC::Monocle::IDocument LC::Monocle::ISupportTiledRendering)
 
 		fz_context *MuCtx_;
 		pdf_document *MuDoc_;
@@ -57,6 +60,8 @@ namespace Mu
 		QUrl URL_;
 
 		QObject *Plugin_;
+
+		QThreadPool RenderPool_;
 	public:
 		Document (const QString&, fz_context*, QObject*);
 		~Document ();
@@ -67,9 +72,13 @@ namespace Mu
 		DocumentInfo GetDocumentInfo () const;
 		int GetNumPages () const;
 		QSize GetPageSize (int) const;
-		QImage RenderPage (int, double xRes, double yRes);
+		QFuture<QImage> RenderPage (int, double xRes, double yRes);
 		QList<ILink_ptr> GetPageLinks (int);
 		QUrl GetDocURL () const;
+
+		QFuture<QImage> RenderPageTile (int, double xRes, double yRes, const QRect&);
+	private:
+		QImage RenderRect (int, double xRes, double yRes, const QRect&);
 	signals:
 		void navigateRequested (const QString& , const IDocument::Position&);
 		void printRequested (const QList<int>&);
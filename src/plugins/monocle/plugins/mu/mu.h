@@ -53,7 +53,7 @@ namespace Mu
 		Q_OBJECT
 		Q_INTERFACES (IInfo IPlugin2 LC::Monocle::IBackendPlugin)
 
-		LC_PLUGIN_METADATA ("org.LeechCraft.Monocle.Mu")
+		Q_PLUGIN_METADATA (IID "org.LeechCraft.Monocle.Mu" FILE "manifest.json")
 
 		fz_context *MuCtx_;
 	public:
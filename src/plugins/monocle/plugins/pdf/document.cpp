@@ -130,6 +130,19 @@ namespace PDF
 		return QtConcurrent::run ([=] { return page->renderToImage (72 * xScale, 72 * yScale); });
 	}
 
+	QFuture<QImage> Document::RenderPageTile (int num, double xScale, double yScale, const QRect& rect)
+	{
+		std::shared_ptr<Poppler::Page> page (PDocument_->page (num));
+		if (!page)
+			return Util::MakeReadyFuture (QImage {});
+
+		return QtConcurrent::run ([=]
+				{
+					return page->renderToImage (72 * xScale, 72 * yScale,
+							rect.x (), rect.y (), rect.width (), rect.height ());
+				});
+	}
+
 	QList<ILink_ptr> Document::GetPageLinks (int num)
 	{
 		QList<ILink_ptr> result;
@@ -283,6 +296,35 @@ namespace PDF
 		return result;
 	}
 
+	void Document::ExtractTextLayout (const PageHandler_f& handler)
+	{
+		// Poppler documents aren't thread-safe, so a separate instance is
+		// used like in GetTextPositions().
+		const std::unique_ptr<Poppler::Document> doc (Poppler::Document::load (DocURL_.toLocalFile ()));
+		if (!doc)
+			return;
+
+		for (int i = 0, numPages = doc->numPages (); i < numPages; ++i)
+		{
+			QList<TextBox> boxes;
+
+			const std::unique_ptr<Poppler::Page> page (doc->page (i));
+			if (page)
+			{
+				const auto& size = page->pageSizeF ();
+				const auto& scaleMat = QMatrix {}.scale (1 / size.width (), 1 / size.height ());
+				for (const auto box : page->textList ())
+				{
+					boxes.append ({ box->text (), scaleMat.mapRect (box->boundingBox ()) });
+					delete box;
+				}
+			}
+
+			if (!handler (i, boxes))
+				return;
+		}
+	}
+
 	auto Document::CanSave () const -> SaveQueryResult
 	{
 		if (PDocument_->isEncrypted ())
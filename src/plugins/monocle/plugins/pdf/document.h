@@ -42,6 +42,8 @@
 #include <interfaces/monocle/isaveabledocument.h>
 #include <interfaces/monocle/isupportpainting.h>
 #include <interfaces/monocle/ihaveoptionalcontent.h>
+#include <interfaces/monocle/isupporttiledrendering.h>
+#include <interfaces/monocle/ihavetextlayout.h>
 
 namespace Poppler
 {
@@ -67,6 +69,8 @@ namespace PDF
 				   , public ISupportPainting
 				   , public ISearchableDocument
 				   , public ISaveableDocument
+				   , public ISupportTiledRendering
+				   , public IHaveTextLayout
 	{
 		Q_OBJECT
 		Q_INTERFACES (LC::Monocle::IDocument
@@ -78,7 +82,9 @@ namespace PDF
 				LC::Monocle::ISupportForms
 				LC::Monocle::ISupportPainting
 				LC::Monocle::ISearchableDocument
-				LC::Monocle::ISaveableDocument)
+				LC::Monocle::ISaveableDocument
+				LC::Monocle::ISupportTiledRendering
+				LC::Monocle::IHaveTextLayout)
 
 		PDocument_ptr PDocument_;
 		TOCEntryLevel_t TOC_;
@@ -95,6 +101,7 @@ namespace PDF
 		int GetNumPages () const;
 		QSize GetPageSize (int) const;
 		QFuture<QImage> RenderPage (int, double, double);
+		QFuture<QImage> RenderPageTile (int, double, double, const QRect&);
 		QList<ILink_ptr> GetPageLinks (int);
 		QUrl GetDocURL () const;
 
@@ -114,6 +121,8 @@ namespace PDF
 
 		QMap<int, QList<QRectF>> GetTextPositions (const QString&, Qt::CaseSensitivity);
 
+		void ExtractTextLayout (const PageHandler_f&);
+
 		SaveQueryResult CanSave () const;
 		bool Save (const QString& path);
 
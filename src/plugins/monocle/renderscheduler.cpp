@@ -0,0 +1,249 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "renderscheduler.h"
+#include <algorithm>
+#include <QThread>
+#include <QtDebug>
+#include <util/threads/futures.h>
+#include "interfaces/monocle/isupporttiledrendering.h"
+#include "pagegraphicsitem.h"
+
+namespace LC
+{
+namespace Monocle
+{
+	RenderScheduler::RenderScheduler (const IDocument_ptr& doc)
+	: Doc_ { doc }
+	, TiledDoc_ { qobject_cast<ISupportTiledRendering*> (doc->GetQObject ()) }
+	, MaxRunning_ { std::max (QThread::idealThreadCount () / 2, 1) }
+	{
+	}
+
+	RenderScheduler::~RenderScheduler ()
+	{
+		for (auto& request : Queue_)
+			Drop (request);
+
+		qDebug () << Q_FUNC_INFO << Stats_;
+	}
+
+	std::shared_ptr<RenderScheduler> RenderScheduler::ForDocument (const IDocument_ptr& doc)
+	{
+		static QHash<IDocument*, std::weak_ptr<RenderScheduler>> schedulers;
+
+		auto& weak = schedulers [doc.get ()];
+		if (const auto existing = weak.lock ())
+			return existing;
+
+		for (auto it = schedulers.begin (); it != schedulers.end (); )
+			if (it->expired () && it.key () != doc.get ())
+				it = schedulers.erase (it);
+			else
+				++it;
+
+		const auto scheduler = std::make_shared<RenderScheduler> (doc);
+		schedulers [doc.get ()] = scheduler;
+		return scheduler;
+	}
+
+	void RenderScheduler::RegisterItem (PageGraphicsItem *item)
+	{
+		Items_.insert (item->GetPageNum (), item);
+	}
+
+	void RenderScheduler::UnregisterItem (PageGraphicsItem *item)
+	{
+		Cancel (item);
+		CancelTiles (item);
+		Items_.remove (item->GetPageNum (), item);
+	}
+
+	QFuture<QImage> RenderScheduler::Render (PageGraphicsItem *item,
+			double xScale, double yScale, Priority priority)
+	{
+		Cancel (item);
+
+		Request request { item, xScale, yScale, priority, {}, {}, {} };
+		const auto& future = request.Promise_.future ();
+		Enqueue (request);
+		return future;
+	}
+
+	void RenderScheduler::Cancel (PageGraphicsItem *item)
+	{
+		const auto pos = std::find_if (Queue_.begin (), Queue_.end (),
+				[item] (const Request& request) { return request.Item_ == item && request.Tile_.isNull (); });
+		if (pos == Queue_.end ())
+			return;
+
+		auto request = *pos;
+		Queue_.erase (pos);
+		Drop (request);
+	}
+
+	QFuture<QImage> RenderScheduler::RenderTile (PageGraphicsItem *item,
+			double xScale, double yScale, const QRect& tile)
+	{
+		if (!TiledDoc_)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "the document doesn't support tiled rendering";
+			return Util::MakeReadyFuture (QImage {});
+		}
+
+		Request request { item, xScale, yScale, Priority::Visible, tile, {}, {} };
+		const auto& future = request.Promise_.future ();
+		Enqueue (request);
+		return future;
+	}
+
+	void RenderScheduler::CancelTiles (PageGraphicsItem *item)
+	{
+		for (auto it = Queue_.begin (); it != Queue_.end (); )
+		{
+			if (it->Item_ != item || it->Tile_.isNull ())
+			{
+				++it;
+				continue;
+			}
+
+			auto request = *it;
+			it = Queue_.erase (it);
+			Drop (request);
+		}
+	}
+
+	void RenderScheduler::SchedulePrefetch (int page)
+	{
+		if (page < 0 || page >= Doc_->GetNumPages ())
+			return;
+
+		PrefetchPages_ << page;
+		RunPrefetch ();
+	}
+
+	const RenderScheduler::Stats& RenderScheduler::GetStats () const
+	{
+		return Stats_;
+	}
+
+	void RenderScheduler::Enqueue (Request request)
+	{
+		++Stats_.Requested_;
+
+		request.Promise_.reportStarted ();
+		request.Timer_.start ();
+
+		const auto pos = request.Priority_ == Priority::Visible ?
+				std::find_if (Queue_.begin (), Queue_.end (),
+						[] (const Request& other) { return other.Priority_ == Priority::Prefetch; }) :
+				Queue_.end ();
+		Queue_.insert (pos, request);
+
+		RunNext ();
+	}
+
+	void RenderScheduler::Drop (Request& request)
+	{
+		++Stats_.Dropped_;
+
+		request.Promise_.reportResult (QImage {});
+		request.Promise_.reportFinished ();
+	}
+
+	void RenderScheduler::RunNext ()
+	{
+		while (Running_ < MaxRunning_ && !Queue_.isEmpty ())
+		{
+			auto request = Queue_.takeFirst ();
+			if (request.Priority_ == Priority::Visible && !request.Item_->IsDisplayed ())
+			{
+				Drop (request);
+				continue;
+			}
+
+			++Running_;
+
+			Util::Sequence (this, Start (request)) >>
+					[this, request] (const QImage& image) mutable
+					{
+						--Running_;
+
+						const auto latency = request.Timer_.elapsed ();
+						Stats_.TotalLatency_ += latency;
+						Stats_.MaxLatency_ = std::max (Stats_.MaxLatency_, latency);
+						++(request.Priority_ == Priority::Visible ? Stats_.Rendered_ : Stats_.Prefetched_);
+
+						request.Promise_.reportResult (image);
+						request.Promise_.reportFinished ();
+
+						RunNext ();
+					};
+		}
+
+		RunPrefetch ();
+	}
+
+	QFuture<QImage> RenderScheduler::Start (const Request& request)
+	{
+		const auto page = request.Item_->GetPageNum ();
+		return request.Tile_.isNull () ?
+				Doc_->RenderPage (page, request.XScale_, request.YScale_) :
+				TiledDoc_->RenderPageTile (page, request.XScale_, request.YScale_, request.Tile_);
+	}
+
+	void RenderScheduler::RunPrefetch ()
+	{
+		if (Running_ || !Queue_.isEmpty () || PrefetchPages_.isEmpty ())
+			return;
+
+		const auto pages = PrefetchPages_;
+		PrefetchPages_.clear ();
+
+		for (const auto page : pages)
+			for (const auto item : Items_.values (page))
+				item->Prefetch ();
+	}
+
+	QDebug operator<< (QDebug dbg, const RenderScheduler::Stats& stats)
+	{
+		QDebugStateSaver saver { dbg };
+		const auto finished = stats.Rendered_ + stats.Prefetched_;
+		dbg.nospace () << "RenderScheduler::Stats { requested: " << stats.Requested_
+				<< "; rendered: " << stats.Rendered_
+				<< "; prefetched: " << stats.Prefetched_
+				<< "; dropped: " << stats.Dropped_
+				<< "; avg latency: " << (finished ? stats.TotalLatency_ / static_cast<qint64> (finished) : 0)
+				<< " ms; max latency: " << stats.MaxLatency_
+				<< " ms }";
+		return dbg;
+	}
+}
+}
@@ -0,0 +1,147 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <QObject>
+#include <QFutureInterface>
+#include <QElapsedTimer>
+#include <QMultiHash>
+#include <QSet>
+#include <QRect>
+#include "interfaces/monocle/idocument.h"
+
+class QDebug;
+
+namespace LC
+{
+namespace Monocle
+{
+	class PageGraphicsItem;
+	class ISupportTiledRendering;
+
+	/** Serializes the page render requests for a single document.
+	 *
+	 * Each page item has at most one pending request: a new request
+	 * from the same item replaces the pending one, and pending requests
+	 * for items that are no longer visible by the time they would be
+	 * started are dropped. Visible pages are rendered before prefetched
+	 * ones, and neighbor pages are prefetched when there is nothing else
+	 * to render.
+	 *
+	 * Tiles of the pages rendered tile by tile go through the same queue
+	 * with the visible priority, but an item may have any number of
+	 * pending tile requests.
+	 *
+	 * The futures of dropped requests are finished with a null image.
+	 */
+	class RenderScheduler : public QObject
+	{
+		Q_OBJECT
+	public:
+		enum class Priority
+		{
+			Visible,
+			Prefetch
+		};
+
+		struct Stats
+		{
+			quint64 Requested_ = 0;
+			quint64 Rendered_ = 0;
+			quint64 Prefetched_ = 0;
+			quint64 Dropped_ = 0;
+
+			qint64 TotalLatency_ = 0;
+			qint64 MaxLatency_ = 0;
+		};
+	private:
+		const IDocument_ptr Doc_;
+		ISupportTiledRendering * const TiledDoc_;
+
+		struct Request
+		{
+			PageGraphicsItem *Item_;
+			double XScale_;
+			double YScale_;
+			Priority Priority_;
+			QRect Tile_;
+			QFutureInterface<QImage> Promise_;
+			QElapsedTimer Timer_;
+		};
+		QList<Request> Queue_;
+
+		int Running_ = 0;
+		const int MaxRunning_;
+
+		QMultiHash<int, PageGraphicsItem*> Items_;
+		QSet<int> PrefetchPages_;
+
+		Stats Stats_;
+	public:
+		RenderScheduler (const IDocument_ptr&);
+		~RenderScheduler ();
+
+		/** Returns the scheduler for the given document, creating one
+		 * if there is no scheduler for it yet.
+		 */
+		static std::shared_ptr<RenderScheduler> ForDocument (const IDocument_ptr&);
+
+		void RegisterItem (PageGraphicsItem*);
+		void UnregisterItem (PageGraphicsItem*);
+
+		QFuture<QImage> Render (PageGraphicsItem*, double xScale, double yScale, Priority);
+		void Cancel (PageGraphicsItem*);
+
+		/** Renders the given rectangle of the page scaled by \em xScale
+		 * and \em yScale.
+		 *
+		 * The document should implement ISupportTiledRendering.
+		 */
+		QFuture<QImage> RenderTile (PageGraphicsItem*, double xScale, double yScale, const QRect&);
+		void CancelTiles (PageGraphicsItem*);
+
+		/** Asks the scheduler to prefetch the given page once there is
+		 * nothing else to render.
+		 */
+		void SchedulePrefetch (int page);
+
+		const Stats& GetStats () const;
+	private:
+		void Enqueue (Request);
+		void Drop (Request&);
+		QFuture<QImage> Start (const Request&);
+		void RunNext ();
+		void RunPrefetch ();
+	};
+
+	QDebug operator<< (QDebug, const RenderScheduler::Stats&);
+}
+}
@@ -63,6 +63,41 @@ namespace Monocle
 	{
 		Model_->clear ();
 		Root2Results_.clear ();
+		LastRoot_ = nullptr;
+	}
+
+	namespace
+	{
+		QList<QStandardItem*> MakePageItems (const TextSearchHandlerResults& results, int& globalPosIdx)
+		{
+			QList<QStandardItem*> pageItems;
+			for (const auto& pair : Util::Stlize (results.Positions_))
+			{
+				const auto& posList = pair.second;
+				if (posList.isEmpty ())
+					continue;
+
+				const auto pageItem = new QStandardItem { SearchTabWidget::tr ("Page %1").arg (pair.first + 1) };
+				pageItem->setData (globalPosIdx, static_cast<int> (SearchModelRole::PageFirstIdx));
+				pageItem->setEditable (false);
+				for (int i = 0; i < posList.size (); ++i, ++globalPosIdx)
+				{
+					const auto posItem = new QStandardItem { SearchTabWidget::tr ("Occurrence %1").arg (i + 1) };
+					posItem->setData (globalPosIdx, static_cast<int> (SearchModelRole::OverallIdx));
+					posItem->setEditable (false);
+					pageItem->appendRow (posItem);
+				}
+
+				pageItems << pageItem;
+			}
+
+			return pageItems;
+		}
+
+		QString MakeRootText (const TextSearchHandlerResults& results, int count)
+		{
+			return SearchTabWidget::tr ("%1 (%n occurrence(s))", nullptr, count).arg (results.Text_);
+		}
 	}
 
 	void SearchTabWidget::handleSearchResults (const TextSearchHandlerResults& results)
@@ -71,36 +106,33 @@ namespace Monocle
 				[] (const QList<QRectF>& list) { return list.isEmpty (); }))
 			return;
 
-		QList<QStandardItem*> pageItems;
-		int globalPosIdx = 0;
-		for (const auto& pair : Util::Stlize (results.Positions_))
+		int count = 0;
+		const auto& pageItems = MakePageItems (results, count);
+		if (pageItems.isEmpty ())
+			return;
+
+		// The results for the same search may arrive in several steps as
+		// the document gets indexed, so the existing root is updated then.
+		if (LastRoot_)
 		{
-			const auto& posList = pair.second;
-			if (posList.isEmpty ())
-				continue;
-
-			const auto pageItem = new QStandardItem { tr ("Page %1").arg (pair.first + 1) };
-			pageItem->setData (globalPosIdx, static_cast<int> (SearchModelRole::PageFirstIdx));
-			pageItem->setEditable (false);
-			for (int i = 0; i < posList.size (); ++i, ++globalPosIdx)
+			const auto& lastResults = Root2Results_.value (LastRoot_);
+			if (lastResults.Text_ == results.Text_ &&
+					lastResults.FindFlags_ == results.FindFlags_)
 			{
-				const auto posItem = new QStandardItem { tr ("Occurrence %1").arg (i + 1) };
-				posItem->setData (globalPosIdx, static_cast<int> (SearchModelRole::OverallIdx));
-				posItem->setEditable (false);
-				pageItem->appendRow (posItem);
+				LastRoot_->removeRows (0, LastRoot_->rowCount ());
+				LastRoot_->appendRows (pageItems);
+				LastRoot_->setText (MakeRootText (results, count));
+				Root2Results_ [LastRoot_] = results;
+				return;
 			}
-
-			pageItems << pageItem;
 		}
 
-		if (pageItems.isEmpty ())
-			return;
-
-		const auto searchItem = new QStandardItem { results.Text_ };
+		const auto searchItem = new QStandardItem { MakeRootText (results, count) };
 		searchItem->appendRows (pageItems);
 		searchItem->setEditable (false);
 
 		Root2Results_ [searchItem] = results;
+		LastRoot_ = searchItem;
 
 		Model_->insertRow (0, searchItem);
 		Ui_.ResultsTree_->expand (searchItem->index ());
@@ -56,6 +56,7 @@ namespace Monocle
 		TextSearchHandler * const SearchHandler_;
 
 		QMap<QStandardItem*, TextSearchHandlerResults> Root2Results_;
+		QStandardItem *LastRoot_ = nullptr;
 	public:
 		SearchTabWidget (TextSearchHandler*, QWidget* = nullptr);
 
@@ -0,0 +1,342 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "textindex.h"
+#include <algorithm>
+#include <functional>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QtConcurrentRun>
+#include <QtDebug>
+#include <util/sys/paths.h>
+#include "interfaces/monocle/ihavetextlayout.h"
+
+namespace LC
+{
+namespace Monocle
+{
+	namespace
+	{
+		const int BatchSize = 16;
+		const qint32 CacheVersion = 1;
+
+		QDataStream& operator<< (QDataStream& out, const TextIndex::Page& page)
+		{
+			return out << page.Text_ << page.Offsets_ << page.Rects_;
+		}
+
+		QDataStream& operator>> (QDataStream& in, TextIndex::Page& page)
+		{
+			return in >> page.Text_ >> page.Offsets_ >> page.Rects_;
+		}
+
+		QString GetCachePath (const QString& docPath)
+		{
+			QFile file { docPath };
+			if (!file.open (QIODevice::ReadOnly))
+				return {};
+
+			QCryptographicHash hash { QCryptographicHash::Sha1 };
+			if (!hash.addData (&file))
+				return {};
+
+			return Util::GetUserDir (Util::UserDir::Cache, "monocle/textindex")
+					.filePath (hash.result ().toHex ());
+		}
+
+		QVector<TextIndex::Page> LoadCached (const QString& cachePath, int numPages)
+		{
+			QFile file { cachePath };
+			if (!file.open (QIODevice::ReadOnly))
+				return {};
+
+			QDataStream in { qUncompress (file.readAll ()) };
+			qint32 version = 0;
+			in >> version;
+			if (version != CacheVersion)
+				return {};
+
+			QVector<TextIndex::Page> pages;
+			in >> pages;
+			if (in.status () != QDataStream::Ok || pages.size () != numPages)
+				return {};
+
+			return pages;
+		}
+
+		void SaveCached (const QString& cachePath, const QVector<TextIndex::Page>& pages)
+		{
+			QByteArray data;
+			{
+				QDataStream out { &data, QIODevice::WriteOnly };
+				out << CacheVersion << pages;
+			}
+
+			QFile file { cachePath };
+			if (!file.open (QIODevice::WriteOnly))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to open"
+						<< cachePath
+						<< file.errorString ();
+				return;
+			}
+
+			file.write (qCompress (data));
+		}
+
+		TextIndex::Page MakePage (const QList<TextBox>& boxes)
+		{
+			TextIndex::Page page;
+			page.Offsets_.reserve (boxes.size ());
+			page.Rects_.reserve (boxes.size ());
+
+			for (const auto& box : boxes)
+			{
+				if (!page.Text_.isEmpty ())
+					page.Text_ += ' ';
+
+				page.Offsets_ << page.Text_.size ();
+				page.Rects_ << box.Rect_;
+				page.Text_ += box.Text_;
+			}
+
+			return page;
+		}
+
+		using Extractor_f = std::function<void (const IHaveTextLayout::PageHandler_f&)>;
+
+		void BuildIndex (QFutureInterface<TextIndex::Batch> iface,
+				const QString& docPath, int numPages, const Extractor_f& extract)
+		{
+			iface.reportStarted ();
+
+			QElapsedTimer timer;
+			timer.start ();
+
+			const auto& cachePath = GetCachePath (docPath);
+
+			if (!cachePath.isEmpty ())
+			{
+				const auto& cached = LoadCached (cachePath, numPages);
+				if (!cached.isEmpty ())
+				{
+					iface.reportResult ({ 0, cached });
+					iface.reportFinished ();
+					return;
+				}
+			}
+
+			QVector<TextIndex::Page> allPages;
+			allPages.reserve (numPages);
+
+			TextIndex::Batch batch { 0, {} };
+			extract ([&] (int, const QList<TextBox>& boxes)
+					{
+						if (iface.isCanceled ())
+							return false;
+
+						batch.Pages_ << MakePage (boxes);
+						if (batch.Pages_.size () >= BatchSize)
+						{
+							allPages += batch.Pages_;
+							iface.reportResult (batch);
+							batch = { allPages.size (), {} };
+						}
+						return true;
+					});
+
+			if (!batch.Pages_.isEmpty () && !iface.isCanceled ())
+			{
+				allPages += batch.Pages_;
+				iface.reportResult (batch);
+			}
+
+			if (!iface.isCanceled () && allPages.size () == numPages && !cachePath.isEmpty ())
+			{
+				SaveCached (cachePath, allPages);
+
+				qDebug () << Q_FUNC_INFO
+						<< "indexed"
+						<< numPages
+						<< "pages of"
+						<< docPath
+						<< "in"
+						<< timer.elapsed ()
+						<< "ms";
+			}
+
+			iface.reportFinished ();
+		}
+	}
+
+	TextIndex::TextIndex (const IDocument_ptr& doc, QObject *parent)
+	: QObject { parent }
+	, Doc_ { doc }
+	, Watcher_ { new QFutureWatcher<Batch> { this } }
+	{
+		connect (Watcher_,
+				SIGNAL (resultsReadyAt (int, int)),
+				this,
+				SLOT (handleResultsReady (int, int)));
+		connect (Watcher_,
+				SIGNAL (finished ()),
+				this,
+				SLOT (handleFinished ()));
+
+		if (!CanIndex (doc))
+		{
+			IsReady_ = true;
+			return;
+		}
+
+		const auto& docPath = doc->GetDocURL ().toLocalFile ();
+		const auto numPages = doc->GetNumPages ();
+		Pages_.reserve (numPages);
+
+		// The worker only gets the raw layout interface: Doc_ keeps the
+		// document alive until the worker is done, see ~TextIndex().
+		const auto layout = qobject_cast<IHaveTextLayout*> (doc->GetQObject ());
+		const Extractor_f extract = [layout] (const IHaveTextLayout::PageHandler_f& handler)
+				{
+					layout->ExtractTextLayout (handler);
+				};
+
+		QFutureInterface<Batch> iface;
+		Watcher_->setFuture (iface.future ());
+		QtConcurrent::run ([iface, docPath, numPages, extract]
+				{ BuildIndex (iface, docPath, numPages, extract); });
+	}
+
+	TextIndex::~TextIndex ()
+	{
+		// The page handler stops the extraction as soon as it sees the
+		// cancellation, so this waits for at most a single page.
+		Watcher_->cancel ();
+		Watcher_->waitForFinished ();
+	}
+
+	bool TextIndex::CanIndex (const IDocument_ptr& doc)
+	{
+		return doc &&
+				doc->GetDocURL ().isLocalFile () &&
+				qobject_cast<IHaveTextLayout*> (doc->GetQObject ());
+	}
+
+	bool TextIndex::IsReady () const
+	{
+		return IsReady_;
+	}
+
+	int TextIndex::GetIndexedPagesCount () const
+	{
+		return Pages_.size ();
+	}
+
+	QMap<int, QList<QRectF>> TextIndex::Search (const QString& text,
+			Qt::CaseSensitivity cs, const QList<int>& pages) const
+	{
+		QMap<int, QList<QRectF>> result;
+		for (const auto page : pages)
+			if (page >= 0 && page < Pages_.size ())
+				SearchPage (result, page, text, cs);
+		return result;
+	}
+
+	QMap<int, QList<QRectF>> TextIndex::Search (const QString& text,
+			Qt::CaseSensitivity cs, int from, int to) const
+	{
+		QMap<int, QList<QRectF>> result;
+		for (int page = std::max (from, 0), end = std::min (to, Pages_.size ()); page < end; ++page)
+			SearchPage (result, page, text, cs);
+		return result;
+	}
+
+	void TextIndex::SearchPage (QMap<int, QList<QRectF>>& result, int pageIdx,
+			const QString& text, Qt::CaseSensitivity cs) const
+	{
+		if (text.isEmpty ())
+			return;
+
+		const auto& page = Pages_.at (pageIdx);
+		const auto& offsets = page.Offsets_;
+
+		for (int pos = page.Text_.indexOf (text, 0, cs); pos >= 0;
+				pos = page.Text_.indexOf (text, pos + text.size (), cs))
+		{
+			const auto end = pos + text.size ();
+
+			auto word = std::upper_bound (offsets.begin (), offsets.end (), pos) - offsets.begin () - 1;
+			QRectF rect;
+			for (word = std::max (word, 0); word < offsets.size () && offsets.at (word) < end; ++word)
+				rect |= page.Rects_.at (word);
+
+			if (!rect.isNull ())
+				result [pageIdx] << rect;
+		}
+	}
+
+	void TextIndex::handleResultsReady (int from, int to)
+	{
+		const auto prevCount = Pages_.size ();
+
+		for (int i = from; i < to; ++i)
+		{
+			const auto& batch = Watcher_->resultAt (i);
+			if (batch.From_ != Pages_.size ())
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unexpected batch start"
+						<< batch.From_
+						<< "for"
+						<< Pages_.size ()
+						<< "indexed pages";
+				continue;
+			}
+
+			Pages_ += batch.Pages_;
+		}
+
+		if (Pages_.size () != prevCount)
+			emit pagesIndexed (prevCount, Pages_.size () - prevCount);
+	}
+
+	void TextIndex::handleFinished ()
+	{
+		if (Watcher_->isCanceled ())
+			return;
+
+		IsReady_ = true;
+		emit ready ();
+	}
+}
+}
@@ -0,0 +1,122 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QVector>
+#include <QRectF>
+#include <QMap>
+#include "interfaces/monocle/idocument.h"
+
+template<typename>
+class QFutureWatcher;
+
+namespace LC
+{
+namespace Monocle
+{
+	/** Full-text index of a document supporting IHaveTextLayout.
+	 *
+	 * The index is built in background as soon as it is created, and
+	 * the pages become searchable in order as they are indexed. Complete
+	 * indexes are cached on disk keyed by the hash of the document file,
+	 * so reopening a document doesn't need to extract its text again.
+	 */
+	class TextIndex : public QObject
+	{
+		Q_OBJECT
+	public:
+		struct Page
+		{
+			/** The words of the page joined with spaces.
+			 */
+			QString Text_;
+
+			/** The offsets of the words in Text_.
+			 */
+			QVector<int> Offsets_;
+
+			/** The relative page rectangles of the words.
+			 */
+			QVector<QRectF> Rects_;
+		};
+
+		struct Batch
+		{
+			int From_;
+			QVector<Page> Pages_;
+		};
+	private:
+		QVector<Page> Pages_;
+		bool IsReady_ = false;
+
+		/** Kept here so that the document is only ever destroyed in
+		 * the GUI thread, and not by the indexing worker.
+		 */
+		const IDocument_ptr Doc_;
+
+		QFutureWatcher<Batch> * const Watcher_;
+	public:
+		TextIndex (const IDocument_ptr&, QObject* = nullptr);
+		~TextIndex ();
+
+		/** Returns whether the given document can be indexed.
+		 */
+		static bool CanIndex (const IDocument_ptr&);
+
+		bool IsReady () const;
+		int GetIndexedPagesCount () const;
+
+		/** Searches for the \em text in the given indexed pages.
+		 *
+		 * The pages that aren't indexed yet are skipped. The result has
+		 * the same format as ISearchableDocument::GetTextPositions(),
+		 * with a single rectangle per occurrence.
+		 */
+		QMap<int, QList<QRectF>> Search (const QString& text,
+				Qt::CaseSensitivity, const QList<int>& pages) const;
+
+		/** Searches for the \em text in the pages from \em from
+		 * (inclusive) to \em to (exclusive).
+		 */
+		QMap<int, QList<QRectF>> Search (const QString& text,
+				Qt::CaseSensitivity, int from, int to) const;
+	private:
+		void SearchPage (QMap<int, QList<QRectF>>&, int,
+				const QString&, Qt::CaseSensitivity) const;
+	private slots:
+		void handleResultsReady (int, int);
+		void handleFinished ();
+	signals:
+		void pagesIndexed (int from, int count);
+		void ready ();
+	};
+}
+}
@@ -35,6 +35,7 @@
 #include "interfaces/monocle/isearchabledocument.h"
 #include "pagegraphicsitem.h"
 #include "pageslayoutmanager.h"
+#include "textindex.h"
 
 namespace LC
 {
@@ -57,6 +58,18 @@ namespace Monocle
 		CurrentHighlights_.clear ();
 		CurrentRectIndex_ = -1;
 		CurrentSearchString_.clear ();
+		CurrentResults_.clear ();
+
+		delete Index_;
+		Index_ = nullptr;
+		if (TextIndex::CanIndex (doc))
+		{
+			Index_ = new TextIndex { doc, this };
+			connect (Index_,
+					SIGNAL (pagesIndexed (int, int)),
+					this,
+					SLOT (handlePagesIndexed (int, int)));
+		}
 	}
 
 	bool TextSearchHandler::Search (const QString& text, Util::FindNotification::FindFlags flags)
@@ -104,14 +117,29 @@ namespace Monocle
 		{
 			ClearHighlights ();
 			CurrentSearchString_ = results.Text_;
+			CurrentFlags_ = results.FindFlags_;
+			CurrentResults_ = results.Positions_;
 			BuildHighlights (results.Positions_);
 		}
 
 		SelectItem (select);
 	}
 
+	namespace
+	{
+		Qt::CaseSensitivity GetCaseSensitivity (Util::FindNotification::FindFlags flags)
+		{
+			return flags & Util::FindNotification::FindCaseSensitively ?
+					Qt::CaseSensitive :
+					Qt::CaseInsensitive;
+		}
+	}
+
 	bool TextSearchHandler::RequestSearch (const QString& text, Util::FindNotification::FindFlags flags)
 	{
+		if (Index_)
+			return RequestIndexSearch (text, flags);
+
 		ClearHighlights ();
 		CurrentSearchString_ = text;
 
@@ -119,10 +147,7 @@ namespace Monocle
 		if (!searchable)
 			return false;
 
-		const auto cs = flags & Util::FindNotification::FindCaseSensitively ?
-				Qt::CaseSensitive :
-				Qt::CaseInsensitive;
-		const auto& map = searchable->GetTextPositions (text, cs);
+		const auto& map = searchable->GetTextPositions (text, GetCaseSensitivity (flags));
 		emit gotSearchResults ({ text, flags, map });
 
 		BuildHighlights (map);
@@ -133,6 +158,37 @@ namespace Monocle
 		return !CurrentHighlights_.isEmpty ();
 	}
 
+	bool TextSearchHandler::RequestIndexSearch (const QString& text, Util::FindNotification::FindFlags flags)
+	{
+		ClearHighlights ();
+
+		const auto cs = GetCaseSensitivity (flags);
+
+		// The results for the previous query cover all the indexed pages,
+		// so if the new query extends it, only the pages having matched the
+		// previous one need to be searched.
+		const auto& prevText = CurrentSearchString_;
+		const bool narrows = !prevText.isEmpty () &&
+				CurrentFlags_ == flags &&
+				text.startsWith (prevText, cs);
+		CurrentResults_ = narrows ?
+				Index_->Search (text, cs, CurrentResults_.keys ()) :
+				Index_->Search (text, cs, 0, Index_->GetIndexedPagesCount ());
+
+		CurrentSearchString_ = text;
+		CurrentFlags_ = flags;
+
+		emit gotSearchResults ({ text, flags, CurrentResults_ });
+
+		BuildHighlights (CurrentResults_);
+
+		if (!CurrentHighlights_.isEmpty ())
+			SelectItem (0);
+
+		// The rest of the pages will be searched as soon as they are indexed.
+		return !CurrentHighlights_.isEmpty () || !Index_->IsReady ();
+	}
+
 	void TextSearchHandler::BuildHighlights (const QMap<int, QList<QRectF>>& map)
 	{
 		const QBrush brush (Qt::yellow);
@@ -166,6 +222,27 @@ namespace Monocle
 		CurrentHighlights_.clear ();
 	}
 
+	void TextSearchHandler::handlePagesIndexed (int from, int count)
+	{
+		if (CurrentSearchString_.isEmpty ())
+			return;
+
+		const auto& newResults = Index_->Search (CurrentSearchString_,
+				GetCaseSensitivity (CurrentFlags_), from, from + count);
+		if (newResults.isEmpty ())
+			return;
+
+		for (const auto& pair : Util::Stlize (newResults))
+			CurrentResults_ [pair.first] = pair.second;
+
+		const bool hadHighlights = !CurrentHighlights_.isEmpty ();
+		BuildHighlights (newResults);
+		if (!hadHighlights)
+			SelectItem (0);
+
+		emit gotSearchResults ({ CurrentSearchString_, CurrentFlags_, CurrentResults_ });
+	}
+
 	void TextSearchHandler::SelectItem (int index)
 	{
 		if (CurrentRectIndex_ >= 0 && CurrentRectIndex_ < CurrentHighlights_.size ())
@@ -44,6 +44,7 @@ namespace Monocle
 {
 	class PageGraphicsItem;
 	class PagesLayoutManager;
+	class TextIndex;
 
 	struct TextSearchHandlerResults
 	{
@@ -63,7 +64,11 @@ namespace Monocle
 		IDocument_ptr Doc_;
 		QList<PageGraphicsItem*> Pages_;
 
+		TextIndex *Index_ = nullptr;
+
 		QString CurrentSearchString_;
+		Util::FindNotification::FindFlags CurrentFlags_;
+		QMap<int, QList<QRectF>> CurrentResults_;
 
 		QList<QGraphicsRectItem*> CurrentHighlights_;
 		int CurrentRectIndex_;
@@ -76,11 +81,14 @@ namespace Monocle
 		void SetPreparedResults (const TextSearchHandlerResults&, int selectedItem);
 	private:
 		bool RequestSearch (const QString&, Util::FindNotification::FindFlags);
+		bool RequestIndexSearch (const QString&, Util::FindNotification::FindFlags);
 
 		void BuildHighlights (const QMap<int, QList<QRectF>>&);
 		void ClearHighlights ();
 
 		void SelectItem (int);
+	private slots:
+		void handlePagesIndexed (int, int);
 	signals:
 		void navigateRequested (const IDocument::Position&);
 
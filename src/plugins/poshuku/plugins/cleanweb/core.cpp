@@ -114,6 +114,7 @@ namespace CleanWeb
 	: UserFilters_ { ufm }
 	, SubsModel_ { model }
 	, Proxy_ { proxy }
+	, EnableFiltering_ { XmlSettingsManager::Instance (), "EnableFiltering" }
 	{
 		connect (SubsModel_,
 				SIGNAL (filtersListChanged ()),
@@ -332,9 +333,6 @@ namespace CleanWeb
 				const QList<QList<FilterItem_ptr>>& exceptions,
 				const QList<QList<FilterItem_ptr>>& filters)
 		{
-			if (!XmlSettingsManager::Instance ()->property ("EnableFiltering").toBool ())
-				return false;
-
 			if (!req.PageUrl_.isValid ())
 				return false;
 
@@ -400,7 +398,7 @@ namespace CleanWeb
 		auto interceptor = [this] (const IInterceptableRequests::RequestInfo& info)
 				-> IInterceptableRequests::Result_t
 		{
-			if (info.RequestUrl_.scheme () == "data")
+			if (!EnableFiltering_ () || info.RequestUrl_.scheme () == "data")
 				return IInterceptableRequests::Allow {};
 
 			if (!ShouldReject (info, ExceptionsCache_, FilterItemsCache_))
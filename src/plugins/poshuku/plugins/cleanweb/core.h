@@ -39,6 +39,7 @@
 #include <interfaces/idownload.h>
 #include <interfaces/poshuku/poshukutypes.h>
 #include <interfaces/core/ihookproxy.h>
+#include <xmlsettingsdialog/settingshandle.h>
 #include "filter.h"
 
 class QNetworkRequest;
@@ -77,6 +78,8 @@ namespace CleanWeb
 		QSet<IWebView*> ScheduledHidings_;
 
 		const ICoreProxy_ptr Proxy_;
+
+		const Util::SettingHandle<bool> EnableFiltering_;
 	public:
 		Core (SubscriptionsModel*, UserFiltersModel*, const ICoreProxy_ptr&);
 
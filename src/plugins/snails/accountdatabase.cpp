@@ -29,6 +29,7 @@
 
 #include "accountdatabase.h"
 #include <QDir>
+#include <QElapsedTimer>
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QSqlQuery>
@@ -107,6 +108,21 @@ namespace Snails
 		}
 	};
 
+	struct AccountDatabase::MessageBodyRef
+	{
+		oral::PKey<int> Id_;
+		oral::References<&Message::Id_> MsgId_;
+		QByteArray PlainTextHash_;
+		QByteArray HTMLHash_;
+
+		static QString ClassName ()
+		{
+			return "MessageBodyRefs";
+		}
+
+		using Constraints = oral::Constraints<oral::UniqueSubset<1>>;
+	};
+
 	struct AccountDatabase::Folder
 	{
 		oral::PKey<int> Id_;
@@ -177,6 +193,12 @@ BOOST_FUSION_ADAPT_STRUCT (LC::Snails::AccountDatabase::MessageBodies,
 		PlainText_,
 		HTML_)
 
+BOOST_FUSION_ADAPT_STRUCT (LC::Snails::AccountDatabase::MessageBodyRef,
+		Id_,
+		MsgId_,
+		PlainTextHash_,
+		HTMLHash_)
+
 BOOST_FUSION_ADAPT_STRUCT (LC::Snails::AccountDatabase::Folder,
 		Id_,
 		FolderPath_)
@@ -196,8 +218,9 @@ namespace LC
 {
 namespace Snails
 {
-	AccountDatabase::AccountDatabase (const QDir& dir, const Account *acc)
-	: DB_ { QSqlDatabase::addDatabase ("QSQLITE", Util::GenConnectionName ("SnailsStorage_" + acc->GetID ())) }
+	AccountDatabase::AccountDatabase (const QDir& dir, const QByteArray& accountId)
+	: DB_ { QSqlDatabase::addDatabase ("QSQLITE", Util::GenConnectionName ("SnailsStorage_" + accountId)) }
+	, Bodies_ { dir.filePath ("bodies") }
 	{
 		DB_.setDatabaseName (dir.filePath ("msgs.db"));
 		if (!DB_.open ())
@@ -216,6 +239,7 @@ namespace Snails
 		Attachments_ = Util::oral::AdaptPtr<Attachment> (DB_);
 
 		MessagesBodies_ = Util::oral::AdaptPtr<MessageBodies> (DB_);
+		MessageBodyRefs_ = Util::oral::AdaptPtr<MessageBodyRef> (DB_);
 
 		Folders_ = Util::oral::AdaptPtr<Folder> (DB_);
 		Msg2Folder_ = Util::oral::AdaptPtr<Msg2Folder> (DB_);
@@ -449,7 +473,7 @@ namespace Snails
 			Msg2Folder_->DeleteBy (sph::f<&Msg2Folder::Id_> == *id);
 	}
 
-	void AccountDatabase::SaveMessageBodies (const QStringList& folder,
+	bool AccountDatabase::SaveMessageBodies (const QStringList& folder,
 			const QByteArray& msgId, const Snails::MessageBodies& bodies)
 	{
 		auto msgPKey = GetMsgTableId (msgId, folder);
@@ -459,10 +483,23 @@ namespace Snails
 					<< "unknown message"
 					<< folder
 					<< msgId;
-			return;
+			return false;
 		}
 
-		MessagesBodies_->Insert ({ {}, *msgPKey, bodies.PlainText_, bodies.HTML_ });
+		const auto& plainHash = Bodies_.Put (bodies.PlainText_.toUtf8 ());
+		const auto& htmlHash = Bodies_.Put (bodies.HTML_.toUtf8 ());
+		if (!plainHash || !htmlHash)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to store the bodies of"
+					<< folder
+					<< msgId;
+			return false;
+		}
+
+		MessageBodyRefs_->Insert ({ {}, *msgPKey, *plainHash, *htmlHash },
+				oral::InsertAction::Replace::Fields<&MessageBodyRef::MsgId_>);
+		return true;
 	}
 
 	std::optional<MessageBodies> AccountDatabase::GetMessageBodies (const QStringList& folder, const QByteArray& msgId)
@@ -471,6 +508,24 @@ namespace Snails
 		if (!msgPKey)
 			return {};
 
+		if (const auto ref = MessageBodyRefs_->SelectOne (sph::fields<&MessageBodyRef::PlainTextHash_, &MessageBodyRef::HTMLHash_>,
+				sph::f<&MessageBodyRef::MsgId_> == *msgPKey))
+		{
+			const auto& [plainHash, htmlHash] = *ref;
+			const auto& plain = Bodies_.Get (plainHash);
+			const auto& html = Bodies_.Get (htmlHash);
+			if (!plain || !html)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "missing body blobs for"
+						<< folder
+						<< msgId;
+				return {};
+			}
+
+			return Snails::MessageBodies { QString::fromUtf8 (*plain), QString::fromUtf8 (*html) };
+		}
+
 		using Util::operator*;
 
 		return MessagesBodies_->SelectOne (sph::fields<&MessageBodies::PlainText_, &MessageBodies::HTML_>,
@@ -484,7 +539,8 @@ namespace Snails
 		if (!msgPKey)
 			return {};
 
-		return MessagesBodies_->Select (sph::count<>, sph::f<&MessageBodies::MsgId_> == *msgPKey);
+		return MessageBodyRefs_->Select (sph::count<>, sph::f<&MessageBodyRef::MsgId_> == *msgPKey) ||
+				MessagesBodies_->Select (sph::count<>, sph::f<&MessageBodies::MsgId_> == *msgPKey);
 	}
 
 	std::optional<bool> AccountDatabase::IsMessageRead (const QByteArray& msgId, const QStringList& folder)
@@ -587,6 +643,89 @@ namespace Snails
 		Msg2Folder_->Insert ({ {}, msgTableId, folderTableId, msgId });
 	}
 
+	void AccountDatabase::MigrateBodies (const std::atomic<bool>& cancelled)
+	{
+		if (!MessagesBodies_->Select (sph::count<>))
+			return;
+
+		qDebug () << Q_FUNC_INFO
+				<< "migrating message bodies to the blob store...";
+
+		QElapsedTimer timer;
+		timer.start ();
+
+		const auto batchSize = 500;
+		int count = 0;
+		while (!cancelled)
+		{
+			const auto& batch = MessagesBodies_->Select.Build ()
+					.Order (oral::OrderBy<sph::asc<&MessageBodies::Id_>>)
+					.Limit (batchSize)
+					();
+			if (batch.isEmpty ())
+				break;
+
+			// The blobs are written before the transaction is started, so
+			// that it doesn't block the other connections for too long.
+			QList<MessageBodyRef> refs;
+			for (const auto& body : batch)
+			{
+				const auto& plainHash = Bodies_.Put (body.PlainText_.toUtf8 ());
+				const auto& htmlHash = Bodies_.Put (body.HTML_.toUtf8 ());
+				if (!plainHash || !htmlHash)
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "unable to store the bodies, stopping after"
+							<< count
+							<< "bodies";
+					return;
+				}
+				refs.push_back ({ {}, body.MsgId_, *plainHash, *htmlHash });
+			}
+
+			Util::DBLock lock { DB_ };
+			lock.Init ();
+
+			for (const auto& ref : refs)
+				MessageBodyRefs_->Insert (ref,
+						oral::InsertAction::Replace::Fields<&MessageBodyRef::MsgId_>);
+
+			MessagesBodies_->DeleteBy (sph::f<&MessageBodies::Id_> < *batch.last ().Id_ + 1);
+
+			lock.Good ();
+
+			count += batch.size ();
+		}
+
+		if (cancelled)
+		{
+			qDebug () << Q_FUNC_INFO
+					<< "cancelled after"
+					<< count
+					<< "bodies";
+			return;
+		}
+
+		try
+		{
+			Util::RunTextQuery (DB_, "VACUUM;");
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to vacuum the database:"
+					<< e.what ();
+		}
+
+		qDebug () << Q_FUNC_INFO
+				<< "migrated"
+				<< count
+				<< "message bodies in"
+				<< timer.elapsed ()
+				<< "ms:"
+				<< Bodies_.GetStats ();
+	}
+
 	int AccountDatabase::AddFolder (const QStringList& folder)
 	{
 		if (KnownFolders_.contains (folder))
@@ -29,12 +29,14 @@
 
 #pragma once
 
+#include <atomic>
 #include <optional>
 #include <QObject>
 #include <QStringList>
 #include <QMap>
 #include <QSqlDatabase>
 #include <util/db/oral/oralfwd.h>
+#include "blobstore.h"
 
 class QDir;
 
@@ -54,12 +56,14 @@ namespace Snails
 	class AccountDatabase
 	{
 		QSqlDatabase DB_;
+		BlobStore Bodies_;
 	public:
 		struct Message;
 		struct Address;
 		struct Attachment;
 
 		struct MessageBodies;
+		struct MessageBodyRef;
 
 		struct Folder;
 		struct Msg2Folder;
@@ -70,6 +74,7 @@ namespace Snails
 		Util::oral::ObjectInfo_ptr<Attachment> Attachments_;
 
 		Util::oral::ObjectInfo_ptr<MessageBodies> MessagesBodies_;
+		Util::oral::ObjectInfo_ptr<MessageBodyRef> MessageBodyRefs_;
 
 		Util::oral::ObjectInfo_ptr<Folder> Folders_;
 		Util::oral::ObjectInfo_ptr<Msg2Folder> Msg2Folder_;
@@ -77,7 +82,7 @@ namespace Snails
 
 		QMap<QStringList, int> KnownFolders_;
 	public:
-		AccountDatabase (const QDir&, const Account*);
+		AccountDatabase (const QDir&, const QByteArray& accountId);
 
 		Util::DBLock BeginTransaction ();
 
@@ -93,7 +98,7 @@ namespace Snails
 		void AddMessage (const MessageInfo&);
 		void RemoveMessage (const QByteArray& msgId, const QStringList& folder);
 
-		void SaveMessageBodies (const QStringList& folder, const QByteArray& msgId, const Snails::MessageBodies&);
+		bool SaveMessageBodies (const QStringList& folder, const QByteArray& msgId, const Snails::MessageBodies&);
 		std::optional<Snails::MessageBodies> GetMessageBodies (const QStringList& folder, const QByteArray& msgId);
 		bool HasMessageBodies (const QStringList& folder, const QByteArray& msgId);
 
@@ -106,6 +111,17 @@ namespace Snails
 
 		std::optional<int> GetMsgTableId (const QByteArray& uniqueId);
 		std::optional<int> GetMsgTableId (const QByteArray& msgId, const QStringList& folder);
+
+		/** @brief Moves the bodies from the legacy table to the blob store.
+		 *
+		 * This may take a while for big mailboxes, so this is meant to be
+		 * called once per account off the GUI thread. The bodies that
+		 * are not migrated yet are still served from the legacy table.
+		 * The migration stops between the batches once \em cancelled is
+		 * set, or if a blob can't be stored, and continues from there
+		 * the next time.
+		 */
+		void MigrateBodies (const std::atomic<bool>& cancelled);
 	private:
 		int AddMessageUnfoldered (const MessageInfo&);
 		void AddMessageToFolder (int msgTableId, int folderTableId, const QByteArray& msgId);
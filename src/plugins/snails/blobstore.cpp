@@ -0,0 +1,236 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "blobstore.h"
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QSaveFile>
+#include <QtDebug>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace LC::Snails
+{
+	namespace
+	{
+		enum Codec : char
+		{
+			Zlib = 'q',
+			Zstd = 'z'
+		};
+
+#ifdef HAVE_ZSTD
+		const int ZstdLevel = 3;
+#endif
+
+		std::optional<QByteArray> Compress (const QByteArray& data)
+		{
+#ifdef HAVE_ZSTD
+			QByteArray result { static_cast<int> (ZSTD_compressBound (data.size ())) + 1, Qt::Uninitialized };
+			result [0] = Codec::Zstd;
+
+			const auto size = ZSTD_compress (result.data () + 1, result.size () - 1,
+					data.constData (), data.size (),
+					ZstdLevel);
+			if (ZSTD_isError (size))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to compress blob:"
+						<< ZSTD_getErrorName (size);
+				return {};
+			}
+
+			result.resize (size + 1);
+			return result;
+#else
+			auto result = qCompress (data);
+			result.prepend (Codec::Zlib);
+			return result;
+#endif
+		}
+
+		std::optional<QByteArray> Decompress (const QByteArray& blob)
+		{
+			if (blob.isEmpty ())
+				return {};
+
+			const auto payload = blob.constData () + 1;
+			const auto payloadSize = blob.size () - 1;
+
+			switch (blob [0])
+			{
+			case Codec::Zlib:
+			{
+				const auto& result = qUncompress (reinterpret_cast<const uchar*> (payload), payloadSize);
+				if (result.isEmpty ())
+					return {};
+				return result;
+			}
+			case Codec::Zstd:
+			{
+#ifdef HAVE_ZSTD
+				const auto rawSize = ZSTD_getFrameContentSize (payload, payloadSize);
+				if (rawSize == ZSTD_CONTENTSIZE_ERROR || rawSize == ZSTD_CONTENTSIZE_UNKNOWN)
+					return {};
+
+				QByteArray result { static_cast<int> (rawSize), Qt::Uninitialized };
+				const auto size = ZSTD_decompress (result.data (), result.size (), payload, payloadSize);
+				if (ZSTD_isError (size) || size != rawSize)
+					return {};
+				return result;
+#else
+				qWarning () << Q_FUNC_INFO
+						<< "the blob is compressed with zstd, but Snails is built without zstd support";
+				return {};
+#endif
+			}
+			}
+
+			qWarning () << Q_FUNC_INFO
+					<< "unknown codec"
+					<< blob [0];
+			return {};
+		}
+	}
+
+	BlobStore::BlobStore (const QDir& dir)
+	: Dir_ { dir }
+	{
+		// Put() will report the failure if the directory is still missing.
+		if (!Dir_.exists () && !Dir_.mkpath ("."))
+			qWarning () << Q_FUNC_INFO
+					<< "unable to create blobs directory"
+					<< Dir_.path ();
+	}
+
+	std::optional<QByteArray> BlobStore::Put (const QByteArray& data)
+	{
+		if (data.isEmpty ())
+			return QByteArray {};
+
+		const auto& hash = QCryptographicHash::hash (data, QCryptographicHash::Sha256).toHex ();
+
+		++Stats_.Puts_;
+
+		const auto& path = GetPath (hash);
+		if (QFile::exists (path))
+		{
+			++Stats_.DedupHits_;
+			Stats_.DedupBytes_ += data.size ();
+			return hash;
+		}
+
+		QElapsedTimer timer;
+		timer.start ();
+		const auto& compressed = Compress (data);
+		Stats_.CompressNs_ += timer.nsecsElapsed ();
+		if (!compressed)
+			return {};
+
+		Dir_.mkpath (hash.left (2));
+
+		QSaveFile file { path };
+		if (!file.open (QIODevice::WriteOnly) ||
+				file.write (*compressed) != compressed->size () ||
+				!file.commit ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to write"
+					<< path
+					<< file.errorString ();
+			return {};
+		}
+
+		Stats_.RawBytes_ += data.size ();
+		Stats_.StoredBytes_ += compressed->size ();
+
+		return hash;
+	}
+
+	std::optional<QByteArray> BlobStore::Get (const QByteArray& hash) const
+	{
+		if (hash.isEmpty ())
+			return QByteArray {};
+
+		QFile file { GetPath (hash) };
+		if (!file.open (QIODevice::ReadOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< file.fileName ()
+					<< file.errorString ();
+			return {};
+		}
+
+		const auto& result = Decompress (file.readAll ());
+		if (!result)
+			qWarning () << Q_FUNC_INFO
+					<< "corrupted blob"
+					<< hash;
+		return result;
+	}
+
+	bool BlobStore::Has (const QByteArray& hash) const
+	{
+		return hash.isEmpty () || QFile::exists (GetPath (hash));
+	}
+
+	const BlobStore::Stats& BlobStore::GetStats () const
+	{
+		return Stats_;
+	}
+
+	QString BlobStore::GetPath (const QByteArray& hash) const
+	{
+		return Dir_.filePath (hash.left (2) + '/' + hash);
+	}
+
+	QDebug operator<< (QDebug dbg, const BlobStore::Stats& stats)
+	{
+		QDebugStateSaver saver { dbg };
+
+		const auto ratio = stats.RawBytes_ ?
+				static_cast<double> (stats.StoredBytes_) / stats.RawBytes_ :
+				0;
+		const auto throughput = stats.CompressNs_ ?
+				stats.RawBytes_ * 1000.0 / stats.CompressNs_ :
+				0;
+
+		dbg.nospace () << "BlobStore::Stats { puts: " << stats.Puts_
+				<< ", dedup hits: " << stats.DedupHits_
+				<< ", dedup bytes: " << stats.DedupBytes_
+				<< ", raw bytes: " << stats.RawBytes_
+				<< ", stored bytes: " << stats.StoredBytes_
+				<< ", ratio: " << ratio
+				<< ", compression throughput: " << throughput << " MB/s }";
+		return dbg;
+	}
+}
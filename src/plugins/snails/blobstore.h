@@ -0,0 +1,102 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <optional>
+#include <QDir>
+#include <QByteArray>
+
+class QDebug;
+
+namespace LC::Snails
+{
+	/** @brief Content-addressed storage for compressed blobs.
+	 *
+	 * Each blob is stored in its own file named after the SHA-256 hash of
+	 * its (uncompressed) contents, so storing the same data several times
+	 * (for instance, when a message is copied between folders) costs
+	 * nothing. The blobs are compressed with zstd if it is available, or
+	 * with zlib otherwise.
+	 *
+	 * The empty blob is never stored and is represented by an empty hash.
+	 *
+	 * Different instances may safely share the same directory, even from
+	 * different threads, but a single instance is not thread-safe.
+	 */
+	class BlobStore
+	{
+		const QDir Dir_;
+	public:
+		struct Stats
+		{
+			quint64 Puts_ = 0;
+			quint64 DedupHits_ = 0;
+			quint64 DedupBytes_ = 0;
+
+			/** @brief The uncompressed size of the newly written blobs.
+			 */
+			quint64 RawBytes_ = 0;
+			/** @brief The compressed size of the newly written blobs.
+			 */
+			quint64 StoredBytes_ = 0;
+
+			qint64 CompressNs_ = 0;
+		};
+	private:
+		Stats Stats_;
+	public:
+		explicit BlobStore (const QDir& dir);
+
+		/** @brief Stores the \em data and returns its hash.
+		 *
+		 * @param[in] data The data to store.
+		 * @return The hex-encoded hash identifying the data, or an
+		 * empty optional if the data cannot be compressed or written
+		 * (for instance, if the disk is full).
+		 */
+		std::optional<QByteArray> Put (const QByteArray& data);
+
+		/** @brief Returns the data identified by the \em hash.
+		 *
+		 * @param[in] hash The hash returned by Put().
+		 * @return The data, or an empty optional if there is no such
+		 * blob or it is corrupted.
+		 */
+		std::optional<QByteArray> Get (const QByteArray& hash) const;
+
+		bool Has (const QByteArray& hash) const;
+
+		const Stats& GetStats () const;
+	private:
+		QString GetPath (const QByteArray& hash) const;
+	};
+
+	QDebug operator<< (QDebug, const BlobStore::Stats&);
+}
@@ -0,0 +1,25 @@
+find_package (PkgConfig)
+pkg_check_modules (PC_ZSTD libzstd)
+find_path (ZSTD_INCLUDE_DIR zstd.h
+	HINTS
+		${PC_ZSTD_INCLUDEDIR} ${PC_ZSTD_INCLUDE_DIRS})
+find_library (ZSTD_LIBRARIES
+	NAMES zstd
+	HINTS
+		${PC_ZSTD_LIBDIR} ${PC_ZSTD_LIBRARY_DIRS}
+		)
+
+if (ZSTD_INCLUDE_DIR AND ZSTD_LIBRARIES)
+	set (ZSTD_FOUND TRUE)
+endif ()
+
+if (ZSTD_FOUND)
+	message (STATUS "Found zstd libraries at ${ZSTD_LIBRARIES}")
+	message (STATUS "Found zstd headers at ${ZSTD_INCLUDE_DIR}")
+else ()
+	if (Zstd_FIND_REQUIRED)
+		message (FATAL_ERROR "Could NOT find required zstd library, aborting")
+	else ()
+		message (STATUS "Could NOT find zstd, Snails will compress message bodies with zlib")
+	endif ()
+endif ()
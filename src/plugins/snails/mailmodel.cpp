@@ -28,12 +28,15 @@
  **********************************************************************/
 
 #include "mailmodel.h"
+#include <algorithm>
+#include <numeric>
 #include <QIcon>
 #include <QMimeData>
-#include <QtConcurrentMap>
+#include <QtConcurrentRun>
 #include <util/util.h>
 #include <util/sll/prelude.h>
 #include <util/models/modelitembase.h>
+#include <util/threads/futures.h>
 #include <interfaces/core/iiconthememanager.h>
 #include "core.h"
 #include "messagelistactionsmanager.h"
@@ -79,6 +82,7 @@ namespace Snails
 	, Headers_ { tr ("From"), {}, {}, tr ("Subject"), tr ("Date"), tr ("Size") }
 	, Folder_ { "INBOX" }
 	, Root_ { std::make_shared<TreeNode> () }
+	, Threader_ { std::make_shared<MessageThreader> () }
 	{
 	}
 
@@ -314,24 +318,37 @@ namespace Snails
 
 	void MailModel::Clear ()
 	{
+		++ThreadingGeneration_;
+		IsThreading_ = false;
+		ThreadingIds_.clear ();
+		PendingMessages_.clear ();
+		PendingRemovals_.clear ();
+		PendingReadStatuses_.clear ();
+
+		Threader_ = std::make_shared<MessageThreader> ();
+
+		MsgId2Actions_.clear ();
+
 		auto rc = rowCount ();
 		if (!rc)
 			return;
 
 		beginRemoveRows ({}, 0, rc - 1);
 		Root_->EraseChildren (Root_->begin (), Root_->end ());
-		FolderId2Nodes_.clear ();
-		MsgId2FolderId_.clear ();
+		FolderId2Node_.clear ();
 		endRemoveRows ();
+	}
 
-		MsgId2Actions_.clear ();
+	namespace
+	{
+		/* Threading this many messages takes noticeable time, so it's
+		 * better done off the GUI thread.
+		 */
+		const int AsyncThreadingThreshold = 1000;
 	}
 
 	void MailModel::Append (QList<MessageInfo> messages)
 	{
-		if (messages.isEmpty ())
-			return;
-
 		for (auto i = messages.begin (); i != messages.end (); )
 		{
 			const auto& msg = *i;
@@ -348,56 +365,87 @@ namespace Snails
 		if (messages.isEmpty ())
 			return;
 
-		std::stable_sort (messages.begin (), messages.end (), Util::ComparingBy (&MessageInfo::Date_));
+		if (IsThreading_)
+		{
+			for (const auto& msg : messages)
+			{
+				PendingRemovals_.remove (msg.FolderId_);
+				PendingReadStatuses_.remove (msg.FolderId_);
+			}
+			PendingMessages_ += messages;
+			return;
+		}
 
-		for (const auto& msg : messages)
+		if (FolderId2Node_.isEmpty () && messages.size () >= AsyncThreadingThreshold)
 		{
-			const auto& msgId = msg.MessageId_;
-			if (!msgId.isEmpty ())
-				MsgId2FolderId_ [msgId] = msg.FolderId_;
+			StartThreading (messages);
+			return;
 		}
 
-		for (const auto& msg : messages)
-			if (!AppendStructured (msg))
-			{
-				const auto node = std::make_shared<TreeNode> (msg, Root_);
+		std::stable_sort (messages.begin (), messages.end (), Util::ComparingBy (&MessageInfo::Date_));
 
-				const auto childrenCount = Root_->GetRowCount ();
-				beginInsertRows ({}, childrenCount, childrenCount);
-				Root_->AppendExisting (node);
-				FolderId2Nodes_ [msg.FolderId_] << node;
-				endInsertRows ();
-			}
+		for (const auto& msg : messages)
+			AppendThreaded (msg);
 
 		emit messageListUpdated ();
 	}
 
 	bool MailModel::Remove (const QByteArray& id)
 	{
+		// The message may be among the ones being threaded, so the
+		// removal is applied once the threading is done.
+		if (IsThreading_)
+		{
+			const auto pendingEnd = std::remove_if (PendingMessages_.begin (), PendingMessages_.end (),
+					[&id] (const MessageInfo& msg) { return msg.FolderId_ == id; });
+			const auto wasPending = pendingEnd != PendingMessages_.end ();
+			PendingMessages_.erase (pendingEnd, PendingMessages_.end ());
+			PendingReadStatuses_.remove (id);
+
+			if (!ThreadingIds_.contains (id))
+				return wasPending;
+
+			const auto wasRemoved = PendingRemovals_.contains (id);
+			PendingRemovals_ << id;
+			return wasPending || !wasRemoved;
+		}
+
+		const auto& node = FolderId2Node_.value (id);
+		if (!node)
+			return false;
+
 		UpdateParents (id, true);
 
-		for (const auto& node : FolderId2Nodes_.value (id))
-			RemoveNode (node);
+		ApplyRelocations (Threader_->Remove (id));
 
-		FolderId2Nodes_.remove (id);
-		MsgId2FolderId_.remove (MsgId2FolderId_.key (id));
+		RemoveNode (node);
+		FolderId2Node_.remove (id);
 
 		return true;
 	}
 
 	void MailModel::UpdateReadStatus (const QList<QByteArray>& msgIds, bool read)
 	{
+		if (IsThreading_)
+		{
+			for (const auto& msgId : msgIds)
+				PendingReadStatuses_ [msgId] = read;
+			for (auto& msg : PendingMessages_)
+				if (msgIds.contains (msg.FolderId_))
+					msg.IsRead_ = read;
+			return;
+		}
+
 		for (const auto& msgId : msgIds)
 		{
-			for (const auto& indexPair : GetIndexes (msgId, { 0, columnCount () - 1 }))
-			{
-				for (const auto& index : indexPair)
-					static_cast<TreeNode*> (index.internalPointer ())->Msg_.IsRead_ = read;
+			const auto& node = FolderId2Node_.value (msgId);
+			if (!node)
+				continue;
 
-				emit dataChanged (indexPair.value (0), indexPair.value (1));
-			}
+			node->Msg_.IsRead_ = read;
+			EmitRowChanged (node);
 
-			UpdateParents (MsgId2FolderId_.value (msgId), read);
+			UpdateParents (msgId, read);
 		}
 	}
 
@@ -411,52 +459,40 @@ namespace Snails
 	{
 		QList<QByteArray> result;
 
-		for (const auto& list : FolderId2Nodes_)
-			for (const auto& node : list)
-				if (node->IsChecked_)
-					result << node->Msg_.FolderId_;
+		for (const auto& node : FolderId2Node_)
+			if (node->IsChecked_)
+				result << node->Msg_.FolderId_;
 
 		std::sort (result.begin (), result.end ());
-		result.erase (std::unique (result.begin (), result.end ()), result.end ());
 
 		return result;
 	}
 
 	bool MailModel::HasCheckedIds () const
 	{
-		return std::any_of (FolderId2Nodes_.begin (), FolderId2Nodes_.end (),
-				[] (const auto& list)
-				{
-					return std::any_of (list.begin (), list.end (), [] (const auto& node) { return node->IsChecked_; });
-				});
+		return std::any_of (FolderId2Node_.begin (), FolderId2Node_.end (),
+				[] (const auto& node) { return node->IsChecked_; });
 	}
 
 	void MailModel::UpdateParents (const QByteArray& folderId, bool read)
 	{
-		QList<TreeNode_ptr> nodes;
-		for (const auto& node : FolderId2Nodes_.value (folderId))
-		{
-			const auto& parent = node->GetParent ();
-			if (parent != Root_)
-				nodes << parent;
-		}
-
-		for (int i = 0; i < nodes.size (); ++i)
-		{
-			const auto& item = nodes.at (i);
+		if (const auto& node = FolderId2Node_.value (folderId))
+			UpdateUnread (node->GetParent (), { folderId }, !read);
+	}
 
-			if (!read && !item->UnreadChildren_.contains (folderId))
-				item->UnreadChildren_ << folderId;
-			else if (read)
-				item->UnreadChildren_.remove (folderId);
+	void MailModel::UpdateUnread (const TreeNode_ptr& from, const QSet<QByteArray>& ids, bool unread)
+	{
+		if (ids.isEmpty ())
+			return;
 
-			const auto& leftIdx = createIndex (item->GetRow (), 0, item.get ());
-			const auto& rightIdx = createIndex (item->GetRow (), columnCount () - 1, item.get ());
-			emit dataChanged (leftIdx, rightIdx);
+		for (auto item = from; item && item != Root_; item = item->GetParent ())
+		{
+			if (unread)
+				item->UnreadChildren_ += ids;
+			else
+				item->UnreadChildren_.subtract (ids);
 
-			const auto& parent = item->GetParent ();
-			if (parent != Root_)
-				nodes << parent;
+			EmitRowChanged (item);
 		}
 	}
 
@@ -464,9 +500,7 @@ namespace Snails
 	{
 		const auto& parent = node->GetParent ();
 
-		const auto& parentIndex = parent == Root_ ?
-				QModelIndex {} :
-				createIndex (parent->GetRow (), 0, parent.get ());
+		const auto& parentIndex = GetParentIndex (node);
 
 		const auto row = node->GetRow ();
 
@@ -493,42 +527,215 @@ namespace Snails
 		endRemoveRows ();
 	}
 
-	bool MailModel::AppendStructured (const MessageInfo& msg)
+	void MailModel::MoveNode (const TreeNode_ptr& node, const TreeNode_ptr& newParent)
 	{
-		auto refs = msg.References_;
-		for (const auto& replyTo : msg.InReplyTo_)
-			if (!refs.contains (replyTo))
-				refs << replyTo;
+		const auto& oldParent = node->GetParent ();
 
-		if (refs.isEmpty ())
-			return false;
+		auto unread = node->UnreadChildren_;
+		if (!node->Msg_.IsRead_)
+			unread << node->Msg_.FolderId_;
+
+		UpdateUnread (oldParent, unread, false);
+
+		const auto row = node->GetRow ();
+		const auto newRow = newParent->GetRowCount ();
+		const auto& newParentIndex = newParent == Root_ ?
+				QModelIndex {} :
+				GetIndex (newParent, 0);
+		beginMoveRows (GetParentIndex (node), row, row, newParentIndex, newRow);
+		oldParent->EraseChild (oldParent->begin () + row);
+		node->SetParent (newParent);
+		newParent->AppendExisting (node);
+		endMoveRows ();
+
+		UpdateUnread (newParent, unread, true);
+	}
 
-		QByteArray folderId;
-		for (int i = refs.size () - 1; i >= 0; --i)
+	namespace
+	{
+		struct ThreadingResult
 		{
-			folderId = MsgId2FolderId_.value (refs.at (i));
-			if (!folderId.isEmpty ())
-				break;
+			std::shared_ptr<MessageThreader> Threader_;
+			QList<MessageThreader::Placement> Placements_;
+		};
+	}
+
+	void MailModel::StartThreading (const QList<MessageInfo>& messages)
+	{
+		IsThreading_ = true;
+
+		ThreadingIds_.clear ();
+		ThreadingIds_.reserve (messages.size ());
+		for (const auto& msg : messages)
+			ThreadingIds_ << msg.FolderId_;
+
+		const auto future = QtConcurrent::run ([messages]
+				{
+					const auto& threader = std::make_shared<MessageThreader> ();
+					threader->AddAll (messages);
+					return ThreadingResult { threader, threader->GetPlacements () };
+				});
+		Util::Sequence (this, future) >>
+				[this, generation = ThreadingGeneration_] (const ThreadingResult& result)
+				{
+					if (generation != ThreadingGeneration_)
+						return;
+
+					ApplyThreading (result.Threader_, result.Placements_);
+				};
+	}
+
+	void MailModel::ApplyThreading (const std::shared_ptr<MessageThreader>& threader,
+			const QList<MessageThreader::Placement>& placements)
+	{
+		IsThreading_ = false;
+		ThreadingIds_.clear ();
+		Threader_ = threader;
+
+		QVector<TreeNode_ptr> topLevel;
+		QVector<TreeNode_ptr> nodes;
+		nodes.reserve (placements.size ());
+		for (const auto& [msg, parentId] : placements)
+		{
+			const auto& parent = parentId.isEmpty () ? Root_ : FolderId2Node_.value (parentId, Root_);
+
+			const auto& node = std::make_shared<TreeNode> (msg, parent);
+			FolderId2Node_ [msg.FolderId_] = node;
+			nodes << node;
+
+			if (parent == Root_)
+				topLevel << node;
+			else
+				parent->AppendExisting (node);
 		}
-		if (folderId.isEmpty ())
-			return false;
 
-		const auto& indexes = GetIndexes (folderId, 0);
-		for (const auto& parentIndex : indexes)
+		// Placements go parents first, so walking backwards visits children first.
+		for (auto i = nodes.rbegin (); i != nodes.rend (); ++i)
 		{
-			const auto parentNode = static_cast<TreeNode*> (parentIndex.internalPointer ());
-			const auto row = parentNode->GetRowCount ();
+			const auto& node = *i;
+			const auto& parent = node->GetParent ();
+			if (parent == Root_)
+				continue;
+
+			parent->UnreadChildren_ += node->UnreadChildren_;
+			if (!node->Msg_.IsRead_)
+				parent->UnreadChildren_ << node->Msg_.FolderId_;
+		}
 
-			const auto node = std::make_shared<TreeNode> (msg, parentNode->shared_from_this ());
-			beginInsertRows (parentIndex, row, row);
-			parentNode->AppendExisting (node);
-			FolderId2Nodes_ [msg.FolderId_] << node;
+		if (!topLevel.isEmpty ())
+		{
+			beginInsertRows ({}, 0, topLevel.size () - 1);
+			Root_->AppendExisting (topLevel);
 			endInsertRows ();
 		}
 
-		UpdateParents (msg.FolderId_, msg.IsRead_);
+		const auto pending = std::move (PendingMessages_);
+		PendingMessages_.clear ();
+		const auto removals = std::move (PendingRemovals_);
+		PendingRemovals_.clear ();
+		const auto readStatuses = std::move (PendingReadStatuses_);
+		PendingReadStatuses_.clear ();
+
+		for (const auto& id : removals)
+			Remove (id);
+
+		for (const auto& msg : pending)
+			AppendThreaded (msg);
+
+		QList<QByteArray> readIds;
+		QList<QByteArray> unreadIds;
+		for (auto i = readStatuses.begin (); i != readStatuses.end (); ++i)
+			(i.value () ? readIds : unreadIds) << i.key ();
+		UpdateReadStatus (readIds, true);
+		UpdateReadStatus (unreadIds, false);
+
+		emit messageListUpdated ();
+	}
+
+	void MailModel::AppendThreaded (const MessageInfo& msg)
+	{
+		if (const auto& existing = FolderId2Node_.value (msg.FolderId_))
+		{
+			const auto wasRead = existing->Msg_.IsRead_;
+			existing->Msg_ = msg;
+			EmitRowChanged (existing);
+			if (wasRead != msg.IsRead_)
+				UpdateParents (msg.FolderId_, msg.IsRead_);
+			return;
+		}
+
+		const auto& result = Threader_->Add (msg);
+
+		const auto& parent = result.ParentFolderId_.isEmpty () ?
+				Root_ :
+				FolderId2Node_.value (result.ParentFolderId_, Root_);
+
+		const auto& node = std::make_shared<TreeNode> (msg, parent);
+		const auto row = parent->GetRowCount ();
+		beginInsertRows (GetParentIndex (node), row, row);
+		parent->AppendExisting (node);
+		FolderId2Node_ [msg.FolderId_] = node;
+		endInsertRows ();
+
+		ApplyRelocations (result.Relocations_);
+
+		if (!msg.IsRead_)
+			UpdateParents (msg.FolderId_, false);
+	}
+
+	namespace
+	{
+		template<typename T>
+		bool IsInSubtree (T node, const T& subtreeRoot)
+		{
+			for (; node; node = node->GetParent ())
+				if (node == subtreeRoot)
+					return true;
+			return false;
+		}
+	}
+
+	void MailModel::ApplyRelocations (QList<MessageThreader::Relocation> relocations)
+	{
+		/* A relocation may be impossible to perform right away if the new
+		 * parent is still in the subtree of the node being moved, in which
+		 * case some other relocation is going to move the parent away.
+		 */
+		while (!relocations.isEmpty ())
+		{
+			bool progress = false;
+
+			for (auto i = relocations.begin (); i != relocations.end (); )
+			{
+				const auto& node = FolderId2Node_.value (i->FolderId_);
+				const auto& newParent = i->NewParentFolderId_.isEmpty () ?
+						Root_ :
+						FolderId2Node_.value (i->NewParentFolderId_);
+
+				if (node && newParent && node->GetParent () != newParent)
+				{
+					if (IsInSubtree (newParent, node))
+					{
+						++i;
+						continue;
+					}
+
+					MoveNode (node, newParent);
+				}
+
+				i = relocations.erase (i);
+				progress = true;
+			}
 
-		return !indexes.isEmpty ();
+			if (!progress)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to apply"
+						<< relocations.size ()
+						<< "relocations";
+				break;
+			}
+		}
 	}
 
 	void MailModel::EmitRowChanged (const TreeNode_ptr& node)
@@ -542,20 +749,12 @@ namespace Snails
 		return createIndex (node->GetRow (), column, node.get ());
 	}
 
-	QList<QModelIndex> MailModel::GetIndexes (const QByteArray& folderId, int column) const
-	{
-		return Util::Map (FolderId2Nodes_.value (folderId),
-				[this, column] (const auto& node) { return GetIndex (node, column); });
-	}
-
-	QList<QList<QModelIndex>> MailModel::GetIndexes (const QByteArray& folderId, const QList<int>& columns) const
+	QModelIndex MailModel::GetParentIndex (const TreeNode_ptr& node) const
 	{
-		return Util::Map (FolderId2Nodes_.value (folderId),
-				[this, &columns] (const auto& node)
-				{
-					return Util::Map (columns,
-							[this, &node] (auto column) { return GetIndex (node, column); });
-				});
+		const auto& parent = node->GetParent ();
+		return parent == Root_ ?
+				QModelIndex {} :
+				GetIndex (parent, 0);
 	}
 }
 }
@@ -33,7 +33,9 @@
 #include <QStringList>
 #include <QAbstractItemModel>
 #include <QList>
+#include <QSet>
 #include "messagelistactioninfo.h"
+#include "messagethreader.h"
 
 namespace LC
 {
@@ -57,8 +59,16 @@ namespace Snails
 		typedef std::weak_ptr<TreeNode> TreeNode_wptr;
 		const TreeNode_ptr Root_;
 
-		QHash<QByteArray, QList<TreeNode_ptr>> FolderId2Nodes_;
-		QHash<QByteArray, QByteArray> MsgId2FolderId_;
+		QHash<QByteArray, TreeNode_ptr> FolderId2Node_;
+
+		std::shared_ptr<MessageThreader> Threader_;
+
+		quint64 ThreadingGeneration_ = 0;
+		bool IsThreading_ = false;
+		QSet<QByteArray> ThreadingIds_;
+		QList<MessageInfo> PendingMessages_;
+		QSet<QByteArray> PendingRemovals_;
+		QHash<QByteArray, bool> PendingReadStatuses_;
 
 		mutable QHash<QByteArray, QList<MessageListActionInfo>> MsgId2Actions_;
 	public:
@@ -114,15 +124,20 @@ namespace Snails
 		bool HasCheckedIds () const;
 	private:
 		void UpdateParents (const QByteArray&, bool);
+		void UpdateUnread (const TreeNode_ptr&, const QSet<QByteArray>&, bool);
 
 		void RemoveNode (const TreeNode_ptr&);
-		bool AppendStructured (const MessageInfo&);
+		void MoveNode (const TreeNode_ptr&, const TreeNode_ptr&);
+
+		void StartThreading (const QList<MessageInfo>&);
+		void ApplyThreading (const std::shared_ptr<MessageThreader>&, const QList<MessageThreader::Placement>&);
+		void AppendThreaded (const MessageInfo&);
+		void ApplyRelocations (QList<MessageThreader::Relocation>);
 
 		void EmitRowChanged (const TreeNode_ptr&);
 
 		QModelIndex GetIndex (const TreeNode_ptr& node, int column) const;
-		QList<QModelIndex> GetIndexes (const QByteArray& folderId, int column) const;
-		QList<QList<QModelIndex>> GetIndexes (const QByteArray& folderId, const QList<int>& columns) const;
+		QModelIndex GetParentIndex (const TreeNode_ptr& node) const;
 	signals:
 		void messageListUpdated ();
 		void messagesSelectionChanged ();
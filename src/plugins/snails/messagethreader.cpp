@@ -0,0 +1,414 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "messagethreader.h"
+#include <algorithm>
+#include <util/sll/prelude.h>
+
+namespace LC::Snails
+{
+	namespace
+	{
+		bool SkipSubjectPrefix (const QString& subject, int& pos, bool& isReply)
+		{
+			while (pos < subject.size () && subject [pos].isSpace ())
+				++pos;
+
+			if (pos >= subject.size ())
+				return false;
+
+			// Mailing list tags like "[leechcraft-dev]".
+			if (subject [pos] == '[')
+			{
+				const auto end = subject.indexOf (']', pos);
+				if (end < 0)
+					return false;
+
+				pos = end + 1;
+				return true;
+			}
+
+			for (const auto& prefix : { QLatin1String { "re" }, QLatin1String { "aw" } })
+			{
+				if (subject.midRef (pos, prefix.size ()).compare (prefix, Qt::CaseInsensitive))
+					continue;
+
+				auto next = pos + prefix.size ();
+
+				// Things like "Re[2]:" produced by some clients.
+				if (next < subject.size () && subject [next] == '[')
+				{
+					const auto end = subject.indexOf (']', next);
+					if (end < 0)
+						return false;
+					next = end + 1;
+				}
+
+				if (next < subject.size () && subject [next] == ':')
+				{
+					pos = next + 1;
+					isReply = true;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		std::pair<QString, bool> NormalizeSubject (const QString& subject)
+		{
+			int pos = 0;
+			bool isReply = false;
+			while (SkipSubjectPrefix (subject, pos, isReply))
+				;
+
+			return { subject.mid (pos).trimmed ().toLower (), isReply };
+		}
+	}
+
+	void MessageThreader::AddAll (QList<MessageInfo> messages)
+	{
+		std::stable_sort (messages.begin (), messages.end (), Util::ComparingBy (&MessageInfo::Date_));
+
+		for (const auto& msg : messages)
+			Link (msg, nullptr);
+	}
+
+	MessageThreader::AddResult MessageThreader::Add (const MessageInfo& msg)
+	{
+		QList<Container*> relinked;
+		const auto c = Link (msg, &relinked);
+
+		QList<Container*> affected;
+		CollectAffected (c, false, affected);
+		for (const auto r : relinked)
+			CollectAffected (r, true, affected);
+		if (!c->SubjectKey_.isEmpty () && SubjectRoots_.value (c->SubjectKey_) == c)
+			affected += GetSubjectReplies (c->SubjectKey_);
+
+		// The new message may be found among the descendants of the relinked
+		// containers, but it is not known to anybody yet, so nothing to move.
+		affected.removeAll (c);
+
+		const auto parent = ResolveParent (c);
+		return { parent ? parent->Msg_->FolderId_ : QByteArray {}, MakeRelocations (affected) };
+	}
+
+	QList<MessageThreader::Relocation> MessageThreader::Remove (const QByteArray& folderId)
+	{
+		const auto c = FolderId2Container_.take (folderId);
+		if (!c)
+			return {};
+
+		const auto wasSubjectRoot = !c->SubjectKey_.isEmpty () && SubjectRoots_.value (c->SubjectKey_) == c;
+		if (wasSubjectRoot)
+			SubjectRoots_.remove (c->SubjectKey_);
+
+		c->Msg_.reset ();
+
+		if (c->IsReply_)
+		{
+			const auto pos = SubjectReplies_.find (c->SubjectKey_);
+			if (pos != SubjectReplies_.end () && pos->remove (c) && pos->isEmpty ())
+				SubjectReplies_.erase (pos);
+		}
+
+		QList<Container*> affected;
+		CollectAffected (c, false, affected);
+
+		// The replies below the removed message may have become top-level,
+		// and they should follow the subject root from now on.
+		for (const auto x : affected)
+			if (x->IsReply_ && !x->SubjectKey_.isEmpty () && IsTopLevel (x))
+				AddSubjectReply (x);
+
+		if (wasSubjectRoot)
+			affected += GetSubjectReplies (c->SubjectKey_);
+		return MakeRelocations (affected);
+	}
+
+	QList<MessageThreader::Placement> MessageThreader::GetPlacements () const
+	{
+		QHash<const Container*, QList<const Container*>> children;
+		QList<const Container*> topLevel;
+		for (const auto& c : Containers_)
+		{
+			if (!c.Msg_)
+				continue;
+
+			if (const auto parent = ResolveParent (&c))
+				children [parent] << &c;
+			else
+				topLevel << &c;
+		}
+
+		const auto byDate = [] (const Container *c1, const Container *c2)
+		{
+			return c1->Msg_->Date_ < c2->Msg_->Date_;
+		};
+		std::stable_sort (topLevel.begin (), topLevel.end (), byDate);
+		for (auto& list : children)
+			std::stable_sort (list.begin (), list.end (), byDate);
+
+		QList<Placement> result;
+		result.reserve (FolderId2Container_.size ());
+
+		// Explicit stack instead of recursion: some threads are really deep.
+		std::vector<std::pair<const Container*, const Container*>> stack;
+		for (auto i = topLevel.rbegin (); i != topLevel.rend (); ++i)
+			stack.emplace_back (*i, nullptr);
+
+		while (!stack.empty ())
+		{
+			const auto [c, parent] = stack.back ();
+			stack.pop_back ();
+
+			result.push_back ({ *c->Msg_, parent ? parent->Msg_->FolderId_ : QByteArray {} });
+
+			const auto pos = children.constFind (c);
+			if (pos == children.constEnd ())
+				continue;
+
+			for (auto i = pos->rbegin (); i != pos->rend (); ++i)
+				stack.emplace_back (*i, c);
+		}
+
+		return result;
+	}
+
+	MessageThreader::Container* MessageThreader::MakeContainer (const QByteArray& msgId)
+	{
+		Containers_.emplace_back ();
+
+		const auto c = &Containers_.back ();
+		c->MsgId_ = msgId;
+		if (!msgId.isEmpty ())
+			MsgId2Container_ [msgId] = c;
+		return c;
+	}
+
+	MessageThreader::Container* MessageThreader::GetContainer (const QByteArray& msgId)
+	{
+		if (const auto c = MsgId2Container_.value (msgId))
+			return c;
+
+		return MakeContainer (msgId);
+	}
+
+	namespace
+	{
+		template<typename T>
+		bool IsAncestor (const T *ancestor, const T *c)
+		{
+			for (; c; c = c->Parent_)
+				if (c == ancestor)
+					return true;
+			return false;
+		}
+	}
+
+	MessageThreader::Container* MessageThreader::Link (const MessageInfo& msg, QList<Container*> *relinked)
+	{
+		auto c = msg.MessageId_.isEmpty () ? nullptr : GetContainer (msg.MessageId_);
+
+		// Either there is no message ID, or this is a duplicate.
+		if (!c || c->Msg_)
+			c = MakeContainer ({});
+
+		c->Msg_ = msg;
+		std::tie (c->SubjectKey_, c->IsReply_) = NormalizeSubject (msg.Subject_);
+		FolderId2Container_ [msg.FolderId_] = c;
+
+		auto refs = msg.References_;
+		for (const auto& replyTo : msg.InReplyTo_)
+			if (!refs.contains (replyTo))
+				refs << replyTo;
+
+		Container *prev = nullptr;
+		for (const auto& ref : refs)
+		{
+			if (ref.isEmpty () || ref == msg.MessageId_)
+				continue;
+
+			const auto refC = GetContainer (ref);
+
+			// Links that are already known are not changed.
+			if (prev && !refC->Parent_ && refC != prev && !IsAncestor (refC, prev))
+			{
+				SetParent (refC, prev);
+				if (relinked)
+					*relinked << refC;
+			}
+
+			prev = refC;
+		}
+
+		// The message's own references are authoritative, so drop the old
+		// parent guessed from other messages.
+		if (!IsAncestor<Container> (c, prev))
+			SetParent (c, prev);
+
+		RegisterSubject (c);
+
+		return c;
+	}
+
+	void MessageThreader::SetParent (Container *c, Container *parent)
+	{
+		if (c->Parent_ == parent)
+			return;
+
+		if (c->Parent_)
+		{
+			auto& siblings = c->Parent_->Children_;
+			siblings.erase (std::find (siblings.begin (), siblings.end (), c));
+		}
+
+		c->Parent_ = parent;
+
+		if (parent)
+			parent->Children_.push_back (c);
+	}
+
+	void MessageThreader::RegisterSubject (Container *c)
+	{
+		if (c->SubjectKey_.isEmpty () || !IsTopLevel (c))
+			return;
+
+		if (c->IsReply_)
+		{
+			AddSubjectReply (c);
+			return;
+		}
+
+		const auto existing = SubjectRoots_.value (c->SubjectKey_);
+		if (!existing || !existing->Msg_ || !IsTopLevel (existing))
+			SubjectRoots_ [c->SubjectKey_] = c;
+	}
+
+	void MessageThreader::AddSubjectReply (Container *c)
+	{
+		SubjectReplies_ [c->SubjectKey_] << c;
+	}
+
+	QList<MessageThreader::Container*> MessageThreader::GetSubjectReplies (const QString& key)
+	{
+		const auto pos = SubjectReplies_.find (key);
+		if (pos == SubjectReplies_.end ())
+			return {};
+
+		// Drop the replies that have been removed or got a parent since
+		// they were registered, so the lists don't grow forever.
+		for (auto i = pos->begin (); i != pos->end (); )
+			if (!(*i)->Msg_ || !IsTopLevel (*i))
+				i = pos->erase (i);
+			else
+				++i;
+
+		if (pos->isEmpty ())
+		{
+			SubjectReplies_.erase (pos);
+			return {};
+		}
+
+		return pos->values ();
+	}
+
+	bool MessageThreader::IsTopLevel (const Container *c) const
+	{
+		for (auto p = c->Parent_; p; p = p->Parent_)
+			if (p->Msg_)
+				return false;
+		return true;
+	}
+
+	const MessageThreader::Container* MessageThreader::ResolveParent (const Container *c) const
+	{
+		for (auto p = c->Parent_; p; p = p->Parent_)
+			if (p->Msg_)
+				return p;
+
+		if (c->IsReply_ && !c->SubjectKey_.isEmpty ())
+		{
+			const auto root = SubjectRoots_.value (c->SubjectKey_);
+			if (root && root != c && root->Msg_ && IsTopLevel (root))
+				return root;
+		}
+
+		return nullptr;
+	}
+
+	void MessageThreader::CollectAffected (Container *c, bool includeSelf, QList<Container*>& result)
+	{
+		std::vector<Container*> stack;
+		if (includeSelf)
+			stack.push_back (c);
+		else
+			stack = c->Children_;
+
+		while (!stack.empty ())
+		{
+			const auto x = stack.back ();
+			stack.pop_back ();
+
+			if (!x->Msg_)
+			{
+				stack.insert (stack.end (), x->Children_.begin (), x->Children_.end ());
+				continue;
+			}
+
+			result << x;
+
+			// A subject root that got a parent can't serve as one anymore.
+			if (!x->SubjectKey_.isEmpty () &&
+					SubjectRoots_.value (x->SubjectKey_) == x &&
+					!IsTopLevel (x))
+			{
+				SubjectRoots_.remove (x->SubjectKey_);
+				result += GetSubjectReplies (x->SubjectKey_);
+			}
+		}
+	}
+
+	QList<MessageThreader::Relocation> MessageThreader::MakeRelocations (const QList<Container*>& affected) const
+	{
+		QSet<const Container*> seen;
+		QList<Relocation> result;
+		for (const auto c : affected)
+		{
+			if (!c->Msg_ || seen.contains (c))
+				continue;
+			seen << c;
+
+			const auto parent = ResolveParent (c);
+			result.push_back ({ c->Msg_->FolderId_, parent ? parent->Msg_->FolderId_ : QByteArray {} });
+		}
+		return result;
+	}
+}
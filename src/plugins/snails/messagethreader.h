@@ -0,0 +1,181 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <optional>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QByteArray>
+#include "messageinfo.h"
+
+namespace LC::Snails
+{
+	/** @brief Threads messages by their References/In-Reply-To headers.
+	 *
+	 * This is an implementation of the JWZ threading algorithm: every
+	 * message ID ever mentioned gets a container, and containers for the
+	 * IDs that are referenced but not (yet) known are kept as empty
+	 * placeholders, so that the order in which messages are added does
+	 * not affect the resulting threads. Root messages that are replies
+	 * (like "Re: foo") whose parents are not known are additionally
+	 * grouped under the root message with the same base subject.
+	 *
+	 * Messages are identified by their folder IDs in the results, and
+	 * the "model parent" of a message is its nearest ancestor that has a
+	 * message attached (placeholders are transparent).
+	 *
+	 * The threader is not thread-safe, but it is not bound to any thread
+	 * either, so it can be built in a worker thread and then passed to
+	 * the GUI thread for the incremental updates.
+	 */
+	class MessageThreader
+	{
+		struct Container
+		{
+			QByteArray MsgId_;
+			std::optional<MessageInfo> Msg_;
+
+			QString SubjectKey_;
+			bool IsReply_ = false;
+
+			Container *Parent_ = nullptr;
+			std::vector<Container*> Children_;
+		};
+
+		std::deque<Container> Containers_;
+
+		QHash<QByteArray, Container*> MsgId2Container_;
+		QHash<QByteArray, Container*> FolderId2Container_;
+
+		QHash<QString, Container*> SubjectRoots_;
+		QHash<QString, QSet<Container*>> SubjectReplies_;
+	public:
+		/** @brief Describes the position of a message in the threads.
+		 */
+		struct Placement
+		{
+			MessageInfo Msg_;
+
+			/** @brief The folder ID of the parent message, or empty
+			 * for top-level messages.
+			 */
+			QByteArray ParentFolderId_;
+		};
+
+		/** @brief Describes a message that should be moved to another
+		 * parent.
+		 */
+		struct Relocation
+		{
+			QByteArray FolderId_;
+			QByteArray NewParentFolderId_;
+		};
+
+		/** @brief The result of adding a single message.
+		 */
+		struct AddResult
+		{
+			/** @brief The folder ID of the parent of the new message,
+			 * or empty if it is a top-level one.
+			 */
+			QByteArray ParentFolderId_;
+
+			/** @brief The already known messages that changed their
+			 * parents due to this message being added.
+			 */
+			QList<Relocation> Relocations_;
+		};
+
+		MessageThreader () = default;
+
+		MessageThreader (const MessageThreader&) = delete;
+		MessageThreader& operator= (const MessageThreader&) = delete;
+
+		/** @brief Adds a bunch of messages without tracking the changes.
+		 *
+		 * This is the preferred way of initially filling the threader.
+		 * The messages are added in their date order.
+		 *
+		 * @param[in] messages The messages to add.
+		 */
+		void AddAll (QList<MessageInfo> messages);
+
+		/** @brief Adds a single message and returns the changes.
+		 *
+		 * The complexity of this method is proportional to the depth of
+		 * the thread the message belongs to (plus the number of
+		 * messages whose parents are changed by this one).
+		 *
+		 * @param[in] msg The message to add.
+		 * @return The position of the new message and the changes to
+		 * the already existing messages.
+		 */
+		AddResult Add (const MessageInfo& msg);
+
+		/** @brief Removes the message with the given folder ID.
+		 *
+		 * The container of the message is kept as a placeholder, so that
+		 * the thread structure is preserved.
+		 *
+		 * @param[in] folderId The folder ID of the message to remove.
+		 * @return The messages that changed their parents due to the
+		 * removal.
+		 */
+		QList<Relocation> Remove (const QByteArray& folderId);
+
+		/** @brief Returns the placements of all the known messages.
+		 *
+		 * The messages are returned in the depth-first pre-order, so
+		 * the parent of each message precedes the message itself. The
+		 * siblings are ordered by date.
+		 *
+		 * @return The placements of all the messages.
+		 */
+		QList<Placement> GetPlacements () const;
+	private:
+		Container* MakeContainer (const QByteArray&);
+		Container* GetContainer (const QByteArray&);
+
+		Container* Link (const MessageInfo&, QList<Container*> *relinked);
+		void SetParent (Container*, Container*);
+		void RegisterSubject (Container*);
+		void AddSubjectReply (Container*);
+		QList<Container*> GetSubjectReplies (const QString&);
+
+		bool IsTopLevel (const Container*) const;
+		const Container* ResolveParent (const Container*) const;
+
+		void CollectAffected (Container*, bool, QList<Container*>&);
+		QList<Relocation> MakeRelocations (const QList<Container*>&) const;
+	};
+}
@@ -31,6 +31,7 @@
 #include <stdexcept>
 #include <QApplication>
 #include <QThread>
+#include <QtConcurrentRun>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QDataStream>
@@ -65,6 +66,15 @@ namespace Snails
 		SDir_ = Util::CreateIfNotExists ("snails/storage");
 	}
 
+	Storage::~Storage ()
+	{
+		MigrationsCancelled_ = true;
+
+		QMutexLocker locker { &MigrationsGuard_ };
+		for (auto& future : Migrations_)
+			future.waitForFinished ();
+	}
+
 	void Storage::SaveMessageInfos (Account *acc, const QList<MessageInfo>& infos)
 	{
 		const auto& base = BaseForAccount (acc);
@@ -87,6 +97,7 @@ namespace Snails
 			const QByteArray& msgId,
 			const MessageBodies& bodies)
 	{
+		// The bodies will be fetched again if they can't be stored.
 		BaseForAccount (acc)->SaveMessageBodies (folder, msgId, bodies);
 	}
 
@@ -173,10 +184,35 @@ namespace Snails
 			return AccountBases_ [acc];
 
 		const auto& dir = DirForAccount (acc);
-		const auto& base = std::make_shared<AccountDatabase> (dir, acc);
+		const auto& base = std::make_shared<AccountDatabase> (dir, acc->GetID ());
 		if (isCachedThread)
 			AccountBases_ [acc] = base;
+
+		StartMigration (acc->GetID (), dir);
+
 		return base;
 	}
+
+	void Storage::StartMigration (const QByteArray& accountId, const QDir& dir)
+	{
+		QMutexLocker locker { &MigrationsGuard_ };
+		if (Migrations_.contains (accountId))
+			return;
+
+		Migrations_ [accountId] = QtConcurrent::run ([this, accountId, dir]
+				{
+					try
+					{
+						AccountDatabase { dir, accountId }.MigrateBodies (MigrationsCancelled_);
+					}
+					catch (const std::exception& e)
+					{
+						qWarning () << Q_FUNC_INFO
+								<< "unable to migrate the bodies of"
+								<< accountId
+								<< e.what ();
+					}
+				});
+	}
 }
 }
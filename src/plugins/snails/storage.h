@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <optional>
 #include <QObject>
@@ -36,6 +37,8 @@
 #include <QSettings>
 #include <QHash>
 #include <QSet>
+#include <QMutex>
+#include <QFuture>
 
 namespace LC
 {
@@ -55,8 +58,13 @@ namespace Snails
 
 		QHash<const Account*, AccountDatabase_ptr> AccountBases_;
 		const Qt::HANDLE CachedThread_;
+
+		QMutex MigrationsGuard_;
+		QHash<QByteArray, QFuture<void>> Migrations_;
+		std::atomic<bool> MigrationsCancelled_ { false };
 	public:
 		Storage (QObject* = nullptr);
+		~Storage () override;
 
 		AccountDatabase_ptr BaseForAccount (const Account*);
 
@@ -79,6 +87,7 @@ namespace Snails
 		void SetMessagesRead (Account*, const QStringList& folder, const QList<QByteArray>& folderIds, bool read);
 	private:
 		QDir DirForAccount (const Account*) const;
+		void StartMigration (const QByteArray& accountId, const QDir&);
 	};
 }
 }
@@ -0,0 +1,155 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "mailmodeltest.h"
+#include <QtTest>
+#include <mailmodel.h>
+
+QTEST_GUILESS_MAIN (LC::Snails::MailModelTest)
+
+namespace LC
+{
+namespace Snails
+{
+	namespace
+	{
+		// Enough to get threaded asynchronously.
+		const int MessagesCount = 5000;
+
+		QByteArray MakeId (int i)
+		{
+			return "id" + QByteArray::number (i);
+		}
+
+		QList<MessageInfo> MakeMessages ()
+		{
+			const auto& base = QDateTime::currentDateTime ();
+
+			QList<MessageInfo> result;
+			for (int i = 0; i < MessagesCount; ++i)
+			{
+				MessageInfo msg {};
+				msg.FolderId_ = MakeId (i);
+				msg.MessageId_ = "<" + MakeId (i) + "@example.com>";
+				msg.Folder_ = QStringList { "INBOX" };
+				msg.Subject_ = "Message " + QString::number (i);
+				msg.Date_ = base.addSecs (i);
+				result << msg;
+			}
+			return result;
+		}
+
+		QHash<QByteArray, bool> GetReadStatuses (const MailModel& model)
+		{
+			QHash<QByteArray, bool> result;
+			for (int i = 0; i < model.rowCount (); ++i)
+			{
+				const auto& idx = model.index (i, 0);
+				result [idx.data (MailModel::ID).toByteArray ()] = idx.data (MailModel::IsRead).toBool ();
+			}
+			return result;
+		}
+
+		void WaitThreaded (MailModel& model)
+		{
+			QSignalSpy spy { &model, &MailModel::messageListUpdated };
+			QVERIFY (spy.wait (30000));
+		}
+	}
+
+	void MailModelTest::testRemoveDuringThreading ()
+	{
+		MailModel model { nullptr };
+		model.Append (MakeMessages ());
+		QCOMPARE (model.rowCount (), 0);
+
+		QVERIFY (model.Remove (MakeId (5)));
+		model.MarkUnavailable ({ MakeId (6), MakeId (7) });
+
+		WaitThreaded (model);
+
+		const auto& statuses = GetReadStatuses (model);
+		QCOMPARE (statuses.size (), MessagesCount - 3);
+		QVERIFY (!statuses.contains (MakeId (5)));
+		QVERIFY (!statuses.contains (MakeId (6)));
+		QVERIFY (!statuses.contains (MakeId (7)));
+		QVERIFY (statuses.contains (MakeId (8)));
+	}
+
+	void MailModelTest::testRemoveUnknownDuringThreading ()
+	{
+		MailModel model { nullptr };
+		model.Append (MakeMessages ());
+
+		QVERIFY (!model.Remove (MakeId (MessagesCount)));
+		QVERIFY (model.Remove (MakeId (5)));
+		QVERIFY (!model.Remove (MakeId (5)));
+
+		WaitThreaded (model);
+
+		QCOMPARE (GetReadStatuses (model).size (), MessagesCount - 1);
+	}
+
+	void MailModelTest::testReadStatusDuringThreading ()
+	{
+		MailModel model { nullptr };
+		model.Append (MakeMessages ());
+
+		model.UpdateReadStatus ({ MakeId (1), MakeId (2) }, true);
+		model.UpdateReadStatus ({ MakeId (2) }, false);
+
+		WaitThreaded (model);
+
+		const auto& statuses = GetReadStatuses (model);
+		QCOMPARE (statuses.size (), MessagesCount);
+		QCOMPARE (statuses.value (MakeId (1)), true);
+		QCOMPARE (statuses.value (MakeId (2)), false);
+		QCOMPARE (statuses.value (MakeId (3)), false);
+	}
+
+	void MailModelTest::testReappendDuringThreading ()
+	{
+		MailModel model { nullptr };
+		const auto& messages = MakeMessages ();
+		model.Append (messages);
+
+		model.Remove (MakeId (10));
+
+		auto reappended = messages.at (10);
+		reappended.IsRead_ = true;
+		model.Append ({ reappended });
+
+		WaitThreaded (model);
+
+		const auto& statuses = GetReadStatuses (model);
+		QCOMPARE (statuses.size (), MessagesCount);
+		QCOMPARE (statuses.value (MakeId (10)), true);
+	}
+}
+}
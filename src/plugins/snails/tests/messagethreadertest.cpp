@@ -0,0 +1,298 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "messagethreadertest.h"
+#include <algorithm>
+#include <numeric>
+#include <QtTest>
+#include <messagethreader.h>
+
+QTEST_GUILESS_MAIN (LC::Snails::MessageThreaderTest)
+
+namespace LC
+{
+namespace Snails
+{
+	namespace
+	{
+		using Parents_t = QHash<QByteArray, QByteArray>;
+
+		QByteArray MakeMsgId (const QByteArray& name)
+		{
+			return "<" + name + "@example.com>";
+		}
+
+		QList<QByteArray> MakeMsgIds (const QList<QByteArray>& names)
+		{
+			QList<QByteArray> result;
+			for (const auto& name : names)
+				result << MakeMsgId (name);
+			return result;
+		}
+
+		MessageInfo MakeMsg (const QByteArray& name, int secs,
+				const QList<QByteArray>& refs = {}, const QString& subject = {})
+		{
+			MessageInfo msg {};
+			msg.FolderId_ = name;
+			msg.MessageId_ = MakeMsgId (name);
+			msg.Folder_ = QStringList { "INBOX" };
+			msg.Subject_ = subject.isEmpty () ? "Subject " + QString::fromLatin1 (name) : subject;
+			msg.Date_ = QDateTime { QDate { 2020, 1, 1 }, QTime { 0, 0 } }.addSecs (secs);
+			msg.References_ = MakeMsgIds (refs);
+			return msg;
+		}
+
+		MessageInfo MakeReply (const QByteArray& name, int secs, const QList<QByteArray>& inReplyTo)
+		{
+			auto msg = MakeMsg (name, secs);
+			msg.InReplyTo_ = MakeMsgIds (inReplyTo);
+			return msg;
+		}
+
+		Parents_t GetParents (const MessageThreader& threader)
+		{
+			Parents_t result;
+			for (const auto& placement : threader.GetPlacements ())
+				result [placement.Msg_.FolderId_] = placement.ParentFolderId_;
+			return result;
+		}
+
+		Parents_t ToParents (const QList<MessageThreader::Relocation>& relocations)
+		{
+			Parents_t result;
+			for (const auto& reloc : relocations)
+				result [reloc.FolderId_] = reloc.NewParentFolderId_;
+			return result;
+		}
+	}
+
+	void MessageThreaderTest::testReferences ()
+	{
+		MessageThreader threader;
+		threader.AddAll ({
+				MakeMsg ("a", 0),
+				MakeMsg ("b", 1, { "a" }),
+				MakeMsg ("c", 2, { "a", "b" })
+			});
+
+		const Parents_t expected { { "a", {} }, { "b", "a" }, { "c", "b" } };
+		QCOMPARE (GetParents (threader), expected);
+
+		const auto& placements = threader.GetPlacements ();
+		QCOMPARE (placements.size (), 3);
+		QCOMPARE (placements.at (0).Msg_.FolderId_, QByteArray { "a" });
+	}
+
+	void MessageThreaderTest::testInReplyTo ()
+	{
+		auto c = MakeReply ("c", 2, { "b" });
+		c.References_ = MakeMsgIds ({ "a" });
+
+		MessageThreader threader;
+		threader.AddAll ({
+				MakeMsg ("a", 0),
+				MakeReply ("b", 1, { "a" }),
+				c
+			});
+
+		const Parents_t expected { { "a", {} }, { "b", "a" }, { "c", "b" } };
+		QCOMPARE (GetParents (threader), expected);
+	}
+
+	void MessageThreaderTest::testPlaceholders ()
+	{
+		MessageThreader threader;
+		threader.AddAll ({
+				MakeMsg ("a", 0),
+				MakeMsg ("c", 2, { "a", "b" })
+			});
+
+		// The unknown "b" is transparent.
+		QCOMPARE (GetParents (threader), (Parents_t { { "a", {} }, { "c", "a" } }));
+
+		const auto& result = threader.Add (MakeMsg ("b", 1, { "a" }));
+		QCOMPARE (result.ParentFolderId_, QByteArray { "a" });
+		QCOMPARE (ToParents (result.Relocations_), (Parents_t { { "c", "b" } }));
+
+		QCOMPARE (GetParents (threader), (Parents_t { { "a", {} }, { "b", "a" }, { "c", "b" } }));
+	}
+
+	void MessageThreaderTest::testSubjectGrouping ()
+	{
+		MessageThreader threader;
+		threader.AddAll ({
+				MakeMsg ("a", 0, {}, "Foo"),
+				MakeMsg ("b", 1, {}, "Re: Foo"),
+				MakeMsg ("c", 2, {}, "Re[2]: [list] RE: foo"),
+				MakeMsg ("d", 3, {}, "Bar"),
+				MakeMsg ("e", 4, {}, "Re: Baz")
+			});
+
+		const Parents_t expected
+		{
+			{ "a", {} },
+			{ "b", "a" },
+			{ "c", "a" },
+			{ "d", {} },
+			{ "e", {} }
+		};
+		QCOMPARE (GetParents (threader), expected);
+	}
+
+	void MessageThreaderTest::testSubjectRootAddedLater ()
+	{
+		MessageThreader threader;
+		QCOMPARE (threader.Add (MakeMsg ("b", 1, {}, "Re: Foo")).ParentFolderId_, QByteArray {});
+
+		const auto& result = threader.Add (MakeMsg ("a", 0, {}, "Foo"));
+		QCOMPARE (result.ParentFolderId_, QByteArray {});
+		QCOMPARE (ToParents (result.Relocations_), (Parents_t { { "b", "a" } }));
+	}
+
+	void MessageThreaderTest::testOrderIndependence ()
+	{
+		const QList<MessageInfo> messages
+		{
+			MakeMsg ("a", 0),
+			MakeMsg ("b", 1, { "a" }),
+			MakeMsg ("c", 2, { "a", "b" }),
+			MakeReply ("d", 3, { "b" }),
+			MakeMsg ("e", 4, { "a", "x" }),
+			MakeMsg ("f", 5, {}, "Foo"),
+			MakeMsg ("g", 6, {}, "Re: Foo")
+		};
+
+		MessageThreader reference;
+		reference.AddAll (messages);
+		const auto& expected = GetParents (reference);
+		QCOMPARE (expected,
+				(Parents_t
+				{
+					{ "a", {} },
+					{ "b", "a" },
+					{ "c", "b" },
+					{ "d", "b" },
+					{ "e", "a" },
+					{ "f", {} },
+					{ "g", "f" }
+				}));
+
+		std::vector<int> order (messages.size ());
+		std::iota (order.begin (), order.end (), 0);
+		do
+		{
+			MessageThreader threader;
+
+			// The parents as a model applying the results of Add() sees them.
+			Parents_t tracked;
+			for (const auto idx : order)
+			{
+				const auto& msg = messages.at (idx);
+				const auto& result = threader.Add (msg);
+				tracked [msg.FolderId_] = result.ParentFolderId_;
+				for (const auto& reloc : result.Relocations_)
+					tracked [reloc.FolderId_] = reloc.NewParentFolderId_;
+
+				QCOMPARE (tracked, GetParents (threader));
+			}
+
+			QCOMPARE (tracked, expected);
+		}
+		while (std::next_permutation (order.begin (), order.end ()));
+	}
+
+	void MessageThreaderTest::testReparentOnRemove ()
+	{
+		MessageThreader threader;
+		threader.AddAll ({
+				MakeMsg ("a", 0),
+				MakeMsg ("b", 1, { "a" }),
+				MakeMsg ("c", 2, { "a", "b" })
+			});
+
+		QCOMPARE (ToParents (threader.Remove ("b")), (Parents_t { { "c", "a" } }));
+		QCOMPARE (GetParents (threader), (Parents_t { { "a", {} }, { "c", "a" } }));
+
+		QVERIFY (threader.Remove ("b").isEmpty ());
+		QVERIFY (threader.Remove ("unknown").isEmpty ());
+
+		// Adding the message back restores its place in the thread.
+		const auto& result = threader.Add (MakeMsg ("b", 1, { "a" }));
+		QCOMPARE (result.ParentFolderId_, QByteArray { "a" });
+		QCOMPARE (ToParents (result.Relocations_), (Parents_t { { "c", "b" } }));
+	}
+
+	void MessageThreaderTest::testRemoveSubjectRoot ()
+	{
+		MessageThreader threader;
+		threader.AddAll ({
+				MakeMsg ("a", 0, {}, "Foo"),
+				MakeMsg ("b", 1, {}, "Re: Foo")
+			});
+
+		QCOMPARE (ToParents (threader.Remove ("a")), (Parents_t { { "b", {} } }));
+		QCOMPARE (GetParents (threader), (Parents_t { { "b", {} } }));
+	}
+
+	void MessageThreaderTest::testReplyFollowsRootAfterParentRemoved ()
+	{
+		MessageThreader threader;
+		threader.AddAll ({
+				MakeMsg ("p", 0),
+				MakeMsg ("b", 1, { "p" }, "Re: Foo")
+			});
+
+		QCOMPARE (ToParents (threader.Remove ("p")), (Parents_t { { "b", {} } }));
+
+		// "b" is top-level now, so it should be grouped under the new root.
+		const auto& result = threader.Add (MakeMsg ("a", 2, {}, "Foo"));
+		QCOMPARE (ToParents (result.Relocations_), (Parents_t { { "b", "a" } }));
+		QCOMPARE (GetParents (threader), (Parents_t { { "a", {} }, { "b", "a" } }));
+	}
+
+	void MessageThreaderTest::testRepliesWithParentsNotRelocated ()
+	{
+		MessageThreader threader;
+		threader.Add (MakeMsg ("b", 1, {}, "Re: Foo"));
+		threader.Add (MakeMsg ("a", 0));
+
+		// "c" tells "b" is a reply to "a".
+		const auto& linked = threader.Add (MakeMsg ("c", 2, { "a", "b" }));
+		QCOMPARE (linked.ParentFolderId_, QByteArray { "b" });
+		QCOMPARE (ToParents (linked.Relocations_), (Parents_t { { "b", "a" } }));
+
+		// "b" is not a top-level reply anymore, so the new subject root
+		// doesn't affect it.
+		const auto& result = threader.Add (MakeMsg ("r", 3, {}, "Foo"));
+		QVERIFY (result.Relocations_.isEmpty ());
+		QCOMPARE (GetParents (threader).value ("b"), QByteArray { "a" });
+	}
+}
+}
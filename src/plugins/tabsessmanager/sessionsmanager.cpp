@@ -42,6 +42,7 @@
 #include <interfaces/core/irootwindowsmanager.h>
 #include <interfaces/core/icoretabwidget.h>
 #include <util/sll/qtutil.h>
+#include <util/sys/tracing.h>
 #include "recinfo.h"
 #include "restoresessiondialog.h"
 #include "util.h"
@@ -245,6 +246,8 @@ namespace TabSessManager
 
 	void SessionsManager::OpenTabs (const QHash<QObject*, QList<RecInfo>>& tabs)
 	{
+		Util::Tracing::TraceSpan span { "SessionsManager::OpenTabs", "tabs" };
+
 		QList<QPair<QObject*, RecInfo>> ordered;
 		for (auto i = tabs.begin (); i != tabs.end (); ++i)
 			for (const auto& info : i.value ())
@@ -256,6 +259,8 @@ namespace TabSessManager
 
 		for (const auto& pair : ordered)
 		{
+			Util::Tracing::TraceSpan tabSpan { "restore tab", "tabs", pair.second.Name_ };
+
 			const auto winGuard = TabsPropsMgr_->AppendWindow (pair.second.WindowID_);
 			const auto propsGuard = TabsPropsMgr_->AppendProps (pair.second.Props_);
 			if (const auto ihrt = qobject_cast<IHaveRecoverableTabs*> (pair.first))
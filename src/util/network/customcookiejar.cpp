@@ -61,14 +61,50 @@ namespace Util
 		MatchDomainExactly_ = enabled;
 	}
 
+	namespace
+	{
+		QString GetDomainKey (const QString& domain)
+		{
+			return domain.startsWith ('.') ? domain.mid (1) : domain;
+		}
+	}
+
+	bool CustomCookieJar::CompiledList::Matches (const QString& str) const
+	{
+		return Patterns_.contains (str) ||
+				(!Combined_.isEmpty () && Combined_.exactMatch (str));
+	}
+
+	namespace
+	{
+		template<typename T>
+		T Compile (const QList<QRegExp>& list)
+		{
+			T result;
+
+			QStringList alternatives;
+			for (const auto& rx : list)
+			{
+				result.Patterns_ << rx.pattern ();
+				if (rx.isValid ())
+					alternatives << "(?:" + rx.pattern () + ")";
+			}
+
+			if (!alternatives.isEmpty ())
+				result.Combined_ = QRegExp { "(?:" + alternatives.join ('|') + ")" };
+
+			return result;
+		}
+	}
+
 	void CustomCookieJar::SetWhitelist (const QList<QRegExp>& list)
 	{
-		WL_ = list;
+		WL_ = Compile<CompiledList> (list);
 	}
 
 	void CustomCookieJar::SetBlacklist (const QList<QRegExp>& list)
 	{
-		BL_ = list;
+		BL_ = Compile<CompiledList> (list);
 	}
 
 	QByteArray CustomCookieJar::Save () const
@@ -132,15 +168,125 @@ namespace Util
 		setAllCookies (result);
 	}
 
+	void CustomCookieJar::EnableJournal ()
+	{
+		JournalEnabled_ = true;
+	}
+
+	std::optional<QByteArray> CustomCookieJar::TakeJournal ()
+	{
+		if (!JournalEnabled_ || JournalReset_)
+		{
+			JournalReset_ = false;
+			Journal_.clear ();
+			return {};
+		}
+
+		const auto result = Journal_;
+		Journal_.clear ();
+		return result;
+	}
+
+	void CustomCookieJar::LoadJournal (const QByteArray& journal)
+	{
+		QList<QNetworkCookie> added;
+		QList<QNetworkCookie> removed;
+
+		for (const auto& line : journal.split ('\n'))
+		{
+			if (line.size () < 2)
+				continue;
+
+			const auto& record = line.mid (1);
+			for (const auto& cookie : QNetworkCookie::parseCookies (record))
+				switch (line.at (0))
+				{
+				case '+':
+					if (insertCookie (cookie))
+						added << cookie;
+					break;
+				case '-':
+					if (deleteCookie (cookie))
+						removed << cookie;
+					break;
+				default:
+					qWarning () << Q_FUNC_INFO
+							<< "unknown journal record"
+							<< line;
+					break;
+				}
+		}
+
+		if (!removed.isEmpty ())
+			emit cookiesRemoved (removed);
+		if (!added.isEmpty ())
+			emit cookiesAdded (added);
+	}
+
+	namespace
+	{
+		// Mirror the matching rules of QNetworkCookieJar::cookiesForUrl().
+		bool IsParentDomain (const QString& domain, const QString& reference)
+		{
+			if (!reference.startsWith ('.'))
+				return domain == reference;
+
+			return domain.endsWith (reference) || domain == reference.midRef (1);
+		}
+
+		bool IsParentPath (const QString& path, const QString& reference)
+		{
+			if ((path.isEmpty () && reference == "/") || path.startsWith (reference))
+			{
+				if (path.size () == reference.size ())
+					return true;
+				if (reference.endsWith ('/'))
+					return true;
+				if (path.at (reference.size ()) == '/')
+					return true;
+			}
+
+			return false;
+		}
+	}
+
 	QList<QNetworkCookie> CustomCookieJar::cookiesForUrl (const QUrl& url) const
 	{
 		if (!Enabled_)
 			return {};
 
+		const auto& now = QDateTime::currentDateTimeUtc ();
+		const auto isEncrypted = url.scheme ().toLower () == "https";
+		const auto& host = url.host ();
+		const auto& path = url.path ();
+
 		QList<QNetworkCookie> filtered;
-		for (const auto& cookie : QNetworkCookieJar::cookiesForUrl (url))
-			if (!filtered.contains (cookie))
-				filtered << cookie;
+
+		// Every cookie applicable to the host is indexed by one of its suffixes.
+		for (int pos = 0; pos >= 0; )
+		{
+			const auto domainPos = Domain2Cookies_.find (host.mid (pos));
+			if (domainPos != Domain2Cookies_.end ())
+				for (const auto& cookie : *domainPos)
+				{
+					if (!IsParentDomain (host, cookie.domain ()) ||
+							!IsParentPath (path, cookie.path ()) ||
+							IsExpired (cookie, now) ||
+							(cookie.isSecure () && !isEncrypted))
+						continue;
+
+					if (!filtered.contains (cookie))
+						filtered << cookie;
+				}
+
+			const auto dot = host.indexOf ('.', pos);
+			pos = dot >= 0 ? dot + 1 : -1;
+		}
+
+		std::stable_sort (filtered.begin (), filtered.end (),
+				[] (const QNetworkCookie& left, const QNetworkCookie& right)
+					{ return left.path ().size () > right.path ().size (); });
+
 		return filtered;
 	}
 
@@ -163,15 +309,6 @@ namespace Util
 			return idx > 0 && domain.at (idx - 1) == '.';
 		}
 
-		bool Check (const QList<QRegExp>& list, const QString& str)
-		{
-			for (auto& rx : list)
-				if (str == rx.pattern () || rx.exactMatch (str))
-					return true;
-
-			return false;
-		}
-
 		struct CookiesDiff
 		{
 			QList<QNetworkCookie> Added_;
@@ -233,7 +370,7 @@ namespace Util
 			bool checkWhitelist = false;
 			const auto wlGuard = Util::MakeScopeGuard ([&]
 					{
-						if (checkWhitelist && Check (WL_, cookie.domain ()))
+						if (checkWhitelist && WL_.Matches (cookie.domain ()))
 							filtered << cookie;
 					});
 
@@ -250,7 +387,7 @@ namespace Util
 				continue;
 			}
 
-			if (!Check (BL_, cookie.domain ()))
+			if (!BL_.Matches (cookie.domain ()))
 				filtered << cookie;
 		}
 
@@ -269,5 +406,88 @@ namespace Util
 
 		return QNetworkCookieJar::setCookiesFromUrl (filtered, url);
 	}
+
+	bool CustomCookieJar::insertCookie (const QNetworkCookie& cookie)
+	{
+		RemoveCookie (cookie);
+
+		if (IsExpired (cookie, QDateTime::currentDateTimeUtc ()))
+		{
+			AppendToJournal ('-', cookie);
+			return false;
+		}
+
+		Domain2Cookies_ [GetDomainKey (cookie.domain ())] << cookie;
+		AppendToJournal ('+', cookie);
+		return true;
+	}
+
+	bool CustomCookieJar::updateCookie (const QNetworkCookie& cookie)
+	{
+		if (!deleteCookie (cookie))
+			return false;
+
+		return insertCookie (cookie);
+	}
+
+	bool CustomCookieJar::deleteCookie (const QNetworkCookie& cookie)
+	{
+		if (!RemoveCookie (cookie))
+			return false;
+
+		AppendToJournal ('-', cookie);
+		return true;
+	}
+
+	QList<QNetworkCookie> CustomCookieJar::allCookies () const
+	{
+		QList<QNetworkCookie> result;
+		for (const auto& cookies : Domain2Cookies_)
+			result += cookies;
+		return result;
+	}
+
+	void CustomCookieJar::setAllCookies (const QList<QNetworkCookie>& cookies)
+	{
+		Domain2Cookies_.clear ();
+		for (const auto& cookie : cookies)
+			Domain2Cookies_ [GetDomainKey (cookie.domain ())] << cookie;
+
+		JournalReset_ = true;
+		Journal_.clear ();
+	}
+
+	bool CustomCookieJar::RemoveCookie (const QNetworkCookie& cookie)
+	{
+		const auto pos = Domain2Cookies_.find (GetDomainKey (cookie.domain ()));
+		if (pos == Domain2Cookies_.end ())
+			return false;
+
+		auto& cookies = *pos;
+		const auto it = std::find_if (cookies.begin (), cookies.end (),
+				[&cookie] (const QNetworkCookie& other)
+				{
+					return other.name () == cookie.name () &&
+							other.domain () == cookie.domain () &&
+							other.path () == cookie.path ();
+				});
+		if (it == cookies.end ())
+			return false;
+
+		cookies.erase (it);
+		if (cookies.isEmpty ())
+			Domain2Cookies_.erase (pos);
+		return true;
+	}
+
+	void CustomCookieJar::AppendToJournal (char op, const QNetworkCookie& cookie)
+	{
+		if (!JournalEnabled_ || JournalReset_)
+			return;
+
+		Journal_ += op;
+		Journal_ += cookie.toRawForm ();
+		Journal_ += '\n';
+	}
 }
 }
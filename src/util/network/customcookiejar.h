@@ -29,9 +29,12 @@
 
 #pragma once
 
+#include <optional>
 #include <QNetworkCookieJar>
 #include <QByteArray>
 #include <QRegExp>
+#include <QHash>
+#include <QSet>
 #include "networkconfig.h"
 
 namespace LC
@@ -43,6 +46,13 @@ namespace Util
 	 * Allows one to filter tracking cookies, filter duplicate cookies
 	 * and has unlimited storage period.
 	 *
+	 * The cookies are indexed by their domains, so looking up the
+	 * cookies for an URL doesn't depend on the total number of cookies.
+	 *
+	 * The jar can also keep a journal of the changes (see
+	 * EnableJournal()), so that only the changed cookies need to be
+	 * written to the disk.
+	 *
 	 * @ingroup NetworkUtil
 	 */
 	class UTIL_NETWORK_API CustomCookieJar : public QNetworkCookieJar
@@ -53,8 +63,22 @@ namespace Util
 		bool Enabled_ = true;
 		bool MatchDomainExactly_ = false;
 
-		QList<QRegExp> WL_;
-		QList<QRegExp> BL_;
+		struct CompiledList
+		{
+			QSet<QString> Patterns_;
+			QRegExp Combined_;
+
+			bool Matches (const QString&) const;
+		};
+
+		CompiledList WL_;
+		CompiledList BL_;
+
+		QHash<QString, QList<QNetworkCookie>> Domain2Cookies_;
+
+		bool JournalEnabled_ = false;
+		bool JournalReset_ = false;
+		QByteArray Journal_;
 	public:
 		/** @brief Constructs the cookie jar.
 		 *
@@ -138,6 +162,42 @@ namespace Util
 		 */
 		void CollectGarbage ();
 
+		/** @brief Enables recording the changes to the jar.
+		 *
+		 * Once enabled, the changes to the jar are recorded until they
+		 * are retrieved via TakeJournal().
+		 *
+		 * @sa TakeJournal(), LoadJournal()
+		 */
+		void EnableJournal ();
+
+		/** @brief Returns the changes since the previous call.
+		 *
+		 * The returned journal records are meant to be appended to the
+		 * records returned by the previous calls and restored via
+		 * LoadJournal() after the jar contents are restored via Load().
+		 *
+		 * If the whole jar has been replaced since the previous call (for
+		 * example, via setAllCookies(), Load() or CollectGarbage()), the
+		 * changes can't be expressed as a journal, and an empty optional
+		 * is returned. In this case the previous journal records should
+		 * be discarded and the jar should be saved via Save().
+		 *
+		 * @return The journal records, or an empty optional if the jar
+		 * should be saved in whole.
+		 *
+		 * @sa EnableJournal(), LoadJournal()
+		 */
+		[[nodiscard]] std::optional<QByteArray> TakeJournal ();
+
+		/** @brief Applies the journal records obtained via TakeJournal().
+		 *
+		 * @param[in] journal The concatenated journal records.
+		 *
+		 * @sa TakeJournal()
+		 */
+		void LoadJournal (const QByteArray& journal);
+
 		/** @brief Returns cookies for the given url.
 		 *
 		 * This function automatically filters out duplicate cookies.
@@ -159,8 +219,32 @@ namespace Util
 		 */
 		bool setCookiesFromUrl (const QList<QNetworkCookie>& cookieList, const QUrl& url);
 
-		using QNetworkCookieJar::allCookies;
-		using QNetworkCookieJar::setAllCookies;
+		/** @brief Reimplemented from QNetworkCookieJar.
+		 */
+		bool insertCookie (const QNetworkCookie& cookie) override;
+
+		/** @brief Reimplemented from QNetworkCookieJar.
+		 */
+		bool updateCookie (const QNetworkCookie& cookie) override;
+
+		/** @brief Reimplemented from QNetworkCookieJar.
+		 */
+		bool deleteCookie (const QNetworkCookie& cookie) override;
+
+		/** @brief Returns all the cookies in the jar.
+		 *
+		 * @return All the cookies in the jar.
+		 */
+		QList<QNetworkCookie> allCookies () const;
+
+		/** @brief Replaces the contents of the jar with \em cookies.
+		 *
+		 * @param[in] cookies The new contents of the jar.
+		 */
+		void setAllCookies (const QList<QNetworkCookie>& cookies);
+	private:
+		bool RemoveCookie (const QNetworkCookie&);
+		void AppendToJournal (char, const QNetworkCookie&);
 	signals:
 		void cookiesAdded (const QList<QNetworkCookie>&);
 		void cookiesRemoved (const QList<QNetworkCookie>&);
@@ -30,11 +30,13 @@
 #include "networkdiskcache.h"
 #include <QtDebug>
 #include <QDir>
-#include <QFuture>
+#include <QFileInfo>
+#include <QCryptographicHash>
 #include <QMutexLocker>
+#include <QtConcurrentRun>
 #include <util/sys/paths.h>
-#include <util/threads/futures.h>
 #include "networkdiskcachegc.h"
+#include "networkdiskcacheindex.h"
 
 namespace LC
 {
@@ -50,23 +52,27 @@ namespace Util
 
 	NetworkDiskCache::NetworkDiskCache (const QString& subpath, QObject *parent)
 	: QNetworkDiskCache (parent)
-	, CurrentSize_ (-1)
+	, CacheDir_ (GetCacheDir (subpath))
 	, InsertRemoveMutex_ (QMutex::Recursive)
-	, GcGuard_ (NetworkDiskCacheGC::Instance ().RegisterDirectory (GetCacheDir (subpath),
+	, GcGuard_ (NetworkDiskCacheGC::Instance ().RegisterDirectory (CacheDir_,
 			[this] { return maximumCacheSize (); }))
+	, Index_ (NetworkDiskCacheGC::Instance ().GetIndex (CacheDir_))
 	{
-		setCacheDirectory (GetCacheDir (subpath));
+		setCacheDirectory (CacheDir_);
 	}
 
 	qint64 NetworkDiskCache::cacheSize () const
 	{
-		return CurrentSize_;
+		return Index_->GetTotalSize ();
 	}
 
 	QIODevice* NetworkDiskCache::data (const QUrl& url)
 	{
 		QMutexLocker lock (&InsertRemoveMutex_);
-		return QNetworkDiskCache::data (url);
+		const auto result = QNetworkDiskCache::data (url);
+		if (result)
+			Index_->Touch (GetCacheFileName (url));
+		return result;
 	}
 
 	void NetworkDiskCache::insert (QIODevice *device)
@@ -79,10 +85,17 @@ namespace Util
 			return;
 		}
 
-		PendingUrl2Devs_ [PendingDev2Url_.take (device)].removeAll (device);
+		const auto& url = PendingDev2Url_.take (device);
+		PendingUrl2Devs_ [url].removeAll (device);
 
-		CurrentSize_ += device->size ();
+		const auto deviceSize = device->size ();
 		QNetworkDiskCache::insert (device);
+
+		const auto& path = GetCacheFileName (url);
+		const QFileInfo fi { path };
+		Index_->Insert (path, fi.exists () ? fi.size () : deviceSize);
+
+		expire ();
 	}
 
 	QNetworkCacheMetaData NetworkDiskCache::metaData (const QUrl& url)
@@ -105,6 +118,7 @@ namespace Util
 		QMutexLocker lock (&InsertRemoveMutex_);
 		for (const auto dev : PendingUrl2Devs_.take (url))
 			PendingDev2Url_.remove (dev);
+		Index_->Remove (GetCacheFileName (url));
 		return QNetworkDiskCache::remove (url);
 	}
 
@@ -114,18 +128,42 @@ namespace Util
 		QNetworkDiskCache::updateMetaData (metaData);
 	}
 
+	void NetworkDiskCache::clear ()
+	{
+		QMutexLocker lock (&InsertRemoveMutex_);
+
+		// QNetworkDiskCache::clear() goes through expire(), which would
+		// schedule an asynchronous eviction racing with Index_->Clear(),
+		// so evict all the indexed files synchronously beforehand.
+		Index_->Evict (0);
+		QNetworkDiskCache::clear ();
+		Index_->Clear ();
+	}
+
 	qint64 NetworkDiskCache::expire ()
 	{
-		if (CurrentSize_ < 0)
-		{
-			const auto& dir = cacheDirectory ();
-			Util::Sequence (this, NetworkDiskCacheGC::Instance ().GetCurrentSize (dir)) >>
-					[this] (qint64 res) { CurrentSize_ = res; };
+		const auto size = Index_->GetTotalSize ();
+		const auto maxSize = maximumCacheSize ();
+		if (size <= maxSize)
+			return size;
 
-			return maximumCacheSize () * 8 / 10;
-		}
+		// Evicting an already evicted index is cheap, so concurrent runs are fine.
+		QtConcurrent::run ([index = Index_, goal = maxSize * 9 / 10] { index->Evict (goal); });
+
+		return size;
+	}
+
+	// Mirrors QNetworkDiskCachePrivate::cacheFileName(), which isn't public.
+	QString NetworkDiskCache::GetCacheFileName (QUrl url) const
+	{
+		url.setPassword ({});
+		url.setFragment ({});
+
+		const auto& hash = QCryptographicHash::hash (url.toEncoded (), QCryptographicHash::Sha1);
+		const auto& id = QByteArray::number (*reinterpret_cast<const qlonglong*> (hash.constData ()), 36).left (8);
+		const auto code = static_cast<uint> (id.at (id.size () - 1)) % 16;
 
-		return CurrentSize_;
+		return CacheDir_ + "/data8/" + QString::number (code, 16) + '/' + QString::fromLatin1 (id) + ".d";
 	}
 }
 }
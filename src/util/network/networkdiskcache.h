@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <memory>
 #include <QNetworkDiskCache>
 #include <QMutex>
 #include <QHash>
@@ -45,18 +46,21 @@ namespace Util
 	 * thus it can be used from multiple threads simultaneously.
 	 *
 	 * Also, old cache data is automatically removed from the cache in a
-	 * background thread without blocking. The garbage collection can be
-	 * also triggered manually via the collectGarbage() slot.
+	 * background thread without blocking. The least recently used data
+	 * is removed first, as recorded by a NetworkDiskCacheIndex.
 	 *
-	 * The garbage is collected until cache takes 90% of its maximum size.
+	 * The garbage is collected as soon as the cache exceeds its maximum
+	 * size, until the cache takes 90% of its maximum size.
 	 *
 	 * @ingroup NetworkUtil
 	 */
+	class NetworkDiskCacheIndex;
+
 	class UTIL_NETWORK_API NetworkDiskCache : public QNetworkDiskCache
 	{
 		Q_OBJECT
 
-		qint64 CurrentSize_;
+		const QString CacheDir_;
 
 		mutable QMutex InsertRemoveMutex_;
 
@@ -64,6 +68,9 @@ namespace Util
 		QHash<QUrl, QList<QIODevice*>> PendingUrl2Devs_;
 
 		const Util::DefaultScopeGuard GcGuard_;
+		const std::shared_ptr<NetworkDiskCacheIndex> Index_;
+
+		friend class NetworkDiskCacheTest;
 	public:
 		/** @brief Constructs the new disk cache.
 		 *
@@ -104,10 +111,16 @@ namespace Util
 		/** @brief Reimplemented from QNetworkDiskCache.
 		 */
 		void updateMetaData (const QNetworkCacheMetaData& metaData) override;
+
+		/** @brief Reimplemented from QNetworkDiskCache.
+		 */
+		void clear () override;
 	protected:
 		/** @brief Reimplemented from QNetworkDiskCache.
 		 */
 		qint64 expire () override;
+	private:
+		QString GetCacheFileName (QUrl) const;
 	};
 }
 }
@@ -32,13 +32,12 @@
 #include <QDir>
 #include <QDirIterator>
 #include <QtConcurrentRun>
-#include <QDateTime>
 #include <QtDebug>
-#include <util/compat/fileinfo.h>
 #include <util/sll/qtutil.h>
 #include <util/sll/prelude.h>
 #include <util/sll/util.h>
 #include <util/threads/futures.h>
+#include "networkdiskcacheindex.h"
 
 namespace LC
 {
@@ -62,25 +61,17 @@ namespace Util
 
 	namespace
 	{
-		struct SizeCollectInfo
+		qint64 CollectSize (const QString& cacheDirectory)
 		{
-			QMultiMap<QDateTime, QString> Items_;
-			qint64 TotalSize_ = 0;
-		};
-
-		SizeCollectInfo CollectSizes (const QString& cacheDirectory)
-		{
-			SizeCollectInfo result;
+			qint64 result = 0;
 
 			const QDir::Filters filters = QDir::AllDirs | QDir:: Files | QDir::NoDotAndDotDot;
 			QDirIterator it { cacheDirectory, filters, QDirIterator::Subdirectories };
 
 			while (it.hasNext ())
 			{
-				const auto& path = it.next ();
-				const auto& info = it.fileInfo ();
-				result.Items_.insert (Compat::Created (info), path);
-				result.TotalSize_ += info.size ();
+				it.next ();
+				result += it.fileInfo ().size ();
 			}
 
 			return result;
@@ -89,7 +80,7 @@ namespace Util
 
 	QFuture<qint64> NetworkDiskCacheGC::GetCurrentSize (const QString& path) const
 	{
-		return QtConcurrent::run ([path] { return CollectSizes (path).TotalSize_; });
+		return QtConcurrent::run ([path] { return CollectSize (path); });
 	}
 
 	Util::DefaultScopeGuard NetworkDiskCacheGC::RegisterDirectory (const QString& path,
@@ -99,6 +90,13 @@ namespace Util
 		list.push_front (sizeGetter);
 		const auto thisItem = list.begin ();
 
+		if (!Indexes_.contains (path))
+		{
+			const auto index = std::make_shared<NetworkDiskCacheIndex> (path);
+			Indexes_ [path] = index;
+			QtConcurrent::run ([index] { index->Load (); });
+		}
+
 		return Util::MakeScopeGuard ([this, path, thisItem] { UnregisterDirectory (path, thisItem); }).EraseType ();
 	}
 
@@ -120,31 +118,21 @@ namespace Util
 
 		Directories_.remove (path);
 		LastSizes_.remove (path);
+		Indexes_.remove (path);
+	}
+
+	std::shared_ptr<NetworkDiskCacheIndex> NetworkDiskCacheGC::GetIndex (const QString& path) const
+	{
+		return Indexes_.value (path);
 	}
 
 	namespace
 	{
-		qint64 Collector (const QString& cacheDirectory, qint64 goal)
+		qint64 Collector (const std::shared_ptr<NetworkDiskCacheIndex>& index, qint64 goal)
 		{
-			if (cacheDirectory.isEmpty ())
-				return 0;
-
-			qDebug () << Q_FUNC_INFO << "running..." << cacheDirectory << goal;
-
-			auto sizeInfoResult = CollectSizes (cacheDirectory);
-
-			for (auto i = sizeInfoResult.Items_.constBegin ();
-					i != sizeInfoResult.Items_.constEnd () && sizeInfoResult.TotalSize_ > goal;
-					++i)
-			{
-				QFile file { *i };
-				sizeInfoResult.TotalSize_ -= file.size ();
-				file.remove ();
-			}
-
-			qDebug () << "collector finished" << sizeInfoResult.TotalSize_;
-
-			return sizeInfoResult.TotalSize_;
+			const auto& result = index->Evict (goal);
+			qDebug () << Q_FUNC_INFO << "collector finished" << result;
+			return result;
 		}
 	};
 
@@ -157,13 +145,13 @@ namespace Util
 			return;
 		}
 
-		QList<QPair<QString, int>> dirs;
+		QList<std::tuple<QString, std::shared_ptr<NetworkDiskCacheIndex>, int>> dirs;
 		for (const auto& pair : Util::Stlize (Directories_))
 		{
 			const auto& getters = pair.second;
 			const auto minSize = (*std::min_element (getters.begin (), getters.end (),
 						Util::ComparingBy (Apply))) ();
-			dirs.append ({ pair.first, minSize });
+			dirs.append ({ pair.first, Indexes_.value (pair.first), minSize });
 		}
 
 		if (dirs.isEmpty ())
@@ -175,8 +163,8 @@ namespace Util
 				QtConcurrent::run ([dirs]
 						{
 							QMap<QString, qint64> sizes;
-							for (const auto& pair : dirs)
-								sizes [pair.first] = Collector (pair.first, pair.second);
+							for (const auto& [path, index, goal] : dirs)
+								sizes [path] = Collector (index, goal);
 							return sizes;
 						})) >>
 				[this] (const QMap<QString, qint64>& sizes)
@@ -43,12 +43,18 @@ namespace LC
 {
 namespace Util
 {
+	class NetworkDiskCacheIndex;
+
 	/** @brief Garbage collection for a set of network disk caches.
 	 *
 	 * This GC manager class aids having multiple network disk caches at
 	 * the same path and running garbage collection periodically on them,
 	 * but only once per each path.
 	 *
+	 * The caches at the same path also share a single
+	 * NetworkDiskCacheIndex, which is used to evict the least recently
+	 * used files without walking the cache directory.
+	 *
 	 * @ingroup NetworkUtil
 	 */
 	class NetworkDiskCacheGC : public QObject
@@ -59,6 +65,7 @@ namespace Util
 		QMap<QString, CacheSizeGetters_t> Directories_;
 
 		QMap<QString, qint64> LastSizes_;
+		QMap<QString, std::shared_ptr<NetworkDiskCacheIndex>> Indexes_;
 
 		bool IsCollecting_ = false;
 
@@ -107,6 +114,20 @@ namespace Util
 		 */
 		Util::DefaultScopeGuard RegisterDirectory (const QString& path,
 				const std::function<int ()>& sizeGetter);
+
+		/** @brief Returns the index of the given cache \em path.
+		 *
+		 * The index is created and loaded in background when the
+		 * \em path is registered for the first time via
+		 * RegisterDirectory(), and it is saved when the last guard
+		 * object for the \em path is destroyed and nobody else holds
+		 * the returned pointer.
+		 *
+		 * @param[in] path The registered cache path.
+		 * @return The index of the \em path, or a null pointer if the
+		 * \em path is not registered.
+		 */
+		std::shared_ptr<NetworkDiskCacheIndex> GetIndex (const QString& path) const;
 	private:
 		void UnregisterDirectory (const QString&, CacheSizeGetters_t::iterator);
 	private slots:
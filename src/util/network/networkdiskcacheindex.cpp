@@ -0,0 +1,284 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "networkdiskcacheindex.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFile>
+#include <QSaveFile>
+#include <QtDebug>
+
+namespace LC
+{
+namespace Util
+{
+	namespace
+	{
+		const QString IndexFilename = "lc_cache_index";
+		const quint8 IndexVersion = 1;
+	}
+
+	NetworkDiskCacheIndex::NetworkDiskCacheIndex (const QString& cacheDir)
+	: CacheDir_ { cacheDir }
+	{
+	}
+
+	NetworkDiskCacheIndex::~NetworkDiskCacheIndex ()
+	{
+		Save ();
+	}
+
+	namespace
+	{
+		template<typename Entry>
+		bool ReadIndex (const QString& path, const QString& cacheDir, std::list<Entry>& entries)
+		{
+			QFile file { path };
+			if (!file.open (QIODevice::ReadOnly))
+				return false;
+
+			QDataStream stream { &file };
+			quint8 version = 0;
+			stream >> version;
+			if (version != IndexVersion)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unknown index version"
+						<< version;
+				return false;
+			}
+
+			quint32 count = 0;
+			stream >> count;
+			for (quint32 i = 0; i < count && stream.status () == QDataStream::Ok; ++i)
+			{
+				QString relPath;
+				qint64 size = 0;
+				qint64 lastAccess = 0;
+				stream >> relPath >> size >> lastAccess;
+				entries.push_back ({ cacheDir + '/' + relPath, size, lastAccess });
+			}
+
+			if (stream.status () != QDataStream::Ok)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "corrupted index"
+						<< path;
+				entries.clear ();
+				return false;
+			}
+
+			return true;
+		}
+
+		template<typename Entry>
+		void WalkDirectory (const QString& cacheDir, const QString& indexPath, std::list<Entry>& entries)
+		{
+			QDirIterator it { cacheDir, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories };
+			while (it.hasNext ())
+			{
+				const auto& path = it.next ();
+				if (path == indexPath)
+					continue;
+
+				const auto& info = it.fileInfo ();
+				entries.push_back ({ path, info.size (), info.lastModified ().toMSecsSinceEpoch () });
+			}
+
+			entries.sort ([] (const Entry& left, const Entry& right)
+					{ return left.LastAccess_ < right.LastAccess_; });
+		}
+	}
+
+	void NetworkDiskCacheIndex::Load ()
+	{
+		const auto& indexPath = GetIndexPath ();
+
+		Entries_t loaded;
+		if (!ReadIndex (indexPath, CacheDir_, loaded))
+		{
+			qDebug () << Q_FUNC_INFO
+					<< "rebuilding the index for"
+					<< CacheDir_;
+			WalkDirectory (CacheDir_, indexPath, loaded);
+		}
+
+		// A crash from now on would leave an outdated index otherwise.
+		QFile::remove (indexPath);
+
+		QMutexLocker locker { &Mutex_ };
+
+		Entries_t accepted;
+		for (auto it = loaded.begin (); it != loaded.end (); )
+		{
+			const auto next = std::next (it);
+			if (!Path2Entry_.contains (it->Path_))
+			{
+				Path2Entry_ [it->Path_] = it;
+				TotalSize_ += it->Size_;
+				accepted.splice (accepted.end (), loaded, it);
+			}
+			it = next;
+		}
+
+		// The entries added while loading are more recent than the loaded ones.
+		Entries_.splice (Entries_.begin (), accepted);
+	}
+
+	void NetworkDiskCacheIndex::Save () const
+	{
+		QSaveFile file { GetIndexPath () };
+		if (!file.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< file.fileName ()
+					<< file.errorString ();
+			return;
+		}
+
+		QDataStream stream { &file };
+
+		{
+			QMutexLocker locker { &Mutex_ };
+
+			stream << IndexVersion << static_cast<quint32> (Entries_.size ());
+
+			const auto prefixLength = CacheDir_.size () + 1;
+			for (const auto& entry : Entries_)
+				stream << entry.Path_.mid (prefixLength) << entry.Size_ << entry.LastAccess_;
+		}
+
+		if (!file.commit ())
+			qWarning () << Q_FUNC_INFO
+					<< "unable to save"
+					<< file.fileName ()
+					<< file.errorString ();
+	}
+
+	void NetworkDiskCacheIndex::Insert (const QString& path, qint64 size)
+	{
+		const auto now = QDateTime::currentMSecsSinceEpoch ();
+
+		QMutexLocker locker { &Mutex_ };
+		const auto pos = Path2Entry_.find (path);
+		if (pos == Path2Entry_.end ())
+		{
+			Entries_.push_back ({ path, size, now });
+			Path2Entry_ [path] = std::prev (Entries_.end ());
+			TotalSize_ += size;
+			return;
+		}
+
+		const auto entry = *pos;
+		TotalSize_ += size - entry->Size_;
+		entry->Size_ = size;
+		entry->LastAccess_ = now;
+		Entries_.splice (Entries_.end (), Entries_, entry);
+	}
+
+	void NetworkDiskCacheIndex::Touch (const QString& path)
+	{
+		const auto now = QDateTime::currentMSecsSinceEpoch ();
+
+		QMutexLocker locker { &Mutex_ };
+		const auto pos = Path2Entry_.find (path);
+		if (pos == Path2Entry_.end ())
+			return;
+
+		const auto entry = *pos;
+		entry->LastAccess_ = now;
+		Entries_.splice (Entries_.end (), Entries_, entry);
+	}
+
+	void NetworkDiskCacheIndex::Remove (const QString& path)
+	{
+		QMutexLocker locker { &Mutex_ };
+		const auto pos = Path2Entry_.find (path);
+		if (pos == Path2Entry_.end ())
+			return;
+
+		TotalSize_ -= (*pos)->Size_;
+		Entries_.erase (*pos);
+		Path2Entry_.erase (pos);
+	}
+
+	qint64 NetworkDiskCacheIndex::GetTotalSize () const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return TotalSize_;
+	}
+
+	int NetworkDiskCacheIndex::GetCount () const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return Path2Entry_.size ();
+	}
+
+	void NetworkDiskCacheIndex::Clear ()
+	{
+		QMutexLocker locker { &Mutex_ };
+		Entries_.clear ();
+		Path2Entry_.clear ();
+		TotalSize_ = 0;
+	}
+
+	qint64 NetworkDiskCacheIndex::Evict (qint64 goal)
+	{
+		Entries_t victims;
+		qint64 result = 0;
+
+		{
+			QMutexLocker locker { &Mutex_ };
+
+			auto end = Entries_.begin ();
+			while (end != Entries_.end () && TotalSize_ > goal)
+			{
+				TotalSize_ -= end->Size_;
+				Path2Entry_.remove (end->Path_);
+				++end;
+			}
+			victims.splice (victims.end (), Entries_, Entries_.begin (), end);
+
+			result = TotalSize_;
+		}
+
+		for (const auto& entry : victims)
+			QFile::remove (entry.Path_);
+
+		return result;
+	}
+
+	QString NetworkDiskCacheIndex::GetIndexPath () const
+	{
+		return CacheDir_ + '/' + IndexFilename;
+	}
+}
+}
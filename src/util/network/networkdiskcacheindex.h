@@ -0,0 +1,158 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <list>
+#include <QString>
+#include <QHash>
+#include <QMutex>
+#include "networkconfig.h"
+
+namespace LC
+{
+namespace Util
+{
+	/** @brief The persistent LRU index of files in a network disk cache.
+	 *
+	 * The index keeps track of the size and last access time of every
+	 * file in the cache directory, so that the total cache size is known
+	 * precisely and the least recently used files can be evicted without
+	 * walking the directory tree.
+	 *
+	 * The index is saved to the cache directory when it is destroyed and
+	 * is read back by Load(). The saved index is removed as soon as it
+	 * is loaded, so if the application doesn't shut down cleanly, the
+	 * next Load() rebuilds the index by walking the directory once.
+	 *
+	 * All the methods are thread-safe.
+	 *
+	 * @ingroup NetworkUtil
+	 */
+	class UTIL_NETWORK_API NetworkDiskCacheIndex
+	{
+		const QString CacheDir_;
+
+		struct Entry
+		{
+			QString Path_;
+			qint64 Size_;
+			qint64 LastAccess_;
+		};
+		using Entries_t = std::list<Entry>;
+
+		// The least recently used entries are at the front.
+		Entries_t Entries_;
+		QHash<QString, Entries_t::iterator> Path2Entry_;
+		qint64 TotalSize_ = 0;
+
+		mutable QMutex Mutex_;
+	public:
+		/** @brief Constructs an empty index for the \em cacheDir.
+		 *
+		 * @param[in] cacheDir The cache directory to index.
+		 */
+		explicit NetworkDiskCacheIndex (const QString& cacheDir);
+
+		/** @brief Saves the index to the cache directory.
+		 */
+		~NetworkDiskCacheIndex ();
+
+		NetworkDiskCacheIndex (const NetworkDiskCacheIndex&) = delete;
+		NetworkDiskCacheIndex& operator= (const NetworkDiskCacheIndex&) = delete;
+
+		/** @brief Loads the saved index or rebuilds it from scratch.
+		 *
+		 * This function may walk the whole cache directory and thus is
+		 * better called from a separate thread. The entries added while
+		 * the index is being loaded are considered to be more recent
+		 * than the loaded ones.
+		 */
+		void Load ();
+
+		/** @brief Saves the index to the cache directory.
+		 */
+		void Save () const;
+
+		/** @brief Adds the \em path to the index or updates its size.
+		 *
+		 * The \em path becomes the most recently used one.
+		 *
+		 * @param[in] path The absolute path of the cache file.
+		 * @param[in] size The size of the cache file.
+		 */
+		void Insert (const QString& path, qint64 size);
+
+		/** @brief Marks the \em path as the most recently used one.
+		 *
+		 * @param[in] path The absolute path of the cache file.
+		 */
+		void Touch (const QString& path);
+
+		/** @brief Removes the \em path from the index.
+		 *
+		 * The file itself is not removed.
+		 *
+		 * @param[in] path The absolute path of the cache file.
+		 */
+		void Remove (const QString& path);
+
+		/** @brief Returns the total size of the indexed files.
+		 *
+		 * @return The total size of the indexed files.
+		 */
+		qint64 GetTotalSize () const;
+
+		/** @brief Returns the number of the indexed files.
+		 *
+		 * @return The number of the indexed files.
+		 */
+		int GetCount () const;
+
+		/** @brief Removes all the entries from the index.
+		 *
+		 * The files themselves are not removed.
+		 */
+		void Clear ();
+
+		/** @brief Removes least recently used files until \em goal is met.
+		 *
+		 * The files are removed from the index and then from the disk
+		 * until the total size of the cache is not greater than
+		 * \em goal.
+		 *
+		 * @param[in] goal The desired total size of the cache.
+		 * @return The total size of the cache after the eviction.
+		 */
+		qint64 Evict (qint64 goal);
+	private:
+		QString GetIndexPath () const;
+	};
+}
+}
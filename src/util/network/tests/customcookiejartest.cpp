@@ -0,0 +1,208 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "customcookiejartest.h"
+#include <QtTest>
+#include <QNetworkCookie>
+#include <customcookiejar.h>
+
+QTEST_GUILESS_MAIN (LC::Util::CustomCookieJarTest)
+
+namespace LC
+{
+namespace Util
+{
+	namespace
+	{
+		QNetworkCookie MakeCookie (const QByteArray& name, const QString& domain,
+				const QString& path = "/", bool secure = false)
+		{
+			QNetworkCookie cookie { name, "value_" + name };
+			cookie.setDomain (domain);
+			cookie.setPath (path);
+			cookie.setSecure (secure);
+			cookie.setExpirationDate (QDateTime::currentDateTime ().addDays (1));
+			return cookie;
+		}
+
+		QSet<QByteArray> GetNames (const QList<QNetworkCookie>& cookies)
+		{
+			QSet<QByteArray> result;
+			for (const auto& cookie : cookies)
+				result << cookie.name ();
+			return result;
+		}
+	}
+
+	void CustomCookieJarTest::testDomainMatching ()
+	{
+		CustomCookieJar jar;
+		jar.setAllCookies ({
+					MakeCookie ("wide", ".example.com"),
+					MakeCookie ("host", "www.example.com"),
+					MakeCookie ("other", ".other.com"),
+					MakeCookie ("suffix", ".ample.com")
+				});
+
+		QCOMPARE (GetNames (jar.cookiesForUrl (QUrl { "http://www.example.com/" })),
+				(QSet<QByteArray> { "wide", "host" }));
+		QCOMPARE (GetNames (jar.cookiesForUrl (QUrl { "http://example.com/" })),
+				(QSet<QByteArray> { "wide" }));
+		QCOMPARE (GetNames (jar.cookiesForUrl (QUrl { "http://a.b.example.com/" })),
+				(QSet<QByteArray> { "wide" }));
+		QCOMPARE (GetNames (jar.cookiesForUrl (QUrl { "http://notexample.com/" })),
+				QSet<QByteArray> {});
+	}
+
+	void CustomCookieJarTest::testSecure ()
+	{
+		CustomCookieJar jar;
+		jar.setAllCookies ({ MakeCookie ("secure", ".example.com", "/", true) });
+
+		QVERIFY (jar.cookiesForUrl (QUrl { "http://example.com/" }).isEmpty ());
+		QCOMPARE (jar.cookiesForUrl (QUrl { "https://example.com/" }).size (), 1);
+	}
+
+	void CustomCookieJarTest::testPathOrdering ()
+	{
+		CustomCookieJar jar;
+		jar.setAllCookies ({
+					MakeCookie ("root", ".example.com", "/"),
+					MakeCookie ("deep", ".example.com", "/a/b"),
+					MakeCookie ("mid", ".example.com", "/a"),
+					MakeCookie ("unrelated", ".example.com", "/ab")
+				});
+
+		const auto& cookies = jar.cookiesForUrl (QUrl { "http://example.com/a/b/c" });
+		QCOMPARE (cookies.size (), 3);
+		QCOMPARE (cookies.at (0).name (), QByteArray { "deep" });
+		QCOMPARE (cookies.at (1).name (), QByteArray { "mid" });
+		QCOMPARE (cookies.at (2).name (), QByteArray { "root" });
+	}
+
+	void CustomCookieJarTest::testInsertReplaces ()
+	{
+		CustomCookieJar jar;
+		auto cookie = MakeCookie ("name", ".example.com");
+		QVERIFY (jar.insertCookie (cookie));
+
+		cookie.setValue ("newvalue");
+		QVERIFY (jar.insertCookie (cookie));
+		QCOMPARE (jar.allCookies ().size (), 1);
+		QCOMPARE (jar.allCookies ().value (0).value (), QByteArray { "newvalue" });
+
+		cookie.setExpirationDate (QDateTime::currentDateTime ().addDays (-1));
+		QVERIFY (!jar.insertCookie (cookie));
+		QVERIFY (jar.allCookies ().isEmpty ());
+	}
+
+	void CustomCookieJarTest::testBlacklist ()
+	{
+		CustomCookieJar jar;
+		jar.SetBlacklist ({ QRegExp { ".*\\.ads\\.com" }, QRegExp { "tracker.net" } });
+
+		const QUrl adsUrl { "http://banner.ads.com/" };
+		jar.setCookiesFromUrl ({ MakeCookie ("ad", ".banner.ads.com") }, adsUrl);
+		QVERIFY (jar.cookiesForUrl (adsUrl).isEmpty ());
+
+		const QUrl trackerUrl { "http://tracker.net/" };
+		jar.setCookiesFromUrl ({ MakeCookie ("tr", "tracker.net") }, trackerUrl);
+		QVERIFY (jar.cookiesForUrl (trackerUrl).isEmpty ());
+
+		const QUrl goodUrl { "http://good.com/" };
+		jar.setCookiesFromUrl ({ MakeCookie ("good", "good.com") }, goodUrl);
+		QCOMPARE (jar.cookiesForUrl (goodUrl).size (), 1);
+	}
+
+	void CustomCookieJarTest::testWhitelist ()
+	{
+		CustomCookieJar jar;
+		jar.SetFilterTrackingCookies (true);
+		jar.SetWhitelist ({ QRegExp { "example\\.com" } });
+
+		const QUrl url { "http://example.com/" };
+		jar.setCookiesFromUrl ({ MakeCookie ("__utma", "example.com") }, url);
+		QCOMPARE (jar.cookiesForUrl (url).size (), 1);
+
+		const QUrl otherUrl { "http://other.com/" };
+		jar.setCookiesFromUrl ({ MakeCookie ("__utma", "other.com") }, otherUrl);
+		QVERIFY (jar.cookiesForUrl (otherUrl).isEmpty ());
+	}
+
+	void CustomCookieJarTest::testJournal ()
+	{
+		CustomCookieJar jar;
+		jar.EnableJournal ();
+		jar.setAllCookies ({ MakeCookie ("a", ".a.com"), MakeCookie ("b", ".b.com") });
+		QVERIFY (!jar.TakeJournal ());
+
+		const auto& snapshot = jar.Save ();
+		QVERIFY (jar.TakeJournal ()->isEmpty ());
+
+		jar.insertCookie (MakeCookie ("c", ".c.com"));
+		jar.deleteCookie (MakeCookie ("a", ".a.com"));
+		const auto& journal = jar.TakeJournal ();
+		QVERIFY (journal);
+		QVERIFY (!journal->isEmpty ());
+
+		CustomCookieJar restored;
+		restored.Load (snapshot);
+		restored.LoadJournal (*journal);
+		QCOMPARE (GetNames (restored.allCookies ()), (QSet<QByteArray> { "b", "c" }));
+	}
+
+	void CustomCookieJarTest::testJournalReset ()
+	{
+		CustomCookieJar jar;
+		jar.EnableJournal ();
+		QVERIFY (jar.TakeJournal ()->isEmpty ());
+
+		jar.insertCookie (MakeCookie ("a", ".a.com"));
+		jar.CollectGarbage ();
+		QVERIFY (!jar.TakeJournal ());
+		QVERIFY (jar.TakeJournal ()->isEmpty ());
+	}
+
+	void CustomCookieJarTest::benchCookiesForUrl ()
+	{
+		QList<QNetworkCookie> cookies;
+		for (int i = 0; i < 20000; ++i)
+			cookies << MakeCookie ("c" + QByteArray::number (i % 5),
+					QString (".site%1.com").arg (i / 5));
+
+		CustomCookieJar jar;
+		jar.setAllCookies (cookies);
+
+		const QUrl url { "https://www.site1234.com/some/path" };
+		QCOMPARE (jar.cookiesForUrl (url).size (), 5);
+
+		QBENCHMARK { jar.cookiesForUrl (url); }
+	}
+}
+}
@@ -0,0 +1,206 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "networkdiskcacheindexbench.h"
+#include <QtTest>
+#include <networkdiskcacheindex.h>
+
+QTEST_GUILESS_MAIN (LC::Util::NetworkDiskCacheIndexBench)
+
+namespace LC
+{
+namespace Util
+{
+	namespace
+	{
+		// 200k entries of 10 KiB on average make up a 2 GiB cache.
+		const int EntriesCount = 200000;
+		const qint64 AvgEntrySize = 10 * 1024;
+		const qint64 CacheSize = EntriesCount * AvgEntrySize;
+
+		qint64 GetSize (int i)
+		{
+			return AvgEntrySize / 2 + (i * 7919) % AvgEntrySize;
+		}
+
+		void Fill (NetworkDiskCacheIndex& index, const QStringList& paths)
+		{
+			for (int i = 0; i < paths.size (); ++i)
+				index.Insert (paths.at (i), GetSize (i));
+		}
+
+		void CreateFile (const QString& path, int size)
+		{
+			QDir {}.mkpath (QFileInfo { path }.absolutePath ());
+			QFile file { path };
+			QVERIFY (file.open (QIODevice::WriteOnly));
+			file.write (QByteArray (size, 'x'));
+		}
+	}
+
+	// The paths point to a temporary directory, and the files are not
+	// created, so the benchmarks measure the index itself and not the
+	// file system.
+	void NetworkDiskCacheIndexBench::initTestCase ()
+	{
+		Dir_ = std::make_unique<QTemporaryDir> ();
+		QVERIFY (Dir_->isValid ());
+
+		Paths_.reserve (EntriesCount);
+		for (int i = 0; i < EntriesCount; ++i)
+			Paths_ << QString ("%1/data8/%2/%3.d")
+					.arg (Dir_->path ())
+					.arg (i % 16, 0, 16)
+					.arg (i, 8, 36, QChar { '0' });
+	}
+
+	void NetworkDiskCacheIndexBench::testLru ()
+	{
+		QTemporaryDir dir;
+		const auto& path = [&dir] (const QString& name) { return dir.path () + '/' + name; };
+
+		CreateFile (path ("a"), 10);
+		CreateFile (path ("b"), 20);
+		CreateFile (path ("c"), 30);
+
+		NetworkDiskCacheIndex index { dir.path () };
+		index.Insert (path ("a"), 10);
+		index.Insert (path ("b"), 20);
+		index.Insert (path ("c"), 30);
+		QCOMPARE (index.GetTotalSize (), qint64 { 60 });
+
+		index.Touch (path ("a"));
+		index.Insert (path ("c"), 35);
+		QCOMPARE (index.GetTotalSize (), qint64 { 65 });
+
+		QCOMPARE (index.Evict (50), qint64 { 45 });
+		QVERIFY (!QFile::exists (path ("b")));
+		QVERIFY (QFile::exists (path ("a")));
+		QVERIFY (QFile::exists (path ("c")));
+
+		QCOMPARE (index.Evict (35), qint64 { 35 });
+		QVERIFY (!QFile::exists (path ("a")));
+		QVERIFY (QFile::exists (path ("c")));
+
+		index.Remove (path ("c"));
+		QCOMPARE (index.GetTotalSize (), qint64 { 0 });
+		QCOMPARE (index.GetCount (), 0);
+	}
+
+	void NetworkDiskCacheIndexBench::testSaveLoad ()
+	{
+		QTemporaryDir dir;
+		const auto& path = [&dir] (const QString& name) { return dir.path () + '/' + name; };
+
+		{
+			NetworkDiskCacheIndex index { dir.path () };
+			index.Insert (path ("a"), 10);
+			index.Insert (path ("b"), 20);
+			index.Touch (path ("a"));
+		}
+
+		NetworkDiskCacheIndex index { dir.path () };
+		index.Insert (path ("c"), 30);
+		index.Load ();
+		QCOMPARE (index.GetCount (), 3);
+		QCOMPARE (index.GetTotalSize (), qint64 { 60 });
+
+		// b is the least recently used one, and c has been added after a.
+		QCOMPARE (index.Evict (40), qint64 { 40 });
+		QCOMPARE (index.Evict (30), qint64 { 30 });
+		QCOMPARE (index.GetCount (), 1);
+	}
+
+	void NetworkDiskCacheIndexBench::testRebuild ()
+	{
+		QTemporaryDir dir;
+		CreateFile (dir.path () + "/data8/1/a.d", 10);
+		CreateFile (dir.path () + "/data8/2/b.d", 20);
+
+		NetworkDiskCacheIndex index { dir.path () };
+		index.Load ();
+		QCOMPARE (index.GetCount (), 2);
+		QCOMPARE (index.GetTotalSize (), qint64 { 30 });
+	}
+
+	void NetworkDiskCacheIndexBench::benchFill ()
+	{
+		NetworkDiskCacheIndex index { Dir_->path () };
+
+		QBENCHMARK
+		{
+			index.Clear ();
+			Fill (index, Paths_);
+		}
+
+		QCOMPARE (index.GetCount (), EntriesCount);
+	}
+
+	void NetworkDiskCacheIndexBench::benchLookup ()
+	{
+		NetworkDiskCacheIndex index { Dir_->path () };
+		Fill (index, Paths_);
+
+		int i = 0;
+		QBENCHMARK
+		{
+			for (int j = 0; j < 1000; ++j)
+				index.Touch (Paths_.at ((++i * 104729) % EntriesCount));
+		}
+	}
+
+	void NetworkDiskCacheIndexBench::benchEvict ()
+	{
+		NetworkDiskCacheIndex index { Dir_->path () };
+
+		QBENCHMARK
+		{
+			Fill (index, Paths_);
+			QVERIFY (index.GetTotalSize () > CacheSize * 9 / 10);
+			index.Evict (CacheSize * 9 / 10);
+		}
+	}
+
+	void NetworkDiskCacheIndexBench::benchSaveLoad ()
+	{
+		QBENCHMARK
+		{
+			{
+				NetworkDiskCacheIndex index { Dir_->path () };
+				Fill (index, Paths_);
+			}
+
+			NetworkDiskCacheIndex index { Dir_->path () };
+			index.Load ();
+			QCOMPARE (index.GetCount (), EntriesCount);
+			index.Clear ();
+		}
+	}
+}
+}
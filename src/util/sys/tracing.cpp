@@ -0,0 +1,214 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "tracing.h"
+#include <atomic>
+#include <vector>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+#include <QtDebug>
+
+namespace LC
+{
+namespace Util
+{
+namespace Tracing
+{
+	namespace
+	{
+		struct Event
+		{
+			const char *Name_;
+			const char *Category_;
+			QString Detail_;
+			qint64 Start_;
+			qint64 Duration_;
+			int Thread_;
+		};
+
+		struct ThreadInfo
+		{
+			int ID_;
+			QString Name_;
+		};
+
+		struct State
+		{
+			std::atomic_bool Enabled_ { false };
+
+			QElapsedTimer Timer_;
+
+			QMutex Mutex_;
+			std::vector<Event> Events_;
+			QList<ThreadInfo> Threads_;
+			int NextThreadId_ = 0;
+		};
+
+		State& GetState ()
+		{
+			static State state;
+			return state;
+		}
+
+		int GetThreadId (State& state)
+		{
+			thread_local int threadId = -1;
+			if (threadId == -1)
+			{
+				const auto thread = QThread::currentThread ();
+				auto name = thread->objectName ();
+				if (name.isEmpty ())
+					name = qApp && thread == qApp->thread () ?
+							QStringLiteral ("main") :
+							QStringLiteral ("thread %1").arg (state.NextThreadId_);
+
+				threadId = state.NextThreadId_++;
+				state.Threads_.push_back ({ threadId, name });
+			}
+			return threadId;
+		}
+	}
+
+	void Enable ()
+	{
+		auto& state = GetState ();
+		QMutexLocker locker { &state.Mutex_ };
+		if (state.Enabled_)
+			return;
+
+		state.Timer_.start ();
+		state.Enabled_ = true;
+	}
+
+	bool IsEnabled ()
+	{
+		return GetState ().Enabled_.load (std::memory_order_relaxed);
+	}
+
+	bool Dump (const QString& path)
+	{
+		auto& state = GetState ();
+
+		std::vector<Event> events;
+		QList<ThreadInfo> threads;
+		{
+			QMutexLocker locker { &state.Mutex_ };
+			state.Enabled_ = false;
+			std::swap (events, state.Events_);
+			threads = state.Threads_;
+		}
+
+		QJsonArray traceEvents;
+		for (const auto& thread : threads)
+			traceEvents.append (QJsonObject
+					{
+						{ "name", "thread_name" },
+						{ "ph", "M" },
+						{ "pid", 1 },
+						{ "tid", thread.ID_ },
+						{ "args", QJsonObject { { "name", thread.Name_ } } }
+					});
+
+		for (const auto& event : events)
+		{
+			QJsonObject obj
+			{
+				{ "name", QString::fromUtf8 (event.Name_) },
+				{ "cat", QString::fromUtf8 (event.Category_) },
+				{ "ph", "X" },
+				{ "ts", event.Start_ / 1000. },
+				{ "dur", event.Duration_ / 1000. },
+				{ "pid", 1 },
+				{ "tid", event.Thread_ }
+			};
+			if (!event.Detail_.isEmpty ())
+				obj ["args"] = QJsonObject { { "detail", event.Detail_ } };
+			traceEvents.append (obj);
+		}
+
+		QFile file { path };
+		if (!file.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< path
+					<< "for writing:"
+					<< file.errorString ();
+			return false;
+		}
+
+		const QJsonObject root
+		{
+			{ "traceEvents", traceEvents },
+			{ "displayTimeUnit", "ms" }
+		};
+		file.write (QJsonDocument { root }.toJson (QJsonDocument::Compact));
+
+		qDebug () << Q_FUNC_INFO
+				<< "written"
+				<< events.size ()
+				<< "spans to"
+				<< path;
+		return true;
+	}
+
+	TraceSpan::TraceSpan (const char *name, const char *category, const QString& detail)
+	: Name_ { name }
+	, Category_ { category }
+	{
+		if (!IsEnabled ())
+			return;
+
+		Detail_ = detail;
+		Start_ = GetState ().Timer_.nsecsElapsed ();
+	}
+
+	TraceSpan::~TraceSpan ()
+	{
+		if (Start_ < 0)
+			return;
+
+		auto& state = GetState ();
+		const auto end = state.Timer_.nsecsElapsed ();
+
+		QMutexLocker locker { &state.Mutex_ };
+		if (!state.Enabled_)
+			return;
+
+		state.Events_.push_back ({ Name_, Category_, Detail_, Start_, end - Start_, GetThreadId (state) });
+	}
+}
+}
+}
@@ -0,0 +1,90 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QString>
+#include "sysconfig.h"
+
+namespace LC
+{
+namespace Util
+{
+namespace Tracing
+{
+	/** @brief Enables recording the trace spans.
+	 *
+	 * Until this function is called, creating TraceSpan objects costs
+	 * just a single atomic load.
+	 *
+	 * @sa Dump()
+	 */
+	UTIL_SYS_API void Enable ();
+
+	/** @brief Returns whether the trace spans are being recorded.
+	 */
+	UTIL_SYS_API bool IsEnabled ();
+
+	/** @brief Writes the spans recorded so far to the given file.
+	 *
+	 * The file is written in the Chrome trace event format, suitable
+	 * for loading into chrome://tracing or Perfetto. Recording is
+	 * disabled afterwards, and the recorded spans are discarded.
+	 *
+	 * @param[in] path The path to the output file.
+	 * @return Whether the trace has been written successfully.
+	 */
+	UTIL_SYS_API bool Dump (const QString& path);
+
+	/** @brief Records the lifetime of the object as a trace span.
+	 *
+	 * The span is attributed to the thread the object has been
+	 * created in.
+	 *
+	 * The name and category strings must outlive the tracing session,
+	 * so string literals are expected to be passed here. The optional
+	 * detail string is stored along with the span, and may be used to
+	 * name the particular plugin, file or such.
+	 */
+	class UTIL_SYS_API TraceSpan
+	{
+		const char * const Name_;
+		const char * const Category_;
+		QString Detail_;
+		qint64 Start_ = -1;
+	public:
+		TraceSpan (const char *name, const char *category, const QString& detail = {});
+		~TraceSpan ();
+
+		TraceSpan (const TraceSpan&) = delete;
+		TraceSpan& operator= (const TraceSpan&) = delete;
+	};
+}
+}
+}
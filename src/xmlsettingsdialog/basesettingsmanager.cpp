@@ -59,6 +59,8 @@ namespace Util
 
 	void BaseSettingsManager::Release ()
 	{
+		SettingsThreadManager::Instance ().Flush (this);
+
 		auto settings = GetSettings ();
 
 		for (const auto& dProp : dynamicPropertyNames ())
@@ -0,0 +1,153 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <QReadWriteLock>
+#include "basesettingsmanager.h"
+
+namespace LC
+{
+namespace Util
+{
+	namespace detail
+	{
+		template<typename T, typename = void>
+		class SettingStorage
+		{
+			mutable QReadWriteLock Lock_;
+			T Value_ {};
+		public:
+			T Get () const
+			{
+				QReadLocker locker { &Lock_ };
+				return Value_;
+			}
+
+			void Set (T value)
+			{
+				QWriteLocker locker { &Lock_ };
+				Value_ = std::move (value);
+			}
+		};
+
+		template<typename T>
+		class SettingStorage<T, std::enable_if_t<std::is_trivially_copyable_v<T> && sizeof (T) <= sizeof (qint64)>>
+		{
+			std::atomic<T> Value_ {};
+		public:
+			T Get () const
+			{
+				return Value_.load (std::memory_order_relaxed);
+			}
+
+			void Set (T value)
+			{
+				Value_.store (value, std::memory_order_relaxed);
+			}
+		};
+	}
+
+	/** @brief A typed cached handle to a single setting.
+	 *
+	 * Reading a setting via BaseSettingsManager::property() involves a
+	 * string-keyed dynamic property lookup and a QVariant conversion,
+	 * and isn't safe to do from threads other than the one the settings
+	 * manager lives in. This class instead keeps the value of the
+	 * setting converted to T, updating it each time the setting
+	 * changes, so that reading it is just an atomic load for small
+	 * trivially copyable types (like bool or int) and a read-locked
+	 * copy for the rest.
+	 *
+	 * The handle should be created in the thread the settings manager
+	 * lives in, while Get() may be called from any thread.
+	 *
+	 * Typical usage is declaring it as a class member:
+	 * @code
+	 * Util::SettingHandle<bool> EnableFiltering_ { XmlSettingsManager::Instance (), "EnableFiltering" };
+	 * @endcode
+	 *
+	 * @tparam T The type of the setting value.
+	 */
+	template<typename T>
+	class SettingHandle
+	{
+		using Storage_t = detail::SettingStorage<T>;
+		std::shared_ptr<Storage_t> Storage_ = std::make_shared<Storage_t> ();
+
+		std::unique_ptr<QObject> Context_ { new QObject };
+	public:
+		/** @brief Constructs the handle for the given setting.
+		 *
+		 * @param[in] manager The settings manager owning the setting.
+		 * @param[in] propName The name of the setting.
+		 */
+		SettingHandle (BaseSettingsManager *manager, const QByteArray& propName)
+		{
+			manager->RegisterObject (propName, Context_.get (),
+					[storage = Storage_] (const QVariant& value) { storage->Set (value.value<T> ()); });
+		}
+
+		/** @brief Constructs the handle for the given setting.
+		 *
+		 * This is an overloaded function provided for convenience.
+		 */
+		SettingHandle (BaseSettingsManager& manager, const QByteArray& propName)
+		: SettingHandle { &manager, propName }
+		{
+		}
+
+		/** @brief Returns the current value of the setting.
+		 *
+		 * This function is thread-safe.
+		 *
+		 * @return The current value of the setting, or a
+		 * default-constructed T if the setting isn't set.
+		 */
+		T Get () const
+		{
+			return Storage_->Get ();
+		}
+
+		/** @brief Returns the current value of the setting.
+		 *
+		 * This is an overloaded function provided for convenience.
+		 *
+		 * @sa Get()
+		 */
+		T operator() () const
+		{
+			return Get ();
+		}
+	};
+}
+}
@@ -28,6 +28,7 @@
  **********************************************************************/
 
 #include "settingsthread.h"
+#include <algorithm>
 #include <QMutexLocker>
 #include <QFile>
 #include <QTimer>
@@ -51,26 +52,110 @@ namespace LC
 	{
 		QMutexLocker l { &Mutex_ };
 
-		if (Pendings_.isEmpty ())
-			QTimer::singleShot (0, this, SLOT (saveScheduled ()));
-		Pendings_ [bsm].push_back ({ name, value });
+		++Stats_.Changes_;
+
+		auto& pendings = Pendings_ [bsm];
+		const auto prevSize = pendings.size ();
+		pendings [name] = value;
+		if (pendings.size () == prevSize)
+			++Stats_.Coalesced_;
+
+		if (!FlushScheduled_)
+		{
+			FlushScheduled_ = true;
+
+			// The caller's thread may have no event loop to run the timer,
+			// so it's started in the settings thread instead.
+			QMetaObject::invokeMethod (this, "scheduleFlush", Qt::QueuedConnection);
+		}
 	}
 
-	void SettingsThread::saveScheduled ()
+	void SettingsThread::SetFlushInterval (int msecs)
 	{
-		decltype (Pendings_) pendings;
+		QMutexLocker l { &Mutex_ };
+		FlushInterval_ = std::max (msecs, 0);
+	}
+
+	void SettingsThread::Flush (Util::BaseSettingsManager *bsm)
+	{
+		QMutexLocker writeLocker { &WriteMutex_ };
 
+		decltype (Pendings_) pendings;
 		{
 			QMutexLocker l { &Mutex_ };
-			using std::swap;
-			swap (pendings, Pendings_);
+			if (bsm)
+			{
+				const auto pos = Pendings_.find (bsm);
+				if (pos == Pendings_.end ())
+					return;
+
+				pendings [bsm] = *pos;
+				Pendings_.erase (pos);
+			}
+			else
+			{
+				using std::swap;
+				swap (pendings, Pendings_);
+			}
 		}
 
+		Write (pendings);
+	}
+
+	SettingsThread::Stats SettingsThread::GetStats ()
+	{
+		QMutexLocker l { &Mutex_ };
+		return Stats_;
+	}
+
+	void SettingsThread::Write (const QHash<Util::BaseSettingsManager*, QHash<QString, QVariant>>& pendings)
+	{
+		if (pendings.isEmpty ())
+			return;
+
+		quint64 keysWritten = 0;
 		for (const auto& pair : Util::Stlize (pendings))
 		{
 			const auto& s = pair.first->GetSettings ();
-			for (const auto& p : pair.second)
+			for (const auto& p : Util::Stlize (pair.second))
 				s->setValue (p.first, p.second);
+			keysWritten += pair.second.size ();
 		}
+
+		QMutexLocker l { &Mutex_ };
+		++Stats_.Flushes_;
+		Stats_.KeysWritten_ += keysWritten;
+	}
+
+	void SettingsThread::scheduleFlush ()
+	{
+		int interval = 0;
+		{
+			QMutexLocker l { &Mutex_ };
+			interval = FlushInterval_;
+		}
+
+		QTimer::singleShot (interval, this, SLOT (saveScheduled ()));
+	}
+
+	void SettingsThread::saveScheduled ()
+	{
+		{
+			QMutexLocker l { &Mutex_ };
+			FlushScheduled_ = false;
+		}
+
+		Flush ();
+	}
+
+	QDebug operator<< (QDebug dbg, const SettingsThread::Stats& stats)
+	{
+		QDebugStateSaver saver { dbg };
+		dbg.nospace () << "SettingsThread::Stats { changes: " << stats.Changes_
+				<< "; coalesced: " << stats.Coalesced_
+				<< "; flushes: " << stats.Flushes_
+				<< "; keys written: " << stats.KeysWritten_
+				<< " }";
+		return dbg;
 	}
 }
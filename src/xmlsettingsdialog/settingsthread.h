@@ -29,9 +29,10 @@
 
 #pragma once
 
-#include <QMap>
+#include <QHash>
 #include <QVariant>
 #include <QMutex>
+#include <QDebug>
 
 namespace LC
 {
@@ -40,18 +41,61 @@ namespace Util
 	class BaseSettingsManager;
 }
 
+	/** Accumulates the changed settings and writes them to the
+	 * corresponding QSettings at most once per flush interval, which is
+	 * two seconds by default.
+	 *
+	 * Repeated changes of the same key before the flush are coalesced,
+	 * so only the last value gets written.
+	 */
 	class SettingsThread : public QObject
 	{
 		Q_OBJECT
 
 		QMutex Mutex_;
-		QMap<Util::BaseSettingsManager*, QList<QPair<QString, QVariant>>> Pendings_;
+		QHash<Util::BaseSettingsManager*, QHash<QString, QVariant>> Pendings_;
+		bool FlushScheduled_ = false;
+		int FlushInterval_ = 2000;
+
+		// Serializes the actual writes so that an older batch never
+		// overwrites a newer one flushed from another thread.
+		QMutex WriteMutex_;
+	public:
+		struct Stats
+		{
+			quint64 Changes_ = 0;
+			quint64 Coalesced_ = 0;
+			quint64 Flushes_ = 0;
+			quint64 KeysWritten_ = 0;
+		};
+	private:
+		Stats Stats_;
 	public:
 		using QObject::QObject;
 		~SettingsThread ();
 
 		void Save (Util::BaseSettingsManager*, QString, QVariant);
+
+		/** Sets the delay in milliseconds between the first pending
+		 * change and the write of all the pending changes.
+		 *
+		 * The new interval is used starting with the next scheduled
+		 * flush.
+		 */
+		void SetFlushInterval (int msecs);
+
+		/** Writes the pending settings of the given manager, or of all
+		 * managers if it is null, in the calling thread.
+		 */
+		void Flush (Util::BaseSettingsManager* = nullptr);
+
+		Stats GetStats ();
+	private:
+		void Write (const QHash<Util::BaseSettingsManager*, QHash<QString, QVariant>>&);
 	private slots:
+		void scheduleFlush ();
 		void saveScheduled ();
 	};
+
+	QDebug operator<< (QDebug, const SettingsThread::Stats&);
 }
@@ -28,8 +28,10 @@
  **********************************************************************/
 
 #include "settingsthreadmanager.h"
+#include <QCoreApplication>
 #include <QMetaObject>
 #include <QThread>
+#include <QtDebug>
 #include "settingsthread.h"
 #include "basesettingsmanager.h"
 
@@ -41,6 +43,16 @@ namespace LC
 	{
 		Thread_->start (QThread::IdlePriority);
 		Worker_->moveToThread (Thread_);
+
+		if (const auto app = QCoreApplication::instance ())
+			connect (app,
+					&QCoreApplication::aboutToQuit,
+					this,
+					[this]
+					{
+						Flush ();
+						qDebug () << Q_FUNC_INFO << Worker_->GetStats ();
+					});
 	}
 
 	SettingsThreadManager::~SettingsThreadManager ()
@@ -62,4 +74,14 @@ namespace LC
 	{
 		Worker_->Save (bsm, name, value);
 	}
+
+	void SettingsThreadManager::Flush (Util::BaseSettingsManager *bsm)
+	{
+		Worker_->Flush (bsm);
+	}
+
+	void SettingsThreadManager::SetFlushInterval (int msecs)
+	{
+		Worker_->SetFlushInterval (msecs);
+	}
 }
@@ -31,6 +31,7 @@
 
 #include <memory>
 #include <QObject>
+#include "xsdconfig.h"
 
 namespace LC
 {
@@ -41,7 +42,7 @@ namespace Util
 
 	class SettingsThread;
 
-	class SettingsThreadManager : public QObject
+	class XMLSETTINGSMANAGER_API SettingsThreadManager : public QObject
 	{
 		Q_OBJECT
 
@@ -59,5 +60,22 @@ namespace Util
 
 		void Add (Util::BaseSettingsManager*,
 				const QString& name, const QVariant& value);
+
+		/** Synchronously writes the pending settings of the given
+		 * settings manager, or of all of them if it is null.
+		 *
+		 * This should be called before the settings manager objects are
+		 * destroyed, for example, before unloading the plugin owning
+		 * them.
+		 */
+		void Flush (Util::BaseSettingsManager* = nullptr);
+
+		/** Sets the delay in milliseconds after which the changed
+		 * settings are written, two seconds by default.
+		 *
+		 * Longer intervals coalesce more changes of the same keys,
+		 * while shorter ones lose less data on a crash.
+		 */
+		void SetFlushInterval (int msecs);
 	};
 }
@@ -0,0 +1,126 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "settingshandlebench.h"
+#include <QtTest>
+#include <settingshandle.h>
+
+QTEST_GUILESS_MAIN (LC::Util::SettingsHandleBench)
+
+namespace LC
+{
+namespace Util
+{
+	namespace
+	{
+		class TestSettingsManager : public BaseSettingsManager
+		{
+		public:
+			TestSettingsManager ()
+			{
+				const auto guard = EnterInitMode ();
+				setProperty ("BoolProp", true);
+				setProperty ("StringProp", "some string value");
+			}
+		protected:
+			QSettings* BeginSettings () const override
+			{
+				return new QSettings { QSettings::IniFormat, QSettings::UserScope,
+						"LeechCraft", "SettingsHandleBench" };
+			}
+
+			void EndSettings (QSettings*) const override
+			{
+			}
+		};
+	}
+
+	void SettingsHandleBench::testHandleValue ()
+	{
+		TestSettingsManager xsm;
+		const SettingHandle<bool> boolHandle { xsm, "BoolProp" };
+		const SettingHandle<QString> stringHandle { xsm, "StringProp" };
+
+		QCOMPARE (boolHandle (), true);
+		QCOMPARE (stringHandle (), QString { "some string value" });
+	}
+
+	void SettingsHandleBench::testHandleUpdate ()
+	{
+		TestSettingsManager xsm;
+		const SettingHandle<bool> boolHandle { xsm, "BoolProp" };
+		const SettingHandle<QString> stringHandle { xsm, "StringProp" };
+
+		const auto guard = xsm.EnterInitMode ();
+		xsm.setProperty ("BoolProp", false);
+		xsm.setProperty ("StringProp", "other value");
+
+		QCOMPARE (boolHandle (), false);
+		QCOMPARE (stringHandle (), QString { "other value" });
+	}
+
+	void SettingsHandleBench::benchPropertyBool ()
+	{
+		TestSettingsManager xsm;
+
+		bool result = false;
+		QBENCHMARK { result ^= xsm.property ("BoolProp").toBool (); }
+		Q_UNUSED (result)
+	}
+
+	void SettingsHandleBench::benchHandleBool ()
+	{
+		TestSettingsManager xsm;
+		const SettingHandle<bool> handle { xsm, "BoolProp" };
+
+		bool result = false;
+		QBENCHMARK { result ^= handle (); }
+		Q_UNUSED (result)
+	}
+
+	void SettingsHandleBench::benchPropertyString ()
+	{
+		TestSettingsManager xsm;
+
+		int result = 0;
+		QBENCHMARK { result += xsm.property ("StringProp").toString ().size (); }
+		Q_UNUSED (result)
+	}
+
+	void SettingsHandleBench::benchHandleString ()
+	{
+		TestSettingsManager xsm;
+		const SettingHandle<QString> handle { xsm, "StringProp" };
+
+		int result = 0;
+		QBENCHMARK { result += handle ().size (); }
+		Q_UNUSED (result)
+	}
+}
+}
@@ -48,6 +48,7 @@
 #include <util/util.h>
 #include <util/sll/qtutil.h>
 #include <util/sll/util.h>
+#include <util/sys/tracing.h>
 #include "itemhandlerfactory.h"
 #include "basesettingsmanager.h"
 #include "settingsthreadmanager.h"
@@ -74,6 +75,8 @@ namespace Util
 
 	void XmlSettingsDialog::RegisterObject (BaseSettingsManager *obj, const QString& basename)
 	{
+		Util::Tracing::TraceSpan span { "XmlSettingsDialog::RegisterObject", "settings", basename };
+
 		Basename_ = QFileInfo (basename).baseName ();
 		TrContext_ = basename.endsWith (".xml") ?
 				Basename_ :